@@ -0,0 +1,336 @@
+/**
+ * @file CoreBenchmarks.cpp
+ * @brief Microbenchmarks of the pipeline building blocks (Google Benchmark).
+ *
+ * Covers the queues and thread pools between the pipeline stages, the
+ * summary pass of PacketProcessor and the PacketStore write and read paths.
+ * Packets are synthetic Ethernet / IPv4 frames built in memory, so the
+ * numbers do not depend on a capture device or file.
+ *
+ * Run: ./packet-scope-bench --benchmark_repetitions=5 --benchmark_report_aggregates_only=true
+ */
+
+#include "core/FlowTable.hpp"
+#include "core/PacketBufferPool.hpp"
+#include "core/PacketProcessor.hpp"
+#include "core/PacketStore.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/ThreadSafeQueue.hpp"
+#include "core/WorkStealingThreadPool.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Items per benchmark iteration of the queue and pool benchmarks
+constexpr std::size_t kItemsPerIteration = 4096;
+
+/// Distinct 5-tuples of the generated traffic
+constexpr std::size_t kFlowCount = 1024;
+
+/// Packets of the pre-filled store read by the lookup benchmarks
+constexpr std::size_t kStoredPacketCount = std::size_t{1} << 16;
+
+/// The store is cleared (untimed) before its IDs reach this many packets
+constexpr std::size_t kStoreResetThreshold = std::size_t{1} << 20;
+
+constexpr std::size_t kEthernetHeaderSize = 14;
+constexpr std::size_t kIpv4HeaderSize = 20;
+constexpr std::size_t kTcpHeaderSize = 20;
+constexpr std::size_t kUdpHeaderSize = 8;
+constexpr uint8_t kTcpProtocol = 6;
+constexpr uint8_t kUdpProtocol = 17;
+
+void writeBigEndian16(std::vector<uint8_t>& frame, std::size_t offset, uint16_t value) {
+    frame[offset] = static_cast<uint8_t>(value >> 8);
+    frame[offset + 1] = static_cast<uint8_t>(value & 0xff);
+}
+
+/**
+ * @brief Builds an Ethernet / IPv4 / TCP or UDP frame from 10.0.0.1 to 10.0.0.2.
+ *
+ * @param ipProtocol kTcpProtocol or kUdpProtocol
+ * @param sourcePort Varied to spread the packets over flows
+ * @param payloadSize Zero bytes after the transport header
+ */
+std::vector<uint8_t> makeFrame(uint8_t ipProtocol, uint16_t sourcePort, std::size_t payloadSize) {
+    const std::size_t transportSize = ipProtocol == kTcpProtocol ? kTcpHeaderSize : kUdpHeaderSize;
+    std::vector<uint8_t> frame(kEthernetHeaderSize + kIpv4HeaderSize + transportSize + payloadSize, 0);
+
+    // Ethernet: locally administered MACs, EtherType IPv4
+    const uint8_t macs[] = {0x02, 0, 0, 0, 0, 0x02, 0x02, 0, 0, 0, 0, 0x01};
+    std::copy(std::begin(macs), std::end(macs), frame.begin());
+    writeBigEndian16(frame, 12, 0x0800);
+
+    const std::size_t ip = kEthernetHeaderSize;
+    frame[ip] = 0x45;
+    writeBigEndian16(frame, ip + 2, static_cast<uint16_t>(frame.size() - kEthernetHeaderSize));
+    writeBigEndian16(frame, ip + 6, 0x4000);    // Don't fragment
+    frame[ip + 8] = 64;
+    frame[ip + 9] = ipProtocol;
+    const uint8_t addresses[] = {10, 0, 0, 1, 10, 0, 0, 2};
+    std::copy(std::begin(addresses), std::end(addresses), frame.begin() + static_cast<std::ptrdiff_t>(ip + 12));
+
+    const std::size_t transport = ip + kIpv4HeaderSize;
+    writeBigEndian16(frame, transport, sourcePort);
+    if (ipProtocol == kTcpProtocol) {
+        writeBigEndian16(frame, transport + 2, 443);
+        frame[transport + 12] = 0x50;           // Data offset: 5 words
+        frame[transport + 13] = 0x18;           // PSH, ACK
+        writeBigEndian16(frame, transport + 14, 0xffff);
+    } else {
+        writeBigEndian16(frame, transport + 2, 53);
+        writeBigEndian16(frame, transport + 4, static_cast<uint16_t>(kUdpHeaderSize + payloadSize));
+    }
+    return frame;
+}
+
+/**
+ * @brief Copies frames into pooled buffers as the capture thread would.
+ *
+ * Packet i uses source port 1024 + i % kFlowCount.
+ */
+std::vector<packetscope::RawPacketData> makePackets(PacketBufferPool& pool, uint8_t ipProtocol,
+                                                    std::size_t count, std::size_t payloadSize) {
+    std::vector<packetscope::RawPacketData> packets;
+    packets.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::vector<uint8_t> frame = makeFrame(ipProtocol, static_cast<uint16_t>(1024 + i % kFlowCount),
+                                                     payloadSize);
+        packetscope::RawPacketData packet;
+        packet.sequence = i;
+        packet.timestamp = timespec{static_cast<time_t>(i / 1000), static_cast<long>(i % 1000) * 1000000};
+        packet.rawData = pool.copyFrom(frame.data(), frame.size());
+        packet.rawDataLen = static_cast<int>(frame.size());
+        packet.frameLength = packet.rawDataLen;
+        packet.linkLayerType = pcpp::LINKTYPE_ETHERNET;
+        packets.push_back(std::move(packet));
+    }
+    return packets;
+}
+
+/**
+ * @brief Returns the processed form of a packet with the given store ID.
+ */
+packetscope::ParsedPacket makeParsedPacket(const PacketProcessor& processor,
+                                           const packetscope::RawPacketData& rawPacket, std::size_t id) {
+    packetscope::ParsedPacket parsedPacket = processor.process(rawPacket);
+    parsedPacket.id = static_cast<int>(id);
+    return parsedPacket;
+}
+
+// ThreadSafeQueue
+
+void BM_ThreadSafeQueuePushPop(benchmark::State& state) {
+    ThreadSafeQueue<std::size_t> queue;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < kItemsPerIteration; ++i) {
+            queue.push(i);
+        }
+        for (std::size_t i = 0; i < kItemsPerIteration; ++i) {
+            benchmark::DoNotOptimize(queue.pop());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kItemsPerIteration));
+}
+BENCHMARK(BM_ThreadSafeQueuePushPop);
+
+/**
+ * @brief One producer (the benchmark thread) and one consumer, bounded queue of range(0) items.
+ */
+void BM_ThreadSafeQueueProducerConsumer(benchmark::State& state) {
+    ThreadSafeQueue<std::size_t> queue(
+        packetscope::QueueLimits{static_cast<std::size_t>(state.range(0)), packetscope::OverflowPolicy::Block});
+    std::atomic<std::size_t> consumed{0};
+
+    // Item 0 stops the consumer
+    std::thread consumer([&queue, &consumed] {
+        while (queue.pop() != 0) {
+            consumed.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    std::size_t produced = 0;
+    for (auto _ : state) {
+        for (std::size_t i = 1; i <= kItemsPerIteration; ++i) {
+            queue.push(i);
+        }
+        produced += kItemsPerIteration;
+        while (consumed.load(std::memory_order_acquire) < produced) {
+            std::this_thread::yield();
+        }
+    }
+    queue.forcePush(0);
+    consumer.join();
+    state.SetItemsProcessed(static_cast<int64_t>(produced));
+}
+BENCHMARK(BM_ThreadSafeQueueProducerConsumer)->Arg(64)->Arg(65536)->UseRealTime();
+
+// Thread pools
+
+/**
+ * @brief Submits kItemsPerIteration empty tasks to a pool of range(0) threads and waits for them.
+ */
+template <typename Pool>
+void BM_PoolSubmit(benchmark::State& state) {
+    Pool pool(static_cast<std::size_t>(state.range(0)));
+    std::atomic<std::size_t> completed{0};
+
+    std::size_t submitted = 0;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < kItemsPerIteration; ++i) {
+            if (!pool.submit([&completed] { completed.fetch_add(1, std::memory_order_release); })) {
+                completed.fetch_add(1, std::memory_order_release);
+            }
+        }
+        submitted += kItemsPerIteration;
+        while (completed.load(std::memory_order_acquire) < submitted) {
+            std::this_thread::yield();
+        }
+    }
+    pool.shutdown();
+    state.SetItemsProcessed(static_cast<int64_t>(submitted));
+}
+BENCHMARK_TEMPLATE(BM_PoolSubmit, ThreadPool)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PoolSubmit, WorkStealingThreadPool)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// PacketProcessor
+
+/**
+ * @brief Summary pass over packets with range(0) payload bytes.
+ */
+void runProcess(benchmark::State& state, uint8_t ipProtocol, bool isTrackingFlows) {
+    const std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::create();
+    const std::vector<packetscope::RawPacketData> packets =
+        makePackets(*pool, ipProtocol, kFlowCount, static_cast<std::size_t>(state.range(0)));
+    const PacketProcessor processor;
+    FlowTable flowTable;
+
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        for (const packetscope::RawPacketData& packet : packets) {
+            benchmark::DoNotOptimize(processor.process(packet, isTrackingFlows ? &flowTable : nullptr));
+            bytes += static_cast<std::size_t>(packet.rawDataLen);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(packets.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_ProcessTcp(benchmark::State& state) {
+    runProcess(state, kTcpProtocol, false);
+}
+BENCHMARK(BM_ProcessTcp)->Arg(0)->Arg(1400);
+
+void BM_ProcessUdp(benchmark::State& state) {
+    runProcess(state, kUdpProtocol, false);
+}
+BENCHMARK(BM_ProcessUdp)->Arg(0)->Arg(1400);
+
+void BM_ProcessTcpTrackFlows(benchmark::State& state) {
+    runProcess(state, kTcpProtocol, true);
+}
+BENCHMARK(BM_ProcessTcpTrackFlows)->Arg(0)->Arg(1400);
+
+// PacketStore
+
+/**
+ * @brief Stores one packet at a time, as many writers would (range(0) == 1) or in batches of range(0).
+ */
+void BM_PacketStoreAdd(benchmark::State& state) {
+    const auto batchSize = static_cast<std::size_t>(state.range(0));
+    const std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::create();
+    const std::vector<packetscope::RawPacketData> packets = makePackets(*pool, kTcpProtocol, kFlowCount, 64);
+    const PacketProcessor processor;
+    std::vector<packetscope::ParsedPacket> parsedPackets;
+    for (const packetscope::RawPacketData& packet : packets) {
+        parsedPackets.push_back(processor.process(packet));
+    }
+
+    PacketStore store;
+    std::size_t nextId = 1;
+    std::vector<packetscope::ParsedPacket> batch;
+    batch.reserve(batchSize);
+    for (auto _ : state) {
+        // The copies are part of the timing; the pipeline moves freshly parsed packets in
+        batch.clear();
+        for (std::size_t i = 0; i < batchSize; ++i, ++nextId) {
+            batch.push_back(parsedPackets[nextId % parsedPackets.size()]);
+            batch.back().id = static_cast<int>(nextId);
+        }
+        if (batchSize == 1) {
+            store.addPacket(std::move(batch.front()));
+        } else {
+            store.addPackets(std::move(batch));
+        }
+
+        if (nextId >= kStoreResetThreshold) {
+            state.PauseTiming();
+            store.clear();
+            nextId = 1;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batchSize));
+}
+BENCHMARK(BM_PacketStoreAdd)->Arg(1)->Arg(64);
+
+/**
+ * @brief Fills a store with kStoredPacketCount packets for the lookup benchmarks.
+ */
+std::unique_ptr<PacketStore> makeFilledStore(PacketBufferPool& pool) {
+    const std::vector<packetscope::RawPacketData> packets = makePackets(pool, kTcpProtocol, kFlowCount, 64);
+    const PacketProcessor processor;
+    auto store = std::make_unique<PacketStore>();
+    for (std::size_t id = 1; id <= kStoredPacketCount; ++id) {
+        store->addPacket(makeParsedPacket(processor, packets[id % packets.size()], id));
+    }
+    return store;
+}
+
+/**
+ * @brief Random lookups that copy the packet out, as the detail view does.
+ */
+void BM_PacketStoreGetById(benchmark::State& state) {
+    const std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::create();
+    const std::unique_ptr<PacketStore> store = makeFilledStore(*pool);
+
+    // Multiplicative stride walks every ID once per kStoredPacketCount lookups
+    std::size_t index = 0;
+    for (auto _ : state) {
+        index = (index + 40503) % kStoredPacketCount;
+        benchmark::DoNotOptimize(store->getById(static_cast<int>(index + 1)));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PacketStoreGetById);
+
+/**
+ * @brief Random lookups through visit(), the copy free path of table repaints.
+ */
+void BM_PacketStoreVisit(benchmark::State& state) {
+    const std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::create();
+    const std::unique_ptr<PacketStore> store = makeFilledStore(*pool);
+
+    std::size_t index = 0;
+    for (auto _ : state) {
+        index = (index + 40503) % kStoredPacketCount;
+        store->visit(static_cast<int>(index + 1), [](const PacketView& view) {
+            benchmark::DoNotOptimize(&view);
+        });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PacketStoreVisit);
+
+}
+
+BENCHMARK_MAIN();
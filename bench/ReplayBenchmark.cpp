@@ -0,0 +1,223 @@
+/**
+ * @file ReplayBenchmark.cpp
+ * @brief Headless end to end benchmark: loads a capture file through the full pipeline.
+ *
+ * Every run is a PipelineController::openFile() of the same file, read at
+ * maximum speed (no pacing by the packet timestamps) through the dispatcher,
+ * task queue, workers and store. Reports packets and megabytes per second,
+ * the p99 of every pipeline stage and the peak RSS of the process, as text
+ * or as one JSON object so runs can be compared from one change to the next.
+ *
+ * Usage: packet-scope-replay <file> [--runs N] [--workers N] [--flow-affine] [--json]
+ */
+
+#include "core/PipelineController.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Interval the progress of a run is polled at
+constexpr std::chrono::milliseconds kPollInterval{1};
+
+struct Options {
+    std::string path;
+    std::size_t runs{3};
+    std::size_t workerCount{0};         ///< 0: one per core, as PipelineConfig::workerCount
+    bool isFlowAffine{false};
+    bool isJson{false};
+};
+
+struct RunResult {
+    uint64_t packets{};
+    uint64_t bytes{};
+    double seconds{};
+    double packetsPerSecond{};
+    double megabytesPerSecond{};
+    packetscope::PipelineMetricsSnapshot metrics;
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s <file> [--runs N] [--workers N] [--flow-affine] [--json]\n"
+                 "  Loads a pcap / pcapng file through the pipeline N times (default 3) at maximum speed\n"
+                 "  and prints packets/s, MB/s, stage p99 latencies and peak RSS.\n",
+                 program);
+}
+
+bool parseCount(const char* text, std::size_t& value) {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<std::size_t>(parsed);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument == "--runs" && i + 1 < argc) {
+            if (!parseCount(argv[++i], options.runs) || options.runs == 0) {
+                return false;
+            }
+        } else if (argument == "--workers" && i + 1 < argc) {
+            if (!parseCount(argv[++i], options.workerCount)) {
+                return false;
+            }
+        } else if (argument == "--flow-affine") {
+            options.isFlowAffine = true;
+        } else if (argument == "--json") {
+            options.isJson = true;
+        } else if (!argument.empty() && argument[0] != '-' && options.path.empty()) {
+            options.path = argument;
+        } else {
+            return false;
+        }
+    }
+    return !options.path.empty();
+}
+
+/**
+ * @brief Returns the peak resident set size of the process in bytes.
+ */
+uint64_t peakRssBytes() {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Linux reports kilobytes
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+/**
+ * @brief Loads the file once and waits until every packet is stored.
+ */
+bool runOnce(PipelineController& controller, const std::string& path, RunResult& result) {
+    if (!controller.openFile(path)) {
+        return false;
+    }
+
+    std::optional<packetscope::FileLoadProgress> progress;
+    while (!(progress = controller.fileLoadProgress()) || !progress->isFinished) {
+        std::this_thread::sleep_for(kPollInterval);
+    }
+
+    result.packets = progress->packetsRead;
+    result.bytes = progress->bytesRead;
+    result.seconds = progress->secondsElapsed;
+    if (result.seconds > 0) {
+        result.packetsPerSecond = static_cast<double>(result.packets) / result.seconds;
+    }
+    result.megabytesPerSecond = progress->megabytesPerSecond;
+    result.metrics = controller.metrics();
+    return true;
+}
+
+void printText(const Options& options, const std::vector<RunResult>& results, const RunResult& median,
+               uint64_t peakRss) {
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        std::printf("run %zu: %llu packets in %.3f s, %.0f packets/s, %.1f MB/s\n", i + 1,
+                    static_cast<unsigned long long>(results[i].packets), results[i].seconds,
+                    results[i].packetsPerSecond, results[i].megabytesPerSecond);
+    }
+
+    std::printf("\nfile      : %s\n", options.path.c_str());
+    std::printf("packets/s : %.0f (median of %zu runs)\n", median.packetsPerSecond, results.size());
+    std::printf("MB/s      : %.1f\n", median.megabytesPerSecond);
+    for (std::size_t stage = 0; stage < packetscope::kPipelineStageCount; ++stage) {
+        const packetscope::LatencyHistogram& histogram = median.metrics.stages[stage];
+        if (histogram.count == 0) {
+            continue;
+        }
+        std::printf("p99 %-17s: %llu ns (p50 %llu ns, max %llu ns)\n",
+                    packetscope::pipelineStageName(static_cast<packetscope::PipelineStage>(stage)),
+                    static_cast<unsigned long long>(histogram.percentile(0.99)),
+                    static_cast<unsigned long long>(histogram.percentile(0.5)),
+                    static_cast<unsigned long long>(histogram.max));
+    }
+    std::printf("peak RSS  : %.1f MiB\n", static_cast<double>(peakRss) / (1024.0 * 1024.0));
+}
+
+void printJson(const Options& options, const std::vector<RunResult>& results, const RunResult& median,
+               uint64_t peakRss) {
+    std::printf("{\"file\":\"");
+    for (const char c : options.path) {
+        if (c == '"' || c == '\\') {
+            std::putchar('\\');
+        }
+        std::putchar(c);
+    }
+    std::printf("\",\"runs\":[");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        std::printf("%s{\"packets\":%llu,\"bytes\":%llu,\"seconds\":%.6f,\"packets_per_second\":%.0f,"
+                    "\"megabytes_per_second\":%.3f}",
+                    i == 0 ? "" : ",", static_cast<unsigned long long>(results[i].packets),
+                    static_cast<unsigned long long>(results[i].bytes), results[i].seconds,
+                    results[i].packetsPerSecond, results[i].megabytesPerSecond);
+    }
+    std::printf("],\"packets_per_second\":%.0f,\"megabytes_per_second\":%.3f,\"p99_ns\":{",
+                median.packetsPerSecond, median.megabytesPerSecond);
+    for (std::size_t stage = 0; stage < packetscope::kPipelineStageCount; ++stage) {
+        std::printf("%s\"%s\":%llu", stage == 0 ? "" : ",",
+                    packetscope::pipelineStageName(static_cast<packetscope::PipelineStage>(stage)),
+                    static_cast<unsigned long long>(median.metrics.stages[stage].percentile(0.99)));
+    }
+    std::printf("},\"peak_rss_bytes\":%llu}\n", static_cast<unsigned long long>(peakRss));
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Keeps the per run info logs out of the report
+    spdlog::set_level(spdlog::level::warn);
+
+    packetscope::PipelineConfig config;
+    config.workerCount = options.workerCount;
+    if (options.isFlowAffine) {
+        config.dispatchMode = packetscope::DispatchMode::FlowAffine;
+    }
+    PipelineController controller(config);
+
+    std::vector<RunResult> results(options.runs);
+    for (RunResult& result : results) {
+        if (!runOnce(controller, options.path, result)) {
+            std::fprintf(stderr, "Cannot load '%s'\n", options.path.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    const uint64_t peakRss = peakRssBytes();
+
+    // The median run is reported with its stage latencies, so one slow run does not skew them
+    std::vector<RunResult> sorted = results;
+    std::sort(sorted.begin(), sorted.end(), [](const RunResult& left, const RunResult& right) {
+        return left.packetsPerSecond < right.packetsPerSecond;
+    });
+    const RunResult& median = sorted[sorted.size() / 2];
+
+    if (options.isJson) {
+        printJson(options, results, median, peakRss);
+    } else {
+        printText(options, results, median, peakRss);
+    }
+    controller.stop();
+    return EXIT_SUCCESS;
+}
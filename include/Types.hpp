@@ -6,8 +6,12 @@
 #include <time.h>
 #include <cstdint>
 
+#include <ProtocolType.h>
 #include <RawPacket.h>
 
+#include "core/PacketAddress.hpp"
+#include "core/PacketBuffer.hpp"
+
 /**
  * @file Types.hpp
  * @brief Core data structures for packet capture pipeline.
@@ -17,17 +21,26 @@ namespace packetscope {
 
 /**
  * @brief Raw captured packet data.
- * Contains a deep copy of the captured packet bytes and metadata.
+ * Contains the captured packet bytes (in a pooled buffer) and metadata.
  * Produced by PacketCapture and consumed by PacketProcessor.
  */
 struct RawPacketData {
+    uint64_t sequence{};                ///< Capture order (0 based), see toPacketId()
     timespec timestamp;
-    std::vector<uint8_t> rawData;
+    PacketBuffer rawData;
     int rawDataLen;
     int frameLength;
     pcpp::LinkLayerType linkLayerType;
 };
 
+/**
+ * @brief Maps a capture sequence number to its PacketStore ID.
+ * IDs are 1 based, so the first captured packet has ID 1.
+ */
+inline int toPacketId(uint64_t sequence) {
+    return static_cast<int>(sequence + 1);
+}
+
 /**
  * @brief Network capture device information.
  */
@@ -36,22 +49,50 @@ struct DeviceInfo {
     std::string description;
 };
 
+/**
+ * @brief Packet counters of a capture socket as reported by the kernel.
+ *
+ * Read with pcap_stats() (Pcap backend) or PACKET_STATISTICS (TPacketV3),
+ * counted since the capture started. Packets the kernel dropped never
+ * reach the raw queue, so they are invisible to the pipeline's own counters.
+ */
+struct KernelCaptureStats {
+    uint64_t received{};                ///< Packets that passed the filter, on Linux the dropped ones included
+    uint64_t dropped{};                 ///< Dropped by the kernel: socket buffer or ring full
+    uint64_t interfaceDropped{};        ///< Dropped by the interface or its driver, if reported (libpcap only)
+
+    /**
+     * @brief Adds the counters of another socket (or an earlier session).
+     */
+    void merge(const KernelCaptureStats& other) {
+        received += other.received;
+        dropped += other.dropped;
+        interfaceDropped += other.interfaceDropped;
+    }
+};
+
 /**
  * @brief Parsed packet ready for UI display and storage.
+ *
+ * Only holds the summary columns of the packet list, in binary form.
+ * Addresses and protocol are formatted to text when a row is displayed and
+ * the per layer detail view is dissected again from rawData when a packet
+ * is selected, see PacketProcessor::dissect().
  */
 struct ParsedPacket {
-    int id{};                           ///< Unique packet ID
+    int id{};                           ///< Unique packet ID (capture order, 1 based)
     timespec timestamp;                 ///< Capture timestamp
     int rawDataLen;                     ///< Raw data length
     int frameLength;                    ///< Original frame length
-    std::vector<uint8_t> rawData;       ///< Raw bytes
-
-    std::string srcAddr;                ///< Source address (IP or MAC)
-    std::string dstAddr;                ///< Destination address (IP or MAC)
-    std::string protocol;               ///< Highest layer protocol name
-    std::string info;                   ///< Info column
+    PacketBuffer rawData;               ///< Raw bytes (shared with RawPacketData)
+    pcpp::LinkLayerType linkLayerType;  ///< Link layer for re-dissection in the detail view
 
-    std::vector<std::string> layerSummaries;
+    PacketAddress srcAddr;              ///< Source address (IP or MAC)
+    PacketAddress dstAddr;              ///< Destination address (IP or MAC)
+    pcpp::ProtocolType protocol{pcpp::UnknownProtocol}; ///< Highest recognized layer protocol
+    uint16_t srcPort{};                 ///< TCP, UDP or SCTP source port, 0 if none
+    uint16_t dstPort{};                 ///< TCP, UDP or SCTP destination port, 0 if none
+    uint8_t ipProtocol{};               ///< IANA transport protocol (6 = TCP, 17 = UDP), 0 if not IP
 };
 
 }
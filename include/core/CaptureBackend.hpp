@@ -0,0 +1,101 @@
+#ifndef CAPTUREBACKEND_HPP_
+#define CAPTUREBACKEND_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "core/PipelineConfig.hpp"
+
+/**
+ * @brief Source of captured frames behind PacketCapture.
+ *
+ * A backend owns the capture socket and the thread reading from it, and
+ * hands the frames to PacketCapture in batches. How the bytes are held is up
+ * to the backend: copied into a PacketBufferPool, or borrowed from a kernel
+ * ring (PacketBuffer::isBorrowed()).
+ */
+class CaptureBackend {
+public:
+    /**
+     * @brief PF_PACKET fanout group membership.
+     */
+    struct FanoutGroup {
+        uint16_t id;                        ///< Shared by every member socket of the device
+        packetscope::FanoutMode mode;
+    };
+
+    /**
+     * @brief Per session settings, fixed while the backend runs.
+     */
+    struct Options {
+        std::vector<int> threadCpus;        ///< CPUs of the capture thread, empty leaves it unpinned
+        std::optional<FanoutGroup> fanout;  ///< Join a fanout group instead of capturing every packet
+        packetscope::CaptureFilter filter;  ///< BPF filter and snap length of the socket
+    };
+
+    /**
+     * Receives the frames read in one go (a libpcap callback, a TPACKET_V3
+     * block). Called on the capture thread; the callee moves the elements
+     * out, the vector is reused by the backend.
+     */
+    using FrameHandler = std::function<void(std::vector<packetscope::RawPacketData>&)>;
+
+    virtual ~CaptureBackend() = default;
+
+    /**
+     * @brief Opens the device and starts the capture thread.
+     * @param deviceName Network interface to capture from
+     * @param options Thread placement and fanout membership
+     * @param handler Invoked on the capture thread for every batch of frames
+     * @return true if capture started
+     */
+    virtual bool start(const std::string& deviceName, const Options& options, FrameHandler handler) = 0;
+
+    /**
+     * @brief Stops the capture thread and closes the device.
+     *
+     * Frames still held by the pipeline stay valid until they are released.
+     */
+    virtual void stop() = 0;
+
+    /**
+     * @brief Replaces the BPF filter of the running capture.
+     *
+     * Takes effect in the kernel for the next packet; frames already queued
+     * are still delivered. The snap length of the session is kept.
+     *
+     * @param expression BPF expression, empty keeps every packet
+     * @return false if the expression does not compile or cannot be installed
+     */
+    virtual bool setFilter(const std::string& expression) = 0;
+
+    /**
+     * @brief Returns the kernel's counters of the capture socket since start().
+     *
+     * After stop() the final counters of the session are kept. Called from
+     * the thread controlling the capture, never from the capture thread.
+     */
+    virtual packetscope::KernelCaptureStats kernelStats() = 0;
+
+    /**
+     * @brief Checks that a BPF expression compiles (for Ethernet links).
+     * @param expression BPF expression, empty is valid
+     * @return false on a syntax error, which is logged
+     */
+    static bool isValidFilter(const std::string& expression);
+
+protected:
+    /**
+     * @brief Adds a bound AF_PACKET socket to a PF_PACKET fanout group.
+     * @param socketFd Socket of this member, bound to the device
+     * @param group Group to join
+     * @return false on failure or on platforms without PF_PACKET
+     */
+    static bool joinFanoutGroup(int socketFd, const FanoutGroup& group);
+};
+
+#endif
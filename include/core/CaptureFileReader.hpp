@@ -0,0 +1,170 @@
+#ifndef CAPTUREFILEREADER_HPP_
+#define CAPTUREFILEREADER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+
+/**
+ * @file CaptureFileReader.hpp
+ * @brief Memory mapped pcap / pcapng file source.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Snapshot of an offline file load, see PipelineController::fileLoadProgress().
+ */
+struct FileLoadProgress {
+    std::string path;
+    uint64_t fileSize{};                ///< Bytes in the file
+    uint64_t bytesRead{};               ///< Bytes of the file handed to the workers so far
+    uint64_t packetsRead{};             ///< Packets handed to the workers so far
+    double secondsElapsed{};            ///< Since the load started, until it finished
+    double megabytesPerSecond{};        ///< bytesRead over secondsElapsed (1 MB = 10^6 bytes)
+    bool isFinished{};                  ///< Every packet of the file is stored (or the load was stopped)
+};
+
+}
+
+/// Mapping shared by the reader and every chunk of frames lent from it, defined in the translation unit
+struct CaptureFileMapping;
+
+/**
+ * @brief Reads packets from a pcap or pcapng file without copying them.
+ *
+ * The file is mmap()ed read only. read() walks the record headers (a cheap,
+ * sequential pass) and returns the packets of one chunk as RawPacketData
+ * whose PacketBuffer points into the mapping (PacketBuffer::isBorrowed()),
+ * so copying and parsing happen on the workers, in parallel. The mapping
+ * stays alive until the last frame handle is released, even if the reader
+ * is destroyed first.
+ *
+ * Supported: pcap (micro and nanosecond, either byte order), pcapng
+ * (several sections and interfaces, if_tsresol / if_tsoffset, enhanced,
+ * simple and obsolete packet blocks). A truncated last record ends the file.
+ *
+ * @note read() must be called from one thread at a time, the counters may
+ *       be read from any thread.
+ */
+class CaptureFileReader {
+public:
+    enum class Format {
+        Pcap,
+        PcapNg
+    };
+
+    /**
+     * @brief Maps a capture file and checks its header.
+     * @param path File to read
+     * @return Reader positioned at the first packet, nullptr on error (logged)
+     */
+    static std::unique_ptr<CaptureFileReader> open(const std::string& path);
+
+    ~CaptureFileReader();
+
+    CaptureFileReader(const CaptureFileReader&) = delete;
+    CaptureFileReader& operator=(const CaptureFileReader&) = delete;
+    CaptureFileReader(CaptureFileReader&&) = delete;
+    CaptureFileReader& operator=(CaptureFileReader&&) = delete;
+
+    /**
+     * @brief Appends the next packets of the file, as one chunk.
+     * @param packets Receives up to maxPackets packets (sequence left at 0)
+     * @param maxPackets Chunk size
+     * @return Number of packets appended, 0 at the end of the file
+     */
+    std::size_t read(std::vector<packetscope::RawPacketData>& packets, std::size_t maxPackets);
+
+    /**
+     * @brief Returns true once every record was read (or the rest is unreadable).
+     */
+    bool isAtEnd() const;
+
+    /**
+     * @brief Returns the number of chunks with at least one frame still held by the pipeline.
+     *
+     * Bounds how far read() runs ahead of the workers.
+     */
+    std::size_t chunksInFlight() const;
+
+    Format format() const;
+    const std::string& path() const;
+    uint64_t fileSize() const;
+    uint64_t bytesRead() const;
+    uint64_t packetsRead() const;
+
+private:
+    /**
+     * @brief Interface of a pcapng section (pcap files have exactly one).
+     */
+    struct Interface {
+        pcpp::LinkLayerType linkLayerType{pcpp::LINKTYPE_ETHERNET};
+        uint32_t snapLength{0};
+        uint64_t ticksPerSecond{1000000};   ///< Timestamp units per second (if_tsresol)
+        int64_t offsetSeconds{0};           ///< Added to every timestamp (if_tsoffset)
+    };
+
+    /**
+     * @brief A packet record located in the mapping.
+     */
+    struct Record {
+        const uint8_t* data;
+        uint32_t capturedLength;
+        uint32_t originalLength;
+        timespec timestamp;
+        pcpp::LinkLayerType linkLayerType;
+    };
+
+    CaptureFileReader(std::string path, CaptureFileMapping* mapping);
+
+    /**
+     * @brief Parses the file header, sets format_ and the byte order.
+     */
+    bool readFileHeader();
+
+    /**
+     * @brief Locates the next packet record, skipping non packet blocks.
+     * @return false at the end of the file or on a malformed record (sets isAtEnd_)
+     */
+    bool nextRecord(Record& record);
+    bool nextPcapRecord(Record& record);
+    bool nextPcapNgRecord(Record& record);
+
+    /**
+     * @brief Parses the options of a pcapng interface description block.
+     */
+    void readInterfaceOptions(const uint8_t* options, std::size_t length, Interface& interface) const;
+
+    /**
+     * @brief Converts a timestamp in interface units to a timespec.
+     */
+    static timespec toTimespec(uint64_t ticks, const Interface& interface);
+
+    uint16_t read16(const uint8_t* data) const;
+    uint32_t read32(const uint8_t* data) const;
+    uint64_t read64(const uint8_t* data) const;
+
+    std::string path_;
+    CaptureFileMapping* mapping_;
+    const uint8_t* begin_;
+    std::size_t size_;
+    std::size_t offset_{0};
+
+    Format format_{Format::Pcap};
+    bool isSwapped_{false};
+    bool isAtEnd_{false};
+
+    /// pcap: the single interface; pcapng: interfaces of the current section
+    std::vector<Interface> interfaces_;
+
+    std::atomic<uint64_t> bytesRead_{0};
+    std::atomic<uint64_t> packetsRead_{0};
+};
+
+#endif
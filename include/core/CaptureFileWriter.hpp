@@ -0,0 +1,209 @@
+#ifndef CAPTUREFILEWRITER_HPP_
+#define CAPTUREFILEWRITER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Types.hpp"
+#include "PacketBufferPool.hpp"
+#include "PipelineConfig.hpp"
+#include "SpscRingBuffer.hpp"
+
+/**
+ * @file CaptureFileWriter.hpp
+ * @brief Streaming pcapng writer with file rotation.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Counters of a recording, see PipelineController::recordingStats().
+ */
+struct CaptureWriterStats {
+    uint64_t packetsWritten{};          ///< Packets handed to the disk
+    uint64_t bytesWritten{};            ///< File bytes written, headers included
+    uint64_t packetsDropped{};          ///< Lost to a full queue or a failed write
+    uint64_t filesWritten{};            ///< Files started so far
+    std::string currentFile;            ///< File being written, empty before the first packet
+};
+
+}
+
+/**
+ * @brief Records packets to a ring of pcapng files, off the capture path.
+ *
+ * offer() only queues a handle to the packet (the buffer is shared, not
+ * copied) into a bounded SPSC ring, so the producer never waits for the
+ * disk. Frames borrowed from a capture ring are the exception: they are
+ * copied into the writer's own pool first, otherwise a slow disk would keep
+ * the ring blocks referenced and the kernel would drop captured packets.
+ * Two threads do the rest:
+ *  - The encoder drains the ring and appends pcapng blocks to large write
+ *    buffers, one interface description per link type and file. It decides
+ *    when a file is rotated.
+ *  - The flusher write()s full buffers, opens the next file and deletes the
+ *    oldest one once CaptureWriterConfig::fileCount files exist.
+ *
+ * A handful of buffers circulate between the two, so encoding continues while
+ * a buffer is being written. When the disk falls behind, the ring fills up
+ * and its overflow policy drops packets (counted in the statistics).
+ * Partially filled buffers are written after kFlushInterval.
+ *
+ * @note offer() must be called from one thread at a time (the ring has a
+ *       single producer). Stopping is safe once that thread stopped offering.
+ */
+class CaptureFileWriter {
+public:
+    /**
+     * @brief Checks the configuration and starts the writer threads.
+     * @param config Output directory, rotation and queue settings
+     * @return Running writer, nullptr if the directory is not writable (logged)
+     */
+    static std::unique_ptr<CaptureFileWriter> start(packetscope::CaptureWriterConfig config);
+
+    /**
+     * @brief Writes everything queued and closes the current file.
+     */
+    ~CaptureFileWriter();
+
+    CaptureFileWriter(const CaptureFileWriter&) = delete;
+    CaptureFileWriter& operator=(const CaptureFileWriter&) = delete;
+    CaptureFileWriter(CaptureFileWriter&&) = delete;
+    CaptureFileWriter& operator=(CaptureFileWriter&&) = delete;
+
+    /**
+     * @brief Queues a packet for writing (producer only).
+     * @return false if the queue's overflow policy dropped it
+     */
+    bool offer(const packetscope::RawPacketData& packet);
+
+    /**
+     * @brief Returns the counters of this recording.
+     */
+    packetscope::CaptureWriterStats stats() const;
+
+    const packetscope::CaptureWriterConfig& config() const;
+
+private:
+    /// Buffers circulating between encoder and flusher
+    static constexpr std::size_t kBufferCount = 4;
+
+    /// Longest time a packet waits in a partially filled buffer
+    static constexpr std::chrono::milliseconds kFlushInterval{1000};
+
+    /// How long the idle encoder parks before it checks for stop and flush
+    static constexpr std::chrono::milliseconds kIdleWait{100};
+
+    /**
+     * @brief Bytes bound for one file, handed from encoder to flusher.
+     */
+    struct WriteBuffer {
+        std::vector<uint8_t> bytes;
+        uint64_t packets{0};
+        std::string openPath;           ///< Set on the first buffer of a file
+        bool isFileEnd{false};          ///< Last buffer of its file
+    };
+
+    explicit CaptureFileWriter(packetscope::CaptureWriterConfig config);
+
+    /**
+     * @brief Encoder thread: ring -> pcapng blocks in write buffers.
+     */
+    void encoderLoop();
+
+    /**
+     * @brief Flusher thread: write buffers -> files.
+     */
+    void flusherLoop();
+
+    /**
+     * @brief Appends one packet, rotating the file first if it is due (encoder only).
+     */
+    void encode(const packetscope::RawPacketData& packet);
+
+    /**
+     * @brief Starts a new file: names it and appends the section header (encoder only).
+     */
+    void beginFile();
+
+    /**
+     * @brief Hands the current buffer to the flusher, optionally ending the file (encoder only).
+     */
+    void submitBuffer(bool isFileEnd);
+
+    /**
+     * @brief Makes sure the current buffer has room for bytes more (encoder only).
+     */
+    void reserve(std::size_t bytes);
+
+    /**
+     * @brief Takes a free buffer, waiting for the flusher if every buffer is in use (encoder only).
+     */
+    std::unique_ptr<WriteBuffer> acquireBuffer();
+
+    /**
+     * @brief Returns the pcapng interface ID of a link type in the current file.
+     *
+     * Appends an interface description block the first time the link type
+     * is seen in the file (encoder only).
+     */
+    uint32_t interfaceFor(pcpp::LinkLayerType linkLayerType);
+
+    /**
+     * @brief Writes a buffer to the current file, opening and rotating files (flusher only).
+     */
+    void writeBuffer(const WriteBuffer& buffer);
+
+    packetscope::CaptureWriterConfig config_;
+    std::size_t bufferCapacity_;
+
+    /// Copies of borrowed frames, filled by offer(), released by the encoder
+    std::shared_ptr<PacketBufferPool> bufferPool_;
+
+    SpscRingBuffer<packetscope::RawPacketData> queue_;
+
+    // Encoder state
+    std::unique_ptr<WriteBuffer> current_;
+    bool isFileOpen_{false};
+    uint64_t fileBytes_{0};
+    uint64_t filePackets_{0};
+    uint64_t fileIndex_{0};
+    std::chrono::steady_clock::time_point fileOpenedAt_;
+    std::chrono::steady_clock::time_point bufferStartedAt_;
+    std::vector<pcpp::LinkLayerType> interfaces_;   ///< Index is the interface ID of the current file
+
+    // Buffers between encoder and flusher, guarded by bufferMutex_
+    std::mutex bufferMutex_;
+    std::condition_variable bufferCondition_;
+    std::vector<std::unique_ptr<WriteBuffer>> freeBuffers_;
+    std::deque<std::unique_ptr<WriteBuffer>> fullBuffers_;
+    bool isEncoderFinished_{false};
+
+    // Flusher state
+    int fileFd_{-1};
+    bool isWriteFailed_{false};
+    std::deque<std::string> ringFiles_;     ///< Files of the ring, oldest first
+
+    std::atomic<bool> isStopRequested_{false};
+    std::atomic<uint64_t> packetsWritten_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> packetsFailed_{0};
+    std::atomic<uint64_t> filesWritten_{0};
+
+    mutable std::mutex currentFileMutex_;
+    std::string currentFile_;
+
+    std::thread encoderThread_;
+    std::thread flusherThread_;
+};
+
+#endif
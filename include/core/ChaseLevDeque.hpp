@@ -0,0 +1,182 @@
+#ifndef CHASELEVDEQUE_HPP_
+#define CHASELEVDEQUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Lock-free work-stealing deque (Chase-Lev).
+ *
+ * One owner thread pushes and pops at the bottom (LIFO), any number of
+ * thieves steal from the top (FIFO). The buffer grows when full, old
+ * buffers are kept until destruction because a thief may still read them.
+ *
+ * Memory ordering follows Le, Pop, Cohen, Zappa Nardelli: "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ *
+ * @tparam T Element type, stored by pointer (ownership stays with the caller)
+ */
+template <typename T>
+class ChaseLevDeque {
+public:
+    /// Default initial capacity, must be a power of two
+    static constexpr std::size_t kDefaultCapacity = 256;
+
+    /// Keeps top_, bottom_ and buffer_ on separate cache lines
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    /**
+     * @brief Constructs an empty deque.
+     * @param capacity Initial capacity, rounded up to a power of two
+     */
+    explicit ChaseLevDeque(std::size_t capacity = kDefaultCapacity) {
+        std::size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        buffers_.push_back(std::make_unique<Buffer>(rounded));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+    ChaseLevDeque(ChaseLevDeque&&) = delete;
+    ChaseLevDeque& operator=(ChaseLevDeque&&) = delete;
+
+    /**
+     * @brief Pushes an element at the bottom.
+     * @note Owner thread only.
+     */
+    void push(T* item) {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+        if (bottom - top > buffer->mask) {
+            buffer = grow(buffer, top, bottom);
+        }
+
+        buffer->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pops the most recently pushed element.
+     * @note Owner thread only.
+     * @return nullptr if the deque is empty (or the last element was stolen)
+     */
+    T* pop() {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // Empty, restore bottom
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = buffer->get(bottom);
+        if (top == bottom) {
+            // Last element, race against thieves for it
+            if (!top_.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief Steals the oldest element.
+     *
+     * Safe to call from any thread.
+     *
+     * @return nullptr if the deque is empty or another thread won the race
+     */
+    T* steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        T* item = buffer->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /**
+     * @brief Returns an estimate of the number of elements.
+     * Intended for monitoring and diagnostic purposes only.
+     */
+    std::size_t size() const {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
+
+private:
+    /**
+     * @brief Circular array of element pointers.
+     */
+    struct Buffer {
+        explicit Buffer(std::size_t capacity)
+            : mask(static_cast<int64_t>(capacity) - 1)
+            , slots(std::make_unique<std::atomic<T*>[]>(capacity)) {}
+
+        T* get(int64_t index) const {
+            return slots[static_cast<std::size_t>(index & mask)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T* item) {
+            slots[static_cast<std::size_t>(index & mask)].store(item, std::memory_order_relaxed);
+        }
+
+        const int64_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    /**
+     * @brief Doubles the buffer, copying the live range [top, bottom).
+     * @note Owner thread only.
+     */
+    Buffer* grow(Buffer* old, int64_t top, int64_t bottom) {
+        auto grown = std::make_unique<Buffer>(static_cast<std::size_t>(old->mask + 1) * 2);
+        for (int64_t index = top; index < bottom; ++index) {
+            grown->put(index, old->get(index));
+        }
+
+        Buffer* buffer = grown.get();
+        buffers_.push_back(std::move(grown));
+        buffer_.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+
+    /// Index of the oldest element, advanced by thieves and the last pop
+    alignas(kCacheLineSize) std::atomic<int64_t> top_{0};
+
+    /// Index one past the newest element, owner only
+    alignas(kCacheLineSize) std::atomic<int64_t> bottom_{0};
+
+    /// Current buffer
+    alignas(kCacheLineSize) std::atomic<Buffer*> buffer_{nullptr};
+
+    /// Every buffer ever used (owner only), retired ones may still be read by thieves
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+#endif
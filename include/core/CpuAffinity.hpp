@@ -0,0 +1,59 @@
+#ifndef CPUAFFINITY_HPP_
+#define CPUAFFINITY_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Thread pinning and NUMA topology helpers (Linux).
+ *
+ * Topology is read from sysfs, so no libnuma dependency is needed. Memory
+ * placement relies on the kernel's first touch policy: a thread pinned to
+ * the CPUs of a node allocates (and first writes) its buffers on that node.
+ */
+class CpuAffinity {
+public:
+    CpuAffinity() = delete;
+
+    /**
+     * @brief Returns the number of hardware threads, at least 1.
+     */
+    static std::size_t hardwareThreads();
+
+    /**
+     * @brief Restricts the calling thread to the given CPUs.
+     *
+     * @param cpus CPU indices, an empty list leaves the affinity unchanged
+     * @return true if the affinity was applied (or nothing to apply)
+     */
+    static bool pinCurrentThread(const std::vector<int>& cpus);
+
+    /**
+     * @brief Returns the NUMA node a network device is attached to.
+     *
+     * Reads /sys/class/net/<device>/device/numa_node.
+     *
+     * @param deviceName Network device name (eth0, wlan0, etc.)
+     * @return Node index or -1 if unknown (virtual device, single node system)
+     */
+    static int deviceNumaNode(const std::string& deviceName);
+
+    /**
+     * @brief Returns the CPUs of a NUMA node.
+     *
+     * Parses /sys/devices/system/node/node<N>/cpulist (e.g. "0-7,16-23").
+     *
+     * @param node NUMA node index
+     * @return CPU indices, empty if the node does not exist
+     */
+    static std::vector<int> numaNodeCpus(int node);
+
+    /**
+     * @brief Parses a kernel CPU list ("0-3,8,10-11").
+     * @return CPU indices in the listed order, empty on malformed input
+     */
+    static std::vector<int> parseCpuList(const std::string& cpuList);
+};
+
+#endif
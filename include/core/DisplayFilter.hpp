@@ -0,0 +1,110 @@
+#ifndef DISPLAYFILTER_HPP_
+#define DISPLAYFILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PacketStore.hpp"
+
+/**
+ * @file DisplayFilter.hpp
+ * @brief Wireshark style display filters over the summary columns of PacketStore.
+ */
+
+/// Compiled instructions of a filter, defined in the translation unit
+struct DisplayFilterProgram;
+
+/**
+ * @brief A display filter expression compiled into a column program.
+ *
+ * Syntax (a subset of Wireshark's):
+ *  - Fields: frame.number, frame.len, frame.cap_len, ip.src, ip.dst, ip.addr,
+ *    ip.proto, ipv6.src, ipv6.dst, ipv6.addr, tcp.port, tcp.srcport,
+ *    tcp.dstport, udp.port, udp.srcport, udp.dstport
+ *  - Protocols: ip, ipv6, tcp, udp, icmp, icmpv6, arp, dns, http, tls (ssl), ssh, ftp
+ *  - Comparisons: == != < <= > >= (or eq ne lt le gt ge). Addresses only
+ *    take == and !=, with an optional CIDR prefix (10.0.0.0/8)
+ *  - Logic: && || ! (or and, or, not) and parentheses
+ *
+ * A field on its own tests for its presence, a comparison is false for
+ * packets without the field. Fields present twice (ip.addr, tcp.port) match
+ * if either occurrence matches, != if neither is equal.
+ *
+ * Instead of walking an expression tree per packet and field, compile()
+ * turns the expression into a postfix program. Every instruction runs over
+ * a whole column of a segment (one tight loop over an array, e.g. all
+ * destination ports) into a byte mask, logic instructions combine masks.
+ * filter() runs the program over segment sized chunks on several threads.
+ *
+ * If the store keeps a PacketIndex, compile() also derives the posting
+ * lists that cover the expression (ip.addr == host, tcp.port == 443, dns,
+ * combined with && and ||). While these hold few packets of the range only
+ * those are tested, so looking up one host among millions of packets does
+ * not touch the other rows.
+ *
+ * @note A compiled filter is immutable and may be used by any number of threads.
+ */
+class DisplayFilter {
+public:
+    /**
+     * @brief Compiles a filter expression.
+     * @param expression e.g. "ip.src == 10.0.0.0/8 && tcp.port == 443"
+     * @return Compiled filter, nullptr if the expression is invalid (logged)
+     */
+    static std::shared_ptr<const DisplayFilter> compile(const std::string& expression);
+
+    ~DisplayFilter();
+
+    DisplayFilter(const DisplayFilter&) = delete;
+    DisplayFilter& operator=(const DisplayFilter&) = delete;
+    DisplayFilter(DisplayFilter&&) = delete;
+    DisplayFilter& operator=(DisplayFilter&&) = delete;
+
+    /**
+     * @brief Returns the IDs of the matching packets in [firstId, lastId], in ID order.
+     *
+     * Ranges spanning several segments are split into segment chunks, which
+     * up to threadCount threads (the caller included) take in turn. Smaller
+     * ranges, e.g. the packets that arrived since the last refresh, are
+     * filtered on the calling thread.
+     *
+     * @param store Store to read the columns from
+     * @param firstId First ID to test
+     * @param lastId Last ID to test (inclusive)
+     * @param threadCount Threads to use, 0 for one per hardware thread
+     */
+    std::vector<int> filter(const PacketStore& store, int firstId, int lastId, std::size_t threadCount = 0) const;
+
+    const std::string& expression() const;
+
+private:
+    /// One mask per program stack level, kSegmentSize bytes each
+    using MaskStack = std::vector<std::vector<uint8_t>>;
+
+    DisplayFilter(std::string expression, std::unique_ptr<DisplayFilterProgram> program);
+
+    /**
+     * @brief Runs the program over one chunk and appends the IDs of stored, matching packets.
+     */
+    void evaluate(const PacketColumns& columns, MaskStack& stack, std::vector<int>& ids) const;
+
+    /**
+     * @brief Tests only the packets of the expression's index keys, if the store is indexed and they are sparse.
+     * @return First ID of the range left to scan, firstId if the index was not used
+     */
+    int filterIndexed(const PacketStore& store, int firstId, int lastId, std::vector<int>& ids) const;
+
+    /**
+     * @brief Runs the program over every packet of the range, see filter().
+     */
+    void scanRange(const PacketStore& store, int firstId, int lastId, std::size_t threadCount,
+                   std::vector<int>& ids) const;
+
+    std::string expression_;
+    std::unique_ptr<DisplayFilterProgram> program_;
+};
+
+#endif
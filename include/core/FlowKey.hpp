@@ -0,0 +1,93 @@
+#ifndef FLOWKEY_HPP_
+#define FLOWKEY_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <RawPacket.h>
+
+#include "PacketAddress.hpp"
+
+/**
+ * @file FlowKey.hpp
+ * @brief Direction independent 5-tuple of an IP conversation.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Sequence number and payload of a TCP segment, pointing into the frame bytes.
+ */
+struct TcpSegment {
+    uint32_t sequence{};
+    uint8_t flags{};                    ///< FIN = 0x01 ... CWR = 0x80
+    const uint8_t* payload{nullptr};    ///< First payload byte, nullptr if none was captured
+    std::size_t capturedSize{};         ///< Payload bytes present in the frame
+    std::size_t payloadSize{};          ///< Payload bytes on the wire (from the IP length), at least capturedSize
+};
+
+/**
+ * @brief Symmetric 5-tuple identifying a flow.
+ *
+ * Both directions of a conversation map to the same key: the endpoint
+ * (address, port) that compares lower is always stored as A. Built straight
+ * from the raw bytes by fromRawPacket(), without running PcapPlusPlus.
+ */
+struct FlowKey {
+    std::array<uint8_t, PacketAddress::kMaxSize> addressA{};
+    std::array<uint8_t, PacketAddress::kMaxSize> addressB{};
+    uint16_t portA{};                               ///< 0 for protocols without ports
+    uint16_t portB{};
+    uint8_t ipProtocol{};                           ///< IANA protocol number (6 = TCP, 17 = UDP)
+    PacketAddress::Family family{PacketAddress::Family::None}; ///< IPv4 or IPv6
+
+    /**
+     * @brief Extracts the flow of a captured frame.
+     *
+     * Cheap pre-parse of the link, IP and transport headers: Ethernet (with
+     * up to two VLAN tags), Linux cooked capture, BSD loopback and raw IP
+     * link layers, IPv4 and IPv6 (skipping the common extension headers),
+     * ports of TCP, UDP and SCTP. Non first IPv4 fragments get port 0.
+     *
+     * @param data Frame bytes, starting at the link layer header
+     * @param length Number of captured bytes
+     * @param linkLayerType Link layer of the capture
+     * @param key Filled on success
+     * @param isReversed Optional, set to true if the packet travels from B to A
+     * @param tcpFlags Optional, set to the TCP flags byte (FIN = 0x01 ... CWR = 0x80), 0 if not TCP
+     * @param tcpSegment Optional, filled for TCP packets whose header was captured, reset (no payload) otherwise
+     * @return false for non IP or truncated packets
+     */
+    static bool fromRawPacket(const uint8_t* data, std::size_t length, pcpp::LinkLayerType linkLayerType,
+                              FlowKey& key, bool* isReversed = nullptr, uint8_t* tcpFlags = nullptr,
+                              TcpSegment* tcpSegment = nullptr);
+
+    /**
+     * @brief Returns a well mixed 64 bit hash, identical for both directions.
+     */
+    uint64_t hash() const;
+
+    bool operator==(const FlowKey& other) const {
+        return family == other.family && ipProtocol == other.ipProtocol
+            && portA == other.portA && portB == other.portB
+            && addressA == other.addressA && addressB == other.addressB;
+    }
+
+    bool operator!=(const FlowKey& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Hash functor for unordered containers.
+ */
+struct FlowKeyHash {
+    std::size_t operator()(const FlowKey& key) const {
+        return static_cast<std::size_t>(key.hash());
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef FLOWTABLE_HPP_
+#define FLOWTABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+#include <vector>
+
+#include "FlowKey.hpp"
+
+/**
+ * @file FlowTable.hpp
+ * @brief Per flow counters and the open addressing table that accumulates them.
+ */
+
+namespace packetscope {
+
+/// TCP header flag bits
+constexpr uint8_t kTcpFin = 0x01;
+constexpr uint8_t kTcpSyn = 0x02;
+constexpr uint8_t kTcpRst = 0x04;
+constexpr uint8_t kTcpAck = 0x10;
+
+/**
+ * @brief Converts a capture timestamp to nanoseconds since the epoch.
+ */
+inline int64_t toNanoseconds(const timespec& timestamp) {
+    return static_cast<int64_t>(timestamp.tv_sec) * 1000000000 + timestamp.tv_nsec;
+}
+
+/**
+ * @brief Connection statistics of one flow.
+ *
+ * Directions refer to the canonical FlowKey endpoints. Timestamps are
+ * nanoseconds since the epoch, 0 means "not seen".
+ */
+struct FlowStats {
+    FlowKey key;
+    uint64_t packetsAToB{};
+    uint64_t packetsBToA{};
+    uint64_t bytesAToB{};               ///< Frame (wire) lengths
+    uint64_t bytesBToA{};
+    int64_t firstSeenNs{};
+    int64_t lastSeenNs{};
+    int64_t synSeenNs{};                ///< Earliest SYN without ACK
+    int64_t synAckSeenNs{};             ///< Earliest SYN+ACK
+    uint8_t tcpFlags{};                 ///< OR of every TCP flags byte seen
+
+    uint64_t packets() const {
+        return packetsAToB + packetsBToA;
+    }
+
+    uint64_t bytes() const {
+        return bytesAToB + bytesBToA;
+    }
+
+    /**
+     * @brief Handshake RTT estimate, SYN to SYN+ACK as seen by the capture point.
+     * @return Nanoseconds, -1 if the handshake was not captured
+     */
+    int64_t handshakeRttNs() const {
+        if (synSeenNs == 0 || synAckSeenNs == 0 || synAckSeenNs < synSeenNs) {
+            return -1;
+        }
+        return synAckSeenNs - synSeenNs;
+    }
+
+    /**
+     * @brief Adds the counters of another partial view of the same flow.
+     */
+    void merge(const FlowStats& other);
+};
+
+}
+
+/**
+ * @brief Open addressing hash table of FlowStats, keyed by FlowKey.
+ *
+ * Linear probing over a power of two array of slots. Updating an existing
+ * flow or inserting a new one never allocates; the table only grows (doubling)
+ * when it is more than kMaxLoadPercent full, which is rare once its capacity
+ * matches the number of flows seen between two merges.
+ *
+ * @note Not thread safe, each worker owns its table (see FlowTracker).
+ */
+class FlowTable {
+public:
+    /// Default number of slots
+    static constexpr std::size_t kDefaultCapacity = 4096;
+
+    /// Grows beyond this fill level to keep probe sequences short
+    static constexpr std::size_t kMaxLoadPercent = 70;
+
+    /**
+     * @brief Constructs an empty table.
+     * @param capacity Initial number of slots, rounded up to a power of two
+     */
+    explicit FlowTable(std::size_t capacity = kDefaultCapacity);
+
+    FlowTable(const FlowTable&) = delete;
+    FlowTable& operator=(const FlowTable&) = delete;
+    FlowTable(FlowTable&&) = delete;
+    FlowTable& operator=(FlowTable&&) = delete;
+
+    /**
+     * @brief Accounts one packet to its flow.
+     *
+     * @param key Canonical flow key
+     * @param isReversed true if the packet travels from B to A
+     * @param timestampNs Capture time in nanoseconds since the epoch
+     * @param frameLength Wire length of the packet
+     * @param tcpFlags TCP flags byte, 0 for other protocols
+     */
+    void update(const packetscope::FlowKey& key, bool isReversed, int64_t timestampNs,
+                uint32_t frameLength, uint8_t tcpFlags);
+
+    /**
+     * @brief Calls visitor(const FlowStats&) for every flow, in no particular order.
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        for (const Slot& slot : slots_) {
+            if (slot.isUsed) {
+                visitor(slot.stats);
+            }
+        }
+    }
+
+    /**
+     * @brief Removes all flows, keeping the capacity.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of flows.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Returns the number of slots.
+     */
+    std::size_t capacity() const;
+
+private:
+    struct Slot {
+        uint64_t hash{};
+        bool isUsed{false};
+        packetscope::FlowStats stats;
+    };
+
+    /**
+     * @brief Returns the slot of key, claiming an empty one if the flow is new.
+     */
+    Slot& findOrInsert(const packetscope::FlowKey& key, uint64_t hash);
+
+    /**
+     * @brief Doubles the slot array and reinserts every flow.
+     */
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+    std::size_t size_{0};
+};
+
+#endif
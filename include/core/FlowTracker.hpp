@@ -0,0 +1,163 @@
+#ifndef FLOWTRACKER_HPP_
+#define FLOWTRACKER_HPP_
+
+#include "FlowTable.hpp"
+#include "PipelineConfig.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Connection statistics engine: per worker FlowTables and their merged global view.
+ *
+ * Every worker accumulates into its own shard, so the packet path never
+ * contends with other workers. Shards are drained into the global view at
+ * most once per merge interval: the merger swaps a shard's active table
+ * with an empty standby one (a pointer swap under the shard mutex) and folds
+ * the standby table into the global map without holding that mutex. Worker
+ * tables therefore only hold the flows seen since the last merge.
+ *
+ * In DispatchMode::FlowAffine a flow lives in a single shard; in
+ * DispatchMode::Batch its packets are spread over several shards and are
+ * combined by FlowStats::merge().
+ *
+ * Each merge also applies the FlowLimits to the global view: flows idle for
+ * idleTimeout (capture time) are dropped, and above maxFlows the least
+ * recently seen flows are evicted down to 7/8 of the limit, so the next
+ * merges only fold.
+ *
+ * @note update() may be called concurrently for different shards. reshard()
+ * must not run concurrently with update().
+ */
+class FlowTracker {
+public:
+    /// Default interval between two merges into the global view
+    static constexpr std::chrono::milliseconds kDefaultMergeInterval{1000};
+
+    /**
+     * @brief Constructs a tracker.
+     * @param shardCount Number of shards (one per worker), at least 1
+     * @param tableCapacity Initial slots of each worker table
+     * @param mergeInterval Minimum time between two merges triggered by mergeIfDue()
+     * @param limits Capacity and idle expiry of the global view
+     */
+    explicit FlowTracker(std::size_t shardCount = 1,
+                         std::size_t tableCapacity = FlowTable::kDefaultCapacity,
+                         std::chrono::milliseconds mergeInterval = kDefaultMergeInterval,
+                         const packetscope::FlowLimits& limits = {});
+
+    FlowTracker(const FlowTracker&) = delete;
+    FlowTracker& operator=(const FlowTracker&) = delete;
+    FlowTracker(FlowTracker&&) = delete;
+    FlowTracker& operator=(FlowTracker&&) = delete;
+
+    /**
+     * @brief Runs updater(FlowTable&) on a shard's active table.
+     *
+     * Meant to wrap a whole batch, so the (uncontended) shard mutex is taken
+     * once per batch rather than per packet.
+     *
+     * @param shard Shard index, taken modulo the shard count
+     */
+    template <typename Updater>
+    void update(std::size_t shard, Updater&& updater) {
+        Shard& target = *shards_[shard % shards_.size()];
+        std::lock_guard<std::mutex> lock(target.mutex);
+        updater(*target.active);
+    }
+
+    /**
+     * @brief Merges the shards if the merge interval has elapsed.
+     *
+     * Cheap when not due (one atomic load). Called by workers after each
+     * batch; if another thread is already merging, returns immediately.
+     */
+    void mergeIfDue();
+
+    /**
+     * @brief Merges the shards now and returns every flow of the global view.
+     */
+    std::vector<packetscope::FlowStats> flows();
+
+    /**
+     * @brief Merges the shards now and returns the flows with the most bytes.
+     * @param count Maximum number of flows
+     * @return Flows sorted by total bytes, largest first
+     */
+    std::vector<packetscope::FlowStats> topFlows(std::size_t count);
+
+    /**
+     * @brief Returns the number of flows in the global view (as of the last merge).
+     */
+    std::size_t flowCount() const;
+
+    /**
+     * @brief Removes every flow from the shards and the global view.
+     */
+    void clear();
+
+    /**
+     * @brief Merges pending flows into the global view and recreates the shards.
+     *
+     * Used when the worker pool is recreated with a different size.
+     *
+     * @note Only while no thread is inside update().
+     */
+    void reshard(std::size_t shardCount, std::size_t tableCapacity, std::chrono::milliseconds mergeInterval,
+                 const packetscope::FlowLimits& limits);
+
+private:
+    /**
+     * @brief One worker's double buffered table.
+     */
+    struct Shard {
+        explicit Shard(std::size_t capacity)
+            : active(std::make_unique<FlowTable>(capacity))
+            , standby(std::make_unique<FlowTable>(capacity)) {}
+
+        std::mutex mutex;
+        std::unique_ptr<FlowTable> active;      ///< Guarded by mutex
+        std::unique_ptr<FlowTable> standby;     ///< Guarded by mergeMutex_
+    };
+
+    /**
+     * @brief Drains every shard into global_.
+     * @note Caller must hold mergeMutex_.
+     */
+    void mergeLocked();
+
+    /**
+     * @brief Drops idle flows and evicts the least recently seen ones above maxFlows.
+     * @note Caller must hold mergeMutex_.
+     */
+    void pruneLocked();
+
+    /**
+     * @brief Schedules the next mergeIfDue().
+     */
+    void scheduleNextMerge();
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    // Global view, guarded by mergeMutex_
+    std::unordered_map<packetscope::FlowKey, packetscope::FlowStats, packetscope::FlowKeyHash> global_;
+    mutable std::mutex mergeMutex_;
+
+    std::chrono::milliseconds mergeInterval_;
+    packetscope::FlowLimits limits_;
+
+    // Capture clock of the idle expiry, guarded by mergeMutex_
+    int64_t newestSeenNs_{0};
+    int64_t nextExpiryNs_{0};
+
+    /// steady_clock time (ns) at which mergeIfDue() merges next
+    std::atomic<int64_t> nextMergeNs_{0};
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef METRICSEXPORTER_HPP_
+#define METRICSEXPORTER_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "PipelineConfig.hpp"
+#include "PipelineMetrics.hpp"
+
+/**
+ * @brief Writes pipeline metrics to a file at a fixed interval, off the pipeline threads.
+ *
+ * Meant for the node_exporter textfile collector (Prometheus format) or any
+ * tool tailing a JSON file. Each snapshot is written to "<path>.tmp" and
+ * renamed over path, so readers only ever see complete snapshots. A last
+ * snapshot is written when the exporter is destroyed.
+ */
+class MetricsExporter {
+public:
+    /// Takes a snapshot, called on the exporter thread
+    using Source = std::function<packetscope::PipelineMetricsSnapshot()>;
+
+    /**
+     * @brief Writes a first snapshot and starts the exporter thread.
+     * @param config Output file, format and interval
+     * @param source Provides the snapshots
+     * @return Running exporter, nullptr if the file cannot be written (logged)
+     */
+    static std::unique_ptr<MetricsExporter> start(packetscope::MetricsExportConfig config, Source source);
+
+    /**
+     * @brief Stops the thread and writes the final snapshot.
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+    MetricsExporter(MetricsExporter&&) = delete;
+    MetricsExporter& operator=(MetricsExporter&&) = delete;
+
+    const packetscope::MetricsExportConfig& config() const;
+
+private:
+    MetricsExporter(packetscope::MetricsExportConfig config, Source source);
+
+    /**
+     * @brief Exporter thread: one snapshot per interval until stopped.
+     */
+    void exportLoop();
+
+    /**
+     * @brief Takes a snapshot and replaces the file with it.
+     * @return false if the file could not be written (logged)
+     */
+    bool writeSnapshot();
+
+    packetscope::MetricsExportConfig config_;
+    Source source_;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCondition_;
+    bool isStopRequested_{false};   ///< Guarded by stopMutex_
+    std::thread exportThread_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef PACKETADDRESS_HPP_
+#define PACKETADDRESS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * @file PacketAddress.hpp
+ * @brief Fixed size binary storage for MAC, IPv4 and IPv6 addresses.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Source or destination address of a packet in binary form.
+ *
+ * 16 bytes of storage plus a family tag (17 bytes, no heap allocation) instead
+ * of a formatted std::string. Text is only produced by toString() when a row
+ * is displayed.
+ */
+struct PacketAddress {
+    /**
+     * @brief Kind of address held in bytes.
+     */
+    enum class Family : uint8_t {
+        None,       ///< No address layer found
+        Mac,        ///< 6 bytes
+        IPv4,       ///< 4 bytes, network byte order
+        IPv6        ///< 16 bytes, network byte order
+    };
+
+    /// Largest address (IPv6)
+    static constexpr std::size_t kMaxSize = 16;
+
+    std::array<uint8_t, kMaxSize> bytes{};
+    Family family{Family::None};
+
+    /**
+     * @brief Creates an address from raw bytes.
+     * @param family Address family
+     * @param data Address bytes, size(family) bytes are read
+     */
+    static PacketAddress from(Family family, const uint8_t* data) {
+        PacketAddress address;
+        address.family = family;
+        if (data) {
+            std::memcpy(address.bytes.data(), data, size(family));
+        }
+        return address;
+    }
+
+    /**
+     * @brief Returns the number of significant bytes of a family.
+     */
+    static constexpr std::size_t size(Family family) {
+        switch (family) {
+            case Family::Mac:   return 6;
+            case Family::IPv4:  return 4;
+            case Family::IPv6:  return 16;
+            case Family::None:  return 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Formats the address for display.
+     *
+     * MAC as aa:bb:cc:dd:ee:ff, IPv4 dotted decimal, IPv6 in RFC 5952 form.
+     *
+     * @return Display string, empty for Family::None
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Returns a well mixed 64 bit hash of family and bytes.
+     */
+    uint64_t hash() const;
+
+    bool operator==(const PacketAddress& other) const {
+        return family == other.family && bytes == other.bytes;
+    }
+
+    bool operator!=(const PacketAddress& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Hash functor for unordered containers.
+ */
+struct PacketAddressHash {
+    std::size_t operator()(const PacketAddress& address) const {
+        return static_cast<std::size_t>(address.hash());
+    }
+};
+
+}
+
+#endif
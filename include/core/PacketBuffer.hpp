@@ -0,0 +1,159 @@
+#ifndef PACKETBUFFER_HPP_
+#define PACKETBUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @file PacketBuffer.hpp
+ * @brief Reference counted handle to packet bytes owned by a buffer pool.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Control block shared by every handle referring to the same bytes.
+ *
+ * The owner (e.g. PacketBufferPool) fills in the data pointer, capacity and
+ * the release hook. When the last PacketBuffer referring to this block goes
+ * away, release(header) is invoked so the owner can recycle the memory.
+ */
+struct BufferHeader {
+    std::atomic<uint32_t> refs{0};          ///< Number of live PacketBuffer handles
+    uint32_t size{};                        ///< Number of valid bytes
+    uint32_t capacity{};                    ///< Usable bytes at data
+    uint8_t* data{nullptr};                 ///< Start of the packet bytes
+    void (*release)(BufferHeader*){nullptr};///< Invoked when refs drops to zero
+    void* owner{nullptr};                   ///< Opaque pointer for the release hook
+    bool isBorrowed{false};                 ///< Bytes belong to a capture ring, see PacketBuffer::isBorrowed()
+};
+
+/**
+ * @brief Shared, immutable view of captured packet bytes.
+ *
+ * Copying a PacketBuffer only increments a reference count, so RawPacketData
+ * and ParsedPacket can refer to the same bytes without a memcpy. The bytes are
+ * written once by the producer (before the handle is shared) and are read only
+ * afterwards.
+ *
+ * @note Copies may be destroyed concurrently from different threads.
+ */
+class PacketBuffer {
+public:
+    PacketBuffer() = default;
+
+    /**
+     * @brief Adopts a control block and takes one reference to it.
+     * @param header Control block prepared by the owning pool
+     */
+    explicit PacketBuffer(BufferHeader* header) noexcept
+        : header_(header) {
+        if (header_) {
+            header_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ~PacketBuffer() {
+        reset();
+    }
+
+    PacketBuffer(const PacketBuffer& other) noexcept
+        : PacketBuffer(other.header_) {}
+
+    PacketBuffer& operator=(const PacketBuffer& other) noexcept {
+        if (this != &other) {
+            PacketBuffer(other).swap(*this);
+        }
+        return *this;
+    }
+
+    PacketBuffer(PacketBuffer&& other) noexcept
+        : header_(std::exchange(other.header_, nullptr)) {}
+
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            header_ = std::exchange(other.header_, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Drops this handle's reference, releasing the bytes if it was the last one.
+     */
+    void reset() noexcept {
+        BufferHeader* header = std::exchange(header_, nullptr);
+        if (header && header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            header->release(header);
+        }
+    }
+
+    void swap(PacketBuffer& other) noexcept {
+        std::swap(header_, other.header_);
+    }
+
+    const uint8_t* data() const noexcept {
+        return header_ ? header_->data : nullptr;
+    }
+
+    /**
+     * @brief Writable access for the producer that filled the buffer.
+     *
+     * Must only be used before the handle is shared with other threads.
+     */
+    uint8_t* mutableData() noexcept {
+        return header_ ? header_->data : nullptr;
+    }
+
+    std::size_t size() const noexcept {
+        return header_ ? header_->size : 0;
+    }
+
+    std::size_t capacity() const noexcept {
+        return header_ ? header_->capacity : 0;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    const uint8_t& operator[](std::size_t index) const noexcept {
+        return header_->data[index];
+    }
+
+    const uint8_t* begin() const noexcept {
+        return data();
+    }
+
+    const uint8_t* end() const noexcept {
+        return data() + size();
+    }
+
+    /**
+     * @brief Returns true if the bytes are lent by a capture ring.
+     *
+     * Borrowed bytes (e.g. a TPACKET_V3 frame) are only valid while the
+     * handle lives, and the ring cannot reuse them before every handle is
+     * gone. Copy them before keeping the packet for longer than processing.
+     */
+    bool isBorrowed() const noexcept {
+        return header_ && header_->isBorrowed;
+    }
+
+    /**
+     * @brief Returns the number of handles sharing these bytes.
+     * Intended for diagnostics only.
+     */
+    uint32_t useCount() const noexcept {
+        return header_ ? header_->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    BufferHeader* header_{nullptr};
+};
+
+}
+
+#endif
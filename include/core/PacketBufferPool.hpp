@@ -0,0 +1,144 @@
+#ifndef PACKETBUFFERPOOL_HPP_
+#define PACKETBUFFERPOOL_HPP_
+
+#include "core/PacketBuffer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Recycling slab allocator for packet bytes.
+ *
+ * Memory is carved out of large slabs of fixed-size slots (one slot per
+ * packet, sized for MTU/snaplen). A slot returns to the free list as soon as
+ * the last PacketBuffer referring to it is destroyed, so steady-state capture
+ * performs no heap allocation at all: new slabs are only allocated when every
+ * existing slot is in use.
+ *
+ * Packets larger than the slot size (e.g. GRO/TSO super frames on loopback)
+ * fall back to a dedicated heap buffer so they are never truncated.
+ *
+ * Lifetime:
+ *   The pool is reference counted by its owner AND by every outstanding slot,
+ *   so buffers still held by PacketStore or the UI stay valid after the owner
+ *   drops its std::shared_ptr. The pool is destroyed with its last buffer.
+ *
+ * Thread Safety:
+ *   - acquire() may be called from any thread (typically the capture thread)
+ *   - Buffers may be released from any thread
+ */
+class PacketBufferPool {
+public:
+    /// Default slot size, enough for a full Ethernet frame with VLAN tags
+    static constexpr std::size_t kDefaultSlotSize = 2048;
+
+    /// Default number of slots allocated at once when the pool runs dry
+    static constexpr std::size_t kDefaultSlotsPerSlab = 4096;
+
+    /**
+     * @brief Creates a new pool.
+     *
+     * @param slotSize     Bytes per slot, packets larger than this use the heap
+     * @param slotsPerSlab Number of slots allocated per slab
+     * @return Shared pointer to the pool
+     */
+    static std::shared_ptr<PacketBufferPool> create(std::size_t slotSize = kDefaultSlotSize,
+                                                    std::size_t slotsPerSlab = kDefaultSlotsPerSlab);
+
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+    PacketBufferPool(PacketBufferPool&&) = delete;
+    PacketBufferPool& operator=(PacketBufferPool&&) = delete;
+
+    /**
+     * @brief Acquires a buffer able to hold size bytes.
+     *
+     * The returned buffer reports size() == size, its contents are undefined
+     * and must be filled through mutableData() before the handle is shared.
+     *
+     * @param size Number of bytes the caller is going to write
+     * @return Buffer handle
+     */
+    packetscope::PacketBuffer acquire(std::size_t size);
+
+    /**
+     * @brief Acquires a buffer and copies the given bytes into it.
+     *
+     * @param data Source bytes
+     * @param size Number of bytes to copy
+     * @return Buffer handle holding a copy of the bytes
+     */
+    packetscope::PacketBuffer copyFrom(const uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Returns the size of a single slot in bytes.
+     */
+    std::size_t slotSize() const;
+
+    /**
+     * @brief Returns the number of slabs allocated so far.
+     */
+    std::size_t slabCount() const;
+
+    /**
+     * @brief Returns the number of pooled slots currently referenced.
+     * Intended for monitoring purposes only.
+     */
+    std::size_t slotsInUse() const;
+
+private:
+    PacketBufferPool(std::size_t slotSize, std::size_t slotsPerSlab);
+    ~PacketBufferPool() = default;
+
+    /**
+     * @brief One contiguous block of slots and their control blocks.
+     */
+    struct Slab {
+        std::unique_ptr<uint8_t[]> storage;
+        std::unique_ptr<packetscope::BufferHeader[]> headers;
+    };
+
+    /**
+     * @brief Heap fallback for packets that do not fit into a slot.
+     */
+    struct OversizedBuffer {
+        packetscope::BufferHeader header;
+        std::unique_ptr<uint8_t[]> storage;
+    };
+
+    /**
+     * @brief Allocates a new slab and pushes its slots to the free list.
+     * @note Caller must hold mutex_.
+     */
+    void growLocked();
+
+    /**
+     * @brief Release hook of pooled slots, puts the slot back to the free list.
+     */
+    static void recycleSlot(packetscope::BufferHeader* header);
+
+    /**
+     * @brief Release hook of oversized buffers, frees the heap memory.
+     */
+    static void freeOversized(packetscope::BufferHeader* header);
+
+    /**
+     * @brief Drops one pool reference and destroys the pool on the last one.
+     */
+    void unref();
+
+    const std::size_t slotSize_;
+    const std::size_t slotsPerSlab_;
+
+    std::vector<Slab> slabs_;
+    std::vector<packetscope::BufferHeader*> freeList_;
+    mutable std::mutex mutex_;
+
+    /// One reference for the owner plus one per outstanding slot
+    std::atomic<std::size_t> refs_{1};
+    std::atomic<std::size_t> slotsInUse_{};
+};
+
+#endif
@@ -3,23 +3,52 @@
 
 #include <PcapLiveDeviceList.h>
 #include <atomic>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include "Types.hpp"
+#include "core/CaptureBackend.hpp"
+#include "core/PacketBufferPool.hpp"
+#include "core/PipelineConfig.hpp"
 
 /**
- * @brief Live packet capture helper based on PcapPlusPlus.
+ * @brief Live packet capture helper.
  *
  * PacketCapture provides a simple interface to:
  * - List available capture devices
  * - Start capturing packets on a selected device
- * - Receive raw packets via callback
+ * - Receive raw packets via callback, in batches
+ *
+ * The frames are read by a CaptureBackend chosen with setBackend():
+ * - Pcap (default): libpcap through PcapPlusPlus. Packet bytes are copied
+ *   straight from the libpcap buffer into a slot of the given
+ *   PacketBufferPool, so the capture thread never touches the heap
+ *   allocator in steady state.
+ * - TPacketV3 (Linux): an AF_PACKET mmap ring. A whole ring block is
+ *   delivered per wakeup and the frames are lent in place
+ *   (PacketBuffer::isBorrowed()), the pool is not used.
+ *
+ * Several PacketCaptures may share one device through a PF_PACKET fanout
+ * group (Linux), see setFanout(). The kernel then spreads the device's
+ * packets over the group members, each with its own capture thread.
  */
 class PacketCapture {
 public:
-    using CaptureCallback = std::function<void(packetscope::RawPacketData)>;
+    /**
+     * Receives the packets read in one go, on the capture thread. The callee
+     * moves the elements out. RawPacketData::sequence is left at 0, packets
+     * are numbered once the captures are merged (PipelineController).
+     */
+    using CaptureCallback = std::function<void(std::vector<packetscope::RawPacketData>&)>;
+
+    using FanoutGroup = CaptureBackend::FanoutGroup;
 
-    PacketCapture() = default;
+    /**
+     * @brief Constructs a capture helper.
+     * @param bufferPool Pool that captured packet bytes are copied into (Pcap backend)
+     */
+    explicit PacketCapture(std::shared_ptr<PacketBufferPool> bufferPool);
     ~PacketCapture();
     PacketCapture(const PacketCapture&) = delete;
     PacketCapture& operator=(const PacketCapture&) = delete;
@@ -30,7 +59,7 @@ public:
      * @brief List available live capture devices.
      * @return A vector of DeviceInfo containing device name and description.
      */
-    std::vector<packetscope::DeviceInfo> listAvailableDevices() const;
+    static std::vector<packetscope::DeviceInfo> listAvailableDevices();
 
     /**
      * @brief Starts asynchronous packet capture on the given network interface.
@@ -38,17 +67,61 @@ public:
      * Packets are captured asynchronously and delivered to the provided
      * callback function.
      *
-     * @note Packet capture runs in a background thread managed by PcapPlusPlus.
+     * @note Packet capture runs in a background thread owned by the backend
+     *       (PcapPlusPlus for the default Pcap backend).
      *       The callback is invoked from that background thread.
      *
      * @warning The callback must be thread safe.
      *
      * @param deviceName Name of the network interface to capture from
-     * @param callback   Function invoked for each captured packet
+     * @param callback   Function invoked for each batch of captured packets
      * @return true if capture started successfully, false otherwise
      */
     bool start(const std::string& deviceName, CaptureCallback callback);
 
+    /**
+     * @brief Selects the backend used by the next start().
+     * @param type Kernel interface to read from
+     * @param ringConfig Ring geometry, only used by TPacketV3
+     * @return false if capture is running (nothing changed)
+     */
+    bool setBackend(packetscope::CaptureBackendType type, packetscope::TPacketRingConfig ringConfig = {});
+
+    /**
+     * @brief Sets the CPUs the capture thread may run on.
+     *
+     * Applied by the capture thread of the next start(), from its first
+     * packet if the thread is created by PcapPlusPlus.
+     *
+     * @param cpus CPU indices, empty leaves the capture thread unpinned
+     * @return false if capture is running (nothing changed)
+     */
+    bool setThreadAffinity(std::vector<int> cpus);
+
+    /**
+     * @brief Makes the next start() join a PF_PACKET fanout group.
+     *
+     * With the Pcap backend a fanout member opens the device with libpcap
+     * directly, since PcapLiveDevice does not expose its socket.
+     * Only supported on Linux.
+     *
+     * @param group Group to join, std::nullopt captures every packet of the device
+     * @return false if capture is running (nothing changed)
+     */
+    bool setFanout(std::optional<FanoutGroup> group);
+
+    /**
+     * @brief Sets the kernel side filter and snap length.
+     *
+     * While running only the expression can change; it is replaced in the
+     * kernel without restarting the capture.
+     *
+     * @param filter BPF expression and snap length
+     * @return false if the filter cannot be installed, or the snap length
+     *         would change while running (nothing changed then)
+     */
+    bool setFilter(const packetscope::CaptureFilter& filter);
+
     /**
      * @brief Stop the current packet capture session.
      * Safe to call multiple times.
@@ -71,17 +144,40 @@ public:
      */
     void resetCapturedPacketCount();
 
+    /**
+     * @brief Returns the kernel's counters of every session since resetKernelStats().
+     *
+     * Includes the running session, if any. Packets counted as dropped here
+     * were lost before the capture callback saw them.
+     */
+    packetscope::KernelCaptureStats kernelStats();
+
+    /**
+     * @brief Resets the kernel counters of the past sessions (only while stopped).
+     */
+    void resetKernelStats();
+
 private:
     /**
-     * @brief Internal callback invoked by PcapPlusPlus for each captured packet.
+     * @brief Creates the backend selected by setBackend().
      */
-    static void onPacketArrives(pcpp::RawPacket* packet,
-                                pcpp::PcapLiveDevice* dev,
-                                void* cookie);
-    pcpp::PcapLiveDevice* device_{nullptr};
+    std::unique_ptr<CaptureBackend> createBackend() const;
+
+    std::shared_ptr<PacketBufferPool> bufferPool_;
+    std::unique_ptr<CaptureBackend> backend_;
     std::atomic<bool> isRunning_{false};
     CaptureCallback callback_;
     std::atomic<std::size_t> capturedPacketCount_{};
+
+    /// Kernel counters of the sessions stopped since resetKernelStats()
+    packetscope::KernelCaptureStats pastKernelStats_;
+
+    /// Backend created on the next start()
+    packetscope::CaptureBackendType backendType_{packetscope::CaptureBackendType::Pcap};
+    packetscope::TPacketRingConfig ringConfig_;
+
+    /// Thread placement, fanout membership and filter applied on the next start()
+    CaptureBackend::Options options_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,95 @@
+#ifndef PACKETDETAILCACHE_HPP_
+#define PACKETDETAILCACHE_HPP_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Small LRU cache of dissected layer details, keyed by packet ID.
+ *
+ * Selecting rows back and forth in the packet list would otherwise dissect
+ * the same packets again every time. Entries are handed out as shared
+ * pointers, so an evicted entry stays valid for whoever still holds it.
+ *
+ * @note Thread safe, all operations take an internal mutex.
+ */
+class PacketDetailCache {
+public:
+    /// Layer summaries of one packet, lowest layer first
+    using LayerDetails = std::vector<std::string>;
+
+    /// Default number of cached packets
+    static constexpr std::size_t kDefaultCapacity = 32;
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param capacity Maximum number of cached packets, 0 disables caching
+     */
+    explicit PacketDetailCache(std::size_t capacity = kDefaultCapacity);
+
+    PacketDetailCache(const PacketDetailCache&) = delete;
+    PacketDetailCache& operator=(const PacketDetailCache&) = delete;
+    PacketDetailCache(PacketDetailCache&&) = delete;
+    PacketDetailCache& operator=(PacketDetailCache&&) = delete;
+
+    /**
+     * @brief Looks up a packet and marks it as most recently used.
+     * @param id The packet ID
+     * @return Cached details or nullptr on a miss
+     */
+    std::shared_ptr<const LayerDetails> find(int id);
+
+    /**
+     * @brief Inserts (or replaces) the details of a packet.
+     *
+     * Evicts the least recently used entry when the cache is full.
+     *
+     * @param id The packet ID
+     * @param details Dissected layer summaries
+     */
+    void insert(int id, std::shared_ptr<const LayerDetails> details);
+
+    /**
+     * @brief Changes the capacity, evicting entries if it shrinks.
+     * @param capacity Maximum number of cached packets, 0 disables caching
+     */
+    void setCapacity(std::size_t capacity);
+
+    /**
+     * @brief Removes all entries.
+     *
+     * Must be called whenever packet IDs are reused (PacketStore::clear()).
+     */
+    void clear();
+
+    /**
+     * @brief Returns the current number of cached packets.
+     */
+    std::size_t size() const;
+
+private:
+    using Entry = std::pair<int, std::shared_ptr<const LayerDetails>>;
+
+    /**
+     * @brief Drops least recently used entries until size fits capacity_.
+     * @note Caller must hold mutex_.
+     */
+    void evictLocked();
+
+    /// Most recently used entry first
+    std::list<Entry> entries_;
+
+    /// Packet ID -> position in entries_
+    std::unordered_map<int, std::list<Entry>::iterator> index_;
+
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+};
+
+#endif
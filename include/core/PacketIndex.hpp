@@ -0,0 +1,161 @@
+#ifndef PACKETINDEX_HPP_
+#define PACKETINDEX_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <ProtocolType.h>
+
+#include "PacketAddress.hpp"
+#include "PacketStore.hpp"
+
+/**
+ * @file PacketIndex.hpp
+ * @brief Inverted indexes of PacketStore: packet IDs per address, port and protocol.
+ */
+
+/**
+ * @brief Posting lists of packet IDs keyed by the common lookup fields.
+ *
+ * Keys:
+ *  - Address: packets with it as source or destination
+ *  - Port: packets with it as source or destination port, per transport
+ *    protocol (TCP port 53 and UDP port 53 are different keys)
+ *  - Protocol: packets whose highest layer is it (the Protocol column)
+ *  - IP protocol: packets of a transport protocol (6 = TCP, 17 = UDP)
+ *
+ * Packets are added in ID order by PacketStore's background thread, right
+ * behind the watermark, so the workers storing packets never touch the
+ * index. Each posting list is a run of blocks of up to kBlockSize IDs,
+ * every ID after the first of a block stored as a varint delta, about one
+ * or two bytes per entry. Evicted packets are dropped block wise from the
+ * front.
+ *
+ * Lookups return the IDs in [firstId, lastId] up to indexedUntilId(), in
+ * ascending order; callers scan the packets stored after indexedUntilId()
+ * themselves. Decoding stops after maxIds + 1 IDs, so a caller that only
+ * wants sparse keys does not pay for decoding dense ones.
+ *
+ * @note Thread safe: one writer (the store), any number of readers.
+ */
+class PacketIndex {
+public:
+    /// maxIds of a lookup returning every ID
+    static constexpr std::size_t kUnlimited = ~std::size_t{0};
+
+    PacketIndex() = default;
+
+    PacketIndex(const PacketIndex&) = delete;
+    PacketIndex& operator=(const PacketIndex&) = delete;
+    PacketIndex(PacketIndex&&) = delete;
+    PacketIndex& operator=(PacketIndex&&) = delete;
+
+    /**
+     * @brief Adds the stored packets of a chunk, which must follow the ones added before.
+     */
+    void add(const PacketColumns& columns);
+
+    /**
+     * @brief Marks every ID up to id as indexed (also IDs skipped because they were evicted).
+     */
+    void setIndexedUntil(int id);
+
+    /**
+     * @brief Drops the entries of IDs below firstId, in whole blocks.
+     *
+     * Lists left empty are removed, so the number of keys follows the
+     * retained packets.
+     */
+    void eraseBefore(int firstId);
+
+    /**
+     * @brief Returns the packets with address as source or destination.
+     */
+    std::vector<int> addressIds(const packetscope::PacketAddress& address, int firstId, int lastId,
+                                std::size_t maxIds = kUnlimited) const;
+
+    /**
+     * @brief Returns the packets of ipProtocol with port as source or destination port.
+     */
+    std::vector<int> portIds(uint8_t ipProtocol, uint16_t port, int firstId, int lastId,
+                             std::size_t maxIds = kUnlimited) const;
+
+    /**
+     * @brief Returns the packets whose highest layer is protocol.
+     */
+    std::vector<int> protocolIds(pcpp::ProtocolType protocol, int firstId, int lastId,
+                                 std::size_t maxIds = kUnlimited) const;
+
+    /**
+     * @brief Returns the packets of a transport protocol.
+     */
+    std::vector<int> ipProtocolIds(uint8_t ipProtocol, int firstId, int lastId,
+                                   std::size_t maxIds = kUnlimited) const;
+
+    /**
+     * @brief Returns the highest ID covered by the index, 0 before the first add().
+     */
+    int indexedUntilId() const;
+
+    /**
+     * @brief Returns the heap bytes of all posting lists (approximately).
+     */
+    std::size_t memoryBytes() const;
+
+private:
+    /**
+     * @brief Ascending packet IDs, delta compressed in blocks.
+     */
+    class PostingList {
+    public:
+        /// Appends id, ignored if it is not above the last one (e.g. source == destination)
+        /// @return Heap bytes added
+        std::size_t append(int id);
+
+        /// Drops the leading blocks that only hold IDs below firstId
+        void eraseBefore(int firstId);
+
+        /// Appends the IDs in [firstId, lastId] to ids, stops once ids holds more than maxIds
+        void decode(int firstId, int lastId, std::size_t maxIds, std::vector<int>& ids) const;
+
+        bool isEmpty() const { return firstBlock_ == blocks_.size(); }
+        std::size_t memoryBytes() const;
+
+    private:
+        struct Block {
+            int firstId;
+            int lastId;
+            uint32_t offset;                ///< First delta in bytes_
+            uint32_t count;                 ///< IDs in the block, the first included
+        };
+
+        std::vector<Block> blocks_;
+        std::vector<uint8_t> bytes_;
+        std::size_t firstBlock_{0};         ///< Blocks before it are erased
+    };
+
+    /// IDs per block, a lookup skips whole blocks outside of its range
+    static constexpr uint32_t kBlockSize = 128;
+
+    /// Port key: transport protocol in the upper bits
+    static uint32_t portKey(uint8_t ipProtocol, uint16_t port) {
+        return static_cast<uint32_t>(ipProtocol) << 16 | port;
+    }
+
+    template <typename Map, typename Key>
+    std::vector<int> lookup(const Map& lists, const Key& key, int firstId, int lastId, std::size_t maxIds) const;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<packetscope::PacketAddress, PostingList, packetscope::PacketAddressHash> addresses_;
+    std::unordered_map<uint32_t, PostingList> ports_;
+    std::unordered_map<pcpp::ProtocolType, PostingList> protocols_;
+    std::unordered_map<uint8_t, PostingList> ipProtocols_;
+    std::atomic<int> indexedUntilId_{0};
+    std::atomic<std::size_t> memoryBytes_{0};
+};
+
+#endif
@@ -2,9 +2,14 @@
 #define PACKETPROCESSOR_HPP_
 
 #include "Types.hpp"
+#include "FlowTable.hpp"
+#include "TcpReassembler.hpp"
 
 #include <ProtocolType.h>
 
+#include <string>
+#include <vector>
+
 /**
  * @brief Parses raw captured packets into structured form for UI display.
  *
@@ -12,31 +17,58 @@
  * Output is ready for view.
  *
  * @note This class is stateless and thread safe. Multiple threads can call
- * process() simultaneously on the same instance.
+ * process() simultaneously on the same instance, each with its own FlowTable
+ * and TcpReassembler.
  */
 class PacketProcessor {
 public:
     /**
      * @brief Process a raw captured packet into a ParsedPacket.
      *
+     * Summary pass, runs for every captured packet.
      * Walks through all layers from lowes to highest
      * - Source/destination addresses (IP overwrites MAC if present)
      * - Protocol name (highest recognized layer, excluding payload)
-     * - Layer summaries for detail view (via PcapPlusPlus toString())
+     * - Transport protocol number and ports (FlowKey pre-parse of the raw bytes)
+     *
+     * Layer details are not formatted here, see dissect().
+     *
+     * If flowTable is given, the packet is also accounted to its flow
+     * (FlowKey pre-parse of the raw bytes, no allocation for known flows).
+     * If reassembler is given, a TCP segment's payload is added to its
+     * stream, from the same pre-parse.
      *
      * @param rawPacketData Raw packet bytes and capture metadata from PacketCapture
+     * @param flowTable Optional per worker flow table to update
+     * @param reassembler Optional per worker TCP reassembler to update
      * @return ParsedPacket containing all extracted information, ready for UI display
      */
-    packetscope::ParsedPacket process(const packetscope::RawPacketData& rawPacketData) const;
-private:
+    packetscope::ParsedPacket process(const packetscope::RawPacketData& rawPacketData,
+                                      FlowTable* flowTable = nullptr,
+                                      TcpReassembler* reassembler = nullptr) const;
+
+    /**
+     * @brief Detail pass, dissects a packet again for the detail view.
+     *
+     * Only called for the selected packet, so the per layer
+     * PcapPlusPlus toString() cost is not paid on the capture path.
+     *
+     * @param rawPacketData Raw packet bytes and link layer of a stored packet
+     * @return One summary string per protocol layer, lowest first
+     */
+    std::vector<std::string> dissect(const packetscope::RawPacketData& rawPacketData) const;
+
     /**
      * @brief Convert PcapPlusPlus protocol enum to string.
      *
+     * ParsedPacket keeps the enum, the text is only produced for displayed rows.
+     *
      * @param protocolType Protocol type from PcapPlusPlus
      * @return Display string
      */
     static std::string protocolTypeToString(pcpp::ProtocolType protocolType);
 
+private:
     /// Flag for pcpp::RawPacket constructor.
     constexpr static bool kDoNotDeleteRawData{false};
 };
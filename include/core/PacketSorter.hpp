@@ -0,0 +1,222 @@
+#ifndef PACKETSORTER_HPP_
+#define PACKETSORTER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PacketStore.hpp"
+
+/**
+ * @file PacketSorter.hpp
+ * @brief Background, incrementally updated sort order of PacketStore packets by a summary column.
+ */
+
+/**
+ * @brief Keeps the IDs of a set of packets sorted by one summary column.
+ *
+ * Packets are handed over with add() as they arrive, the sorting happens
+ * on a background thread: the caller never waits for a sort, it picks up
+ * the latest finished order with order() and shows the packets added
+ * since then unsorted until the next one.
+ *
+ * A pass reads the keys of the new packets from the store columns (one
+ * PacketStore::scan() per segment), sorts them in segment sized chunks
+ * on up to threadCount threads, merges the chunks pairwise (also in
+ * parallel) and finally merges them into the previous order, dropping
+ * evicted packets on the way. The first pass over a large store sorts
+ * everything; later ones cost a sort of the new packets plus one linear
+ * merge, so passes simply take longer and batch more packets under load.
+ *
+ * Equal keys are ordered by ID. The keys of the sorted packets are kept
+ * between passes, 24 bytes per packet plus, for every order handed out,
+ * 4 bytes per packet and 4 bytes per ID of its range (the inverse map).
+ *
+ * @note add(), evictBefore() and order() are thread safe.
+ */
+class PacketSorter {
+public:
+    /**
+     * @brief Summary column to sort by.
+     */
+    enum class Column {
+        Id,             ///< Packet ID, the capture order
+        Time,           ///< Capture timestamp
+        Source,         ///< Source address: MAC before IPv4 before IPv6, then by bytes
+        Destination,    ///< Destination address, like Source
+        Protocol,       ///< Protocol name, alphabetically
+        Length          ///< Frame length
+    };
+
+    /**
+     * @brief Result of a pass.
+     */
+    struct Order {
+        /// Entry of positions for an ID that is not in ids
+        static constexpr uint32_t kNoPosition = std::numeric_limits<uint32_t>::max();
+
+        /// IDs ascending by key, equal keys in ID order
+        std::vector<int> ids;
+
+        /// Inverse of ids: positions[id - firstPositionId] is the index of id in ids
+        std::vector<uint32_t> positions;
+        int firstPositionId{1};
+
+        /// Every packet added up to this ID is in ids (unless evicted before the pass)
+        int sortedUntilId{0};
+
+        /**
+         * @brief Returns the index of id in ids in O(1), -1 if the order does not hold it.
+         */
+        std::ptrdiff_t positionOf(int id) const {
+            if (id < firstPositionId || static_cast<std::size_t>(id - firstPositionId) >= positions.size()) {
+                return -1;
+            }
+            const uint32_t position = positions[static_cast<std::size_t>(id - firstPositionId)];
+            return position == kNoPosition ? -1 : static_cast<std::ptrdiff_t>(position);
+        }
+    };
+
+    /**
+     * @brief Starts the background thread, nothing is sorted before the first add().
+     * @param store Store to read the columns from, must not be cleared while the sorter exists
+     * @param column Column to sort by
+     * @param threadCount Threads of a pass (the background thread included), 0 for one per hardware thread
+     */
+    PacketSorter(std::shared_ptr<const PacketStore> store, Column column, std::size_t threadCount = 0);
+
+    /**
+     * @brief Stops the running pass (after its current chunk) and joins the background thread.
+     */
+    ~PacketSorter();
+
+    PacketSorter(const PacketSorter&) = delete;
+    PacketSorter& operator=(const PacketSorter&) = delete;
+    PacketSorter(PacketSorter&&) = delete;
+    PacketSorter& operator=(PacketSorter&&) = delete;
+
+    /**
+     * @brief Adds every stored packet after the previous add() up to lastId, returns at once.
+     */
+    void add(int lastId);
+
+    /**
+     * @brief Adds the listed packets, e.g. the matches of a display filter, returns at once.
+     * @param ids Ascending IDs, all after the previously added ones
+     * @param lastId Every ID up to this one has been offered (becomes Order::sortedUntilId)
+     */
+    void add(const std::vector<int>& ids, int lastId);
+
+    /**
+     * @brief Drops the packets below firstId from the next order.
+     */
+    void evictBefore(int firstId);
+
+    /**
+     * @brief Returns the latest finished order, nullptr before the first pass finished.
+     *
+     * The order stays valid as long as the pointer is held.
+     */
+    std::shared_ptr<const Order> order() const;
+
+    /**
+     * @brief Returns true while packets wait for or are part of a pass.
+     */
+    bool isSorting() const;
+
+    Column column() const;
+
+private:
+    /**
+     * @brief Sort key of a packet, compared as (group, high, low, id).
+     */
+    struct Entry {
+        uint64_t high;
+        uint64_t low;
+        int id;
+        uint8_t group;
+
+        bool operator<(const Entry& other) const {
+            if (group != other.group) {
+                return group < other.group;
+            }
+            if (high != other.high) {
+                return high < other.high;
+            }
+            if (low != other.low) {
+                return low < other.low;
+            }
+            return id < other.id;
+        }
+    };
+
+    /**
+     * @brief Background thread: runs a pass whenever packets were added.
+     */
+    void sortLoop();
+
+    /**
+     * @brief Reads and sorts the keys of the stored packets in [firstId, lastId], only those in ids unless nullptr.
+     * @return Sorted entries, empty if stopped
+     */
+    std::vector<Entry> sortNew(int firstId, int lastId, const std::vector<int>* ids);
+
+    /**
+     * @brief Appends the entries of the stored packets of columns, only those in [idsBegin, idsEnd) unless nullptr.
+     */
+    void appendEntries(const PacketColumns& columns, const int* idsBegin, const int* idsEnd,
+                       std::vector<Entry>& entries) const;
+
+    /**
+     * @brief Returns the key of packet i of columns.
+     */
+    Entry makeEntry(const PacketColumns& columns, std::size_t i) const;
+
+    /**
+     * @brief Calls work(i) for every i below count on up to threadCount_ threads.
+     */
+    template <typename Work>
+    void runParallel(std::size_t count, Work&& work);
+
+    std::shared_ptr<const PacketStore> store_;
+    const Column column_;
+    const std::size_t threadCount_;
+
+    /// Sorted entries of the latest order and their lowest ID, only touched by the background thread
+    std::vector<Entry> entries_;
+    int minEntryId_{std::numeric_limits<int>::max()};
+
+    /// Guards the members below
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::shared_ptr<const Order> order_;
+
+    /// Packets added but not sorted yet: IDs up to pendingUntilId_, or pendingIds_ in list mode
+    int pendingUntilId_{0};
+    std::vector<int> pendingIds_;
+    bool isListMode_{false};
+
+    /// Packets below this are dropped by the next pass
+    int pendingFirstId_{1};
+
+    /// pendingFirstId_ of the latest pass
+    int appliedFirstId_{1};
+
+    /// Added IDs up to this one are part of entries_ or the running pass
+    int takenUntilId_{0};
+
+    bool isPassRunning_{false};
+
+    /// Also read by the threads of a pass, which give up after their current chunk
+    std::atomic<bool> isStopping_{false};
+
+    std::thread thread_;
+};
+
+#endif
@@ -2,26 +2,122 @@
 #define PACKETSTORE_HPP_
 
 #include "Types.hpp"
+#include "PipelineConfig.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
-#include <shared_mutex>
+
+class PacketView;
+class PacketColumns;
+class PacketIndex;
+
+/// Raw bytes of one spilled segment in the spill file, defined in the translation unit
+struct StoreSpillRegion;
+
+/// Descriptor of the (unlinked) spill file, shared by its regions
+struct StoreSpillFile;
+
+namespace packetscope {
+
+/**
+ * @brief Where the raw bytes of the stored packets are, see PacketStore::memoryStats().
+ */
+struct StoreMemoryStats {
+    std::size_t memoryBudget{};         ///< StoreSpillConfig::memoryBudget, 0 means unlimited
+    std::size_t rawBytesInMemory{};     ///< Raw bytes held in RAM (pool slots)
+    std::size_t rawBytesSpilled{};      ///< Raw bytes moved to the spill file
+    std::size_t spilledSegments{};      ///< Segments whose raw bytes are on disk
+    std::size_t evictedPackets{};       ///< Packets dropped from the front by the retention limits
+    std::size_t indexBytes{};           ///< Heap bytes of the posting lists, 0 without indexing
+};
+
+}
 
 /**
- * @brief Thread safe storage for parsed network packets.
+ * @brief Thread safe, append-only storage for parsed network packets.
+ *
+ * Packets are kept in a segmented log: a fixed directory of segment
+ * pointers, each segment holding kSegmentSize slots. Segments are allocated
+ * on demand and never moved, so growing the store never relocates an
+ * existing packet (unlike std::vector::push_back reallocation).
+ *
+ * Layout:
+ *   Inside a segment every summary field is its own column (structure of
+ *   arrays) in binary form, about 85 bytes per packet without any heap
+ *   allocation besides the shared raw bytes. A scan over one field (e.g.
+ *   protocol) only touches that column.
+ *
+ * Ordering:
+ *   Packet IDs are assigned at capture time (see RawPacketData::sequence),
+ *   so each packet is written into the slot of its own ID no matter which
+ *   worker finishes first. count() reports the contiguous watermark: the
+ *   number of leading slots that are all either stored or discarded, so a
+ *   reader never sees a row whose predecessor is still being parsed.
  *
- * PacketStore provides a thread safe container for storing and
- * retrieving parsed packets. It uses a std::shared_mutex to allow
- * multiple concurrent readers while ensuring exclusive access
- * for writers.
+ * Tiers:
+ *   Summaries always stay in RAM. With a StoreSpillConfig::memoryBudget a
+ *   background thread moves the raw bytes of the oldest complete segments
+ *   (every slot below the watermark, so no writer touches them any more) to
+ *   an unlinked spill file once the budget is exceeded, and releases their
+ *   pool slots. The file region is mapped read only: visit() hands out the
+ *   bytes straight from the mapping, so they are paged in lazily and the
+ *   kernel may drop them again under memory pressure.
+ *
+ * Retention:
+ *   With a StoreRetentionConfig the store is a ring: the same background
+ *   thread advances a front index over the oldest packets once a limit is
+ *   exceeded (checked every kMaintenancePollInterval, so limits are soft by
+ *   that much traffic). Evicted IDs are reported as not found; firstId()
+ *   tells readers where the retained range starts. Eviction costs O(1) per
+ *   packet, whole segments behind the front are freed in one go (spilled
+ *   bytes are punched out of the spill file). IDs are never reused, so the
+ *   directory spans the whole positive int range.
+ *
+ * Indexes:
+ *   With setIndexing(true) the background thread also appends every packet
+ *   below the watermark to a PacketIndex (address, port and protocol
+ *   posting lists), so lookups of a host or a port do not scan the columns.
+ *   The index trails the watermark by up to kMaintenancePollInterval and
+ *   drops evicted packets together with their segments.
  *
  * Thread Safety:
- *   - Multiple threads can read simultaneously (shared lock)
- *   - Only one thread can write at a time (exclusive lock)
+ *   - Writers publish each slot with a store and then help advance the
+ *     watermark with compare_exchange, so workers never wait for each other
+ *   - Readers index by ID without taking any lock (acquire load of the slot).
+ *     Every visit() is counted, the background thread only drops the
+ *     in-memory bytes of a spilled segment or frees an evicted one after it
+ *     has been unlinked and no reader is inside the store any more
+ *   - clear() unlinks every segment and waits for the visit() and scan()
+ *     calls already inside the store before freeing them, so readers may
+ *     keep running (they see the store empty). It must not run concurrently
+ *     with writers (pipeline stopped)
  */
 class PacketStore {
 public:
-    PacketStore() = default;
-    ~PacketStore() = default;
+    /// log2 of the number of packets per segment
+    static constexpr std::size_t kSegmentShift = 14;
+
+    /// Number of packets per segment
+    static constexpr std::size_t kSegmentSize = std::size_t{1} << kSegmentShift;
+
+    /// Maximum number of segments, kSegmentSize * kMaxSegments covers every positive int ID
+    static constexpr std::size_t kMaxSegments = std::size_t{1} << 17;
+
+    /**
+     * @brief Constructs an empty store.
+     * @param spillConfig RAM budget of the raw bytes, unlimited by default
+     * @param retentionConfig History kept, unbounded by default
+     */
+    explicit PacketStore(packetscope::StoreSpillConfig spillConfig = {},
+                         packetscope::StoreRetentionConfig retentionConfig = {});
+    ~PacketStore();
 
     PacketStore(const PacketStore&) = delete;
     PacketStore& operator=(const PacketStore&) = delete;
@@ -31,30 +127,97 @@ public:
     /**
      * @brief Adds a parsed packet to the store.
      *
-     * Assigns a unique sequential ID to the packet before storing.
-     * This method acquires an exclusive lock.
+     * The packet is placed into the slot of its ID (assigned at capture
+     * time). Each ID must be added or discarded exactly once.
+     * Lock free, safe to call from multiple threads.
      *
      * @param parsedPacket The packet to store (moved into storage)
+     * @throws std::out_of_range if the ID is outside of the store capacity
      */
     void addPacket(packetscope::ParsedPacket parsedPacket);
 
+    /**
+     * @brief Adds a batch of parsed packets to the store.
+     *
+     * Same as addPacket() for every element, the watermark is advanced
+     * once for the whole batch.
+     *
+     * @param parsedPackets The packets to store (moved into storage)
+     * @throws std::out_of_range if an ID is outside of the store capacity
+     */
+    void addPackets(std::vector<packetscope::ParsedPacket> parsedPackets);
+
+    /**
+     * @brief Marks the slot of a packet that will never be stored.
+     *
+     * Used for packets that received an ID but were dropped later in the
+     * pipeline, so the contiguous watermark can move past them.
+     * getById() reports discarded IDs as not found.
+     *
+     * @param id The packet ID
+     */
+    void discard(int id);
+
     /**
      * @brief Retrieves a packet by its ID.
      *
      * @param id The packet ID
      * @return The packet with the specified ID
+     * @throws std::out_of_range if no packet has been published with this ID
      */
     packetscope::ParsedPacket getById(int id) const;
 
     /**
-     * @brief Returns the number of stored packets.
+     * @brief Calls visitor with a view of the packet, without copying it.
+     *
+     * Preferred over getById() on hot paths (e.g. table repaints): there is
+     * no copy of the raw bytes or strings and a missing packet is reported
+     * through the return value instead of an exception.
+     *
+     * @param id The packet ID
+     * @param visitor Callable invoked as visitor(const PacketView&)
+     * @return false if the ID is outside [1, count()], was discarded or was evicted
+     */
+    template <typename Visitor>
+    bool visit(int id, Visitor&& visitor) const;
+
+    /**
+     * @brief Calls visitor with the summary columns of [firstId, lastId], one segment at a time.
+     *
+     * Meant for whole-store passes (display filter, indexes): the columns
+     * of a segment are read as arrays, without a lookup per packet. Evicted
+     * IDs are skipped, slots that are not stored are reported by
+     * PacketColumns::isStored(). Raw bytes are not part of the columns.
+     *
+     * @param firstId First ID to scan
+     * @param lastId Last ID to scan (inclusive), usually count()
+     * @param visitor Callable invoked as visitor(const PacketColumns&)
+     */
+    template <typename Visitor>
+    void scan(int firstId, int lastId, Visitor&& visitor) const;
+
+    /**
+     * @brief Returns the contiguous watermark.
+     *
+     * Every ID in [1, count()] has been stored or discarded, so rows up to
+     * this ID can be shown without gaps.
      *
      * @return Current packet count
      */
     std::size_t count() const;
 
     /**
-     * @brief Returns all stored packets.
+     * @brief Returns the oldest ID that has not been evicted.
+     *
+     * IDs in [firstId(), count()] are retained, 1 unless retention limits
+     * evicted packets. Only grows until clear().
+     */
+    int firstId() const;
+
+    /**
+     * @brief Returns all retained packets.
+     *
+     * Assembles a ParsedPacket per row from the columns.
      *
      * @return Vector with containing all packets
      */
@@ -63,14 +226,432 @@ public:
     /**
      * @brief Removes all packets and resets ID counter.
      *
-     * Releases all memory used by stored packets.
+     * Releases all memory used by stored packets and starts a new spill file.
+     * Waits for the visit() and scan() calls in progress before freeing the
+     * segments, readers may be called concurrently.
+     *
+     * @warning Must not be called concurrently with addPacket(), addPackets()
+     *          or discard() (stop the pipeline first).
      */
     void clear();
 
+    /**
+     * @brief Replaces the RAM budget and spill directory.
+     *
+     * A lower budget takes effect with the next spill pass; the directory is
+     * used for the next spill file (after clear()). Thread safe.
+     */
+    void setSpillConfig(const packetscope::StoreSpillConfig& spillConfig);
+
+    /**
+     * @brief Replaces the retention limits while packets keep arriving.
+     *
+     * Tighter limits evict with the next maintenance pass, looser ones only
+     * stop further eviction (evicted packets are gone). Thread safe.
+     */
+    void setRetentionConfig(const packetscope::StoreRetentionConfig& retentionConfig);
+
+    /**
+     * @brief Starts or stops maintaining the posting list index.
+     *
+     * Enabling indexes the packets already stored in the background, see
+     * PacketIndex::indexedUntilId() for the progress. Thread safe.
+     */
+    void setIndexing(bool isIndexing);
+
+    /**
+     * @brief Returns the posting list index, nullptr if indexing is off. Thread safe.
+     *
+     * The index stays valid as long as the pointer is held, also after
+     * setIndexing(false) or clear() replaced it.
+     */
+    std::shared_ptr<const PacketIndex> index() const;
+
+    /**
+     * @brief Returns how many raw bytes are in RAM and on disk. Thread safe.
+     */
+    packetscope::StoreMemoryStats memoryStats() const;
+
+private:
+    friend class PacketView;
+    friend class PacketColumns;
+
+    /**
+     * @brief Publication state of a slot.
+     */
+    enum class SlotState : uint8_t {
+        Empty,      ///< Not written yet
+        Ready,      ///< Packet written and visible to readers
+        Discarded   ///< Packet was dropped, slot stays empty
+    };
+
+    /**
+     * @brief kSegmentSize packets as structure of arrays.
+     *
+     * Columns of a slot are written by its writer before states[offset]
+     * is set to Ready, readers only look at them afterwards.
+     */
+    struct Segment {
+        Segment();
+        ~Segment();
+
+        std::atomic<SlotState> states[kSegmentSize];
+        timespec timestamps[kSegmentSize];
+        int rawDataLens[kSegmentSize];
+        int frameLengths[kSegmentSize];
+        pcpp::ProtocolType protocols[kSegmentSize];
+        pcpp::LinkLayerType linkLayerTypes[kSegmentSize];
+        packetscope::PacketAddress srcAddrs[kSegmentSize];
+        packetscope::PacketAddress dstAddrs[kSegmentSize];
+        uint16_t srcPorts[kSegmentSize];
+        uint16_t dstPorts[kSegmentSize];
+        uint8_t ipProtocols[kSegmentSize];
+        packetscope::PacketBuffer rawData[kSegmentSize];
+
+        /// Set once spill is complete, rawData is released afterwards
+        std::atomic<bool> isSpilled{false};
+        StoreSpillRegion* spill{nullptr};
+    };
+
+    /**
+     * @brief Counts a reader for the duration of a visit().
+     *
+     * The reader registers in the counter of the current epoch before it
+     * loads a segment pointer or isSpilled. The background thread unlinks a
+     * segment or sets isSpilled, then flips the epoch and waits for the old
+     * counter to drain (all seq_cst): either the reader sees the change, or
+     * the background thread waits for it to leave. Readers arriving after
+     * the flip use the other counter, so a busy reader cannot starve it.
+     */
+    class ReaderGuard {
+    public:
+        explicit ReaderGuard(const PacketStore& store) {
+            for (;;) {
+                const uint32_t epoch = store.readerEpoch_.load(std::memory_order_seq_cst);
+                readers_ = &store.activeReaders_[epoch & 1];
+                readers_->fetch_add(1, std::memory_order_seq_cst);
+                // A flip in between may already have checked this counter
+                if (store.readerEpoch_.load(std::memory_order_seq_cst) == epoch) {
+                    break;
+                }
+                readers_->fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        ~ReaderGuard() {
+            readers_->fetch_sub(1, std::memory_order_release);
+        }
+
+        ReaderGuard(const ReaderGuard&) = delete;
+        ReaderGuard& operator=(const ReaderGuard&) = delete;
+        ReaderGuard(ReaderGuard&&) = delete;
+        ReaderGuard& operator=(ReaderGuard&&) = delete;
+
+    private:
+        std::atomic<uint32_t>* readers_{nullptr};
+    };
+
+    /**
+     * @brief Returns a handle to the spilled bytes of a slot, pointing into the mapping.
+     */
+    static packetscope::PacketBuffer loadSpilled(const Segment& segment, std::size_t offset);
+
+    /**
+     * @brief Background thread: applies the retention limits, indexes new packets and keeps the raw bytes in RAM below the budget.
+     */
+    void maintenanceLoop();
+
+    /**
+     * @brief Evicts the oldest packets until every retention limit holds again.
+     * @note Caller must hold maintenanceMutex_.
+     */
+    void enforceRetentionLocked();
+
+    /**
+     * @brief Adds the packets between the index's progress and the watermark to the index.
+     *
+     * At most kIndexSegmentsPerPass segments per call, so catching up with a
+     * large store does not hold maintenanceMutex_ (and clear()) for long.
+     *
+     * @return true if packets below the watermark are left for the next call
+     * @note Caller must hold maintenanceMutex_.
+     */
+    bool indexNewPacketsLocked(PacketIndex& index);
+
+    /**
+     * @brief Returns the timestamp of the newest stored packet below watermark, if any.
+     */
+    bool newestTimestamp(std::size_t watermark, timespec& timestamp) const;
+
+    /**
+     * @brief Unlinks and frees the segments below segmentLimit.
+     * @note Caller must hold maintenanceMutex_.
+     */
+    void freeSegmentsLocked(std::size_t segmentLimit);
+
+    /**
+     * @brief Flips the reader epoch and waits for the visit() calls that started before.
+     * @note Caller must hold maintenanceMutex_.
+     */
+    void waitForReadersLocked();
+
+    /**
+     * @brief Spills the oldest complete segment that is still in RAM.
+     * @return false if there is none (or spilling failed)
+     * @note Caller must hold maintenanceMutex_.
+     */
+    bool spillNextSegmentLocked();
+
+    /**
+     * @brief Writes a segment's raw bytes to the spill file, maps them and releases the RAM copy.
+     * @note Caller must hold maintenanceMutex_.
+     */
+    bool spillSegmentLocked(Segment& segment);
+
+    /**
+     * @brief Creates the (unlinked) spill file in the configured directory.
+     * @note Caller must hold maintenanceMutex_.
+     */
+    bool openSpillFileLocked();
+
+    /**
+     * @brief Returns the segment with the given index, allocating it if needed.
+     *
+     * Concurrent writers race with compare_exchange, the loser frees its copy.
+     */
+    Segment* segmentFor(std::size_t segmentIndex);
+
+    /**
+     * @brief Returns the segment holding index if its slot is published and retained, otherwise nullptr.
+     * @note Only valid inside a ReaderGuard.
+     */
+    const Segment* publishedSegment(std::size_t index) const;
+
+    /**
+     * @brief Scatters the packet into the columns of its ID and publishes it.
+     * @return Raw bytes stored
+     */
+    std::size_t publish(packetscope::ParsedPacket&& parsedPacket);
+
+    /**
+     * @brief Returns true if the slot at index has been stored or discarded.
+     * @note Only valid inside a ReaderGuard.
+     */
+    bool isSettled(std::size_t index) const;
+
+    /**
+     * @brief Moves the watermark over every settled slot.
+     *
+     * Any writer may advance it. The seq_cst state store in publish() and
+     * the seq_cst load in isSettled() guarantee that of two writers settling
+     * neighbouring slots at least one sees the other, so the watermark
+     * never stalls in front of a settled slot. The slot states are read
+     * inside a ReaderGuard, like every other segment access.
+     */
+    void advanceWatermark();
+
+    /**
+     * @brief Unlinks all segments, waits for the readers inside them, then destroys them.
+     * @note Caller must hold maintenanceMutex_ (or be the destructor).
+     */
+    void releaseAll();
+
+    /**
+     * @brief Converts a packet ID to its slot index.
+     * @throws std::out_of_range if the ID is outside of the store capacity
+     */
+    static std::size_t indexOf(int id);
+
+    /// Offset inside a segment
+    static constexpr std::size_t kSegmentMask = kSegmentSize - 1;
+
+    /// Segment directory, entries are set once and cleared by eviction or clear()
+    std::unique_ptr<std::atomic<Segment*>[]> segments_;
+
+    /// Number of leading slots that are all settled (stored or discarded)
+    std::atomic<std::size_t> watermark_{0};
+
+    /// Slots below it are evicted, never above the watermark
+    std::atomic<std::size_t> firstIndex_{0};
+
+    /// visit() calls in progress per epoch parity, on their own cache line (see ReaderGuard)
+    alignas(64) mutable std::atomic<uint32_t> activeReaders_[2]{};
+    std::atomic<uint32_t> readerEpoch_{0};
+
+    /// How often the background thread checks the budget and the retention limits
+    static constexpr std::chrono::milliseconds kMaintenancePollInterval{50};
+
+    /// Segments indexed per maintenance pass
+    static constexpr std::size_t kIndexSegmentsPerPass = 8;
+
+    /// Bytes staged per write() to the spill file
+    static constexpr std::size_t kSpillWriteSize = 1 << 20;
+
+    /// Raw bytes in pool slots (added once per batch) and in the spill file
+    std::atomic<std::size_t> rawBytesInMemory_{0};
+    std::atomic<std::size_t> rawBytesSpilled_{0};
+    std::atomic<std::size_t> spilledSegments_{0};
+
+    /// Captured bytes of the retained packets (rawDataLen, added once per batch)
+    std::atomic<std::size_t> retainedRawBytes_{0};
+    std::atomic<std::size_t> evictedPackets_{0};
+
+    // Spill and retention state, guarded by maintenanceMutex_ (held for a whole segment spill)
+    mutable std::mutex maintenanceMutex_;
+    std::condition_variable maintenanceCondition_;
+    packetscope::StoreSpillConfig spillConfig_;
+    packetscope::StoreRetentionConfig retentionConfig_;
+    std::atomic<std::size_t> memoryBudget_{0};
+    std::size_t nextSpillSegment_{0};   ///< Segments below it are spilled
+    std::size_t firstSegment_{0};       ///< Segments below it are freed
+    std::shared_ptr<StoreSpillFile> spillFile_;
+    uint64_t spillFileEnd_{0};
+    bool isSpillFailed_{false};         ///< Stops retrying until clear() after an I/O error
+    std::atomic<bool> isStopRequested_{false};
+    std::thread maintenanceThread_;
+
+    /// Only written to by the background thread, the pointer is swapped under indexMutex_
+    mutable std::mutex indexMutex_;
+    std::shared_ptr<PacketIndex> index_;
+};
+
+/**
+ * @brief Lightweight read-only view of one stored packet.
+ *
+ * Reads the columns of the packet inside PacketStore, nothing is copied.
+ * Only valid for the duration of the PacketStore::visit() call that produced it.
+ */
+class PacketView {
+public:
+    /**
+     * @param isSpilled The segment's raw bytes are read from the spill file
+     */
+    PacketView(const PacketStore::Segment& segment, std::size_t index, bool isSpilled)
+        : segment_(&segment)
+        , index_(index)
+        , offset_(index & PacketStore::kSegmentMask)
+        , isSpilled_(isSpilled) {}
+
+    int id() const { return static_cast<int>(index_ + 1); }
+    const timespec& timestamp() const { return segment_->timestamps[offset_]; }
+    int rawDataLen() const { return segment_->rawDataLens[offset_]; }
+    int frameLength() const { return segment_->frameLengths[offset_]; }
+    /**
+     * @brief Returns the raw bytes; spilled ones are mapped on first use.
+     */
+    const packetscope::PacketBuffer& rawData() const {
+        if (!isSpilled_) {
+            return segment_->rawData[offset_];
+        }
+        if (!isSpilledLoaded_) {
+            spilledData_ = PacketStore::loadSpilled(*segment_, offset_);
+            isSpilledLoaded_ = true;
+        }
+        return spilledData_;
+    }
+    pcpp::LinkLayerType linkLayerType() const { return segment_->linkLayerTypes[offset_]; }
+    const packetscope::PacketAddress& srcAddr() const { return segment_->srcAddrs[offset_]; }
+    const packetscope::PacketAddress& dstAddr() const { return segment_->dstAddrs[offset_]; }
+    pcpp::ProtocolType protocol() const { return segment_->protocols[offset_]; }
+    uint16_t srcPort() const { return segment_->srcPorts[offset_]; }
+    uint16_t dstPort() const { return segment_->dstPorts[offset_]; }
+    uint8_t ipProtocol() const { return segment_->ipProtocols[offset_]; }
+
+    /**
+     * @brief Assembles a copy of the packet (shares the raw bytes).
+     */
+    packetscope::ParsedPacket toParsedPacket() const;
+
 private:
-    std::vector<packetscope::ParsedPacket> parsedPackets_;
-    mutable std::shared_mutex mutex_;
-    int id_{};
+    const PacketStore::Segment* segment_;
+    std::size_t index_;
+    std::size_t offset_;
+    bool isSpilled_;
+    mutable bool isSpilledLoaded_{false};
+    mutable packetscope::PacketBuffer spilledData_;
 };
 
-#endif
\ No newline at end of file
+/**
+ * @brief Read-only summary columns of consecutive packets of one segment.
+ *
+ * Element i is the packet with ID firstId() + i. Only valid for the duration
+ * of the PacketStore::scan() callback that produced it.
+ */
+class PacketColumns {
+public:
+    PacketColumns(const PacketStore::Segment& segment, std::size_t firstIndex, std::size_t size)
+        : segment_(&segment)
+        , firstIndex_(firstIndex)
+        , offset_(firstIndex & PacketStore::kSegmentMask)
+        , size_(size) {}
+
+    int firstId() const { return static_cast<int>(firstIndex_ + 1); }
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Returns false for slots that are discarded or not written yet.
+     */
+    bool isStored(std::size_t i) const {
+        return segment_->states[offset_ + i].load(std::memory_order_acquire) == PacketStore::SlotState::Ready;
+    }
+    const timespec& timestamp(std::size_t i) const { return segment_->timestamps[offset_ + i]; }
+    int rawDataLen(std::size_t i) const { return segment_->rawDataLens[offset_ + i]; }
+    int frameLength(std::size_t i) const { return segment_->frameLengths[offset_ + i]; }
+    pcpp::LinkLayerType linkLayerType(std::size_t i) const { return segment_->linkLayerTypes[offset_ + i]; }
+    const packetscope::PacketAddress& srcAddr(std::size_t i) const { return segment_->srcAddrs[offset_ + i]; }
+    const packetscope::PacketAddress& dstAddr(std::size_t i) const { return segment_->dstAddrs[offset_ + i]; }
+    pcpp::ProtocolType protocol(std::size_t i) const { return segment_->protocols[offset_ + i]; }
+    uint16_t srcPort(std::size_t i) const { return segment_->srcPorts[offset_ + i]; }
+    uint16_t dstPort(std::size_t i) const { return segment_->dstPorts[offset_ + i]; }
+    uint8_t ipProtocol(std::size_t i) const { return segment_->ipProtocols[offset_ + i]; }
+
+private:
+    const PacketStore::Segment* segment_;
+    std::size_t firstIndex_;
+    std::size_t offset_;
+    std::size_t size_;
+};
+
+template <typename Visitor>
+bool PacketStore::visit(int id, Visitor&& visitor) const {
+    if (id <= 0 || static_cast<std::size_t>(id) > count()) {
+        return false;
+    }
+
+    const std::size_t index = static_cast<std::size_t>(id - 1);
+    const ReaderGuard guard(*this);
+    const Segment* segment = publishedSegment(index);
+    if (!segment) {
+        return false;
+    }
+    visitor(PacketView(*segment, index, segment->isSpilled.load(std::memory_order_seq_cst)));
+    return true;
+}
+
+template <typename Visitor>
+void PacketStore::scan(int firstId, int lastId, Visitor&& visitor) const {
+    if (lastId <= 0 || lastId < firstId) {
+        return;
+    }
+
+    std::size_t index = firstId > 0 ? static_cast<std::size_t>(firstId - 1) : 0;
+    const std::size_t end = std::min(static_cast<std::size_t>(lastId), kSegmentSize * kMaxSegments);
+
+    // One registration per segment, the background thread is not held up for the whole scan
+    while (true) {
+        const ReaderGuard guard(*this);
+        index = std::max(index, firstIndex_.load(std::memory_order_seq_cst));
+        if (index >= end) {
+            return;
+        }
+
+        const std::size_t segmentEnd = std::min(end, (index | kSegmentMask) + 1);
+        const Segment* segment = segments_[index >> kSegmentShift].load(std::memory_order_seq_cst);
+        if (segment) {
+            visitor(PacketColumns(*segment, index, segmentEnd - index));
+        }
+        index = segmentEnd;
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PCAPCAPTUREBACKEND_HPP_
+#define PCAPCAPTUREBACKEND_HPP_
+
+#include <PcapLiveDeviceList.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "core/CaptureBackend.hpp"
+#include "core/PacketBufferPool.hpp"
+
+struct pcap;
+struct pcap_pkthdr;
+
+/**
+ * @brief Portable libpcap backend.
+ *
+ * Captures through PcapPlusPlus (pcpp::PcapLiveDevice), or, for fanout
+ * members, through libpcap directly since PcapLiveDevice does not expose its
+ * socket. libpcap delivers one packet per callback and reuses its buffer, so
+ * every frame is copied into a slot of the PacketBufferPool.
+ */
+class PcapCaptureBackend : public CaptureBackend {
+public:
+    /**
+     * @brief Constructs an idle backend.
+     * @param bufferPool Pool that captured packet bytes are copied into
+     */
+    explicit PcapCaptureBackend(std::shared_ptr<PacketBufferPool> bufferPool);
+    ~PcapCaptureBackend() override;
+
+    PcapCaptureBackend(const PcapCaptureBackend&) = delete;
+    PcapCaptureBackend& operator=(const PcapCaptureBackend&) = delete;
+    PcapCaptureBackend(PcapCaptureBackend&&) = delete;
+    PcapCaptureBackend& operator=(PcapCaptureBackend&&) = delete;
+
+    bool start(const std::string& deviceName, const Options& options, FrameHandler handler) override;
+    void stop() override;
+    bool setFilter(const std::string& expression) override;
+    packetscope::KernelCaptureStats kernelStats() override;
+
+private:
+    /// Read timeout of fanout members, bounds how long stop() waits for the capture thread
+    static constexpr int kFanoutReadTimeoutMs = 100;
+
+    /**
+     * @brief Internal callback invoked by PcapPlusPlus for each captured packet.
+     */
+    static void onPacketArrives(pcpp::RawPacket* packet,
+                                pcpp::PcapLiveDevice* dev,
+                                void* cookie);
+
+    /**
+     * @brief libpcap callback of fanout members.
+     */
+    static void onFanoutPacketArrives(unsigned char* cookie, const pcap_pkthdr* header, const unsigned char* data);
+
+    /**
+     * @brief Opens the device with libpcap, joins the fanout group and starts the capture thread.
+     */
+    bool startFanoutMember(const std::string& deviceName, const FanoutGroup& group,
+                           const packetscope::CaptureFilter& filter);
+
+    /**
+     * @brief Compiles and installs a filter on the libpcap handle of a fanout member.
+     */
+    bool setFanoutFilter(const std::string& expression);
+
+    /**
+     * @brief Common per packet path: pin on first use, copy into the pool, hand to the handler.
+     */
+    void deliver(const uint8_t* data, int rawDataLen, int frameLength, timespec timestamp,
+                 pcpp::LinkLayerType linkLayerType);
+
+    std::shared_ptr<PacketBufferPool> bufferPool_;
+    pcpp::PcapLiveDevice* device_{nullptr};
+    FrameHandler handler_;
+
+    /// Single element batch handed to handler_ (capture thread only)
+    std::vector<packetscope::RawPacketData> batch_;
+
+    /// CPUs for the capture thread, applied on its first callback
+    std::vector<int> threadCpus_;
+
+    /// Set by the capture thread once threadCpus_ is applied, reset by start()
+    bool isThreadPinned_{false};
+
+    /// libpcap handle and capture thread of a fanout member
+    pcap* fanoutHandle_{nullptr};
+    pcpp::LinkLayerType fanoutLinkLayerType_{pcpp::LINKTYPE_ETHERNET};
+    std::thread fanoutThread_;
+    std::atomic<bool> isFanoutStopRequested_{false};
+
+    /// Counters of the last successful pcap_stats(), kept after stop()
+    packetscope::KernelCaptureStats lastStats_;
+};
+
+#endif
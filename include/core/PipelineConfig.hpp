@@ -0,0 +1,405 @@
+#ifndef PIPELINECONFIG_HPP_
+#define PIPELINECONFIG_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "QueuePolicy.hpp"
+
+/**
+ * @file PipelineConfig.hpp
+ * @brief Tunable settings of the packet processing pipeline.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief How the dispatcher hands batches to the worker pool.
+ */
+enum class DispatchMode {
+    Batch,      ///< Any idle worker takes (or steals) the next batch
+    FlowAffine  ///< Packets of one 5-tuple always go to the same worker, in capture order
+};
+
+/**
+ * @brief How the kernel spreads one device's packets over its capture queues.
+ */
+enum class FanoutMode {
+    Hash,           ///< By flow hash, both directions of a flow on the same queue
+    Cpu,            ///< By the CPU that received the packet (follows RSS IRQ affinity)
+    QueueMapping    ///< By the NIC RX queue recorded for the packet
+};
+
+/**
+ * @brief Kernel interface the capture sockets read from.
+ */
+enum class CaptureBackendType {
+    Pcap,       ///< libpcap (PcapPlusPlus), portable, one copy per packet into the buffer pool
+    TPacketV3   ///< AF_PACKET TPACKET_V3 mmap ring, frames are handed on in place (Linux only)
+};
+
+/**
+ * @brief Geometry of a TPACKET_V3 receive ring.
+ *
+ * The kernel fills one block at a time and hands it over once it is full or
+ * blockTimeout expired, so a block is also the unit of batching. A block is
+ * returned to the kernel when every frame in it was released by the pipeline.
+ */
+struct TPacketRingConfig {
+    /// Default bytes per block, a multiple of the page size
+    static constexpr std::size_t kDefaultBlockSize = 1 << 20;
+
+    /// Default number of blocks per ring
+    static constexpr std::size_t kDefaultBlockCount = 64;
+
+    /// Default time after which a partially filled block is handed over
+    static constexpr std::chrono::milliseconds kDefaultBlockTimeout{10};
+
+    std::size_t blockSize{kDefaultBlockSize};
+    std::size_t blockCount{kDefaultBlockCount};
+    std::chrono::milliseconds blockTimeout{kDefaultBlockTimeout};
+};
+
+/**
+ * @brief Kernel side packet selection of a capture session.
+ *
+ * Both are pushed down to the capture socket, so packets the filter rejects
+ * and bytes past the snap length are never copied to user space.
+ */
+struct CaptureFilter {
+    /// Upper bound of snapLength, also the snap length of "full frames"
+    static constexpr int kMaxSnapLength = 262144;
+
+    /// BPF expression in libpcap syntax ("tcp port 443"), empty keeps every packet
+    std::string expression;
+
+    /// Bytes kept of every packet, 0 keeps full frames
+    int snapLength{0};
+};
+
+/**
+ * @brief When PacketStore moves raw packet bytes from RAM to disk.
+ *
+ * Packet summaries always stay in memory. Once the raw bytes held in RAM
+ * exceed memoryBudget, the oldest complete store segments are written to a
+ * spill file and their bytes are read back from a read only mapping of it
+ * on demand (e.g. for the hex view).
+ */
+struct StoreSpillConfig {
+    /// Raw packet bytes kept in RAM, 0 keeps every packet in RAM. A soft
+    /// limit: bytes are spilled in whole segments (PacketStore::kSegmentSize
+    /// packets), shortly after the budget was exceeded.
+    std::size_t memoryBudget{0};
+
+    /// Directory of the spill file (deleted on creation, it only lives as
+    /// long as the store), empty uses the temporary directory
+    std::string directory;
+};
+
+/**
+ * @brief Bounded ring mode of PacketStore: how much history is kept.
+ *
+ * Once a limit is exceeded the oldest packets are evicted from the front of
+ * the store (their IDs are reported as not found), without stopping the
+ * pipeline. Every limit is 0 (off) by default, the store then grows until
+ * clear().
+ */
+struct StoreRetentionConfig {
+    /// Packets kept, 0 is unlimited
+    std::size_t maxPackets{0};
+
+    /// Raw packet bytes kept (captured lengths, in RAM and spilled), 0 is unlimited
+    std::size_t maxBytes{0};
+
+    /// Packets older than this relative to the newest stored one are evicted, 0 is unlimited
+    std::chrono::seconds maxAge{0};
+
+    bool isBounded() const {
+        return maxPackets > 0 || maxBytes > 0 || maxAge.count() > 0;
+    }
+};
+
+/**
+ * @brief Output files of PipelineController::startRecording().
+ *
+ * Packets are written to <directory>/<filePrefix>_<index>_<time>.pcapng.
+ * A new file is started once the current one reached maxFileSize bytes or
+ * has been open for maxFileDuration; with fileCount set only the newest
+ * fileCount files are kept (a ring of files for unattended captures).
+ */
+struct CaptureWriterConfig {
+    /// Default packets queued between the dispatcher and the writer
+    static constexpr std::size_t kDefaultQueueCapacity = 65536;
+
+    /// Default size of one write() to disk
+    static constexpr std::size_t kDefaultWriteBufferSize = 4 << 20;
+
+    std::string directory{"."};
+    std::string filePrefix{"packetscope"};
+
+    /// Rotate after this many bytes, 0 never rotates by size
+    uint64_t maxFileSize{0};
+
+    /// Rotate after this long, 0 never rotates by time
+    std::chrono::seconds maxFileDuration{0};
+
+    /// Files kept in the ring, older ones are deleted; 0 keeps every file
+    std::size_t fileCount{0};
+
+    /// Bytes collected before they are written, larger buffers mean fewer system calls
+    std::size_t writeBufferSize{kDefaultWriteBufferSize};
+
+    /// Dispatcher -> writer queue. Dropping is the default so a slow disk
+    /// costs recorded packets, never captured ones (ring frames are copied
+    /// before they are queued, the queue never holds capture ring blocks).
+    QueueLimits queue{kDefaultQueueCapacity, OverflowPolicy::DropNewest};
+};
+
+/**
+ * @brief Text format of exported pipeline metrics.
+ */
+enum class MetricsFormat {
+    Prometheus,     ///< Prometheus text exposition format (node_exporter textfile collector)
+    Json            ///< One JSON object per snapshot
+};
+
+/**
+ * @brief Metrics file of PipelineController::startMetricsExport().
+ *
+ * Every interval the current metrics are written to path. The file is
+ * replaced atomically (written next to it, then renamed), so a scraper
+ * never reads a half written snapshot.
+ */
+struct MetricsExportConfig {
+    /// Default time between two snapshots
+    static constexpr std::chrono::milliseconds kDefaultInterval{1000};
+
+    std::string path{"packetscope.prom"};
+    MetricsFormat format{MetricsFormat::Prometheus};
+    std::chrono::milliseconds interval{kDefaultInterval};
+};
+
+/**
+ * @brief Unix socket of QueryServer, through which clients browse a running pipeline.
+ *
+ * Each client is served on its own thread, so a slow reader never holds
+ * up the others (or the pipeline, which the server only reads from).
+ */
+struct QueryServerConfig {
+    /// Default number of clients served at once, later ones are refused
+    static constexpr std::size_t kDefaultMaxClients = 8;
+
+    std::string socketPath{"/run/packetscope.sock"};
+    std::size_t maxClients{kDefaultMaxClients};
+
+    /// Threads a filter request uses, 0 is one per hardware thread
+    std::size_t filterThreads{1};
+
+    /// Server threads are pinned to these CPUs (housekeeping cores), empty leaves them unpinned
+    std::vector<int> cpus;
+};
+
+/**
+ * @brief Bounds of the merged flow view of FlowTracker.
+ *
+ * Applied when the worker tables are merged, so a port scan or a capture
+ * running for hours cannot grow the global view without limit.
+ */
+struct FlowLimits {
+    /// Default flows kept in the global view (about 200 bytes each)
+    static constexpr std::size_t kDefaultMaxFlows = 1 << 18;
+
+    /// Default time without a packet after which a flow is dropped
+    static constexpr std::chrono::seconds kDefaultIdleTimeout{600};
+
+    /// Above this many flows the least recently seen ones are evicted, 0 is unlimited
+    std::size_t maxFlows{kDefaultMaxFlows};
+
+    /// Flows without a packet for this long (capture time) are dropped, 0 keeps them
+    std::chrono::seconds idleTimeout{kDefaultIdleTimeout};
+};
+
+/**
+ * @brief Memory bounds of TCP stream reassembly.
+ *
+ * Every byte a stream holds counts against both limits (pooled slots are
+ * counted whole), plus a fixed overhead per stream. Data past maxStreamBytes
+ * is dropped and the stream is marked truncated. When maxBytes is reached the
+ * streams seen least recently are evicted first; only when nothing can be
+ * evicted is the new data dropped. Flows never carrying payload, e.g. the
+ * probes of a port scan, hold no stream at all.
+ */
+struct ReassemblyLimits {
+    /// Default bytes kept per stream
+    static constexpr std::size_t kDefaultMaxStreamBytes = 16 << 20;
+
+    /// Default bytes kept over all streams
+    static constexpr std::size_t kDefaultMaxBytes = 256 << 20;
+
+    /// Default out of order bytes held per direction
+    static constexpr std::size_t kDefaultMaxOutOfOrderBytes = 1 << 20;
+
+    /// Default time without a segment after which an evicted stream is released
+    static constexpr std::chrono::seconds kDefaultIdleTimeout{300};
+
+    /// Bytes of one stream, both directions
+    std::size_t maxStreamBytes{kDefaultMaxStreamBytes};
+
+    /// Bytes of every stream together
+    std::size_t maxBytes{kDefaultMaxBytes};
+
+    /// Segments held per direction waiting for a missing one. Beyond this
+    /// the missing bytes (lost before the capture saw them) are skipped.
+    std::size_t maxOutOfOrderBytes{kDefaultMaxOutOfOrderBytes};
+
+    /// A stream whose packets the store evicted is released once it is
+    /// closed, or once it saw no segment for this long (capture time);
+    /// 0 only releases closed ones
+    std::chrono::seconds idleTimeout{kDefaultIdleTimeout};
+};
+
+/**
+ * @brief Runtime configuration of PipelineController.
+ *
+ * Settings are applied when the pipeline is (re)started.
+ */
+struct PipelineConfig {
+    /// Default capacity of the capture -> dispatcher ring
+    static constexpr std::size_t kDefaultRawQueueCapacity = 65536;
+
+    /// Default capacity of the dispatcher -> worker task queue, in tasks
+    static constexpr std::size_t kDefaultTaskQueueCapacity = 65536;
+
+    /// Capture -> dispatcher ring. The capacity is rounded up to a power of two.
+    /// Dropping is the default so the libpcap callback thread is never blocked.
+    QueueLimits rawQueue{kDefaultRawQueueCapacity, OverflowPolicy::DropNewest};
+
+    /// Dispatcher -> worker task queue. The capacity counts tasks, each
+    /// carrying up to dispatchBatchSize packets; dropped tasks are reported
+    /// as the packets they held. Blocking is the default so a parse backlog
+    /// pushes back on the raw ring instead of growing without bound.
+    QueueLimits taskQueue{kDefaultTaskQueueCapacity, OverflowPolicy::Block};
+
+    /// Default maximum packets per worker task
+    static constexpr std::size_t kDefaultDispatchBatchSize = 64;
+
+    /// Default maximum time the dispatcher waits to fill a batch
+    static constexpr std::chrono::microseconds kDefaultDispatchBatchTimeout{200};
+
+    /// N: the dispatcher submits one task per N packets.
+    /// Higher values raise throughput, 1 submits every packet on its own.
+    std::size_t dispatchBatchSize{kDefaultDispatchBatchSize};
+
+    /// T: a partially filled batch is submitted after this long.
+    /// Bounds the latency added by batching.
+    std::chrono::microseconds dispatchBatchTimeout{kDefaultDispatchBatchTimeout};
+
+    /// FlowAffine splits every batch by flow hash so per-flow state (stream
+    /// reassembly, flow tables) needs no locking. Non IP packets are still
+    /// dispatched in Batch mode.
+    DispatchMode dispatchMode{DispatchMode::Batch};
+
+    /// Reassemble the payload of TCP connections, see PipelineController::tcpStream().
+    /// Runs on the workers next to the parser, so it needs DispatchMode::FlowAffine.
+    bool reassembleTcp{false};
+
+    /// Memory bounds of the reassembled streams
+    ReassemblyLimits reassembly;
+
+    /// Time the pipeline stages and keep per thread latency histograms, see
+    /// PipelineController::metrics(). Costs about two clock reads per packet.
+    bool collectMetrics{true};
+
+    /// Default packets per chunk of a file load
+    static constexpr std::size_t kDefaultFileChunkSize = 256;
+
+    /// PipelineController::openFile() hands the file to the workers in
+    /// chunks of this many packets, one task each
+    std::size_t fileChunkSize{kDefaultFileChunkSize};
+
+    /// RAM budget of the stored raw bytes and where the rest goes, see PacketStore
+    StoreSpillConfig storeSpill;
+
+    /// History kept by the store, see PipelineController::setStoreRetention()
+    StoreRetentionConfig storeRetention;
+
+    /// Maintain address / port / protocol posting lists of the store (see PacketIndex),
+    /// about 10 to 30 bytes per packet; display filters on these fields then skip the full scan
+    bool indexStore{false};
+
+    /// Default number of packets whose layer details are cached
+    static constexpr std::size_t kDefaultDetailCacheCapacity = 32;
+
+    /// LRU size of PipelineController::layerDetails(), 0 dissects on every call.
+    std::size_t detailCacheCapacity{kDefaultDetailCacheCapacity};
+
+    /// Default initial slots of each worker's flow table
+    static constexpr std::size_t kDefaultFlowTableCapacity = 4096;
+
+    /// Default interval between merges of the worker flow tables
+    static constexpr std::chrono::milliseconds kDefaultFlowMergeInterval{1000};
+
+    /// Account every packet to its 5-tuple flow, see PipelineController::topFlows()
+    bool trackFlows{true};
+
+    /// Initial slots of each worker's flow table. Tables grow on demand, sizing
+    /// them for the flows seen per merge interval avoids growing at all.
+    std::size_t flowTableCapacity{kDefaultFlowTableCapacity};
+
+    /// How often worker flow tables are folded into the global view
+    std::chrono::milliseconds flowMergeInterval{kDefaultFlowMergeInterval};
+
+    /// Capacity and idle expiry of the global flow view
+    FlowLimits flowLimits;
+
+    /// libpcap works everywhere; TPACKET_V3 batches a whole ring block per
+    /// wakeup and skips the capture side copy (frames are copied once, by the
+    /// worker, when they are stored).
+    CaptureBackendType captureBackend{CaptureBackendType::Pcap};
+
+    /// Ring geometry of the TPacketV3 backend, per capture socket
+    TPacketRingConfig tpacketRing;
+
+    /// Capture sockets (threads and raw rings) per device. Above 1 the sockets
+    /// join a PF_PACKET fanout group and the kernel spreads the device's
+    /// packets over them according to fanoutMode. Linux only.
+    std::size_t captureQueuesPerDevice{1};
+
+    /// Distribution of packets over the capture queues of a device
+    FanoutMode fanoutMode{FanoutMode::Hash};
+
+    /// Default time a packet waits for the other capture rings in the merge
+    static constexpr std::chrono::microseconds kDefaultCaptureMergeWindow{1000};
+
+    /// With several capture rings the dispatcher merges them by timestamp.
+    /// It holds the oldest packet until every ring has one queued, or at most
+    /// this long; later packets of a slower ring are numbered out of order.
+    /// A ring that stayed empty this long is idle and is no longer waited for.
+    std::chrono::microseconds captureMergeWindow{kDefaultCaptureMergeWindow};
+
+    /// Number of parser threads, 0 sizes the pool automatically:
+    /// hardware threads minus the capture threads and the dispatcher, at least 1.
+    std::size_t workerCount{0};
+
+    /// CPUs the capture thread may run on, empty leaves it unpinned.
+    /// With several capture threads, capture thread i is pinned to captureCpus[i % size].
+    std::vector<int> captureCpus;
+
+    /// CPUs the dispatcher thread may run on, empty leaves it unpinned
+    std::vector<int> dispatcherCpus;
+
+    /// Worker i is pinned to workerCpus[i % size], empty leaves them unpinned
+    std::vector<int> workerCpus;
+
+    /// Pin every thread without an explicit CPU list to the NUMA node of the
+    /// capture device, so buffers they first touch (pool slabs, store
+    /// segments, batches) are allocated on the NIC's node.
+    bool pinToDeviceNumaNode{false};
+};
+
+}
+
+#endif
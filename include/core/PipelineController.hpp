@@ -3,20 +3,51 @@
 
 #include "PacketStore.hpp"
 #include "PacketCapture.hpp"
-#include "ThreadPool.hpp"
+#include "WorkStealingThreadPool.hpp"
 #include "PacketProcessor.hpp"
+#include "PacketDetailCache.hpp"
+#include "FlowTracker.hpp"
+#include "StreamTracker.hpp"
+#include "CaptureFileReader.hpp"
+#include "CaptureFileWriter.hpp"
+#include "MetricsExporter.hpp"
+#include "PipelineMetrics.hpp"
+#include "PipelineConfig.hpp"
+#include "SpscRingBuffer.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <optional>
 
 /**
  * @brief Coordinates the entire packet processing pipeline.
  *
  * PipelineController manages the flow of packets from capture to storage:
  *   Capture -> RawQueue -> Dispatcher -> ThreadPool -> Processor -> Store
+ *
+ * There may be several captures (devices, and fanout queues per device), each
+ * with its own capture thread and RawQueue. The dispatcher merges them by
+ * timestamp and numbers the packets in merged order.
+ *
+ * Instead of live captures the pipeline can read a pcap / pcapng file
+ * (openFile()): the dispatcher thread then walks the mapped file and hands
+ * chunks of it straight to the ThreadPool.
+ *
+ * startRecording() additionally streams every dispatched packet to pcapng
+ * files (CaptureFileWriter), independent of stop() / start().
+ *
+ * Every thread times its stages into its own ThreadMetrics (see
+ * PipelineMetrics); metrics() folds them together with the queue and
+ * kernel drop counters, startMetricsExport() writes them to a file.
  */
 class PipelineController {
 public:
-    PipelineController();
+    /**
+     * @brief Constructs an idle pipeline.
+     * @param config Pipeline settings, see PipelineConfig
+     */
+    explicit PipelineController(packetscope::PipelineConfig config = {});
     ~PipelineController();
 
     PipelineController(const PipelineController&) = delete;
@@ -31,8 +62,20 @@ public:
      * Existing packets in store are preserved.
      *
      * @param deviceName Network device name (eth0, wlan0, etc.)
+     * @param filter BPF filter and snap length, applied in the kernel
+     */
+    bool start(const std::string& deviceName, const packetscope::CaptureFilter& filter = {});
+
+    /**
+     * @brief Starts or resumes capture on several devices at once.
+     *
+     * Every device gets PipelineConfig::captureQueuesPerDevice captures.
+     * Packets of all captures are merged into the store by timestamp.
+     *
+     * @param deviceNames Network device names, at least one
+     * @param filter BPF filter and snap length, applied in the kernel to every capture
      */
-    bool start(const std::string& deviceName);
+    bool start(const std::vector<std::string>& deviceNames, const packetscope::CaptureFilter& filter = {});
 
     /**
      * @brief Pauses the capture pipeline.
@@ -42,20 +85,129 @@ public:
      *
      * Shutdown sequence:
      *  Stop packet capture (no new packets produced)
-     *  Push poison pill (std::nullopt) to raw packet queue
+     *  Push poison pill (std::nullopt) to every raw packet queue
      *  Dispatcher thread drains queue and exits
-     *  ThreadPool processes all submitted tasks and shuts down
+     *  WorkStealingThreadPool processes all submitted tasks and shuts down
      */
     void stop();
 
     /**
-     * @brief Restarts the pipeline on the current device.
+     * @brief Restarts the pipeline on the current devices.
      *
      * Clears all stored packets and statistics, then starts
-     * fresh capture on the same device.
+     * fresh capture on the same devices.
      */
     bool restart();
 
+    /**
+     * @brief Replaces the BPF filter of every capture, live.
+     *
+     * Unlike restart() the ThreadPool, dispatcher and stored packets are
+     * left alone: only the kernel filter of the capture sockets changes.
+     * The snap length is kept. Also used by the next restart().
+     *
+     * @param expression BPF expression, empty keeps every packet
+     * @return false if the expression is invalid or could not be installed
+     */
+    bool setCaptureFilter(const std::string& expression);
+
+    /**
+     * @brief Returns the filter of the current (or last) capture session.
+     */
+    packetscope::CaptureFilter captureFilter() const;
+
+    /**
+     * @brief Loads a pcap or pcapng file through the pipeline.
+     *
+     * Stops a running capture and clears the store like restart(), then maps
+     * the file and returns immediately. The dispatcher thread splits the file
+     * into chunks of PipelineConfig::fileChunkSize packets which the workers
+     * copy, parse and store in parallel, so packets show up while the load
+     * runs. IDs follow file order.
+     *
+     * @param path File to load
+     * @return false if the file cannot be opened or is no capture file
+     */
+    bool openFile(const std::string& path);
+
+    /**
+     * @brief Returns the progress and throughput of the last openFile().
+     * @return Progress, or std::nullopt if no file was loaded since the last start()
+     */
+    std::optional<packetscope::FileLoadProgress> fileLoadProgress() const;
+
+    /**
+     * @brief Starts writing every packet the dispatcher sees to pcapng files.
+     *
+     * Works while capturing: from the next batch on the dispatcher also
+     * queues each packet to a CaptureFileWriter, which encodes and writes
+     * it on its own threads. The recording continues across stop() / start()
+     * and restart() until stopRecording().
+     *
+     * @param config Output directory, rotation and ring of files
+     * @return false if already recording or the directory is not writable
+     */
+    bool startRecording(const packetscope::CaptureWriterConfig& config);
+
+    /**
+     * @brief Stops the recording, writing everything queued before returning.
+     */
+    void stopRecording();
+
+    /**
+     * @brief Returns the counters of the current recording.
+     * @return Statistics, or std::nullopt if not recording
+     */
+    std::optional<packetscope::CaptureWriterStats> recordingStats() const;
+
+    /**
+     * @brief Returns stage latencies, per thread counters and drops since the last restart().
+     *
+     * The threads keep recording meanwhile, nothing is locked on their side.
+     * Stage latencies are only recorded with PipelineConfig::collectMetrics,
+     * the queue and kernel counters always are.
+     */
+    packetscope::PipelineMetricsSnapshot metrics() const;
+
+    /**
+     * @brief Starts writing metrics() to a file every interval, in Prometheus or JSON format.
+     *
+     * Like a recording the export runs independent of stop() / start().
+     *
+     * @param config Output file, format and interval
+     * @return false if already exporting or the file cannot be written
+     */
+    bool startMetricsExport(const packetscope::MetricsExportConfig& config);
+
+    /**
+     * @brief Stops the export after writing a last snapshot.
+     */
+    void stopMetricsExport();
+
+    /**
+     * @brief Returns the settings of the running export, std::nullopt if not exporting.
+     */
+    std::optional<packetscope::MetricsExportConfig> metricsExport() const;
+
+    /**
+     * @brief Changes how much history the store keeps, also while capturing.
+     *
+     * Unlike setConfig() this needs no stop: the store evicts its oldest
+     * packets in the background once a limit is exceeded.
+     *
+     * @param retention New limits, stored in the configuration as well
+     */
+    void setStoreRetention(const packetscope::StoreRetentionConfig& retention);
+
+    /**
+     * @brief Starts or stops indexing the store, also while capturing.
+     *
+     * Packets stored so far are indexed in the background.
+     *
+     * @param isIndexing New value of PipelineConfig::indexStore
+     */
+    void setStoreIndexing(bool isIndexing);
+
     /**
      * @brief Checks if pipeline is currently running.
      * @return true if running, false otherwise
@@ -66,7 +218,7 @@ public:
      * @brief Lists available network devices for capture.
      * @return Vector of device information (name, description)
      */
-    std::vector<packetscope::DeviceInfo> listAvailableDevices() const;
+    static std::vector<packetscope::DeviceInfo> listAvailableDevices();
 
     /**
      * @brief Returns the packet store for UI access.
@@ -75,13 +227,113 @@ public:
      */
     std::shared_ptr<PacketStore> getStore() const;
 
+    /**
+     * @brief Returns the per layer details of a stored packet.
+     *
+     * Runs the detail pass (PacketProcessor::dissect()) on the stored raw
+     * bytes on demand and keeps the result in a small LRU cache.
+     * Safe to call while capture is running.
+     *
+     * @param packetId The packet ID
+     * @return Layer summaries, lowest first, or nullptr if the packet is not stored
+     */
+    std::shared_ptr<const PacketDetailCache::LayerDetails> layerDetails(int packetId) const;
+
+    /**
+     * @brief Returns the top talkers since the last restart().
+     *
+     * Folds the worker flow tables into the global view first, so the result
+     * is current. Empty if PipelineConfig::trackFlows is off.
+     *
+     * @param count Maximum number of flows
+     * @return Flows sorted by total bytes, largest first
+     */
+    std::vector<packetscope::FlowStats> topFlows(std::size_t count) const;
+
+    /**
+     * @brief Returns every tracked flow, in no particular order.
+     */
+    std::vector<packetscope::FlowStats> flows() const;
+
+    /**
+     * @brief Returns the reassembled TCP stream of the connection a packet belongs to.
+     *
+     * Safe to call while capture is running: the stream keeps growing, the
+     * result holds the chunks reassembled so far.
+     *
+     * @param packetId ID of any stored packet of the connection
+     * @return std::nullopt if PipelineConfig::reassembleTcp is off, the packet is not
+     *         stored or not TCP, or its connection carried no payload (within the limits)
+     */
+    std::optional<packetscope::TcpStream> tcpStream(int packetId) const;
+
+    /**
+     * @brief Returns the reassembly counters, e.g. to explain a connection without a stream.
+     */
+    packetscope::ReassemblyStats reassemblyStats() const;
+
+    /**
+     * @brief Returns true if TCP streams are reassembled (PipelineConfig::reassembleTcp in FlowAffine mode).
+     */
+    bool isReassemblingTcp() const;
+
     /**
      * @brief Returns current raw packet queue size.
      * Useful for monitoring backpressure and burst detection.
-     * @return Number of packets waiting to be processed
+     * @return Number of packets waiting to be processed, summed over all captures
      */
     std::size_t queueSize() const;
 
+    /**
+     * @brief Returns the number of packets dropped by all pipeline stages.
+     * @return Sum of raw queue and task queue drops since start
+     */
+    std::size_t droppedCount() const;
+
+    /**
+     * @brief Returns statistics of the capture -> dispatcher rings.
+     *
+     * With several captures size, capacity and drops are summed, the high
+     * water mark is that of the fullest ring.
+     *
+     * @return Size, capacity, drops and high water mark
+     */
+    packetscope::QueueStats rawQueueStats() const;
+
+    /**
+     * @brief Returns statistics of the dispatcher -> worker task queue.
+     *
+     * Size, capacity and high water mark count tasks (one dispatch batch
+     * each), drops count the packets of the batches that never ran. Drops
+     * and high water mark accumulate across stop()/start() and are reset by
+     * restart().
+     *
+     * @return Size, capacity, drops and high water mark
+     */
+    packetscope::QueueStats taskQueueStats() const;
+
+    /**
+     * @brief Replaces the pipeline configuration.
+     *
+     * Only allowed while the pipeline is stopped.
+     *
+     * @param config New settings
+     * @return true if applied, false if the pipeline is running
+     */
+    bool setConfig(const packetscope::PipelineConfig& config);
+
+    /**
+     * @brief Returns the current pipeline configuration.
+     */
+    packetscope::PipelineConfig config() const;
+
+    /**
+     * @brief Returns the number of worker threads of the current ThreadPool.
+     *
+     * Resolved from PipelineConfig::workerCount on start().
+     */
+    std::size_t workerCount() const;
+
     /**
      * @brief Returns total captured packet count since start
      * @return Number of packets captured since start
@@ -95,29 +347,215 @@ public:
     std::size_t processedCount() const;
 
 private:
+    /**
+     * @brief CPUs each pipeline thread may run on, empty means unpinned.
+     */
+    struct ThreadPlacement {
+        std::vector<int> capture;
+        std::vector<int> dispatcher;
+        std::vector<int> workers;
+    };
+
+    /**
+     * Buffer between capture and processing
+     *
+     * NOTE:
+     * RawPacketQueue uses a poison pill shutdown mechanism.
+     * std::nullopt is used exclusively as a termination signal
+     * for the dispatcher thread. Exactly one producer (capture thread)
+     * and one consumer (dispatcherThread_) are expected.
+     */
+    using RawPacketQueue = SpscRingBuffer<std::optional<packetscope::RawPacketData>>;
+
+    /**
+     * @brief One capture thread and the ring it feeds.
+     */
+    struct CaptureInput {
+        std::string deviceName;
+        std::unique_ptr<PacketCapture> capture;
+        std::unique_ptr<RawPacketQueue> queue;
+    };
+
+    /**
+     * @brief Resolves the CPU lists of config_ for the capture devices.
+     *
+     * Explicit lists are used as is. With PipelineConfig::pinToDeviceNumaNode
+     * the remaining threads get the CPUs of the first device's NUMA node.
+     */
+    ThreadPlacement placementFor(const std::vector<std::string>& deviceNames) const;
+
+    /**
+     * @brief Returns PipelineConfig::workerCount or the automatic size if it is 0.
+     */
+    std::size_t resolvedWorkerCount() const;
+
+    /**
+     * @brief Replaces threadPool_ (and workerBufferPools_) with a new pool sized and pinned per config_.
+     * @note Caller must hold controlMutex_, the previous pool must be shut down.
+     */
+    void createThreadPoolLocked(const ThreadPlacement& placement);
+
+    /**
+     * @brief Folds the current ThreadPool high water mark into retiredTaskQueueStats_.
+     * Called before the ThreadPool is replaced.
+     */
+    void retireThreadPoolStats();
+
+    /**
+     * @brief Starts PacketCapture feeding the raw packet ring, pinned per placement and filtered.
+     * @note Caller must hold controlMutex_.
+     */
+    bool startCapturesLocked(const ThreadPlacement& placement, const packetscope::CaptureFilter& filter);
+
+    /**
+     * @brief Creates one CaptureInput per device and fanout queue.
+     *
+     * Existing inputs are kept if they already match, so statistics survive
+     * stop() / start() on the same devices.
+     *
+     * @note Caller must hold controlMutex_, capture and dispatcher stopped.
+     */
+    void prepareCaptureInputsLocked(const std::vector<std::string>& deviceNames);
+
+    /**
+     * @brief Adds the counters of the current inputs to the retired totals.
+     * @note Caller must hold controlMutex_.
+     */
+    void retireCaptureInputStats();
+
+    /**
+     * @brief rawQueueStats(), taskQueueStats() and capturedCount() without taking the lock.
+     * @note Caller must hold controlMutex_.
+     */
+    packetscope::QueueStats rawQueueStatsLocked() const;
+    packetscope::QueueStats taskQueueStatsLocked() const;
+    std::size_t capturedCountLocked() const;
+
+    /**
+     * @brief Switches PipelineConfig::reassembleTcp off (with a warning) unless dispatch is flow affine.
+     */
+    void checkReassemblyConfig();
+
+    /**
+     * @brief Clears the store, caches and every counter before a new session.
+     * @note Caller must hold controlMutex_, pipeline stopped.
+     */
+    void resetSessionLocked();
+
+    /**
+     * @brief Starts the dispatcher thread running dispatcherLoop(), pinned per placement.
+     * @note Caller must hold controlMutex_.
+     */
+    void startDispatcherLocked(const ThreadPlacement& placement);
+
+    /**
+     * @brief Shutdown sequence shared by stop() and restart().
+     * @note Caller must hold controlMutex_.
+     */
+    void stopLocked();
+
+    /**
+     * @brief Dispatcher thread main loop.
+     *
+     * Drains up to PipelineConfig::dispatchBatchSize packets, waiting at most
+     * PipelineConfig::dispatchBatchTimeout after the first one, and submits
+     * them to the ThreadPool as a single task. Exits on the poison pill after
+     * submitting the last partial batch.
+     */
+    void dispatcherLoop();
+
+    /**
+     * @brief Dispatcher loop for several captures, a k-way merge by timestamp.
+     *
+     * Keeps the next packet of every ring and always emits the oldest one.
+     * A packet is held until every ring that has not finished has a packet
+     * queued, or for at most PipelineConfig::captureMergeWindow. A ring that
+     * stayed empty for a whole window is idle and holds nothing back until
+     * it delivers again, so a quiet capture does not delay every packet of
+     * a busy one. Exits once every ring delivered its poison pill.
+     */
+    void mergingDispatcherLoop();
+
+    /**
+     * @brief Dispatcher loop of a file session.
+     *
+     * Reads chunks from fileReader_, numbers them and dispatches each as one
+     * batch. Keeps at most kFileChunksInFlightPerWorker chunks per worker
+     * outstanding, waits for the last one and logs the throughput.
+     */
+    void fileDispatcherLoop();
+
+    /**
+     * @brief Submits a batch according to PipelineConfig::dispatchMode.
+     *
+     * Also queues the batch to the recording, if any.
+     */
+    void dispatch(std::vector<packetscope::RawPacketData> batch);
+
+    /**
+     * @brief Submits one task that parses a batch and stores it with one lock acquisition.
+     */
+    void submitBatch(std::vector<packetscope::RawPacketData> batch);
+
+    /**
+     * @brief Splits a batch by FlowKey hash and submits each part to its worker.
+     *
+     * Used in DispatchMode::FlowAffine. Packets without a FlowKey (non IP,
+     * truncated) are submitted as one stealable task.
+     */
+    void submitFlowAffine(std::vector<packetscope::RawPacketData> batch);
+
+    /**
+     * @brief Wraps packets into a parse task and submits it.
+     * @param worker Target worker for affine tasks, WorkStealingThreadPool::kNoWorker for any
+     */
+    void submitTask(std::vector<packetscope::RawPacketData> packets, std::size_t worker);
 
     // Packet storage (shared with UI)
     std::shared_ptr<PacketStore> packetStore_;
 
-    // Packet capture (PcapPlusPlus wrapper)
-    std::unique_ptr<PacketCapture> packetCapture_;
+    // Packets of dispatch batches that never ran, declared before threadPool_
+    // so that tasks destroyed with the pool can still count themselves
+    std::atomic<std::size_t> taskQueueDroppedPackets_{0};
 
     // Worker thread pool
-    std::unique_ptr<ThreadPool> threadPool_;
+    std::unique_ptr<WorkStealingThreadPool> threadPool_;
+
+    // Pool per worker that borrowed ring frames are copied into before they are
+    // stored (TPacketV3 backend only), replaced with threadPool_
+    std::vector<std::shared_ptr<PacketBufferPool>> workerBufferPools_;
+
+    // Task queue high water mark of ThreadPools replaced since the last restart()
+    packetscope::QueueStats retiredTaskQueueStats_;
 
     // Stateless packet parser
     PacketProcessor packetProcessor_;
 
-    /**
-     * Buffer between capture and processing
-     *
-     * NOTE:
-     * rawPacketQueue_ uses a poison pill shutdown mechanism.
-     * std::nullopt is used exclusively as a termination signal
-     * for the dispatcher thread. Only a single consumer
-     * (dispatcherThread_) is expected.
-     */
-    ThreadSafeQueue<std::optional<packetscope::RawPacketData>> rawPacketQueue_;
+    // Recently dissected packets of the detail view (cleared with the store)
+    mutable PacketDetailCache detailCache_;
+
+    // Per worker flow tables and their merged view (cleared with the store)
+    mutable FlowTracker flowTracker_;
+
+    // Per worker TCP reassemblers (cleared with the store)
+    StreamTracker streamTracker_;
+
+    // Pipeline settings (applied on start)
+    packetscope::PipelineConfig config_;
+
+    // Captures and their rings, each Pcap capture copies into its own PacketBufferPool
+    std::vector<CaptureInput> captureInputs_;
+
+    // Ring statistics, captured count and kernel counters of inputs replaced since the last restart()
+    packetscope::QueueStats retiredRawQueueStats_;
+    std::size_t retiredCapturedCount_{0};
+    packetscope::KernelCaptureStats retiredKernelStats_;
+
+    // Stage latencies and counters of every pipeline thread (reset by restart())
+    PipelineMetrics metrics_;
+
+    // Next packet ID source, assigned in merged order (dispatcher thread only while running)
+    uint64_t nextSequence_{0};
 
     // Dispatcher thread (queue -> pool)
     std::thread dispatcherThread_;
@@ -126,13 +564,38 @@ private:
     std::atomic<bool> isRunning_{false};
 
     // Mutex for start/stop coordination
-    std::mutex controlMutex_;
+    mutable std::mutex controlMutex_;
+
+    // Threads besides the captures kept free of workers by the automatic worker count
+    static constexpr std::size_t kDispatcherThreadCount = 1;
+
+    // Current device names (for restart)
+    std::vector<std::string> currentDeviceNames_;
+
+    // Kernel filter of the current session, kept for restart()
+    packetscope::CaptureFilter currentFilter_;
+
+    // Chunks the file dispatcher may run ahead of the workers, per worker
+    static constexpr std::size_t kFileChunksInFlightPerWorker = 8;
+
+    // How long the file dispatcher sleeps while the workers catch up
+    static constexpr std::chrono::microseconds kFileBackpressureSleep{100};
+
+    // Source of a file session, kept after it finished for fileLoadProgress()
+    std::unique_ptr<CaptureFileReader> fileReader_;
+    std::atomic<bool> isFileStopRequested_{false};
+    std::atomic<bool> isFileLoadFinished_{false};
+    std::chrono::steady_clock::time_point fileLoadStart_;
+    std::atomic<int64_t> fileLoadDurationNs_{0};
 
-    // Worker thread count
-    static constexpr std::size_t kWorkerCount = 2;
+    // Recording of dispatched packets. The dispatcher is its only producer,
+    // recordingMutex_ is taken once per batch and to replace it.
+    mutable std::mutex recordingMutex_;
+    std::unique_ptr<CaptureFileWriter> captureWriter_;
 
-    // Current device name (for restart)
-    std::string currentDeviceName_;
+    // Metrics file export; its thread calls metrics(), so it is stopped without holding controlMutex_
+    mutable std::mutex metricsExportMutex_;
+    std::unique_ptr<MetricsExporter> metricsExporter_;
 };
 
 #endif
\ No newline at end of file
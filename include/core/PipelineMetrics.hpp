@@ -0,0 +1,329 @@
+#ifndef PIPELINEMETRICS_HPP_
+#define PIPELINEMETRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "QueuePolicy.hpp"
+
+/**
+ * @file PipelineMetrics.hpp
+ * @brief Per thread stage latencies and counters of the pipeline, and their snapshot.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief Timed steps of a packet's way through the pipeline.
+ */
+enum class PipelineStage {
+    CaptureCallback,    ///< Capture thread handing a batch to its raw ring, per batch
+    RawQueueWait,       ///< Capture timestamp until the dispatcher hands the packet on, per packet (live only)
+    TaskQueueWait,      ///< Submission of a worker task until it starts, per task
+    Process,            ///< PacketProcessor::process(), per packet
+    StoreInsert         ///< PacketStore::addPackets(), per task
+};
+
+constexpr std::size_t kPipelineStageCount = 5;
+
+/**
+ * @brief Returns the snake case name of a stage, as used in the exported metrics.
+ */
+const char* pipelineStageName(PipelineStage stage);
+
+/**
+ * @brief Log-linear (HDR style) histogram of nanosecond latencies.
+ *
+ * Values below kSubBucketCount have a bucket each; above, every power of two
+ * is split into kSubBucketCount buckets, so a bucket is at most 1/32 of its
+ * value wide at any magnitude. Values from 2^kMaxValueBits ns (about 18
+ * minutes) on share the last bucket.
+ */
+struct LatencyHistogram {
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr std::size_t kSubBucketCount = std::size_t{1} << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 40;
+    static constexpr std::size_t kBucketCount = kSubBucketCount * (kMaxValueBits - kSubBucketBits + 1);
+
+    std::vector<uint64_t> counts = std::vector<uint64_t>(kBucketCount);
+    uint64_t count{};                   ///< Recorded values
+    uint64_t sum{};                     ///< Sum of the recorded values in ns
+    uint64_t max{};                     ///< Largest recorded value in ns
+
+    /**
+     * @brief Returns the bucket a value is counted in.
+     */
+    static std::size_t bucketFor(uint64_t value) {
+        if (value < kSubBucketCount) {
+            return static_cast<std::size_t>(value);
+        }
+        // Position of the highest set bit, at least kSubBucketBits here
+        const auto exponent = static_cast<unsigned>(63 - __builtin_clzll(value));
+        if (exponent >= kMaxValueBits) {
+            return kBucketCount - 1;
+        }
+        // The kSubBucketBits bits below the highest one pick the bucket within the octave
+        const unsigned shift = exponent - kSubBucketBits;
+        return kSubBucketCount * (shift + 1) + static_cast<std::size_t>((value >> shift) - kSubBucketCount);
+    }
+
+    /**
+     * @brief Returns the largest value counted in a bucket.
+     */
+    static uint64_t bucketUpperBound(std::size_t bucket);
+
+    /**
+     * @brief Returns the value below which the given share of the values lies.
+     *
+     * Reported as the upper bound of the bucket (but at most max), i.e.
+     * overestimated by less than 1/32.
+     *
+     * @param quantile Share in [0, 1], e.g. 0.99
+     * @return Latency in ns, 0 if nothing was recorded
+     */
+    uint64_t percentile(double quantile) const;
+
+    /**
+     * @brief Returns the average value in ns, 0 if nothing was recorded.
+     */
+    double mean() const;
+
+    /**
+     * @brief Adds the values of another histogram.
+     */
+    void merge(const LatencyHistogram& other);
+};
+
+/**
+ * @brief Count, sum and maximum of one stage on one thread.
+ */
+struct StageTotals {
+    uint64_t count{};
+    uint64_t sum{};                     ///< ns
+    uint64_t max{};                     ///< ns
+};
+
+/**
+ * @brief Counters of one pipeline thread.
+ */
+struct ThreadMetricsSnapshot {
+    std::string name;                   ///< "capture-0", "dispatcher", "worker-3", ...
+    uint64_t packets{};                 ///< Packets handled
+    uint64_t batches{};                 ///< Batches (capture, dispatcher) or tasks (workers) handled
+    uint64_t busyNs{};                  ///< Time spent on them
+    std::array<StageTotals, kPipelineStageCount> stages{};
+};
+
+/**
+ * @brief Counters of one capture socket and its raw ring.
+ */
+struct CaptureMetrics {
+    std::string deviceName;
+    KernelCaptureStats kernel;
+    QueueStats rawQueue;
+    uint64_t captured{};                ///< Packets handed to the ring
+};
+
+/**
+ * @brief Everything PipelineController::metrics() reports, since the last restart().
+ *
+ * Where packets are lost, in pipeline order: kernel.dropped and
+ * kernel.interfaceDropped (before the capture thread), rawQueue.dropped
+ * (capture -> dispatcher ring), taskQueue.dropped (dispatcher -> workers).
+ * All of them count packets; taskQueue size, capacity and high water mark
+ * count tasks of up to PipelineConfig::dispatchBatchSize packets.
+ */
+struct PipelineMetricsSnapshot {
+    /// Stage histograms merged over every thread, index is PipelineStage
+    std::array<LatencyHistogram, kPipelineStageCount> stages;
+
+    std::vector<ThreadMetricsSnapshot> threads;
+    std::vector<CaptureMetrics> captures;
+
+    /// Kernel counters of every capture, those replaced since the last restart() included
+    KernelCaptureStats kernel;
+
+    QueueStats rawQueue;
+    QueueStats taskQueue;
+    uint64_t captured{};
+    uint64_t processed{};
+
+    /// When the snapshot was taken, ms since the epoch
+    int64_t timestampMs{};
+
+    /**
+     * @brief Returns the merged histogram of a stage.
+     */
+    const LatencyHistogram& stage(PipelineStage stage) const;
+
+    /**
+     * @brief Formats the snapshot in the Prometheus text exposition format.
+     *
+     * Stage latencies are summaries (p50, p90, p99, p99.9 in seconds, plus
+     * _sum, _count and a _max gauge); threads and captures are labelled.
+     */
+    std::string toPrometheus() const;
+
+    /**
+     * @brief Formats the snapshot as a JSON object, latencies in ns.
+     */
+    std::string toJson() const;
+};
+
+}
+
+/**
+ * @brief Stage latencies and counters recorded by one pipeline thread.
+ *
+ * Every counter has exactly one writer, the owning thread, which updates it
+ * with a relaxed load and store instead of a read-modify-write: recording
+ * costs a few plain memory accesses and never contends. Readers (snapshot())
+ * may run at any time and see each counter whole, though not necessarily
+ * all of them from the same instant.
+ *
+ * @note record() and addWork() only from the owning thread; reset() only
+ * while that thread does not record.
+ */
+class ThreadMetrics {
+public:
+    /**
+     * @brief Constructs zeroed metrics.
+     * @param name Thread name reported in the snapshot
+     */
+    explicit ThreadMetrics(std::string name);
+
+    ThreadMetrics(const ThreadMetrics&) = delete;
+    ThreadMetrics& operator=(const ThreadMetrics&) = delete;
+    ThreadMetrics(ThreadMetrics&&) = delete;
+    ThreadMetrics& operator=(ThreadMetrics&&) = delete;
+
+    /**
+     * @brief Returns the current time of the clock the stages are timed with, in ns.
+     */
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Records one latency value of a stage (owning thread only).
+     */
+    void record(packetscope::PipelineStage stage, uint64_t nanoseconds) {
+        Recorder& recorder = recorders_[static_cast<std::size_t>(stage)];
+        increment(recorder.counts[packetscope::LatencyHistogram::bucketFor(nanoseconds)], 1);
+        increment(recorder.count, 1);
+        increment(recorder.sum, nanoseconds);
+        if (nanoseconds > recorder.max.load(std::memory_order_relaxed)) {
+            recorder.max.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Counts a handled batch of packets (owning thread only).
+     */
+    void addWork(uint64_t packets, uint64_t busyNanoseconds) {
+        increment(packets_, packets);
+        increment(batches_, 1);
+        increment(busyNs_, busyNanoseconds);
+    }
+
+    /**
+     * @brief Returns the counters and per stage totals.
+     */
+    packetscope::ThreadMetricsSnapshot snapshot() const;
+
+    /**
+     * @brief Adds the histograms of this thread to stages (index is PipelineStage).
+     */
+    void mergeInto(std::array<packetscope::LatencyHistogram, packetscope::kPipelineStageCount>& stages) const;
+
+    /**
+     * @brief Zeroes every counter.
+     */
+    void reset();
+
+private:
+    struct Recorder {
+        std::array<std::atomic<uint64_t>, packetscope::LatencyHistogram::kBucketCount> counts;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+
+    /// Single writer increment, no locked instruction
+    static void increment(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::string name_;
+    std::array<Recorder, packetscope::kPipelineStageCount> recorders_;
+    std::atomic<uint64_t> packets_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<uint64_t> busyNs_;
+};
+
+/**
+ * @brief The ThreadMetrics of every pipeline thread.
+ *
+ * Each thread writes its own ThreadMetrics, on its own allocation, and
+ * collect() folds them into a snapshot without locking the writers.
+ *
+ * The set only grows (resize()), so threads gone since the last reset(),
+ * e.g. workers of a larger earlier pool, stay in the totals.
+ *
+ * @note resize() and reset() only while no pipeline thread runs; the
+ * caller serializes them with collect() (PipelineController::controlMutex_).
+ */
+class PipelineMetrics {
+public:
+    PipelineMetrics();
+
+    PipelineMetrics(const PipelineMetrics&) = delete;
+    PipelineMetrics& operator=(const PipelineMetrics&) = delete;
+    PipelineMetrics(PipelineMetrics&&) = delete;
+    PipelineMetrics& operator=(PipelineMetrics&&) = delete;
+
+    /**
+     * @brief Makes sure there are metrics for this many capture and worker threads.
+     */
+    void resize(std::size_t captureCount, std::size_t workerCount);
+
+    /**
+     * @brief Returns the metrics of capture thread index, nullptr if there is none.
+     */
+    ThreadMetrics* capture(std::size_t index) const;
+
+    /**
+     * @brief Returns the metrics of worker index, nullptr if there is none (e.g. kNoWorker).
+     */
+    ThreadMetrics* worker(std::size_t index) const;
+
+    /**
+     * @brief Returns the metrics of the dispatcher thread.
+     */
+    ThreadMetrics& dispatcher() const;
+
+    /**
+     * @brief Fills the stage histograms and thread list of a snapshot.
+     */
+    void collect(packetscope::PipelineMetricsSnapshot& snapshot) const;
+
+    /**
+     * @brief Zeroes the metrics of every thread.
+     */
+    void reset();
+
+private:
+    std::unique_ptr<ThreadMetrics> dispatcher_;
+    std::vector<std::unique_ptr<ThreadMetrics>> captures_;
+    std::vector<std::unique_ptr<ThreadMetrics>> workers_;
+};
+
+#endif
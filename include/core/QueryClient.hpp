@@ -0,0 +1,99 @@
+#ifndef QUERYCLIENT_HPP_
+#define QUERYCLIENT_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "QueryProtocol.hpp"
+
+/**
+ * @brief Client side of QueryServer: browses the packets of a packet-scope-daemon.
+ *
+ * Blocking, one request at a time; use one client per thread. Replies are
+ * received straight into the caller's vectors (rows, IDs) or one reused
+ * buffer (raw bytes), so there is no copy or allocation per packet.
+ *
+ * Every call returns false (or std::nullopt) on failure, lastError() then
+ * holds the reason. A lost connection cannot be resumed, connect again.
+ */
+class QueryClient {
+public:
+    /**
+     * @brief Raw bytes of one packet of a packetData() reply.
+     */
+    struct PacketData {
+        packetscope::QueryPacketRecord record;
+        const uint8_t* data{nullptr};  ///< record.rawDataLen bytes, valid until the next request
+    };
+
+    /**
+     * @brief Connects to a daemon and checks the protocol version.
+     * @param socketPath QueryServerConfig::socketPath of the daemon
+     * @return Connected client, nullptr if unreachable or incompatible (logged)
+     */
+    static std::unique_ptr<QueryClient> connect(const std::string& socketPath);
+
+    ~QueryClient();
+
+    QueryClient(const QueryClient&) = delete;
+    QueryClient& operator=(const QueryClient&) = delete;
+    QueryClient(QueryClient&&) = delete;
+    QueryClient& operator=(QueryClient&&) = delete;
+
+    /**
+     * @brief Returns the pipeline counters and the range of stored IDs.
+     */
+    std::optional<packetscope::QueryStatusReply> status();
+
+    /**
+     * @brief Reads the summary rows of the stored packets in [firstId, firstId + count).
+     * @param records Replaced with the rows, at most kMaxQueryPackets
+     */
+    bool packets(int firstId, uint32_t count, std::vector<packetscope::QueryPacketRecord>& records);
+
+    /**
+     * @brief Reads rows and raw bytes of the stored packets in [firstId, firstId + count).
+     * @param packets Replaced with the packets, at most kMaxQueryPacketData; bytes valid until the next request
+     */
+    bool packetData(int firstId, uint32_t count, std::vector<PacketData>& packets);
+
+    /**
+     * @brief Returns the IDs in [firstId, lastId] matching a display filter, see DisplayFilter.
+     * @param ids Replaced with the matching IDs, ascending
+     */
+    bool filter(const std::string& expression, int firstId, int lastId, std::vector<int>& ids);
+
+    /**
+     * @brief Returns why the last call failed.
+     */
+    const std::string& lastError() const;
+
+private:
+    explicit QueryClient(int fd);
+
+    /**
+     * @brief Sends a request and reads the header of its reply.
+     *
+     * On an error status reads the message into lastError_ and returns false,
+     * otherwise the caller reads reply.length payload bytes.
+     */
+    bool call(packetscope::QueryType type, const void* payload, std::size_t size, packetscope::QueryHeader& reply,
+              const std::string& trailer = {});
+
+    bool sendAll(const void* data, std::size_t size);
+    bool receiveAll(void* data, std::size_t size);
+
+    /**
+     * @brief Closes the connection after it got out of step, every later call fails.
+     */
+    bool fail(const std::string& error);
+
+    int fd_;
+    std::vector<uint8_t> packetBuffer_;  ///< Last packetData() reply, PacketData::data points into it
+    std::string lastError_;
+};
+
+#endif
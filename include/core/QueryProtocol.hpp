@@ -0,0 +1,145 @@
+#ifndef QUERYPROTOCOL_HPP_
+#define QUERYPROTOCOL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "PacketAddress.hpp"
+
+/**
+ * @file QueryProtocol.hpp
+ * @brief Wire format between QueryServer (packet-scope-daemon) and QueryClient.
+ *
+ * A local Unix stream socket carries requests and their replies in order,
+ * one reply per request. Every message is a QueryHeader followed by
+ * header.length payload bytes. The structs below are sent as they are, in
+ * host byte order: client and daemon run on the same machine.
+ *
+ * Requests and replies (payload):
+ * - Hello:      uint32 version -> uint32 version, VersionMismatch if they differ
+ * - Status:     empty -> QueryStatusReply
+ * - Packets:    QueryRangeRequest -> QueryPacketRecord of every stored packet in the range
+ * - PacketData: QueryRangeRequest -> per stored packet a QueryPacketRecord, then rawDataLen bytes
+ * - Filter:     QueryFilterRequest, then the expression -> int32 IDs of the matches, ascending
+ *
+ * A reply with a status other than Ok carries an error message instead.
+ */
+
+namespace packetscope {
+
+/// Incremented on every incompatible change of the structs below
+constexpr uint32_t kQueryProtocolVersion = 1;
+
+/// Largest request payload the server reads (filter expressions)
+constexpr std::size_t kMaxQueryRequestSize = 64 << 10;
+
+/// Most records of one Packets reply
+constexpr uint32_t kMaxQueryPackets = 4096;
+
+/// Most packets of one PacketData reply, bounds the reply to about 64 MiB of full frames
+constexpr uint32_t kMaxQueryPacketData = 256;
+
+enum class QueryType : uint16_t {
+    Hello = 1,
+    Status = 2,
+    Packets = 3,
+    PacketData = 4,
+    Filter = 5
+};
+
+enum class QueryStatus : uint16_t {
+    Ok = 0,
+    BadRequest,         ///< Payload too short or too long for the type
+    UnknownType,
+    VersionMismatch,
+    InvalidFilter,      ///< The display filter does not compile
+    NotReady,           ///< Requested before Hello
+    Busy                ///< Client limit reached, the server closes the connection
+};
+
+struct QueryHeader {
+    uint32_t length{};  ///< Payload bytes following the header
+    QueryType type{QueryType::Hello};
+    QueryStatus status{QueryStatus::Ok};  ///< Ok in requests
+};
+
+/**
+ * @brief Counters of the pipeline, see PipelineController::metrics() and PacketStore.
+ */
+struct QueryStatusReply {
+    uint64_t storedCount{};             ///< PacketStore::count(), the newest ID that can be read
+    uint64_t firstId{};                 ///< PacketStore::firstId(), older packets were evicted
+    uint64_t capturedCount{};
+    uint64_t processedCount{};
+    uint64_t rawQueueDropped{};
+    uint64_t taskQueueDropped{};        ///< Packets of the dispatch batches that never ran
+    uint64_t kernelReceived{};
+    uint64_t kernelDropped{};
+    uint64_t interfaceDropped{};
+    uint64_t rawBytesInMemory{};
+    uint64_t rawBytesSpilled{};
+    uint32_t isRunning{};
+    uint32_t workerCount{};
+};
+
+/**
+ * @brief IDs [firstId, firstId + count) of a Packets or PacketData request.
+ *
+ * The server answers the stored part of the range, at most kMaxQueryPackets
+ * (kMaxQueryPacketData) packets.
+ */
+struct QueryRangeRequest {
+    int32_t firstId{};
+    uint32_t count{};
+};
+
+/**
+ * @brief IDs [firstId, lastId] tested by a Filter request, the expression follows.
+ */
+struct QueryFilterRequest {
+    int32_t firstId{};
+    int32_t lastId{};
+};
+
+/**
+ * @brief Summary columns of one stored packet, as the packet list shows them.
+ */
+struct QueryPacketRecord {
+    int64_t seconds{};
+    uint64_t protocol{};                ///< pcpp::ProtocolType
+    int32_t id{};
+    uint32_t nanoseconds{};
+    int32_t rawDataLen{};
+    int32_t frameLength{};
+    std::array<uint8_t, PacketAddress::kMaxSize> srcAddr{};
+    std::array<uint8_t, PacketAddress::kMaxSize> dstAddr{};
+    uint16_t linkLayerType{};           ///< pcpp::LinkLayerType
+    uint16_t srcPort{};
+    uint16_t dstPort{};
+    uint8_t ipProtocol{};
+    PacketAddress::Family srcFamily{PacketAddress::Family::None};
+    PacketAddress::Family dstFamily{PacketAddress::Family::None};
+    std::array<uint8_t, 7> reserved{};
+
+    PacketAddress sourceAddress() const {
+        return PacketAddress::from(srcFamily, srcAddr.data());
+    }
+
+    PacketAddress destinationAddress() const {
+        return PacketAddress::from(dstFamily, dstAddr.data());
+    }
+};
+
+// The layouts are the protocol: no implicit padding, copyable as bytes
+static_assert(sizeof(QueryHeader) == 8, "QueryHeader layout changed");
+static_assert(sizeof(QueryStatusReply) == 96, "QueryStatusReply layout changed");
+static_assert(sizeof(QueryRangeRequest) == 8, "QueryRangeRequest layout changed");
+static_assert(sizeof(QueryFilterRequest) == 8, "QueryFilterRequest layout changed");
+static_assert(sizeof(QueryPacketRecord) == 80, "QueryPacketRecord layout changed");
+static_assert(std::is_trivially_copyable<QueryPacketRecord>::value, "QueryPacketRecord is sent as bytes");
+
+}
+
+#endif
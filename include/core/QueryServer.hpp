@@ -0,0 +1,130 @@
+#ifndef QUERYSERVER_HPP_
+#define QUERYSERVER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PipelineConfig.hpp"
+#include "QueryProtocol.hpp"
+
+class PipelineController;
+
+/**
+ * @brief Serves the packets of a running pipeline over a Unix socket (QueryProtocol.hpp).
+ *
+ * Lets a GUI or CLI attach to a headless packet-scope-daemon: status,
+ * summary rows, raw bytes and display filter matches. Requests only read
+ * the PacketStore (scan() / visit()) like the GUI's packet list, so the
+ * capture path never waits on a client.
+ *
+ * Nothing is copied per packet on the way out: summary rows are written
+ * from the store columns into one reply buffer, raw bytes are sent with
+ * sendmsg() straight from the stored PacketBuffers, which are only
+ * referenced while the reply is being sent.
+ *
+ * Threads: one accepting connections, one per client. All of them poll
+ * so the destructor can stop them within kPollTimeoutMs.
+ */
+class QueryServer {
+public:
+    /**
+     * @brief Binds the socket and starts accepting clients.
+     *
+     * A stale socket file of an earlier daemon is replaced. The controller
+     * must outlive the server.
+     *
+     * @param config Socket path, client limit, filter threads and CPUs
+     * @param controller Pipeline whose packets are served
+     * @return Running server, nullptr if the socket cannot be bound
+     */
+    static std::unique_ptr<QueryServer> start(const packetscope::QueryServerConfig& config,
+                                              PipelineController& controller);
+
+    /**
+     * @brief Disconnects every client, joins the threads and removes the socket file.
+     */
+    ~QueryServer();
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    QueryServer(QueryServer&&) = delete;
+    QueryServer& operator=(QueryServer&&) = delete;
+
+    /**
+     * @brief Returns the number of clients currently connected.
+     */
+    std::size_t clientCount() const;
+
+private:
+    /// Timeout of every poll(), bounds how long the destructor waits for a thread
+    static constexpr int kPollTimeoutMs = 100;
+
+    /**
+     * @brief One connected client, served on its own thread.
+     */
+    struct Connection {
+        int fd{-1};
+        std::thread thread;
+        std::atomic<bool> isFinished{false};
+    };
+
+    QueryServer(packetscope::QueryServerConfig config, int listenFd, PipelineController& controller);
+
+    /**
+     * @brief Accept thread: takes new clients and joins the finished ones.
+     */
+    void acceptLoop();
+
+    /**
+     * @brief Client thread: reads requests and answers them until the client disconnects.
+     */
+    void serve(Connection& connection);
+
+    /**
+     * @brief Reads exactly size bytes, polling so a stop request is noticed.
+     * @return false on disconnect, error or stop
+     */
+    bool receive(int fd, void* data, std::size_t size) const;
+
+    /**
+     * @brief Answers one request.
+     * @return false if the connection has to be closed (send failed)
+     */
+    bool handleRequest(int fd, const packetscope::QueryHeader& header, const std::vector<uint8_t>& payload,
+                       bool& isGreeted);
+
+    bool sendStatus(int fd);
+    bool sendPackets(int fd, const packetscope::QueryRangeRequest& request);
+    bool sendPacketData(int fd, const packetscope::QueryRangeRequest& request);
+    bool sendFilterMatches(int fd, const packetscope::QueryFilterRequest& request, const std::string& expression);
+
+    /**
+     * @brief Sends a reply without payload besides an error message.
+     */
+    static bool sendError(int fd, packetscope::QueryType type, packetscope::QueryStatus status,
+                          const std::string& message);
+
+    /**
+     * @brief Sends a header and payload held in one buffer.
+     */
+    static bool sendReply(int fd, packetscope::QueryType type, packetscope::QueryStatus status,
+                          const void* payload, std::size_t size);
+
+    packetscope::QueryServerConfig config_;
+    int listenFd_;
+    PipelineController& controller_;
+
+    std::atomic<bool> isStopRequested_{false};
+    std::atomic<std::size_t> clientCount_{0};
+
+    /// Only touched by the accept thread, then by the destructor after joining it
+    std::list<Connection> connections_;
+    std::thread acceptThread_;
+};
+
+#endif
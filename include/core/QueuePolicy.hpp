@@ -0,0 +1,55 @@
+#ifndef QUEUEPOLICY_HPP_
+#define QUEUEPOLICY_HPP_
+
+#include <cstddef>
+
+/**
+ * @file QueuePolicy.hpp
+ * @brief Capacity limits, overflow policies and statistics shared by pipeline queues.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief What a bounded queue does with a new element when it is under pressure.
+ */
+enum class OverflowPolicy {
+    Block,       ///< Producer waits until there is room (backpressure)
+    DropNewest,  ///< The incoming element is discarded
+    DropOldest,  ///< The oldest queued element is discarded to make room
+    Sample       ///< Above the sampling threshold only 1 in sampleRate elements is admitted
+};
+
+/**
+ * @brief Capacity and overflow behaviour of one pipeline stage.
+ */
+struct QueueLimits {
+    /// Default 1-in-N rate for OverflowPolicy::Sample
+    static constexpr std::size_t kDefaultSampleRate = 10;
+
+    std::size_t capacity{0};                        ///< Maximum queued elements, 0 means unbounded
+    OverflowPolicy policy{OverflowPolicy::Block};   ///< Behaviour when the queue is full
+    std::size_t sampleRate{kDefaultSampleRate};     ///< N for OverflowPolicy::Sample
+
+    /**
+     * @brief Queue length from which OverflowPolicy::Sample starts sampling.
+     * Sampling begins at three quarters of the capacity.
+     */
+    std::size_t samplingThreshold() const {
+        return capacity - capacity / 4;
+    }
+};
+
+/**
+ * @brief Point in time statistics of one pipeline queue.
+ */
+struct QueueStats {
+    std::size_t size{};             ///< Elements currently queued
+    std::size_t capacity{};         ///< Configured capacity, 0 means unbounded
+    std::size_t dropped{};          ///< Elements discarded by the overflow policy
+    std::size_t highWaterMark{};    ///< Largest queue length observed
+};
+
+}
+
+#endif
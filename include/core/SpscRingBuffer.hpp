@@ -0,0 +1,527 @@
+#ifndef SPSCRINGBUFFER_HPP_
+#define SPSCRINGBUFFER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "QueuePolicy.hpp"
+
+/**
+ * @brief Bounded lock-free single producer / single consumer ring buffer.
+ *
+ * Responsibilities:
+ *  - Wait-free tryPush()/tryPop() between exactly one producer thread and
+ *    exactly one consumer thread
+ *  - Apply an OverflowPolicy in offer() when the ring is under pressure
+ *  - Count dropped elements and track the high water mark
+ *  - Park the consumer when the ring stays empty
+ *
+ * Non responsibilities:
+ *  - No shutdown / stop / lifecycle management (same as ThreadSafeQueue)
+ *
+ * Head and tail live on separate cache lines and each side keeps a cached
+ * copy of the other side's index, so in steady state the producer and the
+ * consumer do not share any cache line except the slots themselves.
+ *
+ * Wakeups are batched: the consumer spins for a short while before parking
+ * on a condition variable, and the producer only takes the mutex and notifies
+ * when the consumer is actually parked. A burst of packets therefore costs a
+ * single wakeup instead of one notify_one() per push.
+ *
+ * OverflowPolicy::DropOldest cannot be served by the producer without giving
+ * up the single consumer property, so it is enforced on the consumer side:
+ * pop() discards the oldest elements once the ring is more than 7/8 full,
+ * until it is back at 3/4. The newest element in the ring is never discarded.
+ *
+ * @tparam T Type of elements stored in the ring
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+    /// Assumed cache line size used for padding
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    /**
+     * @brief Constructs a ring holding at least capacity elements.
+     *
+     * @param capacity Requested capacity, rounded up to the next power of two.
+     * If zero is provided, a capacity of one is used.
+     */
+    explicit SpscRingBuffer(std::size_t capacity)
+        : SpscRingBuffer(packetscope::QueueLimits{capacity, packetscope::OverflowPolicy::DropNewest}) {}
+
+    /**
+     * @brief Constructs a ring with the given capacity and overflow policy.
+     *
+     * @param limits Capacity (rounded up to the next power of two, zero means
+     * one as the ring is always bounded) and policy applied by offer()
+     */
+    explicit SpscRingBuffer(packetscope::QueueLimits limits)
+        : capacity_(roundUpToPowerOfTwo(limits.capacity))
+        , mask_(capacity_ - 1)
+        , slots_(new Slot[capacity_])
+        , policy_(limits.policy)
+        , sampleRate_(std::max(limits.sampleRate, std::size_t{1}))
+        , samplingThreshold_(packetscope::QueueLimits{capacity_, limits.policy, limits.sampleRate}.samplingThreshold())
+        , trimThreshold_(capacity_ - capacity_ / 8)
+        , trimTarget_(std::max(capacity_ - capacity_ / 4, std::size_t{1})) {}
+
+    ~SpscRingBuffer() {
+        clear();
+        delete[] slots_;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+    SpscRingBuffer(SpscRingBuffer&&) = delete;
+    SpscRingBuffer& operator=(SpscRingBuffer&&) = delete;
+
+    /**
+     * @brief Non blocking push (producer only).
+     *
+     * @param value Element to push, left untouched when the ring is full
+     * @return false if the ring was full and the element was dropped
+     */
+    bool tryPush(T&& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - cachedHead_ >= capacity_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ >= capacity_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        new (slots_[tail & mask_].raw()) T(std::move(value));
+        publish(tail + 1);
+        updateHighWaterMark(tail + 1);
+        return true;
+    }
+
+    /**
+     * @brief Push applying the configured OverflowPolicy (producer only).
+     *
+     * - Block:      Yields until there is room
+     * - DropNewest: Same as tryPush()
+     * - DropOldest: Same as tryPush(), the consumer trims old elements in pop()
+     * - Sample:     Above the sampling threshold only 1 in sampleRate elements is admitted
+     *
+     * @param value Element to push
+     * @return false if the element was discarded by the overflow policy
+     */
+    bool offer(T&& value) {
+        switch (policy_) {
+            case packetscope::OverflowPolicy::Block:
+                push(std::move(value));
+                return true;
+
+            case packetscope::OverflowPolicy::Sample:
+                if (approximateSizeForProducer() >= samplingThreshold_
+                    && (sampleCounter_++ % sampleRate_) != 0) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                return tryPush(std::move(value));
+
+            case packetscope::OverflowPolicy::DropNewest:
+            case packetscope::OverflowPolicy::DropOldest:
+            default:
+                return tryPush(std::move(value));
+        }
+    }
+
+    /**
+     * @brief offer() for a range of elements, publishing them at once (producer only).
+     *
+     * With DropNewest and DropOldest the elements that fit are moved in with a
+     * single tail update (and at most one consumer wakeup), the rest are
+     * dropped. Block and Sample fall back to offer() per element.
+     *
+     * @param first Iterator to the first element, elements are moved from
+     * @param last  Iterator one past the last element
+     * @return Number of elements admitted
+     */
+    template <typename Iterator>
+    std::size_t offerBatch(Iterator first, Iterator last) {
+        if (policy_ == packetscope::OverflowPolicy::Block || policy_ == packetscope::OverflowPolicy::Sample) {
+            std::size_t admitted = 0;
+            for (; first != last; ++first) {
+                if (offer(T(std::move(*first)))) {
+                    ++admitted;
+                }
+            }
+            return admitted;
+        }
+
+        const std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (capacity_ - (tail - cachedHead_) < count) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+        }
+        const std::size_t admitted = std::min(count, capacity_ - (tail - cachedHead_));
+
+        for (std::size_t i = 0; i < admitted; ++i, ++first) {
+            new (slots_[(tail + i) & mask_].raw()) T(std::move(*first));
+        }
+        if (admitted < count) {
+            dropped_.fetch_add(count - admitted, std::memory_order_relaxed);
+        }
+        if (admitted > 0) {
+            publish(tail + admitted);
+            updateHighWaterMark(tail + admitted);
+        }
+        return admitted;
+    }
+
+    /**
+     * @brief Blocking push (producer only).
+     *
+     * Yields until there is room for the element. Intended for control
+     * messages like poison pills, which must never be dropped.
+     *
+     * @param value Element to push
+     */
+    void push(T value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        while (tail - cachedHead_ >= capacity_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ >= capacity_) {
+                std::this_thread::yield();
+            }
+        }
+
+        new (slots_[tail & mask_].raw()) T(std::move(value));
+        publish(tail + 1);
+        updateHighWaterMark(tail + 1);
+    }
+
+    /**
+     * @brief Non blocking pop (consumer only).
+     *
+     * @return std::nullopt if the ring is empty.
+     */
+    std::optional<T> tryPop() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return std::nullopt;
+            }
+        }
+
+        T* slot = slots_[head & mask_].ptr();
+        std::optional<T> value(std::move(*slot));
+        slot->~T();
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    /**
+     * @brief Discards every element the consumer is not interested in.
+     */
+    struct IgnoreDiscarded {
+        void operator()(T&&) const noexcept {}
+    };
+
+    /**
+     * @brief Blocking pop (consumer only).
+     *
+     * Spins for kSpinCount attempts, then parks until the producer publishes
+     * a new element. With OverflowPolicy::DropOldest, elements trimmed from
+     * the front of the ring are handed to onDiscard before being destroyed.
+     *
+     * @param onDiscard Callable invoked with every element trimmed by DropOldest
+     * @return T
+     */
+    template <typename OnDiscard = IgnoreDiscarded>
+    T pop(OnDiscard&& onDiscard = OnDiscard{}) {
+        while (true) {
+            for (std::size_t spin = 0; spin < kSpinCount; ++spin) {
+                if (std::optional<T> value = tryPopTrimmed(onDiscard)) {
+                    return std::move(*value);
+                }
+            }
+            waitForData();
+        }
+    }
+
+    /**
+     * @brief Non blocking pop including the DropOldest trimming step of pop() (consumer only).
+     *
+     * @param onDiscard Callable invoked with every element trimmed by DropOldest
+     * @return std::nullopt if the ring is empty.
+     */
+    template <typename OnDiscard = IgnoreDiscarded>
+    std::optional<T> poll(OnDiscard&& onDiscard = OnDiscard{}) {
+        return tryPopTrimmed(onDiscard);
+    }
+
+    /**
+     * @brief Pop with deadline (consumer only).
+     *
+     * Same as pop(), but gives up once deadline has passed.
+     *
+     * @param deadline  Point in time after which the call returns empty handed
+     * @param onDiscard Callable invoked with every element trimmed by DropOldest
+     * @return std::nullopt if nothing arrived before the deadline
+     */
+    template <typename Clock, typename Duration, typename OnDiscard = IgnoreDiscarded>
+    std::optional<T> popUntil(const std::chrono::time_point<Clock, Duration>& deadline,
+                              OnDiscard&& onDiscard = OnDiscard{}) {
+        while (true) {
+            for (std::size_t spin = 0; spin < kSpinCount; ++spin) {
+                if (std::optional<T> value = tryPopTrimmed(onDiscard)) {
+                    return value;
+                }
+            }
+            if (!waitForDataUntil(deadline)) {
+                return tryPopTrimmed(onDiscard);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the current number of elements in the ring.
+     *
+     * Only accurate if neither side is running concurrently.
+     * Intended for monitoring and diagnostic purposes only.
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    /**
+     * @brief Returns the maximum number of elements the ring can hold.
+     */
+    std::size_t capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * @brief Returns the number of elements discarded because the ring was under pressure.
+     */
+    std::size_t droppedCount() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns size, capacity, drop count and high water mark.
+     * Intended for monitoring and diagnostic purposes only.
+     */
+    packetscope::QueueStats stats() const {
+        return packetscope::QueueStats{
+            size(),
+            capacity_,
+            dropped_.load(std::memory_order_relaxed),
+            highWaterMark_.load(std::memory_order_relaxed)
+        };
+    }
+
+    /**
+     * @brief Resets the drop counter and the high water mark.
+     *
+     * @warning Must not be called while the producer or the consumer is active.
+     */
+    void resetStats() {
+        dropped_.store(0, std::memory_order_relaxed);
+        highWaterMark_.store(size(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Destroys all elements in the ring.
+     *
+     * @warning Must not be called while the producer or the consumer is active.
+     */
+    void clear() {
+        while (tryPop()) {
+        }
+    }
+
+private:
+    /// Pop attempts before the consumer parks
+    static constexpr std::size_t kSpinCount = 256;
+
+    /**
+     * @brief Uninitialized storage for one element.
+     */
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+
+        void* raw() {
+            return bytes;
+        }
+
+        T* ptr() {
+            return std::launder(reinterpret_cast<T*>(bytes));
+        }
+    };
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+        std::size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Upper bound of the ring length as seen by the producer.
+     * Uses the cached head, so it may overestimate but never underestimates.
+     */
+    std::size_t approximateSizeForProducer() const {
+        return tail_.load(std::memory_order_relaxed) - cachedHead_;
+    }
+
+    /**
+     * @brief Tracks the largest observed length (producer only).
+     *
+     * The cached head only gives an upper bound, so the real head is only
+     * loaded when that bound would raise the high water mark.
+     */
+    void updateHighWaterMark(std::size_t newTail) {
+        const std::size_t current = highWaterMark_.load(std::memory_order_relaxed);
+        if (newTail - cachedHead_ <= current) {
+            return;
+        }
+        const std::size_t length = newTail - head_.load(std::memory_order_acquire);
+        if (length > current) {
+            highWaterMark_.store(length, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Consumer side of OverflowPolicy::DropOldest.
+     *
+     * Discards from the front once the ring is above trimThreshold_ until it
+     * is back at trimTarget_. The newest element is always kept, so a
+     * poison pill pushed last is never trimmed.
+     */
+    template <typename OnDiscard>
+    void trimOldest(OnDiscard& onDiscard) {
+        std::size_t length = size();
+        if (length <= trimThreshold_) {
+            return;
+        }
+        while (length > trimTarget_) {
+            std::optional<T> value = tryPop();
+            if (!value) {
+                break;
+            }
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            onDiscard(std::move(*value));
+            --length;
+        }
+    }
+
+    /**
+     * @brief Makes the element at tail - 1 visible and wakes a parked consumer.
+     *
+     * The seq_cst store/load pair with waitForData() (Dekker style) guarantees
+     * that either the consumer sees the new tail, or the producer sees the
+     * consumer's waiting flag.
+     */
+    void publish(std::size_t newTail) {
+        tail_.store(newTail, std::memory_order_seq_cst);
+
+        if (consumerWaiting_.load(std::memory_order_seq_cst)) {
+            {
+                std::lock_guard<std::mutex> lock(waitMutex_);
+            }
+            cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief tryPop() preceded by the DropOldest trimming step.
+     */
+    template <typename OnDiscard>
+    std::optional<T> tryPopTrimmed(OnDiscard& onDiscard) {
+        if (policy_ == packetscope::OverflowPolicy::DropOldest) {
+            trimOldest(onDiscard);
+        }
+        return tryPop();
+    }
+
+    /**
+     * @brief Returns true if the consumer has something to pop.
+     */
+    bool hasData() const {
+        return tail_.load(std::memory_order_seq_cst) != head_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Parks the consumer until the ring is non empty.
+     */
+    void waitForData() {
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        consumerWaiting_.store(true, std::memory_order_seq_cst);
+
+        cv_.wait(lock, [this] { return hasData(); });
+
+        consumerWaiting_.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Parks the consumer until the ring is non empty or deadline has passed.
+     * @return true if data is available
+     */
+    template <typename Clock, typename Duration>
+    bool waitForDataUntil(const std::chrono::time_point<Clock, Duration>& deadline) {
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        consumerWaiting_.store(true, std::memory_order_seq_cst);
+
+        const bool isDataAvailable = cv_.wait_until(lock, deadline, [this] { return hasData(); });
+
+        consumerWaiting_.store(false, std::memory_order_relaxed);
+        return isDataAvailable;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    Slot* const slots_;
+
+    // Overflow handling (immutable after construction)
+    const packetscope::OverflowPolicy policy_;
+    const std::size_t sampleRate_;
+    const std::size_t samplingThreshold_;
+    const std::size_t trimThreshold_;
+    const std::size_t trimTarget_;
+
+    // Consumer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_{0};
+
+    // Producer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t cachedHead_{0};
+    std::size_t sampleCounter_{0};
+    std::atomic<std::size_t> highWaterMark_{0};
+
+    // Written by both sides (drops are rare)
+    alignas(kCacheLineSize) std::atomic<std::size_t> dropped_{0};
+
+    // Consumer parking
+    alignas(kCacheLineSize) std::atomic<bool> consumerWaiting_{false};
+    std::mutex waitMutex_;
+    std::condition_variable cv_;
+};
+
+#endif
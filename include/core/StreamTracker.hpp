@@ -0,0 +1,113 @@
+#ifndef STREAMTRACKER_HPP_
+#define STREAMTRACKER_HPP_
+
+#include "TcpReassembler.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief TCP reassembly stage: one TcpReassembler per worker and their shared memory budget.
+ *
+ * Like FlowTracker, every worker reassembles into its own shard and takes
+ * the shard mutex once per batch; it is only ever contended by stream(),
+ * i.e. when the user follows a stream. The global limit is a single atomic
+ * byte count shared by the shards.
+ *
+ * Each shard needs every segment of its flows in order, so workers must be
+ * fed in DispatchMode::FlowAffine (shard = worker).
+ *
+ * @note update() may be called concurrently for different shards. reshard()
+ * must not run concurrently with update().
+ */
+class StreamTracker {
+public:
+    /**
+     * @brief Constructs a tracker.
+     * @param shardCount Number of shards (one per worker), at least 1
+     * @param limits Memory bounds of the streams
+     */
+    explicit StreamTracker(std::size_t shardCount = 1, const packetscope::ReassemblyLimits& limits = {});
+
+    StreamTracker(const StreamTracker&) = delete;
+    StreamTracker& operator=(const StreamTracker&) = delete;
+    StreamTracker(StreamTracker&&) = delete;
+    StreamTracker& operator=(StreamTracker&&) = delete;
+
+    /**
+     * @brief Runs updater(TcpReassembler&) on a shard's reassembler.
+     *
+     * Meant to wrap a whole batch, so the shard mutex is taken once per
+     * batch rather than per packet.
+     *
+     * @param shard Shard index, taken modulo the shard count
+     */
+    template <typename Updater>
+    void update(std::size_t shard, Updater&& updater) {
+        Shard& target = *shards_[shard % shards_.size()];
+        std::lock_guard<std::mutex> lock(target.mutex);
+        updater(*target.reassembler);
+    }
+
+    /**
+     * @brief Returns the current state of a flow's stream, std::nullopt if it has none.
+     *
+     * Copies the chunk handles only; the bytes are read from the shared
+     * buffers when the caller needs them.
+     */
+    std::optional<packetscope::TcpStream> stream(const packetscope::FlowKey& key) const;
+
+    /**
+     * @brief Returns the number of streams.
+     */
+    std::size_t streamCount() const;
+
+    /**
+     * @brief Returns the bytes held by every stream.
+     */
+    std::size_t bytes() const;
+
+    /**
+     * @brief Returns the stream, byte, eviction and refusal counts of every shard.
+     */
+    packetscope::ReassemblyStats stats() const;
+
+    /**
+     * @brief Removes every stream.
+     */
+    void clear();
+
+    /**
+     * @brief Recreates the shards, moving the streams to the shard of their flow.
+     *
+     * Used when the worker pool is recreated with a different size.
+     *
+     * @note Only while no thread is inside update().
+     */
+    void reshard(std::size_t shardCount, const packetscope::ReassemblyLimits& limits);
+
+private:
+    struct Shard {
+        Shard(const packetscope::ReassemblyLimits& limits, std::atomic<std::size_t>& totalBytes,
+              std::size_t shardCount)
+            : reassembler(std::make_unique<TcpReassembler>(limits, totalBytes, shardCount)) {}
+
+        mutable std::mutex mutex;
+        std::unique_ptr<TcpReassembler> reassembler;    ///< Guarded by mutex
+    };
+
+    /// Bytes of every shard, the global limit; declared first so it outlives the shards
+    std::atomic<std::size_t> totalBytes_{0};
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    /// Counters of the shards replaced by reshard(), until clear()
+    uint64_t retiredEvicted_{0};
+    uint64_t retiredRefused_{0};
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TPACKETCAPTUREBACKEND_HPP_
+#define TPACKETCAPTUREBACKEND_HPP_
+
+#include <atomic>
+#include <thread>
+
+#include "core/CaptureBackend.hpp"
+#include "core/PipelineConfig.hpp"
+
+/// mmap()ed ring and the socket it belongs to, defined in the translation unit
+struct TPacketRing;
+
+/**
+ * @brief AF_PACKET TPACKET_V3 backend (Linux).
+ *
+ * The kernel writes frames into a ring of blocks mmap()ed into the process
+ * and hands a block over once it is full or its timeout expired. The capture
+ * thread wakes up once per block, wraps every frame in a PacketBuffer that
+ * points into the ring (PacketBuffer::isBorrowed()) and delivers the block as
+ * one batch, without copying.
+ *
+ * The BPF filter is compiled with libpcap and attached to the socket
+ * (SO_ATTACH_FILTER); its return value doubles as the snap length.
+ *
+ * A block is given back to the kernel when the last frame handle referring to
+ * it is destroyed, so frames must be released (or copied) promptly: while
+ * every block is held the kernel drops incoming packets. The ring outlives
+ * stop() until its last frame is released.
+ */
+class TPacketCaptureBackend : public CaptureBackend {
+public:
+    /**
+     * @brief Constructs an idle backend.
+     * @param ringConfig Geometry of the receive ring created by start()
+     */
+    explicit TPacketCaptureBackend(packetscope::TPacketRingConfig ringConfig);
+    ~TPacketCaptureBackend() override;
+
+    TPacketCaptureBackend(const TPacketCaptureBackend&) = delete;
+    TPacketCaptureBackend& operator=(const TPacketCaptureBackend&) = delete;
+    TPacketCaptureBackend(TPacketCaptureBackend&&) = delete;
+    TPacketCaptureBackend& operator=(TPacketCaptureBackend&&) = delete;
+
+    bool start(const std::string& deviceName, const Options& options, FrameHandler handler) override;
+    void stop() override;
+    bool setFilter(const std::string& expression) override;
+    packetscope::KernelCaptureStats kernelStats() override;
+
+private:
+    /// How long the capture thread sleeps without a block to read, bounds how long stop() waits
+    static constexpr int kPollTimeoutMs = 100;
+
+    /// Fixed size of the frame slots the kernel lays out inside a block
+    static constexpr unsigned kFrameSize = 2048;
+
+    /**
+     * @brief Compiles the expression for the ring's link type and attaches it to the socket.
+     *
+     * The program returns the snap length for accepted packets, so the
+     * kernel also truncates them. Without expression and snap length the
+     * socket filter is removed.
+     */
+    bool attachFilter(int socketFd, const std::string& expression) const;
+
+    /**
+     * @brief Capture thread: waits for blocks and delivers them in ring order.
+     */
+    void captureLoop(std::vector<int> threadCpus);
+
+    /**
+     * @brief Wraps the frames of one block and hands them to handler_.
+     */
+    void deliverBlock(std::size_t blockIndex);
+
+    packetscope::TPacketRingConfig ringConfig_;
+    TPacketRing* ring_{nullptr};
+
+    /// Snap length of the session and the libpcap DLT the filter is compiled for
+    int snapLength_{0};
+    int dataLinkType_{0};
+    FrameHandler handler_;
+
+    /// Frames of the current block, reused between blocks (capture thread only)
+    std::vector<packetscope::RawPacketData> batch_;
+
+    std::thread captureThread_;
+    std::atomic<bool> isStopRequested_{false};
+
+    /// Sum of every PACKET_STATISTICS read of the session (each read resets the kernel's counters)
+    packetscope::KernelCaptureStats stats_;
+};
+
+#endif
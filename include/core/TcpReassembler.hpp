@@ -0,0 +1,294 @@
+#ifndef TCPREASSEMBLER_HPP_
+#define TCPREASSEMBLER_HPP_
+
+#include "FlowKey.hpp"
+#include "PacketBuffer.hpp"
+#include "PacketBufferPool.hpp"
+#include "PipelineConfig.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file TcpReassembler.hpp
+ * @brief Per worker reassembly of TCP payload into ordered byte streams.
+ */
+
+namespace packetscope {
+
+/**
+ * @brief A run of contiguous payload bytes of one direction.
+ */
+struct StreamChunk {
+    PacketBuffer buffer;        ///< Pooled bytes, empty for a gap
+    uint32_t offset{};          ///< First byte of the chunk in buffer
+    uint32_t size{};            ///< Bytes of the chunk
+    uint32_t missingBytes{};    ///< Bytes the capture lost at this point, a gap has no buffer
+    bool isReversed{false};     ///< Sent from B to A
+
+    const uint8_t* data() const {
+        return buffer.data() + offset;
+    }
+};
+
+/**
+ * @brief Reassembled payload of a TCP connection at the time it was taken.
+ *
+ * The chunks are in delivery order: sequence order per direction, both
+ * directions interleaved in the order their bytes became contiguous.
+ * They share the reassembler's buffers, no byte is copied.
+ */
+struct TcpStream {
+    FlowKey key;
+    std::vector<StreamChunk> chunks;
+    uint64_t bytesAToB{};
+    uint64_t bytesBToA{};
+    uint64_t missingBytes{};    ///< Bytes of every gap
+    bool isTruncated{false};    ///< A memory limit was reached, later data was dropped
+    bool isClosed{false};       ///< RST, or FIN in both directions seen
+};
+
+/**
+ * @brief Counters of TCP reassembly, see PipelineController::reassemblyStats().
+ */
+struct ReassemblyStats {
+    std::size_t streams{};          ///< Streams held
+    std::size_t bytes{};            ///< Bytes held by every stream
+    uint64_t evictedStreams{};      ///< Streams dropped to make room under ReassemblyLimits::maxBytes
+    uint64_t refusedStreams{};      ///< Connections not reassembled, nothing could be evicted
+};
+
+}
+
+/**
+ * @brief Reassembles the TCP payload of the flows of one worker.
+ *
+ * In DispatchMode::FlowAffine each flow is handled by a single worker in
+ * capture order, so one reassembler per worker sees every segment of its
+ * flows and needs no locking of its own.
+ *
+ * Per direction, segments arriving in order are appended to the stream;
+ * retransmitted bytes are skipped. Segments after a hole wait in a sequence
+ * ordered map and are delivered once the hole is filled, or, past
+ * ReassemblyLimits::maxOutOfOrderBytes, the hole is recorded as a gap.
+ *
+ * Payload is copied into slots of the worker's PacketBufferPool: in order
+ * bytes are packed into the current slot of the stream (the slot is filled
+ * further after a TcpStream shared it, past the bytes it refers to), an out
+ * of order segment keeps a slot of its own until it becomes a chunk itself.
+ *
+ * A stream is created by its first payload byte. The stream starts there
+ * unless the SYN of that direction was seen in the same segment; a segment
+ * retransmitted from before the start is ignored.
+ *
+ * Streams are kept in least recently used order, which within a worker is
+ * the capture order of their last segment. expireIfDue() releases streams
+ * whose packets the store evicted once they are closed or idle. Under the
+ * global limit the least recently used streams are evicted before new data
+ * is refused, and a shard holding more than its share of the limit trims
+ * itself so the other workers' streams keep room.
+ *
+ * @note Not thread safe, see StreamTracker.
+ */
+class TcpReassembler {
+public:
+    /// Bytes accounted per stream besides its chunks
+    static constexpr std::size_t kStreamOverhead = 256;
+
+    /**
+     * @brief Constructs an empty reassembler.
+     * @param limits Memory bounds, maxBytes applies to every reassembler sharing totalBytes
+     * @param totalBytes Bytes held by every reassembler sharing the global limit, must outlive this one
+     * @param shareCount Reassemblers sharing totalBytes, each one's share of maxBytes under pressure
+     */
+    TcpReassembler(const packetscope::ReassemblyLimits& limits, std::atomic<std::size_t>& totalBytes,
+                   std::size_t shareCount = 1);
+
+    /**
+     * @brief Returns the bytes held to totalBytes.
+     */
+    ~TcpReassembler();
+
+    TcpReassembler(const TcpReassembler&) = delete;
+    TcpReassembler& operator=(const TcpReassembler&) = delete;
+    TcpReassembler(TcpReassembler&&) = delete;
+    TcpReassembler& operator=(TcpReassembler&&) = delete;
+
+    /**
+     * @brief Adds one TCP segment of a flow.
+     * @param key Canonical flow key
+     * @param isReversed true if the segment travels from B to A
+     * @param segment Sequence, flags and payload, the payload is copied
+     * @param packetId Store ID of the packet carrying the segment
+     * @param timestamp Capture time of the packet in nanoseconds
+     */
+    void add(const packetscope::FlowKey& key, bool isReversed, const packetscope::TcpSegment& segment,
+             int packetId, uint64_t timestamp);
+
+    /**
+     * @brief Releases stale streams, at most once per kExpiryInterval of capture time.
+     *
+     * A stream whose packets are all evicted (its last one is older than
+     * firstStoredId) cannot be followed any more: it is released once it is
+     * closed or idle for ReassemblyLimits::idleTimeout. When the global limit
+     * is nearly reached, the streams above this reassembler's share are
+     * evicted, least recently used first.
+     *
+     * @param firstStoredId PacketStore::firstId()
+     */
+    void expireIfDue(int firstStoredId);
+
+    /**
+     * @brief Returns the current state of a flow's stream, std::nullopt if it has none.
+     */
+    std::optional<packetscope::TcpStream> stream(const packetscope::FlowKey& key) const;
+
+    /**
+     * @brief Moves every stream to targets[key.hash() % targets.size()], e.g. when the workers change.
+     *
+     * The streams keep their bytes and their share of the budget. Targets
+     * must share totalBytes with this reassembler.
+     */
+    void moveStreamsTo(const std::vector<TcpReassembler*>& targets);
+
+    /**
+     * @brief Removes every stream and returns their bytes to totalBytes.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of streams.
+     */
+    std::size_t streamCount() const;
+
+    /**
+     * @brief Returns the bytes held by the streams of this reassembler.
+     */
+    std::size_t bytes() const;
+
+    /**
+     * @brief Returns the streams of this reassembler evicted under the global limit.
+     */
+    uint64_t evictedCount() const;
+
+    /**
+     * @brief Returns the connections this reassembler could not start a stream for.
+     */
+    uint64_t refusedCount() const;
+
+private:
+    /// Capture time between two expiry passes of expireIfDue()
+    static constexpr uint64_t kExpiryInterval = 1000000000;
+
+    /**
+     * @brief Sequence state of one direction.
+     *
+     * Offsets count the payload bytes from the start of the direction, so the
+     * 32 bit sequence wraps without harm (streams are far below 2 GiB).
+     */
+    struct Direction {
+        uint32_t startSequence{};
+        uint32_t nextOffset{};                          ///< Next byte expected in order
+        bool hasStart{false};
+        bool hasFin{false};
+        std::map<uint32_t, packetscope::PacketBuffer> outOfOrder; ///< Segments after a hole, by offset
+        std::size_t outOfOrderBytes{};
+    };
+
+    struct Stream {
+        std::array<Direction, 2> directions;
+        std::vector<packetscope::StreamChunk> chunks;
+        packetscope::PacketBuffer tailSlot;             ///< Slot in order bytes of both directions are packed into
+        std::size_t tailUsed{};                         ///< Bytes of tailSlot written
+        std::size_t bytes{};                            ///< Accounted bytes of this stream
+        uint64_t missingBytes{};
+        uint64_t bytesAToB{};
+        uint64_t bytesBToA{};
+        bool isTruncated{false};
+        bool isClosed{false};
+        int lastPacketId{};                             ///< Newest packet carrying a segment
+        uint64_t lastSeen{};                            ///< Capture time of that packet, nanoseconds
+        std::list<packetscope::FlowKey>::iterator lruPosition;
+    };
+
+    using StreamMap = std::unordered_map<packetscope::FlowKey, Stream, packetscope::FlowKeyHash>;
+
+    /**
+     * @brief Appends in order payload to the stream, packed into the tail slot.
+     */
+    void appendInOrder(Stream& stream, bool isReversed, const uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Appends a held segment's bytes from skip on, as a chunk of its own.
+     */
+    void appendBuffer(Stream& stream, bool isReversed, packetscope::PacketBuffer buffer, std::size_t skip);
+
+    /**
+     * @brief Records a gap of bytes the capture missed.
+     */
+    void appendGap(Stream& stream, bool isReversed, std::size_t size);
+
+    /**
+     * @brief Delivers the held segments that are in order now, skips a hole if too much is held.
+     */
+    void drainOutOfOrder(Stream& stream, bool isReversed);
+
+    /**
+     * @brief Accounts size more bytes to the stream, false (and the stream marked truncated) over a limit.
+     *
+     * Over the global limit, the least recently used other streams are evicted first.
+     */
+    bool reserve(Stream& stream, std::size_t size);
+
+    /**
+     * @brief Removes a stream and returns its bytes to the budgets.
+     */
+    void remove(StreamMap::iterator it);
+
+    /**
+     * @brief Evicts the least recently used stream other than keep, false if there is none.
+     */
+    bool evictOldest(const Stream& keep);
+
+    /**
+     * @brief Returns bytes of a stream to the budgets.
+     */
+    void release(Stream& stream, std::size_t size);
+
+    /// Slots per slab of bufferPool_, smaller than the capture pools' as few flows carry payload
+    static constexpr std::size_t kSlotsPerSlab = 256;
+
+    const packetscope::ReassemblyLimits limits_;
+    std::atomic<std::size_t>& totalBytes_;
+
+    /// Part of the global limit this reassembler keeps when trimming
+    const std::size_t shareBytes_;
+
+    /// Slots of the stream bytes, created with the first stream (on the worker owning this reassembler)
+    std::shared_ptr<PacketBufferPool> bufferPool_;
+
+    StreamMap streams_;
+
+    /// Keys of streams_, least recently used first
+    std::list<packetscope::FlowKey> lru_;
+
+    /// Bytes held by streams_, part of totalBytes_
+    std::size_t bytes_{0};
+
+    /// Newest capture time added, the clock of expireIfDue()
+    uint64_t now_{0};
+    uint64_t nextExpiry_{0};
+
+    uint64_t evictedCount_{0};
+    uint64_t refusedCount_{0};
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <thread>
 #include <vector>
 
+#include "CpuAffinity.hpp"
 #include "ThreadSafeQueue.hpp"
 
 #include <spdlog/spdlog.h>
@@ -15,6 +16,7 @@
  *
  * Characteristics:
  *  - Fire and forget task execution
+ *  - Optionally bounded task queue with an OverflowPolicy
  *  - Graceful shutdown (drain the queue and exit)
  *  - No futures, no task results
  *
@@ -29,18 +31,40 @@ public:
      *
      * @param threadCount Number of worker threads.
      * If zero is provided, at least one thread is created.
+     * @param limits Capacity and overflow policy of the task queue, unbounded by default
+     * @param cpus Worker i is pinned to cpus[i % cpus.size()], empty leaves workers unpinned
      */
-    explicit ThreadPool(std::size_t threadCount) {
+    explicit ThreadPool(std::size_t threadCount, packetscope::QueueLimits limits = {},
+                        std::vector<int> cpus = {})
+        : tasks_(limits) {
         const std::size_t count = std::max(threadCount, std::size_t{1});
         workers_.reserve(count);
 
         spdlog::debug("ThreadPool::ThreadPool() - Creating {} worker threads", count);
 
         for (std::size_t i = 0; i < count; ++i) {
-            workers_.emplace_back([this] { workerLoop(); });
+            const std::vector<int> workerCpus = cpus.empty()
+                ? std::vector<int>{}
+                : std::vector<int>{cpus[i % cpus.size()]};
+
+            workers_.emplace_back([this, workerCpus] {
+                // Pin before the first task so the worker's allocations are
+                // first touched on its own core (and NUMA node)
+                if (!CpuAffinity::pinCurrentThread(workerCpus)) {
+                    spdlog::warn("ThreadPool::workerLoop() - Failed to pin worker thread");
+                }
+                workerLoop();
+            });
         }
     }
 
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    std::size_t threadCount() const {
+        return workers_.size();
+    }
+
     /**
      * @brief Destructor performs a graceful shutdown.
      *
@@ -62,14 +86,17 @@ public:
      * @brief Submits a new task for execution.
      *
      * Tasks submitted after shutdown has started are ignored.
+     * If the task queue is bounded, its OverflowPolicy applies.
      *
      * @tparam F Callable type (lambda, function, functor)
+     * @return false if the task was ignored or dropped
      */
     template <typename F>
-    void submit(F&& task) {
-        if (!stopped_) {
-            tasks_.push(std::function<void()>(std::forward<F>(task)));
+    bool submit(F&& task) {
+        if (stopped_) {
+            return false;
         }
+        return tasks_.push(std::function<void()>(std::forward<F>(task)));
     }
 
     /**
@@ -89,8 +116,9 @@ public:
 
         // One poison pill per worker thread.
         // An empty std::function signals worker termination.
+        // Pills bypass the capacity limit so they are never dropped.
         for (std::size_t i = 0; i < workers_.size(); ++i) {
-            tasks_.push(std::function<void()>{});
+            tasks_.forcePush(std::function<void()>{});
         }
 
         joinAll();
@@ -104,6 +132,13 @@ public:
         return stopped_;
     }
 
+    /**
+     * @brief Returns task queue size, capacity, drop count and high water mark.
+     */
+    packetscope::QueueStats queueStats() const {
+        return tasks_.stats();
+    }
+
 private:
 
     /**
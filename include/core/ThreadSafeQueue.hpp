@@ -1,17 +1,22 @@
 #ifndef THREADSAFEQUEUE_HPP_
 #define THREADSAFEQUEUE_HPP_
 
+#include <algorithm>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
 #include <queue>
 
+#include "QueuePolicy.hpp"
+
 /**
  * @brief Minimal thread safe FIFO queue.
  *
  * Responsibilities:
  *  - Provide safe push/pop operations
  *  - Block consumers when the queue is empty
+ *  - Optionally bound the queue and apply an OverflowPolicy when it is full
+ *  - Count dropped elements and track the high water mark
  *
  * Non responsibilities:
  *  - No shutdown / stop / lifecycle management
@@ -21,7 +26,13 @@
 template <typename T>
 class ThreadSafeQueue {
 public:
-    ThreadSafeQueue() = default;
+    /**
+     * @brief Constructs a queue.
+     * @param limits Capacity and overflow policy, unbounded by default
+     */
+    explicit ThreadSafeQueue(packetscope::QueueLimits limits = {})
+        : limits_(limits) {}
+
     ~ThreadSafeQueue() = default;
     ThreadSafeQueue(const ThreadSafeQueue &) = delete;
     ThreadSafeQueue &operator=(const ThreadSafeQueue &) = delete;
@@ -31,16 +42,45 @@ public:
     /**
      * @brief Push a new element into the queue.
      *
+     * If the queue is bounded and under pressure, the configured
+     * OverflowPolicy decides whether the caller waits (Block), the element
+     * is discarded (DropNewest, Sample) or the oldest element is discarded
+     * (DropOldest).
+     *
      * Notifies exactly one waiting consumer.
      * The notification is done AFTER releasing the lock
      * to avoid unnecessary wakeups and contention.
      *
      * @param value
+     * @return false if the element was discarded by the overflow policy
+     */
+    bool push(T value) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (!admitLocked(lock)) {
+                ++dropped_;
+                return false;
+            }
+
+            pushLocked(std::move(value));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push ignoring the capacity limit.
+     *
+     * Intended for control messages like poison pills, which must never be
+     * dropped or blocked by the overflow policy.
+     *
+     * @param value
      */
-    void push(T value) {
+    void forcePush(T value) {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(std::move(value));
+            pushLocked(std::move(value));
         }
         cv_.notify_one();
     }
@@ -61,6 +101,10 @@ public:
 
         T value = std::move(queue_.front());
         queue_.pop();
+
+        // Wake a producer blocked by OverflowPolicy::Block
+        lock.unlock();
+        notFullCv_.notify_one();
         return value;
     }
 
@@ -70,13 +114,17 @@ public:
      * @return std::nullopt if the queue is empty.
      */
     std::optional<T> tryPop() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::optional<T> value;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
 
-        if (queue_.empty())
-            return std::nullopt;
+            if (queue_.empty())
+                return std::nullopt;
 
-        T value = std::move(queue_.front());
-        queue_.pop();
+            value = std::move(queue_.front());
+            queue_.pop();
+        }
+        notFullCv_.notify_one();
         return value;
     }
 
@@ -95,20 +143,94 @@ public:
         return queue_.size();
     }
 
+    /**
+     * @brief Returns size, capacity, drop count and high water mark.
+     * Intended for monitoring and diagnostic purposes only.
+     */
+    packetscope::QueueStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return packetscope::QueueStats{queue_.size(), limits_.capacity, dropped_, highWaterMark_};
+    }
+
+    /**
+     * @brief Resets the drop counter and the high water mark.
+     */
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropped_ = 0;
+        highWaterMark_ = queue_.size();
+    }
+
     /**
      * @brief Clears all elements from the queue.
      */
     void clear() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::queue<T> empty;
-        std::swap(queue_, empty);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::queue<T> empty;
+            std::swap(queue_, empty);
+        }
+        notFullCv_.notify_all();
     }
 
 private:
 
+    /**
+     * @brief Applies the overflow policy for one incoming element.
+     *
+     * @note Caller must hold mutex_ through lock.
+     * @return true if the element may be queued
+     */
+    bool admitLocked(std::unique_lock<std::mutex>& lock) {
+        const std::size_t capacity = limits_.capacity;
+        if (capacity == 0) {
+            return true;
+        }
+
+        switch (limits_.policy) {
+            case packetscope::OverflowPolicy::Block:
+                notFullCv_.wait(lock, [this, capacity] { return queue_.size() < capacity; });
+                return true;
+
+            case packetscope::OverflowPolicy::DropNewest:
+                return queue_.size() < capacity;
+
+            case packetscope::OverflowPolicy::DropOldest:
+                if (queue_.size() >= capacity) {
+                    queue_.pop();
+                    ++dropped_;
+                }
+                return true;
+
+            case packetscope::OverflowPolicy::Sample:
+                if (queue_.size() >= capacity) {
+                    return false;
+                }
+                if (queue_.size() >= limits_.samplingThreshold()) {
+                    return (sampleCounter_++ % std::max(limits_.sampleRate, std::size_t{1})) == 0;
+                }
+                return true;
+        }
+        return true;
+    }
+
+    /**
+     * @note Caller must hold mutex_.
+     */
+    void pushLocked(T value) {
+        queue_.push(std::move(value));
+        highWaterMark_ = std::max(highWaterMark_, queue_.size());
+    }
+
     std::queue<T> queue_;
     mutable std::mutex mutex_;
     std::condition_variable cv_;
+    std::condition_variable notFullCv_;
+
+    const packetscope::QueueLimits limits_;
+    std::size_t dropped_{};
+    std::size_t highWaterMark_{};
+    std::size_t sampleCounter_{};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,749 @@
+#ifndef WORKSTEALINGTHREADPOOL_HPP_
+#define WORKSTEALINGTHREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ChaseLevDeque.hpp"
+#include "CpuAffinity.hpp"
+#include "QueuePolicy.hpp"
+
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief Fixed-size thread pool with per-worker work-stealing deques.
+ *
+ * Drop-in replacement for ThreadPool (same submit()/shutdown() semantics)
+ * without the single shared queue every worker contends on:
+ *
+ *  - Each worker owns a Chase-Lev deque. Tasks submitted from a worker go
+ *    straight to its own deque, lock free.
+ *  - Tasks submitted from outside (e.g. the dispatcher) are spread round
+ *    robin over small per-worker inboxes. The owner moves its whole inbox
+ *    into its deque with one lock acquisition.
+ *  - A worker without work steals from the other deques and inboxes, then
+ *    spins briefly and finally parks. Submitters only touch the wakeup
+ *    mutex when a worker is actually parked.
+ *  - submitTo() queues a task for one specific worker. Such affine tasks
+ *    are never stolen and run in submission order, so per-worker state
+ *    (e.g. per-flow tables) needs no locking.
+ *
+ * The OverflowPolicy applies to the total number of queued tasks. Graceful
+ * shutdown replaces ThreadPool's poison pills: once stopped, workers exit
+ * as soon as no queued task is left anywhere, so no submitted task is lost.
+ */
+class WorkStealingThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /// Empty find attempts before a worker parks
+    static constexpr std::size_t kSpinCount = 64;
+
+    /**
+     * @brief Constructs a pool with a fixed number of worker threads.
+     *
+     * @param threadCount Number of worker threads, at least one is created
+     * @param limits Capacity and overflow policy of all queued tasks, unbounded by default
+     * @param cpus Worker i is pinned to cpus[i % cpus.size()], empty leaves workers unpinned
+     */
+    explicit WorkStealingThreadPool(std::size_t threadCount, packetscope::QueueLimits limits = {},
+                                    std::vector<int> cpus = {})
+        : limits_(limits) {
+        const std::size_t count = std::max(threadCount, std::size_t{1});
+
+        spdlog::debug("WorkStealingThreadPool::WorkStealingThreadPool() - Creating {} worker threads", count);
+
+        // All workers exist before any thread starts stealing from them
+        workers_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::vector<int> workerCpus = cpus.empty()
+                ? std::vector<int>{}
+                : std::vector<int>{cpus[i % cpus.size()]};
+
+            workers_[i]->thread = std::thread([this, i, workerCpus] {
+                if (!CpuAffinity::pinCurrentThread(workerCpus)) {
+                    spdlog::warn("WorkStealingThreadPool::workerLoop() - Failed to pin worker thread");
+                }
+                workerLoop(i);
+            });
+        }
+    }
+
+    /**
+     * @brief Destructor performs a graceful shutdown.
+     *
+     * Tasks submitted concurrently with shutdown() that no worker picked up
+     * are destroyed without running.
+     */
+    ~WorkStealingThreadPool() {
+        shutdown();
+
+        for (auto& worker : workers_) {
+            while (Task* task = worker->deque.pop()) {
+                delete task;
+            }
+            for (Task* task : worker->inbox) {
+                delete task;
+            }
+            for (Task* task : worker->affineInbox) {
+                delete task;
+            }
+            for (Task* task : worker->affineLocal) {
+                delete task;
+            }
+        }
+    }
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool(WorkStealingThreadPool&&) = delete;
+    WorkStealingThreadPool& operator=(WorkStealingThreadPool&&) = delete;
+
+    /**
+     * @brief Submits a new task for execution.
+     *
+     * Tasks submitted after shutdown has started are ignored.
+     * If the pool is bounded, its OverflowPolicy applies.
+     *
+     * @tparam F Callable type (lambda, function, functor)
+     * @return false if the task was ignored or dropped
+     */
+    template <typename F>
+    bool submit(F&& task) {
+        if (stopped_) {
+            return false;
+        }
+        if (!admit()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        auto* queued = new Task(std::forward<F>(task));
+
+        // Nested submit from one of our workers: own deque, no lock
+        if (currentPool_ == this) {
+            workers_[currentWorker_]->deque.push(queued);
+        } else {
+            Worker& worker = nextWorker();
+            std::lock_guard<std::mutex> lock(worker.inboxMutex);
+            worker.inbox.push_back(queued);
+            worker.inboxSize.fetch_add(1, std::memory_order_release);
+        }
+
+        stealable_.fetch_add(1, std::memory_order_seq_cst);
+        wakeWorkers(1);
+        return true;
+    }
+
+    /**
+     * @brief Submits a task that must run on one specific worker.
+     *
+     * The task is never stolen. Tasks submitted to the same worker run in
+     * submission order, before the worker looks at any stealable task.
+     * If the pool is bounded, its OverflowPolicy applies.
+     *
+     * @param workerIndex Target worker, taken modulo threadCount()
+     * @param task Callable to run
+     * @return false if the task was ignored or dropped
+     */
+    template <typename F>
+    bool submitTo(std::size_t workerIndex, F&& task) {
+        if (stopped_) {
+            return false;
+        }
+        if (!admit()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Worker& worker = *workers_[workerIndex % workers_.size()];
+        auto* queued = new Task(std::forward<F>(task));
+        {
+            std::lock_guard<std::mutex> lock(worker.inboxMutex);
+            worker.affineInbox.push_back(queued);
+        }
+
+        worker.affineQueued.fetch_add(1, std::memory_order_seq_cst);
+        wakeWorker(worker);
+        return true;
+    }
+
+    /**
+     * @brief Submits several tasks at once.
+     *
+     * The accepted tasks are split into one contiguous chunk per worker, so
+     * each inbox is locked once per batch.
+     *
+     * @param tasks Tasks to run, the OverflowPolicy applies to each of them
+     * @return Number of tasks accepted
+     */
+    std::size_t submitBatch(std::vector<Task> tasks) {
+        if (stopped_ || tasks.empty()) {
+            return 0;
+        }
+
+        const std::size_t chunkSize = (tasks.size() + workers_.size() - 1) / workers_.size();
+        std::vector<Task*> chunk;
+        chunk.reserve(chunkSize);
+        std::size_t acceptedCount = 0;
+
+        auto flush = [this, &chunk] {
+            if (chunk.empty()) {
+                return;
+            }
+            Worker& worker = nextWorker();
+            {
+                std::lock_guard<std::mutex> lock(worker.inboxMutex);
+                worker.inbox.insert(worker.inbox.end(), chunk.begin(), chunk.end());
+                worker.inboxSize.fetch_add(chunk.size(), std::memory_order_release);
+            }
+            stealable_.fetch_add(static_cast<int64_t>(chunk.size()), std::memory_order_seq_cst);
+            wakeWorkers(chunk.size());
+            chunk.clear();
+        };
+
+        for (auto& task : tasks) {
+            // Reserved but unflushed tasks would never free capacity, so the
+            // chunk is handed over before waiting on OverflowPolicy::Block
+            if (!admit(flush)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            chunk.push_back(new Task(std::move(task)));
+            ++acceptedCount;
+            if (chunk.size() == chunkSize) {
+                flush();
+            }
+        }
+        flush();
+
+        return acceptedCount;
+    }
+
+    /**
+     * @brief Graceful shutdown.
+     *
+     * Behavior:
+     *  - Stop accepting new tasks
+     *  - Process all already queued tasks
+     *  - Exit all worker threads
+     *
+     * Safe to call multiple times.
+     */
+    void shutdown() {
+        if (stopped_.exchange(true)) {
+            return; // Already shut down
+        }
+
+        {
+            // Parked workers re-check stopped_ under the mutex
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            for (auto& worker : workers_) {
+                worker->wakeCv.notify_one();
+            }
+        }
+
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Checks if the thread pool has been shut down.
+     * @return true if shutdown() was called, false otherwise
+     */
+    bool isStopped() const {
+        return stopped_;
+    }
+
+    /**
+     * @brief Returns queued task count, capacity, drop count and high water mark.
+     */
+    packetscope::QueueStats queueStats() const {
+        return packetscope::QueueStats{
+            pending_.load(std::memory_order_relaxed),
+            limits_.capacity,
+            dropped_.load(std::memory_order_relaxed),
+            highWaterMark_.load(std::memory_order_relaxed)
+        };
+    }
+
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    std::size_t threadCount() const {
+        return workers_.size();
+    }
+
+    /// Returned by currentWorkerIndex() outside of a worker thread
+    static constexpr std::size_t kNoWorker = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Returns the index of the calling worker thread.
+     * @return Index in [0, threadCount()) or kNoWorker if not called from a worker of this pool
+     */
+    std::size_t currentWorkerIndex() const {
+        return currentPool_ == this ? currentWorker_ : kNoWorker;
+    }
+
+private:
+    /**
+     * @brief Per-worker state, each on its own allocation.
+     */
+    struct Worker {
+        /// Owner pushes/pops at the bottom, thieves steal from the top
+        ChaseLevDeque<Task> deque;
+
+        /// Tasks submitted from outside the pool, oldest first
+        std::mutex inboxMutex;
+        std::deque<Task*> inbox;
+
+        /// Lock free emptiness check of inbox
+        std::atomic<std::size_t> inboxSize{0};
+
+        /// submitTo() tasks, guarded by inboxMutex, never stolen
+        std::deque<Task*> affineInbox;
+
+        /// Affine tasks moved out of affineInbox, owner only
+        std::deque<Task*> affineLocal;
+
+        /// Affine tasks not yet taken (affineInbox + affineLocal), may dip below zero briefly
+        std::atomic<int64_t> affineQueued{0};
+
+        /// Parking state, guarded by the pool's sleepMutex_
+        std::condition_variable wakeCv;
+        std::atomic<bool> isParked{false};
+
+        /// Rotates the first victim of each steal round
+        std::size_t nextVictim{0};
+
+        std::thread thread;
+    };
+
+    /**
+     * @brief Worker thread main loop.
+     *
+     * Runs tasks until the pool is stopped and nothing is queued anymore.
+     * Catches all exceptions thrown by tasks to prevent worker thread
+     * termination and crash.
+     */
+    void workerLoop(std::size_t index) {
+        currentPool_ = this;
+        currentWorker_ = index;
+
+        Worker& self = *workers_[index];
+
+        std::size_t idleRounds = 0;
+        while (true) {
+            bool isAffine = false;
+            if (Task* found = findTask(index, isAffine)) {
+                const std::unique_ptr<Task> task(found);
+                onTaskTaken(isAffine ? &self : nullptr);
+                run(*task);
+                idleRounds = 0;
+                continue;
+            }
+
+            if (stopped_.load(std::memory_order_acquire) && !hasWork(self)) {
+                spdlog::debug("WorkStealingThreadPool::workerLoop() - Worker thread exiting");
+                return;
+            }
+
+            if (++idleRounds < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            park(self);
+            idleRounds = 0;
+        }
+    }
+
+    /**
+     * @brief Returns true if a task this worker could run is queued.
+     */
+    bool hasWork(const Worker& self) const {
+        return stealable_.load(std::memory_order_seq_cst) > 0
+            || self.affineQueued.load(std::memory_order_seq_cst) > 0;
+    }
+
+    /**
+     * @brief Own affine tasks, own deque, own inbox, then the other workers.
+     * @param isAffine Set to true if the task came from submitTo()
+     * @return Task owned by the caller or nullptr
+     */
+    Task* findTask(std::size_t index, bool& isAffine) {
+        Worker& self = *workers_[index];
+
+        isAffine = true;
+        if (Task* task = nextAffineTask(self)) {
+            return task;
+        }
+
+        isAffine = false;
+        if (Task* task = self.deque.pop()) {
+            return task;
+        }
+        if (Task* task = drainInbox(self)) {
+            return task;
+        }
+
+        const std::size_t count = workers_.size();
+        const std::size_t offset = self.nextVictim++;
+        for (std::size_t i = 1; i < count; ++i) {
+            Worker& victim = *workers_[(index + offset + i) % count];
+            if (Task* task = victim.deque.steal()) {
+                return task;
+            }
+            if (Task* task = stealFromInbox(victim)) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the oldest affine task of the calling worker.
+     * @note Owner thread only.
+     */
+    Task* nextAffineTask(Worker& self) {
+        if (self.affineLocal.empty()) {
+            if (self.affineQueued.load(std::memory_order_acquire) <= 0) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(self.inboxMutex);
+            self.affineLocal.swap(self.affineInbox);
+        }
+
+        if (self.affineLocal.empty()) {
+            return nullptr;
+        }
+
+        Task* task = self.affineLocal.front();
+        self.affineLocal.pop_front();
+        return task;
+    }
+
+    /**
+     * @brief Moves the whole inbox of the calling worker into its deque.
+     * @note Owner thread only.
+     * @return The oldest inbox task (to run now) or nullptr
+     */
+    Task* drainInbox(Worker& self) {
+        if (self.inboxSize.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+
+        std::deque<Task*> drained;
+        {
+            std::lock_guard<std::mutex> lock(self.inboxMutex);
+            drained.swap(self.inbox);
+            self.inboxSize.store(0, std::memory_order_relaxed);
+        }
+
+        if (drained.empty()) {
+            return nullptr;
+        }
+
+        // The rest stays stealable, thieves take the oldest first
+        Task* first = drained.front();
+        for (auto it = std::next(drained.begin()); it != drained.end(); ++it) {
+            self.deque.push(*it);
+        }
+        return first;
+    }
+
+    /**
+     * @brief Takes the oldest inbox task of another worker, without waiting for its lock.
+     */
+    Task* stealFromInbox(Worker& victim) {
+        if (victim.inboxSize.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+
+        std::unique_lock<std::mutex> lock(victim.inboxMutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.inbox.empty()) {
+            return nullptr;
+        }
+
+        Task* task = victim.inbox.front();
+        victim.inbox.pop_front();
+        victim.inboxSize.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    /**
+     * @brief Runs one task, exceptions are logged and swallowed.
+     */
+    static void run(Task& task) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            // Catch standard exceptions
+            spdlog::error("WorkStealingThreadPool::workerLoop() - Task exception: {}", e.what());
+        } catch (...) {
+            // Catch all other exceptions
+            spdlog::error("WorkStealingThreadPool::workerLoop() - Task unknown exception");
+        }
+    }
+
+    /**
+     * @brief Round robin target for tasks submitted from outside the pool.
+     */
+    Worker& nextWorker() {
+        return *workers_[nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+    }
+
+    /**
+     * @brief Applies the overflow policy and reserves a slot in pending_.
+     *
+     * @param onBlock Invoked before waiting for OverflowPolicy::Block, and
+     *                before OverflowPolicy::DropOldest gives up on finding a
+     *                task to evict
+     * @return true if the task may be queued
+     */
+    template <typename OnBlock = void (*)()>
+    bool admit(OnBlock&& onBlock = [] {}) {
+        const std::size_t capacity = limits_.capacity;
+        if (capacity == 0) {
+            reserve();
+            return true;
+        }
+
+        switch (limits_.policy) {
+            case packetscope::OverflowPolicy::Block:
+                while (!tryReserve(capacity)) {
+                    onBlock();
+                    std::unique_lock<std::mutex> lock(notFullMutex_);
+                    blockedSubmitters_.fetch_add(1, std::memory_order_seq_cst);
+                    notFullCv_.wait(lock, [this, capacity] {
+                        return pending_.load(std::memory_order_seq_cst) < capacity;
+                    });
+                    blockedSubmitters_.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return true;
+
+            case packetscope::OverflowPolicy::DropNewest:
+                return tryReserve(capacity);
+
+            case packetscope::OverflowPolicy::DropOldest:
+                // An evicted task frees one slot, another submitter may take it first
+                while (!tryReserve(capacity)) {
+                    if (evictOldest()) {
+                        continue;
+                    }
+                    // The reserved tasks may still be waiting in the caller's chunk
+                    onBlock();
+                    if (!evictOldest()) {
+                        return false;
+                    }
+                }
+                return true;
+
+            case packetscope::OverflowPolicy::Sample:
+                if (pending_.load(std::memory_order_relaxed) >= limits_.samplingThreshold()
+                    && (sampleCounter_.fetch_add(1, std::memory_order_relaxed)
+                        % std::max(limits_.sampleRate, std::size_t{1})) != 0) {
+                    return false;
+                }
+                return tryReserve(capacity);
+        }
+        reserve();
+        return true;
+    }
+
+    /**
+     * @brief Counts one more queued task.
+     */
+    void reserve() {
+        updateHighWaterMark(pending_.fetch_add(1, std::memory_order_seq_cst) + 1);
+    }
+
+    /**
+     * @brief Counts one more queued task if fewer than limit are queued.
+     */
+    bool tryReserve(std::size_t limit) {
+        std::size_t pending = pending_.load(std::memory_order_relaxed);
+        do {
+            if (pending >= limit) {
+                return false;
+            }
+        } while (!pending_.compare_exchange_weak(pending, pending + 1, std::memory_order_seq_cst));
+
+        updateHighWaterMark(pending + 1);
+        return true;
+    }
+
+    void updateHighWaterMark(std::size_t pending) {
+        std::size_t highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+        while (pending > highWaterMark
+               && !highWaterMark_.compare_exchange_weak(highWaterMark, pending, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Discards one old queued task for OverflowPolicy::DropOldest.
+     *
+     * Takes the front of the next inbox (stealable first, then affine) or
+     * steals the top of a deque, so it is the oldest task of one worker
+     * rather than strictly of the pool.
+     *
+     * @return false if no queued task was found (all of them being run or
+     *         not yet flushed by their submitter)
+     */
+    bool evictOldest() {
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            Worker& victim = nextWorker();
+
+            Task* task = nullptr;
+            Worker* affineOwner = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(victim.inboxMutex);
+                if (!victim.inbox.empty()) {
+                    task = victim.inbox.front();
+                    victim.inbox.pop_front();
+                    victim.inboxSize.fetch_sub(1, std::memory_order_relaxed);
+                } else if (!victim.affineInbox.empty()) {
+                    task = victim.affineInbox.front();
+                    victim.affineInbox.pop_front();
+                    affineOwner = &victim;
+                }
+            }
+            if (!task) {
+                task = victim.deque.steal();
+            }
+
+            if (task) {
+                onTaskTaken(affineOwner);
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                delete task;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Bookkeeping once a queued task left the pool (run or evicted).
+     *
+     * Wakes a submitter blocked by OverflowPolicy::Block. The seq_cst
+     * decrement and blockedSubmitters_ load pair with the submitter's
+     * increment and pending_ load, so the wakeup cannot be missed.
+     *
+     * @param affineOwner Worker of an affine task, nullptr for a stealable task
+     */
+    void onTaskTaken(Worker* affineOwner) {
+        if (affineOwner) {
+            affineOwner->affineQueued.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            stealable_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        pending_.fetch_sub(1, std::memory_order_seq_cst);
+        if (blockedSubmitters_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(notFullMutex_);
+            notFullCv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Parks the calling worker until it has work or the pool stops.
+     */
+    void park(Worker& self) {
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepingWorkers_.fetch_add(1, std::memory_order_seq_cst);
+
+        while (true) {
+            // Set again after every wakeup, wakeWorkers() clears it when notifying
+            self.isParked.store(true, std::memory_order_seq_cst);
+            if (hasWork(self) || stopped_.load(std::memory_order_seq_cst)) {
+                break;
+            }
+            self.wakeCv.wait(lock);
+        }
+
+        sleepingWorkers_.fetch_sub(1, std::memory_order_relaxed);
+        self.isParked.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Wakes up to count parked workers for stealable tasks.
+     *
+     * stealable_ was incremented (seq_cst) before this load of
+     * sleepingWorkers_, so a worker going to sleep concurrently either sees
+     * the task or is seen here.
+     */
+    void wakeWorkers(std::size_t count) {
+        if (count == 0 || sleepingWorkers_.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        for (auto& worker : workers_) {
+            if (count == 0) {
+                break;
+            }
+            if (worker->isParked.load(std::memory_order_relaxed)) {
+                // Cleared here so the next wakeup goes to another worker
+                worker->isParked.store(false, std::memory_order_relaxed);
+                worker->wakeCv.notify_one();
+                --count;
+            }
+        }
+    }
+
+    /**
+     * @brief Wakes the owner of a newly queued affine task if it is parked.
+     *
+     * Same handshake as wakeWorkers(), with affineQueued and isParked.
+     */
+    void wakeWorker(Worker& worker) {
+        if (!worker.isParked.load(std::memory_order_seq_cst)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        worker.wakeCv.notify_one();
+    }
+
+    /// Pool and worker index of the calling thread, set by workerLoop()
+    inline static thread_local WorkStealingThreadPool* currentPool_{nullptr};
+    inline static thread_local std::size_t currentWorker_{0};
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    const packetscope::QueueLimits limits_;
+
+    /// Tasks submitted but not yet taken by a worker (capacity and statistics)
+    std::atomic<std::size_t> pending_{0};
+
+    /// Queued tasks any worker may take, may dip below zero briefly
+    std::atomic<int64_t> stealable_{0};
+    std::atomic<std::size_t> highWaterMark_{0};
+    std::atomic<std::size_t> dropped_{0};
+    std::atomic<std::size_t> sampleCounter_{0};
+    std::atomic<std::size_t> nextWorker_{0};
+
+    std::mutex sleepMutex_;
+    std::atomic<std::size_t> sleepingWorkers_{0};
+
+    std::mutex notFullMutex_;
+    std::condition_variable notFullCv_;
+    std::atomic<std::size_t> blockedSubmitters_{0};
+
+    std::atomic<bool> stopped_{false};
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef FOLLOWSTREAMDIALOG_HPP
+#define FOLLOWSTREAMDIALOG_HPP
+
+#include "core/TcpReassembler.hpp"
+#include "ui/HexView.hpp"
+
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+
+/**
+ * @brief "Follow TCP Stream" window: the reassembled payload of one connection.
+ *
+ * Shows a snapshot of the stream (see PipelineController::tcpStream()) as a
+ * hex dump, both directions in delivery order or one of them. The bytes
+ * are only gathered from the stream chunks when a direction is picked.
+ */
+class FollowStreamDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief What part of the stream is shown.
+     */
+    enum class Direction {
+        Both,       ///< Every chunk in delivery order
+        AToB,       ///< Bytes sent by endpoint A
+        BToA        ///< Bytes sent by endpoint B
+    };
+
+    /**
+     * @brief Constructs the dialog showing both directions of stream.
+     */
+    explicit FollowStreamDialog(packetscope::TcpStream stream, QWidget* parent = nullptr);
+
+    ~FollowStreamDialog() override = default;
+
+    FollowStreamDialog(const FollowStreamDialog&) = delete;
+    FollowStreamDialog& operator=(const FollowStreamDialog&) = delete;
+    FollowStreamDialog(FollowStreamDialog&&) = delete;
+    FollowStreamDialog& operator=(FollowStreamDialog&&) = delete;
+
+private slots:
+    /**
+     * @brief Gathers the bytes of the picked direction into the hex view.
+     */
+    void onDirectionChanged();
+
+private:
+    /**
+     * @brief Returns "address:port" of endpoint A or B.
+     */
+    QString endpoint(bool isB) const;
+
+    /// Default dialog size in pixels
+    static constexpr int DEFAULT_WIDTH = 720;
+    static constexpr int DEFAULT_HEIGHT = 560;
+
+    packetscope::TcpStream stream_;
+
+    QLabel* summaryLabel_;
+    QComboBox* directionCombo_;
+    HexView* hexView_;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef HEXVIEW_HPP
+#define HEXVIEW_HPP
+
+#include "core/PacketBuffer.hpp"
+
+#include <QAbstractScrollArea>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Read only hex dump of a byte buffer, painted line by line.
+ *
+ * Unlike a QPlainTextEdit holding the whole dump as text, nothing is
+ * formatted up front: paintEvent() formats only the visible lines, each
+ * through byte -> text lookup tables into a preallocated line buffer. A
+ * packet or a multi-megabyte reassembled stream costs the same to show,
+ * scrolling formats the lines that come into view.
+ *
+ * Line layout (16 bytes, extra gap after the 8th):
+ *   0010  45 00 00 3c 1c 46 40 00  40 06 b1 e6 c0 a8 00 68  E..<.F@.@......h
+ * Offsets take 8 digits once the data is larger than 64 KiB.
+ */
+class HexView : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    /// Bytes per line
+    static constexpr std::size_t BYTES_PER_LINE = 16;
+
+    /// Longest formatted line: 8 offset digits, gaps, hex column and ASCII column
+    static constexpr std::size_t MAX_LINE_LENGTH = 8 + 2 + BYTES_PER_LINE * 3 + 1 + 1 + BYTES_PER_LINE;
+
+    explicit HexView(QWidget* parent = nullptr);
+
+    ~HexView() override = default;
+
+    HexView(const HexView&) = delete;
+    HexView& operator=(const HexView&) = delete;
+    HexView(HexView&&) = delete;
+    HexView& operator=(HexView&&) = delete;
+
+    /**
+     * @brief Shows the bytes of a packet buffer, which is kept alive instead of copied.
+     */
+    void setBuffer(packetscope::PacketBuffer buffer);
+
+    /**
+     * @brief Shows bytes owned by the view (e.g. a reassembled stream).
+     */
+    void setBytes(std::vector<uint8_t> bytes);
+
+    /**
+     * @brief Shows nothing and releases the bytes.
+     */
+    void clear();
+
+    /**
+     * @brief Formats one line of the dump.
+     * @param data Bytes of the whole dump
+     * @param size Number of bytes
+     * @param line Line to format, covering bytes [line * BYTES_PER_LINE, +BYTES_PER_LINE)
+     * @param offsetDigits Hex digits of the offset column (4 or 8)
+     * @param out Receives the line, at least MAX_LINE_LENGTH chars, not terminated
+     * @return Number of chars written
+     */
+    static std::size_t formatLine(const uint8_t* data, std::size_t size, std::size_t line,
+                                  int offsetDigits, char* out);
+
+    /**
+     * @brief Returns the whole dump as text, one line per BYTES_PER_LINE bytes.
+     */
+    QString toPlainText() const;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void changeEvent(QEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
+
+private:
+    /**
+     * @brief Points the view at new bytes and scrolls back to the top.
+     */
+    void showBytes(const uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Sizes the scroll bars to the line count and the font.
+     */
+    void updateScrollBars();
+
+    std::size_t lineCount() const;
+    int offsetDigits() const;
+    int lineHeight() const;
+
+    /// Left margin of the text in pixels
+    static constexpr int TEXT_MARGIN = 4;
+
+    /// Handle keeping setBuffer()'s bytes alive
+    packetscope::PacketBuffer buffer_;
+
+    /// Bytes passed to setBytes()
+    std::vector<uint8_t> ownedBytes_;
+
+    /// Bytes shown, from buffer_ or ownedBytes_
+    const uint8_t* data_{nullptr};
+    std::size_t size_{0};
+
+    /// Reused by paintEvent() for every line
+    std::array<char, MAX_LINE_LENGTH> lineBuffer_{};
+};
+
+#endif
@@ -2,13 +2,19 @@
 #define MAINWINDOW_HPP
 
 #include "core/PipelineController.hpp"
+#include "ui/HexView.hpp"
+#include "ui/MetricsPanel.hpp"
 #include "ui/PacketListModel.hpp"
 
 #include <QAction>
+#include <QComboBox>
+#include <QDockWidget>
 #include <QLabel>
+#include <QLineEdit>
 #include <QListWidget>
 #include <QMainWindow>
-#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSpinBox>
 #include <QSplitter>
 #include <QStackedWidget>
 #include <QTableView>
@@ -41,8 +47,9 @@ private slots:
     /**
      * @brief Handles double click on device in welcome screen
      *
-     * Starts packet capture on the selected device and transitions to
-     * the capture screen. Shows an error dialog if capture fails.
+     * Starts packet capture on the selected devices (Ctrl/Shift-click
+     * selects several) and transitions to the capture screen. Shows an
+     * error dialog if capture fails.
      */
     void onDeviceDoubleClicked(QListWidgetItem* item);
 
@@ -78,6 +85,45 @@ private slots:
      */
     void onUpdateUI();
 
+    /**
+     * @brief Applies the toolbar capture filter to the running capture.
+     *
+     * The filter is replaced in the kernel; captured packets, the ThreadPool
+     * and the dispatcher are kept (unlike Restart).
+     */
+    void onApplyCaptureFilter();
+
+    /**
+     * @brief Compiles the display filter and applies it to the packet list.
+     *
+     * Only hides rows, the capture is not affected. An empty expression
+     * shows every packet again.
+     */
+    void onApplyDisplayFilter();
+
+    /**
+     * @brief Asks for a pcap / pcapng file and loads it through the pipeline.
+     *
+     * Packets show up progressively while the load runs, the status bar
+     * shows the progress and throughput.
+     */
+    void onOpenFile();
+
+    /**
+     * @brief Starts (asking for a directory) or stops recording to pcapng files.
+     *
+     * Files rotate every RECORDING_FILE_SIZE_BYTES, the newest
+     * RECORDING_FILE_COUNT are kept.
+     */
+    void onToggleRecording(bool isChecked);
+
+    /**
+     * @brief Starts (asking for a file) or stops writing the pipeline metrics to a file.
+     *
+     * A .json file gets JSON, anything else the Prometheus text format.
+     */
+    void onToggleMetricsExport(bool isChecked);
+
     /**
      * @brief Handles packet selection in the table view
      *
@@ -86,6 +132,30 @@ private slots:
      */
     void onPacketSelected(const QModelIndex& current, const QModelIndex& previous);
 
+    /**
+     * @brief Offers display filters on the clicked packet's addresses and ports.
+     *
+     * Picking one fills in and applies the display filter; the store index
+     * answers these without scanning every packet. TCP packets also offer
+     * "Follow TCP Stream".
+     */
+    void onPacketContextMenu(const QPoint& position);
+
+    /**
+     * @brief Opens a FollowStreamDialog on the reassembled connection of a packet.
+     */
+    void onFollowTcpStream(int packetId);
+
+    /**
+     * @brief Switches follow mode off when the user scrolls away from the newest packet, on when back at it.
+     */
+    void onPacketTableScrolled(int action);
+
+    /**
+     * @brief Applies the Time column reference and precision picked in the toolbar.
+     */
+    void onTimeFormatChanged();
+
 private:
     /**
      * @brief Sets up the welcome screen UI components
@@ -122,30 +192,66 @@ private:
      */
     void updateButtonStates();
 
-    /// UI update interval in milliseconds
+    /**
+     * @brief Shows the file load progress, stops the pipeline once the load finished.
+     * @return false if no file is being loaded
+     */
+    bool updateFileLoadStatus();
+
+    /**
+     * @brief Passes the visible rows of the packet table to the model's viewport cache.
+     */
+    void updateViewport();
+
+    /**
+     * @brief Stretches or shortens the update interval to the cost of the last update.
+     *
+     * An update may take 1 / UI_UPDATE_SHARE of the main thread: under heavy
+     * load row insertions are coalesced into fewer, larger batches instead
+     * of stalling the event loop (and the repaints) every interval.
+     *
+     * @param updateNanoseconds Time the last onUpdateUI() took
+     */
+    void adaptUpdateInterval(qint64 updateNanoseconds);
+
+    /// Shortest UI update interval in milliseconds, used while updates are cheap
     static constexpr int UI_UPDATE_INTERVAL_MS = 100;
 
+    /// Longest UI update interval in milliseconds
+    static constexpr int UI_UPDATE_MAX_INTERVAL_MS = 1000;
+
+    /// Updates may take up to 1 / UI_UPDATE_SHARE of the main thread
+    static constexpr int UI_UPDATE_SHARE = 10;
+
     /// Default window width in pixels
     static constexpr int DEFAULT_WINDOW_WIDTH = 1200;
 
     /// Default window height in pixels
     static constexpr int DEFAULT_WINDOW_HEIGHT = 800;
 
+    /// How long the status bar shows the result of a filter change or recording
+    static constexpr int STATUS_MESSAGE_TIMEOUT_MS = 3000;
+
+    /// Size after which a recording file is rotated
+    static constexpr uint64_t RECORDING_FILE_SIZE_BYTES = 100ULL * 1000 * 1000;
+
+    /// Recording files kept, older ones are deleted
+    static constexpr std::size_t RECORDING_FILE_COUNT = 10;
+
+    /// Snap length spin box step in bytes
+    static constexpr int SNAP_LENGTH_STEP = 64;
+
     /// Title font size in points
     static constexpr int TITLE_FONT_SIZE = 18;
 
     /// Packet table column widths
     static constexpr int COLUMN_WIDTH_ID = 60;
-    static constexpr int COLUMN_WIDTH_TIME = 120;
+    static constexpr int COLUMN_WIDTH_TIME = 150;
     static constexpr int COLUMN_WIDTH_SOURCE = 140;
     static constexpr int COLUMN_WIDTH_DESTINATION = 140;
     static constexpr int COLUMN_WIDTH_PROTOCOL = 70;
     static constexpr int COLUMN_WIDTH_LENGTH = 60;
 
-    /// Hex dump format constants
-    static constexpr int HEX_BYTES_PER_LINE = 16;  ///< Number of bytes per line in hex view
-    static constexpr int HEX_SEPARATOR_POS = 7;    ///< Position to insert extra space
-
     /// Manages packet capture, processing and storage pipeline
     PipelineController controller_;
 
@@ -155,12 +261,19 @@ private:
     // Welcome screen widgets
     QWidget* welcomeWidget_;          ///< Container for welcome screen
     QListWidget* deviceListWidget_;   ///< List of available devices
+    QLineEdit* filterEdit_;           ///< BPF capture filter of the next capture
+    QSpinBox* snapLengthSpinBox_;     ///< Bytes kept per packet, 0 for full frames
+    QPushButton* openFileButton_;     ///< Loads a capture file instead of a live device
 
     // Capture screen widgets
     QWidget* captureWidget_;          ///< Container for capture screen
     QTableView* packetTableView_;     ///< Table displaying captured packets
     QTreeWidget* layerTreeWidget_;    ///< Tree showing protocol layers
-    QPlainTextEdit* hexView_;         ///< Hex dump of raw packet data
+    HexView* hexView_;                ///< Hex dump of raw packet data
+    QLineEdit* liveFilterEdit_;       ///< Capture filter applied live from the toolbar
+    QLineEdit* displayFilterEdit_;    ///< Display filter of the packet list
+    QComboBox* timeReferenceCombo_;   ///< Time column reference (absolute, since start, since previous)
+    QComboBox* timePrecisionCombo_;   ///< Time column precision (microseconds, nanoseconds)
 
     /// Model for packet table view
     PacketListModel* packetListModel_;
@@ -176,12 +289,28 @@ private:
     QAction* startAction_{nullptr};   ///< Start/Resume capture action
     QAction* stopAction_{nullptr};    ///< Stop/Pause capture action
     QAction* restartAction_{nullptr}; ///< Restart capture action
+    QAction* openFileAction_{nullptr};///< Load a capture file action
+    QAction* recordAction_{nullptr};  ///< Toggles recording to pcapng files
+    QAction* followAction_{nullptr};  ///< Keeps the newest packet in view (tail mode)
+    QAction* exportMetricsAction_{nullptr}; ///< Toggles writing the metrics to a file
+
+    /// Stage latencies, thread load and drops; refreshed with the packet list while shown
+    QDockWidget* metricsDock_{nullptr};
+    MetricsPanel* metricsPanel_{nullptr};
+
+    /// Current device names for restart functionality
+    QStringList currentDeviceNames_;
 
-    /// Current device name for restart functionality
-    QString currentDeviceName_;
+    /// Filter and snap length passed to PipelineController::start()
+    packetscope::CaptureFilter captureFilter_;
 
     /// True if a device has been selected (enables restart)
     bool hasDevice_{false};
+
+    /**
+     * @brief Returns currentDeviceNames_ as passed to PipelineController::start().
+     */
+    std::vector<std::string> currentDevices() const;
 };
 
 #endif // MAINWINDOW_HPP
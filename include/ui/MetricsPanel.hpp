@@ -0,0 +1,64 @@
+#ifndef METRICSPANEL_HPP
+#define METRICSPANEL_HPP
+
+#include "core/PipelineMetrics.hpp"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLabel>
+#include <QTableWidget>
+#include <QWidget>
+
+/**
+ * @brief Stats panel of the pipeline: stage latencies, thread load and where packets are lost.
+ *
+ * Shows one PipelineController::metrics() snapshot at a time:
+ * - Stages: count, mean, p50 / p90 / p99 / p99.9 and max latency
+ * - Threads: packets, batches and how busy each thread was since the previous snapshot
+ * - Captures: kernel, interface and raw ring drops per capture socket
+ */
+class MetricsPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MetricsPanel(QWidget* parent = nullptr);
+
+    ~MetricsPanel() override = default;
+
+    MetricsPanel(const MetricsPanel&) = delete;
+    MetricsPanel& operator=(const MetricsPanel&) = delete;
+    MetricsPanel(MetricsPanel&&) = delete;
+    MetricsPanel& operator=(MetricsPanel&&) = delete;
+
+    /**
+     * @brief Replaces the shown values with a new snapshot.
+     */
+    void setMetrics(const packetscope::PipelineMetricsSnapshot& metrics);
+
+private:
+    /**
+     * @brief Formats a latency with a unit that keeps it short (ns, µs, ms, s).
+     */
+    static QString formatDuration(uint64_t nanoseconds);
+
+    /**
+     * @brief Sets the text of a cell, creating its item on first use.
+     */
+    static void setCell(QTableWidget* table, int row, int column, const QString& text);
+
+    /**
+     * @brief Creates a read only table with the given column headers.
+     */
+    QTableWidget* createTable(const QStringList& headers);
+
+    QLabel* dropsLabel_;
+    QTableWidget* stageTable_;
+    QTableWidget* threadTable_;
+    QTableWidget* captureTable_;
+
+    /// Busy time of every thread at the previous snapshot, for the load column
+    QHash<QString, uint64_t> previousBusyNs_;
+    QElapsedTimer sinceLastSnapshot_;
+};
+
+#endif
@@ -1,14 +1,40 @@
 #ifndef PACKETLISTMODEL_HPP
 #define PACKETLISTMODEL_HPP
 
+#include "core/DisplayFilter.hpp"
+#include "core/PacketSorter.hpp"
 #include "core/PacketStore.hpp"
+#include "ui/TimestampFormatter.hpp"
 
 #include <QAbstractTableModel>
-#include <QTime>
+#include <QTimer>
+#include <array>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <vector>
 
 /**
  * @brief Qt Model for displaying captured network packets in a table view
+ *
+ * Row 0 is the oldest retained packet: when the store evicts packets
+ * (see StoreRetentionConfig) refresh() removes them from the front.
+ *
+ * With a DisplayFilter the rows are the matching packets only, kept as a
+ * row -> ID index. refresh() filters just the packets stored since the
+ * previous refresh and appends their matches.
+ *
+ * Formatted cells are cached for the rows around the viewport (see
+ * setViewport()). Rows never change once shown, so the cache is only
+ * shifted when rows are evicted from the front and dropped on reset;
+ * appending rows leaves it alone.
+ *
+ * Sorting (see sort()) never blocks the UI thread: a PacketSorter orders
+ * the rows in the background. The rows are its latest order followed by
+ * the rows added since, unsorted, in ID order (the "tail"); every finished
+ * pass is laid out with one layoutChanged(), selected rows follow their
+ * packet. Passes are picked up by refresh() and, while the sorter is busy,
+ * every SORT_POLL_INTERVAL_MS (refresh() is not called once a capture stopped).
  */
 class PacketListModel : public QAbstractTableModel {
     Q_OBJECT
@@ -20,7 +46,7 @@ public:
      */
     enum class ColumnType {
         Id = 0,          ///< Packet sequence number (1 based)
-        Time,            ///< Capture timestamp (HH:MM:SS)
+        Time,            ///< Capture timestamp, see setTimeFormat()
         Source,          ///< Source IP address or MAC address
         Destination,     ///< Destination IP address or MAC address
         Protocol,        ///< Protocol name
@@ -56,6 +82,10 @@ public:
 
     /**
      * @brief Returns data for the given index and role
+     *
+     * Answered from the viewport cache. A row outside of it (the view
+     * scrolled before setViewport() was called) reloads the cache around
+     * that row.
      */
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
 
@@ -66,12 +96,66 @@ public:
 
     /**
      * @brief Converts a row number to its corresponding packet ID
+     * @return 0 while a row has no packet (being laid out)
      */
     int getPacketId(int row) const;
 
+    /**
+     * @brief Sorts the rows by column, ascending by No. restores the capture order.
+     *
+     * Returns at once: the rows keep the capture order until the first
+     * background pass finished, refresh() picks up the passes. The other
+     * direction of the current column only reverses the sorted rows.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief Stops the background sort, which must not run while the store is cleared.
+     *
+     * The rows keep their order, refresh() starts sorting again.
+     */
+    void stopSorting();
+
+    /**
+     * @brief Shows only the packets matching filter, nullptr shows every packet.
+     *
+     * Filters the whole store once (in parallel, see DisplayFilter::filter())
+     * and resets the model. The filter is kept across reset().
+     */
+    void setFilter(std::shared_ptr<const DisplayFilter> filter);
+
+    /**
+     * @brief Returns the active display filter, nullptr if none.
+     */
+    const std::shared_ptr<const DisplayFilter>& filter() const;
+
+    /**
+     * @brief Tells the model which rows the view shows.
+     *
+     * Formats the rows plus VIEWPORT_CACHE_MARGIN on each side in one pass
+     * unless they are cached already, so scrolling by a few rows or a new
+     * refresh does not touch the store again.
+     *
+     * @param firstRow First visible row
+     * @param lastRow Last visible row (inclusive)
+     */
+    void setViewport(int firstRow, int lastRow);
+
+    /**
+     * @brief Sets how the Time column shows timestamps.
+     *
+     * CaptureStart is relative to the first packet seen since reset(),
+     * PreviousPacket to the packet in the row above (the previous match
+     * while filtered). Reformats the Time column.
+     */
+    void setTimeFormat(TimestampFormatter::Reference reference, TimestampFormatter::Precision precision);
+
 public slots:
     /**
      * @brief Updates the model with new packets from the store
+     *
+     * Evicted rows are removed with one beginRemoveRows() batch, new ones
+     * appended with one beginInsertRows(), so the view keeps its state.
      */
     void refresh();
 
@@ -81,12 +165,138 @@ public slots:
     void reset();
 
 private:
-    QString formatTimestamp(const timespec& ts) const;
+    /**
+     * @brief refresh() with a display filter: drops evicted matches, filters the new packets.
+     */
+    void refreshFiltered();
+
+    /**
+     * @brief Removes evicted rows from the front of the base (ID ordered) rows.
+     *
+     * Only unsorted (tail) rows leave at once, in one batch; sorted rows of
+     * evicted packets stay, empty, until the next order drops them.
+     *
+     * @param evicted Number of base rows evicted
+     */
+    void removeEvictedRows(std::size_t evicted);
+
+    /// Base rows: every retained packet, or the matches of filter_, in ID order
+    std::size_t baseRowCount() const;
+    int baseId(std::size_t baseRow) const;
+
+    /// Rows shown from sortedOrder_
+    std::size_t sortedRowCount() const;
+
+    /**
+     * @brief Starts a sorter for sortColumn_ over the current base rows, or drops it if not sorting.
+     */
+    void startSorter();
+
+    /**
+     * @brief Lays out the sorter's latest order if it is new.
+     */
+    void applySortedOrder();
+
+    /**
+     * @brief Replaces the sorted rows in a layout change, moving the persistent indexes along.
+     * @param order Sorted rows, nullptr for none
+     * @param tailFirst First base row not part of order
+     * @param sortOrder Direction order is read in
+     */
+    void relayout(std::shared_ptr<const PacketSorter::Order> order, std::size_t tailFirst, Qt::SortOrder sortOrder);
+
+    /**
+     * @brief Returns the row showing a packet, -1 if none. Constant time (PacketSorter::Order::positionOf()).
+     */
+    int rowOfId(int id) const;
+
+    /**
+     * @brief Remembers the timestamp of the oldest stored packet once, for Reference::CaptureStart.
+     */
+    void updateCaptureStart();
+
+    /// Formatted cells of one row, empty if the packet is not available (e.g. discarded)
+    using RowCells = std::array<QVariant, static_cast<std::size_t>(ColumnType::COUNT)>;
+
+    /**
+     * @brief Formatted rows [firstRow, firstRow + rows.size()).
+     */
+    struct ViewportCache {
+        int firstRow{0};
+        std::vector<RowCells> rows;
+
+        bool contains(int row) const {
+            return row >= firstRow && row < firstRow + static_cast<int>(rows.size());
+        }
+    };
+
+    /**
+     * @brief Replaces the viewport cache with the rows [firstRow, lastRow], clamped to the model.
+     */
+    void loadRows(int firstRow, int lastRow) const;
+
+    /**
+     * @brief Moves the cache along with rows removed from the front.
+     */
+    void shiftCache(int removedRows);
+
+    /**
+     * @brief Formats the Time cell of a packet.
+     * @param previous Timestamp of the row above, nullptr for row 0
+     */
+    QString formatTimestamp(const timespec& timestamp, const timespec* previous) const;
 
     std::shared_ptr<PacketStore> store_;
 
+    /// Rows cached on either side of the viewport
+    static constexpr int VIEWPORT_CACHE_MARGIN = 64;
+
+    /// How often a busy sorter is checked for a finished pass
+    static constexpr int SORT_POLL_INTERVAL_MS = 50;
+
+    /// Cells of the rows around the viewport
+    mutable ViewportCache viewportCache_;
+
+    /// Formats the Time column, caches local time per second
+    mutable TimestampFormatter timestampFormatter_;
+
+    /// Timestamp of the first packet, valid once hasCaptureStart_ is set
+    timespec captureStart_{};
+    bool hasCaptureStart_{false};
+
     /// Cached row count to avoid repeated PacketStore::count() calls
     std::size_t cachedRowCount_{};
+
+    /// Packet ID shown in row 0
+    int firstRowId_{1};
+
+    /// Active display filter, rows come from filteredIds_ while set
+    std::shared_ptr<const DisplayFilter> filter_;
+
+    /// IDs of the matching packets in ID order, row i shows filteredIds_[i]
+    std::deque<int> filteredIds_;
+
+    /// Every ID up to this one has been tested against filter_
+    int filteredUntilId_{0};
+
+    /// Column sorted by, std::nullopt for the capture order
+    std::optional<PacketSorter::Column> sortColumn_;
+    Qt::SortOrder sortOrder_{Qt::AscendingOrder};
+
+    /// Sorts the base rows in the background while sortColumn_ is set
+    std::unique_ptr<PacketSorter> sorter_;
+
+    /// Runs applySortedOrder() while sorter_ is busy
+    QTimer* sortPollTimer_;
+
+    /// Order shown, the first sortedRowCount() rows
+    std::shared_ptr<const PacketSorter::Order> sortedOrder_;
+
+    /// Base rows from this one on follow the sorted rows (all of them when not sorted)
+    std::size_t tailFirst_{0};
+
+    /// Keeps rowCount() unchanged during relayout(), 0 otherwise
+    int rowAdjustment_{0};
 };
 
 #endif
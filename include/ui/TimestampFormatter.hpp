@@ -0,0 +1,89 @@
+#ifndef TIMESTAMPFORMATTER_HPP
+#define TIMESTAMPFORMATTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <ctime>
+
+/**
+ * @brief Formats packet timestamps for the Time column.
+ *
+ * Formats:
+ *  - Absolute: local wall clock time, "14:03:07.123456"
+ *  - CaptureStart / PreviousPacket: signed seconds since a reference
+ *    timestamp, "12.000250" (the caller passes the reference)
+ *
+ * with 6 (microseconds) or 9 (nanoseconds) fraction digits.
+ *
+ * Text is written straight into a caller buffer. The local time of a
+ * second (localtime_r(), i.e. the time zone lookup) is computed once and
+ * kept in a small direct mapped cache of second buckets, so all packets
+ * of one second, and scrolling back and forth over the same seconds,
+ * reuse it.
+ *
+ * @note Not thread safe, the cache is updated by format().
+ */
+class TimestampFormatter {
+public:
+    /**
+     * @brief What a timestamp is shown relative to.
+     */
+    enum class Reference {
+        Absolute,           ///< Time of day in the local time zone
+        CaptureStart,       ///< Seconds since the first packet
+        PreviousPacket      ///< Seconds since the packet in the row above
+    };
+
+    /**
+     * @brief Digits after the decimal point.
+     */
+    enum class Precision {
+        Microseconds,       ///< 6 digits
+        Nanoseconds         ///< 9 digits
+    };
+
+    /// Longest formatted timestamp ("-9223372036854775808.123456789")
+    static constexpr std::size_t MAX_LENGTH = 32;
+
+    TimestampFormatter() = default;
+
+    Reference reference() const { return reference_; }
+    Precision precision() const { return precision_; }
+
+    void setReference(Reference reference) { reference_ = reference; }
+    void setPrecision(Precision precision) { precision_ = precision; }
+
+    /**
+     * @brief Formats timestamp according to the reference mode.
+     * @param timestamp Packet timestamp
+     * @param reference Timestamp it is relative to, ignored for Reference::Absolute
+     * @param out Receives the text, at least MAX_LENGTH chars, not terminated
+     * @return Number of chars written
+     */
+    std::size_t format(const timespec& timestamp, const timespec& reference, char* out);
+
+private:
+    /**
+     * @brief "HH:MM:SS" of one second, in local time.
+     */
+    struct SecondBucket {
+        time_t second{0};
+        bool isValid{false};
+        std::array<char, 8> clock{};
+    };
+
+    std::size_t formatAbsolute(const timespec& timestamp, char* out);
+    std::size_t formatDuration(const timespec& timestamp, const timespec& reference, char* out) const;
+
+    /// Writes the fraction digits of nanoseconds (0 to 999999999) and returns the end
+    char* writeFraction(long nanoseconds, char* out) const;
+
+    /// Second buckets cached, a power of two
+    static constexpr std::size_t SECOND_BUCKETS = 64;
+
+    Reference reference_{Reference::Absolute};
+    Precision precision_{Precision::Microseconds};
+    std::array<SecondBucket, SECOND_BUCKETS> buckets_{};
+};
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file main.cpp
+ * @brief packet-scope-cli: browses the packets of a running packet-scope-daemon.
+ *
+ * Thin front end of QueryClient, one command per invocation.
+ */
+
+#include "core/PacketProcessor.hpp"
+#include "core/PipelineConfig.hpp"
+#include "core/QueryClient.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Rows listed when no range is given, the newest ones
+constexpr uint32_t kDefaultListCount = 20;
+
+/// Bytes per line of the hex dump
+constexpr std::size_t kHexBytesPerLine = 16;
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--socket PATH] <command>\n"
+                 "  status                       Pipeline counters and stored IDs\n"
+                 "  list [FIRST [COUNT]]         Summary rows, the newest %u by default\n"
+                 "  hex ID                       Raw bytes of one packet\n"
+                 "  filter EXPR [FIRST [LAST]]   Rows matching a display filter, e.g. \"tcp.port == 443\"\n",
+                 program, kDefaultListCount);
+}
+
+bool parseId(const char* text, long long& value) {
+    char* end = nullptr;
+    value = std::strtoll(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+void printRecord(const packetscope::QueryPacketRecord& record) {
+    std::printf("%10d  %lld.%09u  %-39s -> %-39s %-8s %6d\n", record.id, static_cast<long long>(record.seconds),
+                record.nanoseconds, record.sourceAddress().toString().c_str(),
+                record.destinationAddress().toString().c_str(),
+                PacketProcessor::protocolTypeToString(static_cast<pcpp::ProtocolType>(record.protocol)).c_str(),
+                record.frameLength);
+}
+
+int printStatus(QueryClient& client) {
+    const std::optional<packetscope::QueryStatusReply> status = client.status();
+    if (!status) {
+        std::fprintf(stderr, "%s\n", client.lastError().c_str());
+        return EXIT_FAILURE;
+    }
+    std::printf("running          : %s (%u workers)\n", status->isRunning ? "yes" : "no", status->workerCount);
+    std::printf("stored IDs       : %llu - %llu\n", static_cast<unsigned long long>(status->firstId),
+                static_cast<unsigned long long>(status->storedCount));
+    std::printf("captured         : %llu\n", static_cast<unsigned long long>(status->capturedCount));
+    std::printf("processed        : %llu\n", static_cast<unsigned long long>(status->processedCount));
+    std::printf("dropped          : interface %llu, kernel %llu of %llu, raw queue %llu, task queue %llu\n",
+                static_cast<unsigned long long>(status->interfaceDropped),
+                static_cast<unsigned long long>(status->kernelDropped),
+                static_cast<unsigned long long>(status->kernelReceived),
+                static_cast<unsigned long long>(status->rawQueueDropped),
+                static_cast<unsigned long long>(status->taskQueueDropped));
+    std::printf("raw bytes        : %llu in RAM, %llu spilled\n",
+                static_cast<unsigned long long>(status->rawBytesInMemory),
+                static_cast<unsigned long long>(status->rawBytesSpilled));
+    return EXIT_SUCCESS;
+}
+
+int printList(QueryClient& client, int argc, char** argv, int index) {
+    long long firstId = 0;
+    long long count = kDefaultListCount;
+    if (index < argc && !parseId(argv[index++], firstId)) {
+        return EXIT_FAILURE;
+    }
+    if (index < argc && (!parseId(argv[index++], count) || count < 0)) {
+        return EXIT_FAILURE;
+    }
+
+    if (firstId == 0) {
+        const std::optional<packetscope::QueryStatusReply> status = client.status();
+        if (!status) {
+            std::fprintf(stderr, "%s\n", client.lastError().c_str());
+            return EXIT_FAILURE;
+        }
+        firstId = std::max<long long>(static_cast<long long>(status->storedCount) - count + 1, 1);
+    }
+
+    std::vector<packetscope::QueryPacketRecord> records;
+    if (!client.packets(static_cast<int>(firstId), static_cast<uint32_t>(count), records)) {
+        std::fprintf(stderr, "%s\n", client.lastError().c_str());
+        return EXIT_FAILURE;
+    }
+    for (const packetscope::QueryPacketRecord& record : records) {
+        printRecord(record);
+    }
+    return EXIT_SUCCESS;
+}
+
+int printHex(QueryClient& client, int argc, char** argv, int index) {
+    long long id = 0;
+    if (index >= argc || !parseId(argv[index], id)) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<QueryClient::PacketData> packets;
+    if (!client.packetData(static_cast<int>(id), 1, packets)) {
+        std::fprintf(stderr, "%s\n", client.lastError().c_str());
+        return EXIT_FAILURE;
+    }
+    if (packets.empty()) {
+        std::fprintf(stderr, "Packet %lld is not stored\n", id);
+        return EXIT_FAILURE;
+    }
+
+    const QueryClient::PacketData& packet = packets.front();
+    printRecord(packet.record);
+    const auto size = static_cast<std::size_t>(packet.record.rawDataLen);
+    for (std::size_t offset = 0; offset < size; offset += kHexBytesPerLine) {
+        std::printf("%04zx  ", offset);
+        for (std::size_t i = offset; i < std::min(offset + kHexBytesPerLine, size); ++i) {
+            std::printf("%02x ", packet.data[i]);
+        }
+        std::printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+int printFilter(QueryClient& client, int argc, char** argv, int index) {
+    if (index >= argc) {
+        return EXIT_FAILURE;
+    }
+    const std::string expression = argv[index++];
+    long long firstId = 1;
+    long long lastId = std::numeric_limits<int>::max();
+    if (index < argc && !parseId(argv[index++], firstId)) {
+        return EXIT_FAILURE;
+    }
+    if (index < argc && !parseId(argv[index++], lastId)) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<int> ids;
+    if (!client.filter(expression, static_cast<int>(firstId), static_cast<int>(lastId), ids)) {
+        std::fprintf(stderr, "%s\n", client.lastError().c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Matches are fetched as rows in ID ranges, kMaxQueryPackets at a time
+    std::vector<packetscope::QueryPacketRecord> records;
+    std::size_t next = 0;
+    while (next < ids.size()) {
+        const int rangeFirst = ids[next];
+        const uint32_t rangeCount = static_cast<uint32_t>(
+            std::min<long long>(static_cast<long long>(ids.back()) - rangeFirst + 1, packetscope::kMaxQueryPackets));
+        if (!client.packets(rangeFirst, rangeCount, records)) {
+            std::fprintf(stderr, "%s\n", client.lastError().c_str());
+            return EXIT_FAILURE;
+        }
+        for (const packetscope::QueryPacketRecord& record : records) {
+            if (next < ids.size() && record.id == ids[next]) {
+                printRecord(record);
+                ++next;
+            }
+        }
+        // Skip IDs evicted meanwhile
+        const long long rangeEnd = static_cast<long long>(rangeFirst) + rangeCount;
+        while (next < ids.size() && ids[next] < rangeEnd) {
+            ++next;
+        }
+    }
+    std::printf("%zu matching packets\n", ids.size());
+    return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string socketPath = packetscope::QueryServerConfig{}.socketPath;
+    int index = 1;
+    if (index + 1 < argc && std::string(argv[index]) == "--socket") {
+        socketPath = argv[index + 1];
+        index += 2;
+    }
+    if (index >= argc) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::unique_ptr<QueryClient> client = QueryClient::connect(socketPath);
+    if (!client) {
+        return EXIT_FAILURE;
+    }
+
+    const std::string command = argv[index++];
+    int result = EXIT_FAILURE;
+    if (command == "status") {
+        result = printStatus(*client);
+    } else if (command == "list") {
+        result = printList(*client, argc, argv, index);
+    } else if (command == "hex") {
+        result = printHex(*client, argc, argv, index);
+    } else if (command == "filter") {
+        result = printFilter(*client, argc, argv, index);
+    } else {
+        printUsage(argv[0]);
+    }
+    return result;
+}
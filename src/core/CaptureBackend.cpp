@@ -0,0 +1,62 @@
+#include "core/CaptureBackend.hpp"
+
+#include <pcap.h>
+
+#ifdef __linux__
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+#ifdef __linux__
+int toFanoutType(packetscope::FanoutMode mode) {
+    switch (mode) {
+        case packetscope::FanoutMode::Cpu:
+            return PACKET_FANOUT_CPU;
+        case packetscope::FanoutMode::QueueMapping:
+            return PACKET_FANOUT_QM;
+        case packetscope::FanoutMode::Hash:
+        default:
+            // Defragment so every fragment of a datagram lands on the same member
+            return PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+    }
+}
+#endif
+
+}
+
+bool CaptureBackend::joinFanoutGroup(int socketFd, const FanoutGroup& group) {
+#ifdef __linux__
+    const int fanoutArgument = group.id | (toFanoutType(group.mode) << 16);
+    return setsockopt(socketFd, SOL_PACKET, PACKET_FANOUT, &fanoutArgument, sizeof(fanoutArgument)) == 0;
+#else
+    (void)socketFd;
+    (void)group;
+    return false;
+#endif
+}
+
+bool CaptureBackend::isValidFilter(const std::string& expression) {
+    if (expression.empty()) {
+        return true;
+    }
+
+    pcap_t* handle = pcap_open_dead(DLT_EN10MB, packetscope::CaptureFilter::kMaxSnapLength);
+    if (!handle) {
+        return false;
+    }
+
+    bpf_program program{};
+    const bool isValid = pcap_compile(handle, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == 0;
+    if (isValid) {
+        pcap_freecode(&program);
+    } else {
+        spdlog::error("CaptureBackend::isValidFilter() - Invalid filter '{}': {}", expression, pcap_geterr(handle));
+    }
+
+    pcap_close(handle);
+    return isValid;
+}
@@ -0,0 +1,467 @@
+#include "core/CaptureFileReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+/**
+ * Shared by the reader and every chunk lent to the pipeline: refs counts the
+ * reader plus each live chunk, the last one unmaps the file.
+ */
+struct CaptureFileMapping {
+    /**
+     * Frames returned by one read() call. Freed when every frame handle and
+     * the reader's own guard reference are gone.
+     */
+    struct Chunk {
+        CaptureFileMapping* mapping{nullptr};
+        std::atomic<uint32_t> outstanding{0};   ///< Live frame handles + 1 while reading
+        std::unique_ptr<packetscope::BufferHeader[]> frames;
+    };
+
+    const uint8_t* data{nullptr};
+    std::size_t size{0};
+    std::atomic<uint32_t> refs{1};
+    std::atomic<std::size_t> chunksInFlight{0};
+
+    ~CaptureFileMapping() {
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+    }
+};
+
+namespace {
+
+constexpr uint32_t kPcapMagicMicroseconds = 0xA1B2C3D4;
+constexpr uint32_t kPcapMagicNanoseconds = 0xA1B23C4D;
+constexpr std::size_t kPcapFileHeaderSize = 24;
+constexpr std::size_t kPcapRecordHeaderSize = 16;
+
+constexpr uint32_t kPcapNgSectionHeaderBlock = 0x0A0D0D0A;
+constexpr uint32_t kPcapNgInterfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t kPcapNgObsoletePacketBlock = 0x00000002;
+constexpr uint32_t kPcapNgSimplePacketBlock = 0x00000003;
+constexpr uint32_t kPcapNgEnhancedPacketBlock = 0x00000006;
+constexpr uint32_t kPcapNgByteOrderMagic = 0x1A2B3C4D;
+constexpr std::size_t kPcapNgMinimumBlockSize = 12;
+
+constexpr uint16_t kPcapNgOptionEnd = 0;
+constexpr uint16_t kPcapNgOptionTimestampResolution = 9;
+constexpr uint16_t kPcapNgOptionTimestampOffset = 14;
+
+/// The top bits of the pcap link type field carry FCS information
+constexpr uint32_t kPcapLinkTypeMask = 0x0FFFFFFF;
+
+constexpr uint64_t kNanosecondsPerSecond = 1000000000;
+
+/// A fraction of up to 2^64 ticks times 10^9 needs more than 64 bits
+__extension__ using Uint128 = unsigned __int128;
+
+uint32_t byteSwap32(uint32_t value) {
+    return ((value & 0x000000FFu) << 24) | ((value & 0x0000FF00u) << 8)
+         | ((value & 0x00FF0000u) >> 8) | ((value & 0xFF000000u) >> 24);
+}
+
+uint32_t loadRaw32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void releaseMapping(CaptureFileMapping* mapping) {
+    if (mapping->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete mapping;
+    }
+}
+
+void releaseChunk(CaptureFileMapping::Chunk* chunk) {
+    if (chunk->outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    CaptureFileMapping* mapping = chunk->mapping;
+    delete chunk;
+    mapping->chunksInFlight.fetch_sub(1, std::memory_order_release);
+    releaseMapping(mapping);
+}
+
+void releaseFrame(packetscope::BufferHeader* header) {
+    releaseChunk(static_cast<CaptureFileMapping::Chunk*>(header->owner));
+}
+
+}
+
+std::unique_ptr<CaptureFileReader> CaptureFileReader::open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("CaptureFileReader::open() - Cannot open '{}': {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat fileStatus{};
+    if (fstat(fd, &fileStatus) != 0 || fileStatus.st_size < static_cast<off_t>(kPcapNgMinimumBlockSize)) {
+        spdlog::error("CaptureFileReader::open() - '{}' is not a capture file (too small)", path);
+        ::close(fd);
+        return nullptr;
+    }
+
+    const auto size = static_cast<std::size_t>(fileStatus.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        spdlog::error("CaptureFileReader::open() - Cannot map '{}': {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    // Records are read front to back, ask for aggressive readahead
+    posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+    auto* mapping = new CaptureFileMapping();
+    mapping->data = static_cast<const uint8_t*>(data);
+    mapping->size = size;
+
+    std::unique_ptr<CaptureFileReader> reader(new CaptureFileReader(path, mapping));
+    if (!reader->readFileHeader()) {
+        return nullptr;
+    }
+
+    spdlog::info("CaptureFileReader::open() - Opened '{}' ({}, {} bytes)", path,
+                 reader->format_ == Format::Pcap ? "pcap" : "pcapng", size);
+    return reader;
+}
+
+CaptureFileReader::CaptureFileReader(std::string path, CaptureFileMapping* mapping)
+    : path_(std::move(path))
+    , mapping_(mapping)
+    , begin_(mapping->data)
+    , size_(mapping->size) {}
+
+CaptureFileReader::~CaptureFileReader() {
+    // Chunks still held by the pipeline keep the file mapped until they are released
+    releaseMapping(mapping_);
+}
+
+std::size_t CaptureFileReader::read(std::vector<packetscope::RawPacketData>& packets, std::size_t maxPackets) {
+    if (isAtEnd_ || maxPackets == 0) {
+        return 0;
+    }
+
+    auto* chunk = new CaptureFileMapping::Chunk();
+    chunk->mapping = mapping_;
+    chunk->frames = std::make_unique<packetscope::BufferHeader[]>(maxPackets);
+    chunk->outstanding.store(1, std::memory_order_relaxed);
+    mapping_->refs.fetch_add(1, std::memory_order_relaxed);
+    mapping_->chunksInFlight.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t count = 0;
+    Record record{};
+    while (count < maxPackets && nextRecord(record)) {
+        packetscope::BufferHeader& header = chunk->frames[count];
+        header.size = record.capturedLength;
+        header.capacity = record.capturedLength;
+        header.data = const_cast<uint8_t*>(record.data);
+        header.release = &releaseFrame;
+        header.owner = chunk;
+        header.isBorrowed = true;
+        chunk->outstanding.fetch_add(1, std::memory_order_relaxed);
+
+        packetscope::RawPacketData rawPacketData;
+        rawPacketData.timestamp = record.timestamp;
+        rawPacketData.frameLength = static_cast<int>(record.originalLength);
+        rawPacketData.rawDataLen = static_cast<int>(record.capturedLength);
+        rawPacketData.linkLayerType = record.linkLayerType;
+        rawPacketData.rawData = packetscope::PacketBuffer(&header);
+        packets.push_back(std::move(rawPacketData));
+        ++count;
+    }
+
+    bytesRead_.store(offset_, std::memory_order_relaxed);
+    packetsRead_.fetch_add(count, std::memory_order_relaxed);
+
+    // Drop the guard; the chunk lives on in the frames handed out
+    releaseChunk(chunk);
+    return count;
+}
+
+bool CaptureFileReader::readFileHeader() {
+    const uint32_t magic = loadRaw32(begin_);
+
+    if (magic == kPcapNgSectionHeaderBlock) {
+        format_ = Format::PcapNg;
+        // The section header itself is parsed by nextPcapNgRecord()
+        return true;
+    }
+
+    format_ = Format::Pcap;
+    bool isNanoseconds = false;
+    if (magic == kPcapMagicMicroseconds || magic == kPcapMagicNanoseconds) {
+        isSwapped_ = false;
+        isNanoseconds = magic == kPcapMagicNanoseconds;
+    } else if (byteSwap32(magic) == kPcapMagicMicroseconds || byteSwap32(magic) == kPcapMagicNanoseconds) {
+        isSwapped_ = true;
+        isNanoseconds = byteSwap32(magic) == kPcapMagicNanoseconds;
+    } else {
+        spdlog::error("CaptureFileReader::readFileHeader() - '{}' is neither pcap nor pcapng (magic {:#010x})",
+                      path_, magic);
+        return false;
+    }
+
+    if (size_ < kPcapFileHeaderSize) {
+        spdlog::error("CaptureFileReader::readFileHeader() - '{}' has a truncated pcap header", path_);
+        return false;
+    }
+
+    Interface interface;
+    interface.snapLength = read32(begin_ + 16);
+    interface.linkLayerType = static_cast<pcpp::LinkLayerType>(read32(begin_ + 20) & kPcapLinkTypeMask);
+    interface.ticksPerSecond = isNanoseconds ? kNanosecondsPerSecond : 1000000;
+    interfaces_.push_back(interface);
+
+    offset_ = kPcapFileHeaderSize;
+    return true;
+}
+
+bool CaptureFileReader::nextRecord(Record& record) {
+    const bool isFound = format_ == Format::Pcap ? nextPcapRecord(record) : nextPcapNgRecord(record);
+    if (!isFound) {
+        isAtEnd_ = true;
+    }
+    return isFound;
+}
+
+bool CaptureFileReader::nextPcapRecord(Record& record) {
+    if (size_ - offset_ < kPcapRecordHeaderSize) {
+        if (offset_ != size_) {
+            spdlog::warn("CaptureFileReader::nextPcapRecord() - '{}' ends with a truncated record header", path_);
+        }
+        return false;
+    }
+
+    const uint8_t* header = begin_ + offset_;
+    const uint32_t seconds = read32(header);
+    const uint32_t fraction = read32(header + 4);
+    const uint32_t capturedLength = read32(header + 8);
+
+    if (size_ - offset_ - kPcapRecordHeaderSize < capturedLength) {
+        spdlog::warn("CaptureFileReader::nextPcapRecord() - '{}' ends with a truncated record at offset {}",
+                     path_, offset_);
+        return false;
+    }
+
+    const Interface& interface = interfaces_.front();
+    record.data = header + kPcapRecordHeaderSize;
+    record.capturedLength = capturedLength;
+    record.originalLength = read32(header + 12);
+    record.linkLayerType = interface.linkLayerType;
+    record.timestamp.tv_sec = static_cast<time_t>(seconds);
+    record.timestamp.tv_nsec = static_cast<long>(interface.ticksPerSecond == kNanosecondsPerSecond
+                                                     ? fraction
+                                                     : static_cast<uint64_t>(fraction) * 1000);
+
+    offset_ += kPcapRecordHeaderSize + capturedLength;
+    return true;
+}
+
+bool CaptureFileReader::nextPcapNgRecord(Record& record) {
+    while (size_ - offset_ >= kPcapNgMinimumBlockSize) {
+        const uint8_t* block = begin_ + offset_;
+        const uint32_t type = loadRaw32(block);
+
+        if (type == kPcapNgSectionHeaderBlock) {
+            // Every section declares its own byte order and interfaces
+            const uint32_t byteOrderMagic = loadRaw32(block + 8);
+            if (byteOrderMagic == kPcapNgByteOrderMagic) {
+                isSwapped_ = false;
+            } else if (byteSwap32(byteOrderMagic) == kPcapNgByteOrderMagic) {
+                isSwapped_ = true;
+            } else {
+                spdlog::warn("CaptureFileReader::nextPcapNgRecord() - '{}' has a corrupt section header at offset {}",
+                             path_, offset_);
+                return false;
+            }
+            interfaces_.clear();
+        }
+
+        const uint32_t blockType = read32(block);
+        const uint32_t blockLength = read32(block + 4);
+        if (blockLength < kPcapNgMinimumBlockSize || blockLength % 4 != 0 || blockLength > size_ - offset_) {
+            spdlog::warn("CaptureFileReader::nextPcapNgRecord() - '{}' has a truncated or corrupt block at offset {}",
+                         path_, offset_);
+            return false;
+        }
+
+        // Body without the block type, length and trailing length
+        const uint8_t* body = block + 8;
+        const std::size_t bodyLength = blockLength - kPcapNgMinimumBlockSize;
+        offset_ += blockLength;
+
+        switch (blockType) {
+            case kPcapNgInterfaceDescriptionBlock: {
+                if (bodyLength < 8) {
+                    break;
+                }
+                Interface interface;
+                interface.linkLayerType = static_cast<pcpp::LinkLayerType>(read16(body));
+                interface.snapLength = read32(body + 4);
+                readInterfaceOptions(body + 8, bodyLength - 8, interface);
+                interfaces_.push_back(interface);
+                break;
+            }
+
+            case kPcapNgEnhancedPacketBlock:
+            case kPcapNgObsoletePacketBlock: {
+                if (bodyLength < 20) {
+                    break;
+                }
+                const uint32_t interfaceId = blockType == kPcapNgEnhancedPacketBlock ? read32(body) : read16(body);
+                const uint32_t capturedLength = read32(body + 12);
+                if (interfaceId >= interfaces_.size() || capturedLength > bodyLength - 20) {
+                    break;
+                }
+                const Interface& interface = interfaces_[interfaceId];
+                const uint64_t ticks = (static_cast<uint64_t>(read32(body + 4)) << 32) | read32(body + 8);
+
+                record.data = body + 20;
+                record.capturedLength = capturedLength;
+                record.originalLength = read32(body + 16);
+                record.linkLayerType = interface.linkLayerType;
+                record.timestamp = toTimespec(ticks, interface);
+                return true;
+            }
+
+            case kPcapNgSimplePacketBlock: {
+                if (bodyLength < 4 || interfaces_.empty()) {
+                    break;
+                }
+                // No timestamp and no captured length: bounded by the block and the snap length
+                const Interface& interface = interfaces_.front();
+                const uint32_t originalLength = read32(body);
+                uint32_t capturedLength = std::min(originalLength, static_cast<uint32_t>(bodyLength - 4));
+                if (interface.snapLength > 0) {
+                    capturedLength = std::min(capturedLength, interface.snapLength);
+                }
+
+                record.data = body + 4;
+                record.capturedLength = capturedLength;
+                record.originalLength = originalLength;
+                record.linkLayerType = interface.linkLayerType;
+                record.timestamp = timespec{};
+                return true;
+            }
+
+            default:
+                // Section header, statistics, name resolution, custom blocks
+                break;
+        }
+    }
+
+    if (offset_ != size_) {
+        spdlog::warn("CaptureFileReader::nextPcapNgRecord() - '{}' ends with a truncated block", path_);
+    }
+    return false;
+}
+
+void CaptureFileReader::readInterfaceOptions(const uint8_t* options, std::size_t length, Interface& interface) const {
+    std::size_t offset = 0;
+    while (length - offset >= 4) {
+        const uint16_t code = read16(options + offset);
+        const uint16_t valueLength = read16(options + offset + 2);
+        const uint8_t* value = options + offset + 4;
+
+        if (code == kPcapNgOptionEnd || valueLength > length - offset - 4) {
+            return;
+        }
+
+        if (code == kPcapNgOptionTimestampResolution && valueLength >= 1) {
+            // Bit 7 selects a power of 2 instead of a power of 10
+            const uint8_t resolution = value[0];
+            const unsigned exponent = resolution & 0x7F;
+            if (resolution & 0x80) {
+                interface.ticksPerSecond = exponent < 64 ? (uint64_t{1} << exponent) : 0;
+            } else {
+                uint64_t ticksPerSecond = 1;
+                for (unsigned i = 0; i < exponent && i < 19; ++i) {
+                    ticksPerSecond *= 10;
+                }
+                interface.ticksPerSecond = ticksPerSecond;
+            }
+            if (interface.ticksPerSecond == 0) {
+                interface.ticksPerSecond = 1000000;
+            }
+        } else if (code == kPcapNgOptionTimestampOffset && valueLength >= 8) {
+            interface.offsetSeconds = static_cast<int64_t>(read64(value));
+        }
+
+        // Values are padded to 32 bits
+        offset += 4 + ((static_cast<std::size_t>(valueLength) + 3) & ~std::size_t{3});
+    }
+}
+
+timespec CaptureFileReader::toTimespec(uint64_t ticks, const Interface& interface) {
+    const uint64_t seconds = ticks / interface.ticksPerSecond;
+    const uint64_t fraction = ticks % interface.ticksPerSecond;
+
+    timespec timestamp{};
+    timestamp.tv_sec = static_cast<time_t>(static_cast<int64_t>(seconds) + interface.offsetSeconds);
+    // Exact for every resolution: 10^9 / ticksPerSecond is not an integer for powers of 2
+    timestamp.tv_nsec = static_cast<long>(static_cast<Uint128>(fraction) * kNanosecondsPerSecond
+                                          / interface.ticksPerSecond);
+    return timestamp;
+}
+
+uint16_t CaptureFileReader::read16(const uint8_t* data) const {
+    uint16_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return isSwapped_ ? static_cast<uint16_t>((value << 8) | (value >> 8)) : value;
+}
+
+uint32_t CaptureFileReader::read32(const uint8_t* data) const {
+    const uint32_t value = loadRaw32(data);
+    return isSwapped_ ? byteSwap32(value) : value;
+}
+
+uint64_t CaptureFileReader::read64(const uint8_t* data) const {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    if (!isSwapped_) {
+        return value;
+    }
+    return (static_cast<uint64_t>(byteSwap32(static_cast<uint32_t>(value))) << 32)
+         | byteSwap32(static_cast<uint32_t>(value >> 32));
+}
+
+bool CaptureFileReader::isAtEnd() const {
+    return isAtEnd_;
+}
+
+std::size_t CaptureFileReader::chunksInFlight() const {
+    return mapping_->chunksInFlight.load(std::memory_order_acquire);
+}
+
+CaptureFileReader::Format CaptureFileReader::format() const {
+    return format_;
+}
+
+const std::string& CaptureFileReader::path() const {
+    return path_;
+}
+
+uint64_t CaptureFileReader::fileSize() const {
+    return size_;
+}
+
+uint64_t CaptureFileReader::bytesRead() const {
+    return bytesRead_.load(std::memory_order_relaxed);
+}
+
+uint64_t CaptureFileReader::packetsRead() const {
+    return packetsRead_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,407 @@
+#include "core/CaptureFileWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+constexpr uint32_t kPcapNgSectionHeaderBlock = 0x0A0D0D0A;
+constexpr uint32_t kPcapNgInterfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t kPcapNgEnhancedPacketBlock = 0x00000006;
+constexpr uint32_t kPcapNgByteOrderMagic = 0x1A2B3C4D;
+
+constexpr uint16_t kPcapNgOptionEnd = 0;
+constexpr uint16_t kPcapNgOptionUserApplication = 4;
+constexpr uint16_t kPcapNgOptionTimestampResolution = 9;
+
+/// if_tsresol value for nanoseconds (10^-9)
+constexpr uint8_t kNanosecondResolution = 9;
+
+constexpr char kUserApplication[] = "PacketScope";
+
+/// Block type, total length, interface, timestamp (2x), captured and original length
+constexpr std::size_t kEnhancedPacketHeaderSize = 28;
+
+/// Trailing copy of the total length of every block
+constexpr std::size_t kBlockTrailerSize = 4;
+
+constexpr uint64_t kNanosecondsPerSecond = 1000000000;
+
+std::size_t padded(std::size_t length) {
+    return (length + 3) & ~std::size_t{3};
+}
+
+template <typename T>
+void append(std::vector<uint8_t>& bytes, T value) {
+    const std::size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(value));
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+void appendPadded(std::vector<uint8_t>& bytes, const void* data, std::size_t length) {
+    const auto* begin = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), begin, begin + length);
+    bytes.resize(bytes.size() + padded(length) - length, 0);
+}
+
+constexpr std::size_t userApplicationOptionSize() {
+    return 4 + ((sizeof(kUserApplication) - 1 + 3) & ~std::size_t{3});
+}
+
+/// Header, byte order magic, version, section length, user application and end options, trailer
+constexpr std::size_t kSectionHeaderSize = 8 + 4 + 4 + 8 + userApplicationOptionSize() + 4 + kBlockTrailerSize;
+
+/// Header, link type, reserved, snap length, if_tsresol and end options, trailer
+constexpr std::size_t kInterfaceDescriptionSize = 8 + 8 + 8 + 4 + kBlockTrailerSize;
+
+}
+
+std::unique_ptr<CaptureFileWriter> CaptureFileWriter::start(packetscope::CaptureWriterConfig config) {
+    struct stat directoryStatus{};
+    if (stat(config.directory.c_str(), &directoryStatus) != 0 || !S_ISDIR(directoryStatus.st_mode)
+        || access(config.directory.c_str(), W_OK) != 0) {
+        spdlog::error("CaptureFileWriter::start() - '{}' is not a writable directory", config.directory);
+        return nullptr;
+    }
+
+    spdlog::info("CaptureFileWriter::start() - Recording to '{}/{}_*.pcapng' (max {} bytes / {} s per file, {} files kept)",
+                 config.directory, config.filePrefix, config.maxFileSize, config.maxFileDuration.count(),
+                 config.fileCount);
+
+    std::unique_ptr<CaptureFileWriter> writer(new CaptureFileWriter(std::move(config)));
+    writer->encoderThread_ = std::thread([self = writer.get()] { self->encoderLoop(); });
+    writer->flusherThread_ = std::thread([self = writer.get()] { self->flusherLoop(); });
+    return writer;
+}
+
+CaptureFileWriter::CaptureFileWriter(packetscope::CaptureWriterConfig config)
+    : config_(std::move(config))
+      // A maximum size packet (and the blocks in front of it) always fits into one buffer
+    , bufferCapacity_(std::max(config_.writeBufferSize,
+                               kSectionHeaderSize + kInterfaceDescriptionSize + kEnhancedPacketHeaderSize
+                               + padded(packetscope::CaptureFilter::kMaxSnapLength) + kBlockTrailerSize))
+    , bufferPool_(PacketBufferPool::create())
+    , queue_(config_.queue) {
+    for (std::size_t i = 0; i < kBufferCount; ++i) {
+        auto buffer = std::make_unique<WriteBuffer>();
+        buffer->bytes.reserve(bufferCapacity_);
+        freeBuffers_.push_back(std::move(buffer));
+    }
+}
+
+CaptureFileWriter::~CaptureFileWriter() {
+    isStopRequested_ = true;
+    if (encoderThread_.joinable()) {
+        encoderThread_.join();
+    }
+    if (flusherThread_.joinable()) {
+        flusherThread_.join();
+    }
+
+    const packetscope::CaptureWriterStats summary = stats();
+    spdlog::info("CaptureFileWriter::~CaptureFileWriter() - Recorded {} packets ({} bytes) to {} files, {} dropped",
+                 summary.packetsWritten, summary.bytesWritten, summary.filesWritten, summary.packetsDropped);
+}
+
+bool CaptureFileWriter::offer(const packetscope::RawPacketData& packet) {
+    packetscope::RawPacketData queued = packet;
+    // A queued ring frame would keep its whole block from the kernel while the disk is behind,
+    // so borrowed bytes are copied; pooled buffers are shared
+    if (queued.rawData.isBorrowed()) {
+        queued.rawData = bufferPool_->copyFrom(packet.rawData.data(), packet.rawData.size());
+    }
+    return queue_.offer(std::move(queued));
+}
+
+packetscope::CaptureWriterStats CaptureFileWriter::stats() const {
+    packetscope::CaptureWriterStats stats;
+    stats.packetsWritten = packetsWritten_;
+    stats.bytesWritten = bytesWritten_;
+    stats.packetsDropped = queue_.stats().dropped + packetsFailed_;
+    stats.filesWritten = filesWritten_;
+
+    std::lock_guard<std::mutex> lock(currentFileMutex_);
+    stats.currentFile = currentFile_;
+    return stats;
+}
+
+const packetscope::CaptureWriterConfig& CaptureFileWriter::config() const {
+    return config_;
+}
+
+void CaptureFileWriter::encoderLoop() {
+    while (true) {
+        if (std::optional<packetscope::RawPacketData> packet = queue_.poll()) {
+            encode(*packet);
+        } else if (isStopRequested_) {
+            // The producer stopped before the stop request, drain what it left
+            while (std::optional<packetscope::RawPacketData> remaining = queue_.poll()) {
+                encode(*remaining);
+            }
+            break;
+        } else if (std::optional<packetscope::RawPacketData> next =
+                       queue_.popUntil(std::chrono::steady_clock::now() + kIdleWait)) {
+            encode(*next);
+        }
+
+        // Bound how long a packet sits in memory at low rates
+        if (current_ && !current_->bytes.empty()
+            && std::chrono::steady_clock::now() - bufferStartedAt_ >= kFlushInterval) {
+            submitBuffer(false);
+        }
+    }
+
+    submitBuffer(isFileOpen_);
+
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        isEncoderFinished_ = true;
+    }
+    bufferCondition_.notify_all();
+}
+
+void CaptureFileWriter::encode(const packetscope::RawPacketData& packet) {
+    const auto capturedLength = static_cast<std::size_t>(std::max(packet.rawDataLen, 0));
+    const std::size_t recordSize = kEnhancedPacketHeaderSize + padded(capturedLength) + kBlockTrailerSize;
+
+    if (isFileOpen_) {
+        // A file holds at least one packet, even one larger than maxFileSize
+        const bool isFull = config_.maxFileSize > 0 && filePackets_ > 0
+            && fileBytes_ + recordSize > config_.maxFileSize;
+        const bool isExpired = config_.maxFileDuration.count() > 0
+            && std::chrono::steady_clock::now() - fileOpenedAt_ >= config_.maxFileDuration;
+        if (isFull || isExpired) {
+            submitBuffer(true);
+            isFileOpen_ = false;
+        }
+    }
+    if (!isFileOpen_) {
+        beginFile();
+    }
+
+    const uint32_t interfaceId = interfaceFor(packet.linkLayerType);
+    reserve(recordSize);
+
+    const uint64_t ticks = static_cast<uint64_t>(packet.timestamp.tv_sec) * kNanosecondsPerSecond
+        + static_cast<uint64_t>(packet.timestamp.tv_nsec);
+
+    std::vector<uint8_t>& bytes = current_->bytes;
+    append(bytes, kPcapNgEnhancedPacketBlock);
+    append(bytes, static_cast<uint32_t>(recordSize));
+    append(bytes, interfaceId);
+    append(bytes, static_cast<uint32_t>(ticks >> 32));
+    append(bytes, static_cast<uint32_t>(ticks & 0xFFFFFFFF));
+    append(bytes, static_cast<uint32_t>(capturedLength));
+    append(bytes, static_cast<uint32_t>(std::max(packet.frameLength, packet.rawDataLen)));
+    appendPadded(bytes, packet.rawData.data(), capturedLength);
+    append(bytes, static_cast<uint32_t>(recordSize));
+
+    ++current_->packets;
+    ++filePackets_;
+    fileBytes_ += recordSize;
+}
+
+void CaptureFileWriter::beginFile() {
+    // Bytes of the previous file were handed over when it ended
+    if (current_ && !current_->bytes.empty()) {
+        submitBuffer(false);
+    }
+
+    ++fileIndex_;
+
+    char timeText[32] = {};
+    const std::time_t now = std::time(nullptr);
+    std::tm localTime{};
+    localtime_r(&now, &localTime);
+    std::strftime(timeText, sizeof(timeText), "%Y%m%d-%H%M%S", &localTime);
+
+    reserve(kSectionHeaderSize);
+    current_->openPath = fmt::format("{}/{}_{:05}_{}.pcapng", config_.directory, config_.filePrefix,
+                                     fileIndex_, timeText);
+
+    // Written in host byte order, readers detect it from the byte order magic
+    std::vector<uint8_t>& bytes = current_->bytes;
+    append(bytes, kPcapNgSectionHeaderBlock);
+    append(bytes, static_cast<uint32_t>(kSectionHeaderSize));
+    append(bytes, kPcapNgByteOrderMagic);
+    append(bytes, uint16_t{1});                 // Major version
+    append(bytes, uint16_t{0});                 // Minor version
+    append(bytes, int64_t{-1});                 // Section length unknown, the file is streamed
+    append(bytes, kPcapNgOptionUserApplication);
+    append(bytes, static_cast<uint16_t>(sizeof(kUserApplication) - 1));
+    appendPadded(bytes, kUserApplication, sizeof(kUserApplication) - 1);
+    append(bytes, kPcapNgOptionEnd);
+    append(bytes, uint16_t{0});
+    append(bytes, static_cast<uint32_t>(kSectionHeaderSize));
+
+    interfaces_.clear();
+    fileBytes_ = kSectionHeaderSize;
+    filePackets_ = 0;
+    fileOpenedAt_ = std::chrono::steady_clock::now();
+    isFileOpen_ = true;
+}
+
+uint32_t CaptureFileWriter::interfaceFor(pcpp::LinkLayerType linkLayerType) {
+    const auto known = std::find(interfaces_.begin(), interfaces_.end(), linkLayerType);
+    if (known != interfaces_.end()) {
+        return static_cast<uint32_t>(known - interfaces_.begin());
+    }
+
+    reserve(kInterfaceDescriptionSize);
+
+    std::vector<uint8_t>& bytes = current_->bytes;
+    append(bytes, kPcapNgInterfaceDescriptionBlock);
+    append(bytes, static_cast<uint32_t>(kInterfaceDescriptionSize));
+    append(bytes, static_cast<uint16_t>(linkLayerType));
+    append(bytes, uint16_t{0});                 // Reserved
+    append(bytes, uint32_t{0});                 // Snap length, 0 means unlimited
+    append(bytes, kPcapNgOptionTimestampResolution);
+    append(bytes, uint16_t{1});
+    appendPadded(bytes, &kNanosecondResolution, 1);
+    append(bytes, kPcapNgOptionEnd);
+    append(bytes, uint16_t{0});
+    append(bytes, static_cast<uint32_t>(kInterfaceDescriptionSize));
+
+    fileBytes_ += kInterfaceDescriptionSize;
+    interfaces_.push_back(linkLayerType);
+    return static_cast<uint32_t>(interfaces_.size() - 1);
+}
+
+void CaptureFileWriter::reserve(std::size_t bytes) {
+    if (current_ && current_->bytes.size() + bytes > bufferCapacity_) {
+        submitBuffer(false);
+    }
+    if (!current_) {
+        current_ = acquireBuffer();
+        bufferStartedAt_ = std::chrono::steady_clock::now();
+    }
+}
+
+std::unique_ptr<CaptureFileWriter::WriteBuffer> CaptureFileWriter::acquireBuffer() {
+    std::unique_lock<std::mutex> lock(bufferMutex_);
+    // Meanwhile the queue absorbs new packets, and drops them once it is full
+    bufferCondition_.wait(lock, [this] { return !freeBuffers_.empty(); });
+
+    std::unique_ptr<WriteBuffer> buffer = std::move(freeBuffers_.back());
+    freeBuffers_.pop_back();
+    return buffer;
+}
+
+void CaptureFileWriter::submitBuffer(bool isFileEnd) {
+    if (!current_) {
+        if (!isFileEnd) {
+            return;
+        }
+        // Tells the flusher to close the file
+        current_ = acquireBuffer();
+    }
+
+    current_->isFileEnd = isFileEnd;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        fullBuffers_.push_back(std::move(current_));
+    }
+    bufferCondition_.notify_all();
+}
+
+void CaptureFileWriter::flusherLoop() {
+    while (true) {
+        std::unique_ptr<WriteBuffer> buffer;
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex_);
+            bufferCondition_.wait(lock, [this] { return !fullBuffers_.empty() || isEncoderFinished_; });
+            if (fullBuffers_.empty()) {
+                break;
+            }
+            buffer = std::move(fullBuffers_.front());
+            fullBuffers_.pop_front();
+        }
+
+        writeBuffer(*buffer);
+
+        buffer->bytes.clear();
+        buffer->packets = 0;
+        buffer->openPath.clear();
+        buffer->isFileEnd = false;
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex_);
+            freeBuffers_.push_back(std::move(buffer));
+        }
+        bufferCondition_.notify_all();
+    }
+
+    if (fileFd_ >= 0) {
+        ::close(fileFd_);
+        fileFd_ = -1;
+    }
+}
+
+void CaptureFileWriter::writeBuffer(const WriteBuffer& buffer) {
+    if (!buffer.openPath.empty()) {
+        if (fileFd_ >= 0) {
+            ::close(fileFd_);
+        }
+
+        fileFd_ = ::open(buffer.openPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fileFd_ < 0) {
+            spdlog::error("CaptureFileWriter::writeBuffer() - Cannot create '{}': {}",
+                          buffer.openPath, std::strerror(errno));
+        } else {
+            isWriteFailed_ = false;
+            ++filesWritten_;
+            {
+                std::lock_guard<std::mutex> lock(currentFileMutex_);
+                currentFile_ = buffer.openPath;
+            }
+
+            ringFiles_.push_back(buffer.openPath);
+            while (config_.fileCount > 0 && ringFiles_.size() > config_.fileCount) {
+                if (::unlink(ringFiles_.front().c_str()) != 0 && errno != ENOENT) {
+                    spdlog::warn("CaptureFileWriter::writeBuffer() - Cannot delete '{}': {}",
+                                 ringFiles_.front(), std::strerror(errno));
+                }
+                ringFiles_.pop_front();
+            }
+        }
+    }
+
+    // After a failed write the rest of the file is lost, the next file is tried again
+    if (fileFd_ < 0 || isWriteFailed_) {
+        packetsFailed_ += buffer.packets;
+    } else {
+        const uint8_t* data = buffer.bytes.data();
+        std::size_t remaining = buffer.bytes.size();
+        while (remaining > 0) {
+            const ssize_t written = ::write(fileFd_, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                spdlog::error("CaptureFileWriter::writeBuffer() - Write to '{}' failed: {}",
+                              ringFiles_.empty() ? std::string() : ringFiles_.back(), std::strerror(errno));
+                isWriteFailed_ = true;
+                packetsFailed_ += buffer.packets;
+                break;
+            }
+            data += written;
+            remaining -= static_cast<std::size_t>(written);
+            bytesWritten_ += static_cast<uint64_t>(written);
+        }
+        if (!isWriteFailed_) {
+            packetsWritten_ += buffer.packets;
+        }
+    }
+
+    if (buffer.isFileEnd && fileFd_ >= 0) {
+        ::close(fileFd_);
+        fileFd_ = -1;
+    }
+}
@@ -0,0 +1,100 @@
+#include "core/CpuAffinity.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <spdlog/spdlog.h>
+
+std::size_t CpuAffinity::hardwareThreads() {
+    // hardware_concurrency() may return 0 if the value is not computable
+    const unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+bool CpuAffinity::pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            spdlog::warn("CpuAffinity::pinCurrentThread() - Ignoring invalid CPU {}", cpu);
+            continue;
+        }
+        CPU_SET(static_cast<std::size_t>(cpu), &set);
+    }
+
+    if (CPU_COUNT(&set) == 0) {
+        return false;
+    }
+
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        spdlog::warn("CpuAffinity::pinCurrentThread() - pthread_setaffinity_np failed ({})", result);
+        return false;
+    }
+    return true;
+}
+
+int CpuAffinity::deviceNumaNode(const std::string& deviceName) {
+    std::ifstream file("/sys/class/net/" + deviceName + "/device/numa_node");
+
+    int node = -1;
+    if (!(file >> node)) {
+        return -1;
+    }
+    // The kernel reports -1 when the device has no NUMA affinity
+    return node;
+}
+
+std::vector<int> CpuAffinity::numaNodeCpus(int node) {
+    if (node < 0) {
+        return {};
+    }
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+
+    std::string cpuList;
+    if (!std::getline(file, cpuList)) {
+        return {};
+    }
+    return parseCpuList(cpuList);
+}
+
+std::vector<int> CpuAffinity::parseCpuList(const std::string& cpuList) {
+    std::vector<int> cpus;
+    std::stringstream stream(cpuList);
+    std::string range;
+
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        std::istringstream rangeStream(range);
+
+        if (!(rangeStream >> first)) {
+            return {};
+        }
+        last = first;
+        if (rangeStream >> dash) {
+            if (dash != '-' || !(rangeStream >> last) || last < first) {
+                return {};
+            }
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
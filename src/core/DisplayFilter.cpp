@@ -0,0 +1,947 @@
+#include "core/DisplayFilter.hpp"
+#include "core/PacketIndex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <arpa/inet.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+using Family = packetscope::PacketAddress::Family;
+
+enum class Opcode : uint8_t {
+    True,               ///< Pushes an all true mask
+    CompareColumn,      ///< Pushes column <comparison> value
+    MatchAddress,       ///< Pushes address of side within the prefix
+    MatchFamily,        ///< Pushes source address family == family
+    MatchProtocol,      ///< Pushes highest layer protocol == protocol
+    And,                ///< Pops two masks, pushes both
+    Or,                 ///< Pops two masks, pushes either
+    Not                 ///< Inverts the top mask
+};
+
+enum class Column : uint8_t {
+    Number,
+    FrameLength,
+    CapturedLength,
+    SrcPort,
+    DstPort,
+    IpProtocol
+};
+
+enum class Comparison : uint8_t {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+enum class Side : uint8_t {
+    Source,
+    Destination
+};
+
+/**
+ * One step of the postfix program. Addresses are compared as two 64 bit
+ * halves of PacketAddress::bytes, the prefix is applied with the mask.
+ */
+struct Instruction {
+    Opcode opcode{Opcode::True};
+    Column column{};
+    Comparison comparison{};
+    Side side{};
+    Family family{Family::None};
+    int64_t value{};
+    uint64_t addressHigh{};
+    uint64_t addressLow{};
+    uint64_t maskHigh{};
+    uint64_t maskLow{};
+    pcpp::ProtocolType protocol{};
+};
+
+/**
+ * A PacketIndex posting list; the packets of all keys of a hint are a
+ * superset of the packets matching the (sub)expression.
+ */
+struct IndexKey {
+    enum class Kind : uint8_t {
+        Address,        ///< Source or destination address
+        Port,           ///< Source or destination port of ipProtocol
+        Protocol,       ///< Highest layer
+        IpProtocol      ///< Transport protocol
+    };
+
+    Kind kind{Kind::IpProtocol};
+    packetscope::PacketAddress address;
+    uint8_t ipProtocol{};
+    uint16_t port{};
+    pcpp::ProtocolType protocol{};
+};
+
+/// Keys whose union covers a subexpression, std::nullopt if the index cannot narrow it down
+using IndexHint = std::optional<std::vector<IndexKey>>;
+
+/// Candidates up to 1 / kIndexSparsity of the range are tested one by one, more are scanned
+constexpr std::size_t kIndexSparsity = 64;
+
+/// IANA protocol numbers used by the protocol keywords
+constexpr int64_t kIpProtocolIcmp = 1;
+constexpr int64_t kIpProtocolTcp = 6;
+constexpr int64_t kIpProtocolUdp = 17;
+constexpr int64_t kIpProtocolIcmpV6 = 58;
+
+Instruction compareColumn(Column column, Comparison comparison, int64_t value) {
+    Instruction instruction;
+    instruction.opcode = Opcode::CompareColumn;
+    instruction.column = column;
+    instruction.comparison = comparison;
+    instruction.value = value;
+    return instruction;
+}
+
+Instruction matchFamily(Family family) {
+    Instruction instruction;
+    instruction.opcode = Opcode::MatchFamily;
+    instruction.family = family;
+    return instruction;
+}
+
+Instruction matchProtocol(pcpp::ProtocolType protocol) {
+    Instruction instruction;
+    instruction.opcode = Opcode::MatchProtocol;
+    instruction.protocol = protocol;
+    return instruction;
+}
+
+Instruction logic(Opcode opcode) {
+    Instruction instruction;
+    instruction.opcode = opcode;
+    return instruction;
+}
+
+/// Hint of a single test instruction (protocol keywords, presence of a field)
+IndexHint hintOf(const Instruction& instruction) {
+    IndexKey key;
+    if (instruction.opcode == Opcode::MatchProtocol) {
+        key.kind = IndexKey::Kind::Protocol;
+        key.protocol = instruction.protocol;
+        return std::vector<IndexKey>{key};
+    }
+    if (instruction.opcode == Opcode::CompareColumn && instruction.column == Column::IpProtocol
+        && instruction.comparison == Comparison::Equal) {
+        key.kind = IndexKey::Kind::IpProtocol;
+        key.ipProtocol = static_cast<uint8_t>(instruction.value);
+        return std::vector<IndexKey>{key};
+    }
+    return std::nullopt;
+}
+
+/// Either side matching: the union of both hints
+IndexHint unite(IndexHint left, const IndexHint& right) {
+    if (!left || !right) {
+        return std::nullopt;
+    }
+    left->insert(left->end(), right->begin(), right->end());
+    return left;
+}
+
+/// Both sides matching: either hint will do, keep the one likely to have fewer packets
+IndexHint narrower(IndexHint left, IndexHint right) {
+    if (!left || !right) {
+        return left ? left : right;
+    }
+    // Kinds are declared from the most to the least selective
+    auto rank = [](const std::vector<IndexKey>& keys) {
+        IndexKey::Kind widest = IndexKey::Kind::Address;
+        for (const IndexKey& key : keys) {
+            widest = std::max(widest, key.kind);
+        }
+        return std::make_pair(widest, keys.size());
+    };
+    return rank(*right) < rank(*left) ? right : left;
+}
+
+/**
+ * A filterable field: presence test plus the columns (or address sides)
+ * holding its one or two occurrences.
+ */
+struct Field {
+    std::string_view name;
+    Instruction presence;
+    bool isAddress{false};
+    std::size_t occurrences{1};
+    Column columns[2]{};
+    Side sides[2]{};
+    int64_t maxValue{0};                ///< Largest value of an integer field
+};
+
+std::vector<Field> makeFields() {
+    const Instruction always = logic(Opcode::True);
+    const Instruction isIPv4 = matchFamily(Family::IPv4);
+    const Instruction isIPv6 = matchFamily(Family::IPv6);
+    const Instruction isTcp = compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolTcp);
+    const Instruction isUdp = compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolUdp);
+
+    auto integer = [](std::string_view name, Instruction presence, int64_t maxValue,
+                      Column first, std::size_t occurrences = 1, Column second = Column::Number) {
+        Field field;
+        field.name = name;
+        field.presence = presence;
+        field.occurrences = occurrences;
+        field.columns[0] = first;
+        field.columns[1] = second;
+        field.maxValue = maxValue;
+        return field;
+    };
+    auto address = [](std::string_view name, Instruction presence, Side first,
+                      std::size_t occurrences = 1, Side second = Side::Destination) {
+        Field field;
+        field.name = name;
+        field.presence = presence;
+        field.isAddress = true;
+        field.occurrences = occurrences;
+        field.sides[0] = first;
+        field.sides[1] = second;
+        return field;
+    };
+
+    constexpr int64_t kMaxInt = 0x7fffffff;
+    constexpr int64_t kMaxPort = 0xffff;
+    constexpr int64_t kMaxByte = 0xff;
+
+    return {
+        integer("frame.number", always, kMaxInt, Column::Number),
+        integer("frame.len", always, kMaxInt, Column::FrameLength),
+        integer("frame.cap_len", always, kMaxInt, Column::CapturedLength),
+        address("ip.src", isIPv4, Side::Source),
+        address("ip.dst", isIPv4, Side::Destination),
+        address("ip.addr", isIPv4, Side::Source, 2),
+        integer("ip.proto", isIPv4, kMaxByte, Column::IpProtocol),
+        address("ipv6.src", isIPv6, Side::Source),
+        address("ipv6.dst", isIPv6, Side::Destination),
+        address("ipv6.addr", isIPv6, Side::Source, 2),
+        integer("tcp.srcport", isTcp, kMaxPort, Column::SrcPort),
+        integer("tcp.dstport", isTcp, kMaxPort, Column::DstPort),
+        integer("tcp.port", isTcp, kMaxPort, Column::SrcPort, 2, Column::DstPort),
+        integer("udp.srcport", isUdp, kMaxPort, Column::SrcPort),
+        integer("udp.dstport", isUdp, kMaxPort, Column::DstPort),
+        integer("udp.port", isUdp, kMaxPort, Column::SrcPort, 2, Column::DstPort),
+    };
+}
+
+/**
+ * Protocol keyword: the instructions of its test, a single one or two
+ * alternatives joined with Or.
+ */
+struct ProtocolKeyword {
+    std::string_view name;
+    Instruction first;
+    bool hasSecond{false};
+    Instruction second{};
+};
+
+std::vector<ProtocolKeyword> makeProtocolKeywords() {
+    return {
+        {"ip", matchFamily(Family::IPv4)},
+        {"ipv6", matchFamily(Family::IPv6)},
+        {"tcp", compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolTcp)},
+        {"udp", compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolUdp)},
+        {"icmp", compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolIcmp)},
+        {"icmpv6", compareColumn(Column::IpProtocol, Comparison::Equal, kIpProtocolIcmpV6)},
+        // The rest are matched against the highest layer, as shown in the Protocol column
+        {"arp", matchProtocol(pcpp::ARP)},
+        {"dns", matchProtocol(pcpp::DNS)},
+        {"http", matchProtocol(pcpp::HTTPRequest), true, matchProtocol(pcpp::HTTPResponse)},
+        {"tls", matchProtocol(pcpp::SSL)},
+        {"ssl", matchProtocol(pcpp::SSL)},
+        {"ssh", matchProtocol(pcpp::SSH)},
+        {"ftp", matchProtocol(pcpp::FTP)},
+    };
+}
+
+class FilterSyntaxError : public std::runtime_error {
+public:
+    FilterSyntaxError(const std::string& message, std::size_t position)
+        : std::runtime_error(message + " at position " + std::to_string(position + 1)) {}
+};
+
+struct Token {
+    enum class Kind {
+        Word,           ///< Field, protocol, keyword or value
+        Operator,       ///< Comparison or logic symbol
+        OpenParen,
+        CloseParen,
+        End
+    };
+
+    Kind kind{Kind::End};
+    std::string text;
+    std::size_t position{0};
+};
+
+bool isWordCharacter(char character) {
+    return std::isalnum(static_cast<unsigned char>(character)) || character == '_' || character == '.'
+        || character == ':' || character == '/';
+}
+
+std::vector<Token> tokenize(const std::string& expression) {
+    std::vector<Token> tokens;
+    std::size_t position = 0;
+
+    while (position < expression.size()) {
+        const char character = expression[position];
+        if (std::isspace(static_cast<unsigned char>(character))) {
+            ++position;
+            continue;
+        }
+
+        Token token;
+        token.position = position;
+        if (character == '(' || character == ')') {
+            token.kind = character == '(' ? Token::Kind::OpenParen : Token::Kind::CloseParen;
+            token.text = std::string(1, character);
+            ++position;
+        } else if (isWordCharacter(character)) {
+            token.kind = Token::Kind::Word;
+            while (position < expression.size() && isWordCharacter(expression[position])) {
+                token.text += expression[position++];
+            }
+        } else {
+            static constexpr std::string_view kOperators[] = {"==", "!=", "<=", ">=", "&&", "||", "<", ">", "!"};
+            const std::string_view rest(expression.data() + position, expression.size() - position);
+            for (const std::string_view symbol : kOperators) {
+                if (rest.substr(0, symbol.size()) == symbol) {
+                    token.kind = Token::Kind::Operator;
+                    token.text = std::string(symbol);
+                    break;
+                }
+            }
+            if (token.text.empty()) {
+                throw FilterSyntaxError(std::string("Unexpected character '") + character + "'", position);
+            }
+            position += token.text.size();
+        }
+        tokens.push_back(std::move(token));
+    }
+
+    Token end;
+    end.position = expression.size();
+    tokens.push_back(std::move(end));
+    return tokens;
+}
+
+/**
+ * Recursive descent parser which emits the postfix program directly:
+ *   or      := and (("||" | "or") and)*
+ *   and     := unary (("&&" | "and") unary)*
+ *   unary   := ("!" | "not") unary | primary
+ *   primary := "(" or ")" | protocol | field [comparison value]
+ */
+class Compiler {
+public:
+    explicit Compiler(const std::string& expression)
+        : tokens_(tokenize(expression))
+        , fields_(makeFields())
+        , protocols_(makeProtocolKeywords()) {}
+
+    std::vector<Instruction> compile() {
+        if (peek().kind == Token::Kind::End) {
+            throw FilterSyntaxError("Empty filter", 0);
+        }
+        hint_ = parseOr();
+        if (peek().kind != Token::Kind::End) {
+            throw FilterSyntaxError("Unexpected '" + peek().text + "'", peek().position);
+        }
+        return std::move(program_);
+    }
+
+    /// Index keys covering the whole expression, valid after compile()
+    const IndexHint& hint() const {
+        return hint_;
+    }
+
+private:
+    const Token& peek() const {
+        return tokens_[next_];
+    }
+
+    Token take() {
+        return tokens_[next_ < tokens_.size() - 1 ? next_++ : next_];
+    }
+
+    bool accept(std::string_view symbol, std::string_view keyword) {
+        const Token& token = peek();
+        if ((token.kind == Token::Kind::Operator && token.text == symbol)
+            || (token.kind == Token::Kind::Word && token.text == keyword)) {
+            ++next_;
+            return true;
+        }
+        return false;
+    }
+
+    void emit(const Instruction& instruction) {
+        program_.push_back(instruction);
+    }
+
+    // Every parse step returns the index hint of what it parsed
+
+    IndexHint parseOr() {
+        IndexHint hint = parseAnd();
+        while (accept("||", "or")) {
+            hint = unite(std::move(hint), parseAnd());
+            emit(logic(Opcode::Or));
+        }
+        return hint;
+    }
+
+    IndexHint parseAnd() {
+        IndexHint hint = parseUnary();
+        while (accept("&&", "and")) {
+            hint = narrower(std::move(hint), parseUnary());
+            emit(logic(Opcode::And));
+        }
+        return hint;
+    }
+
+    IndexHint parseUnary() {
+        if (accept("!", "not")) {
+            parseUnary();
+            emit(logic(Opcode::Not));
+            // Matches everything outside of the keys' packets
+            return std::nullopt;
+        }
+        return parsePrimary();
+    }
+
+    IndexHint parsePrimary() {
+        const Token token = take();
+
+        if (token.kind == Token::Kind::OpenParen) {
+            IndexHint hint = parseOr();
+            if (take().kind != Token::Kind::CloseParen) {
+                throw FilterSyntaxError("Missing ')'", token.position);
+            }
+            return hint;
+        }
+        if (token.kind != Token::Kind::Word) {
+            throw FilterSyntaxError("Expected a field or protocol", token.position);
+        }
+
+        for (const ProtocolKeyword& protocol : protocols_) {
+            if (protocol.name == token.text) {
+                emit(protocol.first);
+                if (protocol.hasSecond) {
+                    emit(protocol.second);
+                    emit(logic(Opcode::Or));
+                    return unite(hintOf(protocol.first), hintOf(protocol.second));
+                }
+                return hintOf(protocol.first);
+            }
+        }
+
+        const auto field = std::find_if(fields_.begin(), fields_.end(),
+                                        [&token](const Field& candidate) { return candidate.name == token.text; });
+        if (field == fields_.end()) {
+            throw FilterSyntaxError("Unknown field '" + token.text + "'", token.position);
+        }
+
+        Comparison comparison;
+        if (!parseComparison(comparison)) {
+            // Field on its own: presence test
+            emit(field->presence);
+            return hintOf(field->presence);
+        }
+
+        const Token value = take();
+        if (value.kind != Token::Kind::Word) {
+            throw FilterSyntaxError("Expected a value", value.position);
+        }
+        return emitComparison(*field, comparison, value);
+    }
+
+    bool parseComparison(Comparison& comparison) {
+        static constexpr struct {
+            std::string_view symbol;
+            std::string_view keyword;
+            Comparison comparison;
+        } kComparisons[] = {
+            {"==", "eq", Comparison::Equal},
+            {"!=", "ne", Comparison::NotEqual},
+            {"<", "lt", Comparison::Less},
+            {"<=", "le", Comparison::LessEqual},
+            {">", "gt", Comparison::Greater},
+            {">=", "ge", Comparison::GreaterEqual},
+        };
+
+        for (const auto& candidate : kComparisons) {
+            if (accept(candidate.symbol, candidate.keyword)) {
+                comparison = candidate.comparison;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * presence && (occurrence 1 || occurrence 2), != is emitted as
+     * presence && !(occurrence 1 == value || occurrence 2 == value).
+     *
+     * Equality with a whole address, a port or an IP protocol is hinted by
+     * its posting list, anything else by the presence test's.
+     */
+    IndexHint emitComparison(const Field& field, Comparison comparison, const Token& value) {
+        const bool isNegated = comparison == Comparison::NotEqual;
+        const Comparison tested = isNegated ? Comparison::Equal : comparison;
+
+        IndexKey key;
+        bool isKeyed = false;
+        emit(field.presence);
+        if (field.isAddress) {
+            if (tested != Comparison::Equal) {
+                throw FilterSyntaxError("Addresses can only be compared with == or !=", value.position);
+            }
+            Instruction match = parseAddress(field.presence.family, value);
+            for (std::size_t occurrence = 0; occurrence < field.occurrences; ++occurrence) {
+                match.side = field.sides[occurrence];
+                emit(match);
+                if (occurrence > 0) {
+                    emit(logic(Opcode::Or));
+                }
+            }
+            // Only a host address (no shorter prefix) is a key
+            std::array<uint8_t, packetscope::PacketAddress::kMaxSize> bytes{};
+            std::fill_n(bytes.data(), packetscope::PacketAddress::size(match.family), uint8_t{0xff});
+            uint64_t hostHigh;
+            uint64_t hostLow;
+            std::memcpy(&hostHigh, bytes.data(), sizeof(uint64_t));
+            std::memcpy(&hostLow, bytes.data() + sizeof(uint64_t), sizeof(uint64_t));
+            if (match.maskHigh == hostHigh && match.maskLow == hostLow) {
+                std::memcpy(bytes.data(), &match.addressHigh, sizeof(uint64_t));
+                std::memcpy(bytes.data() + sizeof(uint64_t), &match.addressLow, sizeof(uint64_t));
+                key.kind = IndexKey::Kind::Address;
+                key.address = packetscope::PacketAddress::from(match.family, bytes.data());
+                isKeyed = true;
+            }
+        } else {
+            const int64_t number = parseInteger(value, field.maxValue);
+            for (std::size_t occurrence = 0; occurrence < field.occurrences; ++occurrence) {
+                emit(compareColumn(field.columns[occurrence], tested, number));
+                if (occurrence > 0) {
+                    emit(logic(Opcode::Or));
+                }
+            }
+            const Column column = field.columns[0];
+            if (column == Column::SrcPort || column == Column::DstPort) {
+                key.kind = IndexKey::Kind::Port;
+                key.ipProtocol = static_cast<uint8_t>(field.presence.value);
+                key.port = static_cast<uint16_t>(number);
+            } else {
+                key.kind = IndexKey::Kind::IpProtocol;
+                key.ipProtocol = static_cast<uint8_t>(number);
+            }
+            isKeyed = column == Column::SrcPort || column == Column::DstPort || column == Column::IpProtocol;
+        }
+        if (isNegated) {
+            emit(logic(Opcode::Not));
+        }
+        emit(logic(Opcode::And));
+
+        if (isKeyed && tested == Comparison::Equal && !isNegated) {
+            return std::vector<IndexKey>{key};
+        }
+        return hintOf(field.presence);
+    }
+
+    static int64_t parseInteger(const Token& value, int64_t maxValue) {
+        errno = 0;
+        char* end = nullptr;
+        const long long number = std::strtoll(value.text.c_str(), &end, 0);
+        if (value.text.empty() || *end != '\0' || errno == ERANGE || number < 0 || number > maxValue) {
+            throw FilterSyntaxError("Invalid number '" + value.text + "'", value.position);
+        }
+        return static_cast<int64_t>(number);
+    }
+
+    static Instruction parseAddress(Family family, const Token& value) {
+        const std::size_t slash = value.text.find('/');
+        const std::string text = value.text.substr(0, slash);
+        const std::size_t addressSize = packetscope::PacketAddress::size(family);
+
+        std::array<uint8_t, packetscope::PacketAddress::kMaxSize> bytes{};
+        if (inet_pton(family == Family::IPv4 ? AF_INET : AF_INET6, text.c_str(), bytes.data()) != 1) {
+            throw FilterSyntaxError("Invalid address '" + value.text + "'", value.position);
+        }
+
+        std::size_t prefixBits = addressSize * 8;
+        if (slash != std::string::npos) {
+            const std::string prefix = value.text.substr(slash + 1);
+            char* end = nullptr;
+            const unsigned long bits = std::strtoul(prefix.c_str(), &end, 10);
+            if (prefix.empty() || *end != '\0' || bits > prefixBits) {
+                throw FilterSyntaxError("Invalid prefix length '" + prefix + "'", value.position);
+            }
+            prefixBits = bits;
+        }
+
+        std::array<uint8_t, packetscope::PacketAddress::kMaxSize> mask{};
+        for (std::size_t bit = 0; bit < prefixBits; ++bit) {
+            mask[bit / 8] = static_cast<uint8_t>(mask[bit / 8] | (0x80u >> (bit % 8)));
+        }
+
+        Instruction instruction;
+        instruction.opcode = Opcode::MatchAddress;
+        instruction.family = family;
+        std::memcpy(&instruction.maskHigh, mask.data(), sizeof(uint64_t));
+        std::memcpy(&instruction.maskLow, mask.data() + sizeof(uint64_t), sizeof(uint64_t));
+        std::memcpy(&instruction.addressHigh, bytes.data(), sizeof(uint64_t));
+        std::memcpy(&instruction.addressLow, bytes.data() + sizeof(uint64_t), sizeof(uint64_t));
+        instruction.addressHigh &= instruction.maskHigh;
+        instruction.addressLow &= instruction.maskLow;
+        return instruction;
+    }
+
+    std::vector<Token> tokens_;
+    std::size_t next_{0};
+    std::vector<Field> fields_;
+    std::vector<ProtocolKeyword> protocols_;
+    std::vector<Instruction> program_;
+    IndexHint hint_;
+};
+
+/**
+ * One loop per comparison, so the comparison is not decided per element
+ * and the loop over the column can be vectorized.
+ */
+template <typename Getter>
+void compareInto(std::size_t count, Getter get, Comparison comparison, int64_t value, uint8_t* mask) {
+    switch (comparison) {
+        case Comparison::Equal:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) == value);
+            break;
+        case Comparison::NotEqual:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) != value);
+            break;
+        case Comparison::Less:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) < value);
+            break;
+        case Comparison::LessEqual:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) <= value);
+            break;
+        case Comparison::Greater:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) > value);
+            break;
+        case Comparison::GreaterEqual:
+            for (std::size_t i = 0; i < count; ++i) mask[i] = static_cast<uint8_t>(get(i) >= value);
+            break;
+    }
+}
+
+void runCompareColumn(const PacketColumns& columns, const Instruction& instruction, uint8_t* mask) {
+    const std::size_t count = columns.size();
+    const Comparison comparison = instruction.comparison;
+    const int64_t value = instruction.value;
+
+    switch (instruction.column) {
+        case Column::Number: {
+            const int64_t firstId = columns.firstId();
+            compareInto(count, [firstId](std::size_t i) { return firstId + static_cast<int64_t>(i); },
+                        comparison, value, mask);
+            break;
+        }
+        case Column::FrameLength:
+            compareInto(count, [&columns](std::size_t i) { return static_cast<int64_t>(columns.frameLength(i)); },
+                        comparison, value, mask);
+            break;
+        case Column::CapturedLength:
+            compareInto(count, [&columns](std::size_t i) { return static_cast<int64_t>(columns.rawDataLen(i)); },
+                        comparison, value, mask);
+            break;
+        case Column::SrcPort:
+            compareInto(count, [&columns](std::size_t i) { return static_cast<int64_t>(columns.srcPort(i)); },
+                        comparison, value, mask);
+            break;
+        case Column::DstPort:
+            compareInto(count, [&columns](std::size_t i) { return static_cast<int64_t>(columns.dstPort(i)); },
+                        comparison, value, mask);
+            break;
+        case Column::IpProtocol:
+            compareInto(count, [&columns](std::size_t i) { return static_cast<int64_t>(columns.ipProtocol(i)); },
+                        comparison, value, mask);
+            break;
+    }
+}
+
+void runMatchAddress(const PacketColumns& columns, const Instruction& instruction, uint8_t* mask) {
+    const std::size_t count = columns.size();
+    auto match = [&instruction](const packetscope::PacketAddress& address) {
+        uint64_t high;
+        uint64_t low;
+        std::memcpy(&high, address.bytes.data(), sizeof(uint64_t));
+        std::memcpy(&low, address.bytes.data() + sizeof(uint64_t), sizeof(uint64_t));
+        return static_cast<uint8_t>(address.family == instruction.family
+            && (high & instruction.maskHigh) == instruction.addressHigh
+            && (low & instruction.maskLow) == instruction.addressLow);
+    };
+
+    if (instruction.side == Side::Source) {
+        for (std::size_t i = 0; i < count; ++i) mask[i] = match(columns.srcAddr(i));
+    } else {
+        for (std::size_t i = 0; i < count; ++i) mask[i] = match(columns.dstAddr(i));
+    }
+}
+
+}
+
+/**
+ * The postfix program and the stack depth it needs.
+ */
+struct DisplayFilterProgram {
+    std::vector<Instruction> instructions;
+    std::size_t maxDepth{0};
+    IndexHint indexHint;
+};
+
+std::shared_ptr<const DisplayFilter> DisplayFilter::compile(const std::string& expression) {
+    auto program = std::make_unique<DisplayFilterProgram>();
+    try {
+        Compiler compiler(expression);
+        program->instructions = compiler.compile();
+        program->indexHint = compiler.hint();
+    } catch (const FilterSyntaxError& error) {
+        spdlog::warn("DisplayFilter::compile() - Invalid filter '{}': {}", expression, error.what());
+        return nullptr;
+    }
+
+    std::size_t depth = 0;
+    for (const Instruction& instruction : program->instructions) {
+        if (instruction.opcode == Opcode::And || instruction.opcode == Opcode::Or) {
+            --depth;
+        } else if (instruction.opcode != Opcode::Not) {
+            program->maxDepth = std::max(program->maxDepth, ++depth);
+        }
+    }
+
+    return std::shared_ptr<const DisplayFilter>(new DisplayFilter(expression, std::move(program)));
+}
+
+DisplayFilter::DisplayFilter(std::string expression, std::unique_ptr<DisplayFilterProgram> program)
+    : expression_(std::move(expression))
+    , program_(std::move(program)) {}
+
+DisplayFilter::~DisplayFilter() = default;
+
+const std::string& DisplayFilter::expression() const {
+    return expression_;
+}
+
+std::vector<int> DisplayFilter::filter(const PacketStore& store, int firstId, int lastId,
+                                       std::size_t threadCount) const {
+    std::vector<int> ids;
+    firstId = std::max(firstId, 1);
+    if (lastId < firstId) {
+        return ids;
+    }
+
+    // The index covers a prefix of the range, the rest (recent packets) is scanned
+    firstId = filterIndexed(store, firstId, lastId, ids);
+    if (firstId <= lastId) {
+        scanRange(store, firstId, lastId, threadCount, ids);
+    }
+    return ids;
+}
+
+int DisplayFilter::filterIndexed(const PacketStore& store, int firstId, int lastId, std::vector<int>& ids) const {
+    const IndexHint& hint = program_->indexHint;
+    const std::shared_ptr<const PacketIndex> index = hint ? store.index() : nullptr;
+    if (!index) {
+        return firstId;
+    }
+    const int indexedLastId = std::min(lastId, index->indexedUntilId());
+    if (indexedLastId < firstId) {
+        return firstId;
+    }
+
+    // Dense keys are cheaper to scan than to test one by one
+    const std::size_t maxCandidates = (static_cast<std::size_t>(indexedLastId - firstId) + 1) / kIndexSparsity;
+
+    std::vector<int> candidates;
+    for (const IndexKey& key : *hint) {
+        const std::size_t maxIds = maxCandidates - std::min(candidates.size(), maxCandidates);
+        std::vector<int> keyIds;
+        switch (key.kind) {
+            case IndexKey::Kind::Address:
+                keyIds = index->addressIds(key.address, firstId, indexedLastId, maxIds);
+                break;
+            case IndexKey::Kind::Port:
+                keyIds = index->portIds(key.ipProtocol, key.port, firstId, indexedLastId, maxIds);
+                break;
+            case IndexKey::Kind::Protocol:
+                keyIds = index->protocolIds(key.protocol, firstId, indexedLastId, maxIds);
+                break;
+            case IndexKey::Kind::IpProtocol:
+                keyIds = index->ipProtocolIds(key.ipProtocol, firstId, indexedLastId, maxIds);
+                break;
+        }
+        if (keyIds.size() > maxIds) {
+            return firstId;
+        }
+        if (candidates.empty()) {
+            candidates = std::move(keyIds);
+        } else {
+            std::vector<int> merged;
+            merged.reserve(candidates.size() + keyIds.size());
+            std::set_union(candidates.begin(), candidates.end(), keyIds.begin(), keyIds.end(),
+                           std::back_inserter(merged));
+            candidates = std::move(merged);
+        }
+    }
+
+    // Runs of consecutive candidates (a busy flow) are tested in one scan callback
+    MaskStack stack;
+    for (std::size_t run = 0; run < candidates.size();) {
+        std::size_t runEnd = run + 1;
+        while (runEnd < candidates.size() && candidates[runEnd] == candidates[runEnd - 1] + 1) {
+            ++runEnd;
+        }
+        store.scan(candidates[run], candidates[runEnd - 1], [&](const PacketColumns& columns) {
+            evaluate(columns, stack, ids);
+        });
+        run = runEnd;
+    }
+    return indexedLastId + 1;
+}
+
+void DisplayFilter::scanRange(const PacketStore& store, int firstId, int lastId, std::size_t threadCount,
+                              std::vector<int>& ids) const {
+
+    // Chunks are segments, one PacketStore::scan() callback each
+    const auto firstChunk = static_cast<std::size_t>(firstId - 1) >> PacketStore::kSegmentShift;
+    const auto lastChunk = static_cast<std::size_t>(lastId - 1) >> PacketStore::kSegmentShift;
+    const std::size_t chunkCount = lastChunk - firstChunk + 1;
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min(threadCount, chunkCount);
+
+    if (threadCount <= 1) {
+        MaskStack stack;
+        store.scan(firstId, lastId, [&](const PacketColumns& columns) {
+            evaluate(columns, stack, ids);
+        });
+        return;
+    }
+
+    // Each chunk collects its own matches, concatenated in ID order below
+    std::vector<std::vector<int>> chunkIds(chunkCount);
+    std::atomic<std::size_t> nextChunk{0};
+
+    auto work = [&]() {
+        MaskStack stack;
+        for (std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed); chunk < chunkCount;
+             chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+            const std::size_t chunkFirst = ((firstChunk + chunk) << PacketStore::kSegmentShift) + 1;
+            const std::size_t chunkLast = (firstChunk + chunk + 1) << PacketStore::kSegmentShift;
+            store.scan(std::max(firstId, static_cast<int>(chunkFirst)),
+                       static_cast<int>(std::min(static_cast<std::size_t>(lastId), chunkLast)),
+                       [&](const PacketColumns& columns) { evaluate(columns, stack, chunkIds[chunk]); });
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    helpers.reserve(threadCount - 1);
+    for (std::size_t i = 1; i < threadCount; ++i) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+
+    std::size_t total = 0;
+    for (const auto& chunk : chunkIds) {
+        total += chunk.size();
+    }
+    ids.reserve(ids.size() + total);
+    for (const auto& chunk : chunkIds) {
+        ids.insert(ids.end(), chunk.begin(), chunk.end());
+    }
+}
+
+void DisplayFilter::evaluate(const PacketColumns& columns, MaskStack& stack, std::vector<int>& ids) const {
+    const std::size_t count = columns.size();
+    if (stack.size() < program_->maxDepth) {
+        stack.resize(program_->maxDepth, std::vector<uint8_t>(PacketStore::kSegmentSize));
+    }
+
+    std::size_t depth = 0;
+    for (const Instruction& instruction : program_->instructions) {
+        switch (instruction.opcode) {
+            case Opcode::True:
+                std::fill_n(stack[depth++].data(), count, uint8_t{1});
+                break;
+            case Opcode::CompareColumn:
+                runCompareColumn(columns, instruction, stack[depth++].data());
+                break;
+            case Opcode::MatchAddress:
+                runMatchAddress(columns, instruction, stack[depth++].data());
+                break;
+            case Opcode::MatchFamily: {
+                uint8_t* mask = stack[depth++].data();
+                for (std::size_t i = 0; i < count; ++i) {
+                    mask[i] = static_cast<uint8_t>(columns.srcAddr(i).family == instruction.family);
+                }
+                break;
+            }
+            case Opcode::MatchProtocol: {
+                uint8_t* mask = stack[depth++].data();
+                for (std::size_t i = 0; i < count; ++i) {
+                    mask[i] = static_cast<uint8_t>(columns.protocol(i) == instruction.protocol);
+                }
+                break;
+            }
+            case Opcode::And: {
+                --depth;
+                uint8_t* left = stack[depth - 1].data();
+                const uint8_t* right = stack[depth].data();
+                for (std::size_t i = 0; i < count; ++i) left[i] &= right[i];
+                break;
+            }
+            case Opcode::Or: {
+                --depth;
+                uint8_t* left = stack[depth - 1].data();
+                const uint8_t* right = stack[depth].data();
+                for (std::size_t i = 0; i < count; ++i) left[i] |= right[i];
+                break;
+            }
+            case Opcode::Not: {
+                uint8_t* mask = stack[depth - 1].data();
+                for (std::size_t i = 0; i < count; ++i) mask[i] ^= 1;
+                break;
+            }
+        }
+    }
+
+    const uint8_t* matches = stack[0].data();
+    const int firstId = columns.firstId();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (matches[i] && columns.isStored(i)) {
+            ids.push_back(firstId + static_cast<int>(i));
+        }
+    }
+}
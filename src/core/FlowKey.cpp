@@ -0,0 +1,269 @@
+#include "core/FlowKey.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <cstring>
+
+namespace packetscope {
+
+namespace {
+
+constexpr uint16_t kEtherTypeIPv4 = 0x0800;
+constexpr uint16_t kEtherTypeIPv6 = 0x86DD;
+constexpr uint16_t kEtherTypeVlan = 0x8100;
+constexpr uint16_t kEtherTypeQinQ = 0x88A8;
+
+constexpr std::size_t kEthernetHeaderSize = 14;
+constexpr std::size_t kVlanTagSize = 4;
+constexpr std::size_t kMaxVlanTags = 2;
+constexpr std::size_t kLinuxSllHeaderSize = 16;
+constexpr std::size_t kNullHeaderSize = 4;
+
+constexpr std::size_t kIPv4MinHeaderSize = 20;
+constexpr std::size_t kIPv6HeaderSize = 40;
+constexpr std::size_t kMaxIPv6ExtensionHeaders = 4;
+
+constexpr uint8_t kProtocolTcp = 6;
+constexpr uint8_t kProtocolUdp = 17;
+constexpr uint8_t kProtocolSctp = 132;
+
+constexpr std::size_t kTcpFlagsOffset = 13;
+constexpr std::size_t kTcpSequenceOffset = 4;
+constexpr std::size_t kTcpDataOffsetOffset = 12;
+constexpr std::size_t kTcpMinHeaderSize = 20;
+
+constexpr uint8_t kIPv6HopByHop = 0;
+constexpr uint8_t kIPv6Routing = 43;
+constexpr uint8_t kIPv6Fragment = 44;
+constexpr uint8_t kIPv6DestinationOptions = 60;
+
+uint16_t readBigEndian16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t readBigEndian32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16)
+        | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+uint64_t readWord(const uint8_t* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+/// Finalizer of MurmurHash3, spreads every input bit over the result
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * @brief Returns the offset of the IP header and its version (4 or 6), 0 if not IP.
+ */
+std::size_t locateIpHeader(const uint8_t* data, std::size_t length, pcpp::LinkLayerType linkLayerType,
+                           int& ipVersion) {
+    ipVersion = 0;
+    std::size_t offset = 0;
+    uint16_t etherType = 0;
+
+    switch (linkLayerType) {
+        case pcpp::LINKTYPE_ETHERNET: {
+            if (length < kEthernetHeaderSize) {
+                return 0;
+            }
+            etherType = readBigEndian16(data + 12);
+            offset = kEthernetHeaderSize;
+
+            for (std::size_t tag = 0; tag < kMaxVlanTags
+                    && (etherType == kEtherTypeVlan || etherType == kEtherTypeQinQ); ++tag) {
+                if (length < offset + kVlanTagSize) {
+                    return 0;
+                }
+                etherType = readBigEndian16(data + offset + 2);
+                offset += kVlanTagSize;
+            }
+            break;
+        }
+        case pcpp::LINKTYPE_LINUX_SLL:
+            if (length < kLinuxSllHeaderSize) {
+                return 0;
+            }
+            etherType = readBigEndian16(data + 14);
+            offset = kLinuxSllHeaderSize;
+            break;
+
+        case pcpp::LINKTYPE_NULL:
+            // Address family in host byte order, the IP version nibble is more reliable
+            offset = kNullHeaderSize;
+            break;
+
+        case pcpp::LINKTYPE_RAW:
+        case pcpp::LINKTYPE_IPV4:
+        case pcpp::LINKTYPE_IPV6:
+            offset = 0;
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (etherType == kEtherTypeIPv4) {
+        ipVersion = 4;
+    } else if (etherType == kEtherTypeIPv6) {
+        ipVersion = 6;
+    } else if (etherType == 0 && length > offset) {
+        // Link layers without an EtherType
+        const int version = data[offset] >> 4;
+        ipVersion = (version == 4 || version == 6) ? version : 0;
+    }
+    return offset;
+}
+
+}
+
+bool FlowKey::fromRawPacket(const uint8_t* data, std::size_t length, pcpp::LinkLayerType linkLayerType,
+                            FlowKey& key, bool* isReversed, uint8_t* tcpFlags, TcpSegment* tcpSegment) {
+    if (tcpSegment) {
+        *tcpSegment = TcpSegment{};
+    }
+    if (!data) {
+        return false;
+    }
+
+    int ipVersion = 0;
+    std::size_t offset = locateIpHeader(data, length, linkLayerType, ipVersion);
+
+    std::array<uint8_t, PacketAddress::kMaxSize> source{};
+    std::array<uint8_t, PacketAddress::kMaxSize> destination{};
+    uint8_t protocol = 0;
+    bool hasPorts = true;
+
+    // End of the IP payload, before Ethernet padding; the captured length if unknown
+    std::size_t ipEnd = length;
+
+    if (ipVersion == 4) {
+        if (length < offset + kIPv4MinHeaderSize) {
+            return false;
+        }
+        const uint8_t* ip = data + offset;
+        const std::size_t headerSize = static_cast<std::size_t>(ip[0] & 0x0F) * 4;
+        if (headerSize < kIPv4MinHeaderSize || length < offset + headerSize) {
+            return false;
+        }
+
+        protocol = ip[9];
+        const std::size_t totalLength = readBigEndian16(ip + 2);
+        if (totalLength >= headerSize) {
+            // 0 with TCP segmentation offload on the capturing host
+            ipEnd = offset + totalLength;
+        }
+        std::memcpy(source.data(), ip + 12, 4);
+        std::memcpy(destination.data(), ip + 16, 4);
+
+        // Only the first fragment carries the transport header
+        hasPorts = (readBigEndian16(ip + 6) & 0x1FFF) == 0;
+        offset += headerSize;
+        key.family = PacketAddress::Family::IPv4;
+    } else if (ipVersion == 6) {
+        if (length < offset + kIPv6HeaderSize) {
+            return false;
+        }
+        const uint8_t* ip = data + offset;
+
+        protocol = ip[6];
+        const std::size_t payloadLength = readBigEndian16(ip + 4);
+        if (payloadLength > 0) {
+            // 0 for jumbograms
+            ipEnd = offset + kIPv6HeaderSize + payloadLength;
+        }
+        std::memcpy(source.data(), ip + 8, 16);
+        std::memcpy(destination.data(), ip + 24, 16);
+        offset += kIPv6HeaderSize;
+
+        for (std::size_t header = 0; header < kMaxIPv6ExtensionHeaders; ++header) {
+            if (protocol != kIPv6HopByHop && protocol != kIPv6Routing
+                && protocol != kIPv6Fragment && protocol != kIPv6DestinationOptions) {
+                break;
+            }
+            if (length < offset + 8) {
+                hasPorts = false;
+                break;
+            }
+
+            const uint8_t* extension = data + offset;
+            if (protocol == kIPv6Fragment) {
+                hasPorts = hasPorts && (readBigEndian16(extension + 2) & 0xFFF8) == 0;
+                protocol = extension[0];
+                offset += 8;
+            } else {
+                protocol = extension[0];
+                offset += (static_cast<std::size_t>(extension[1]) + 1) * 8;
+            }
+        }
+        key.family = PacketAddress::Family::IPv6;
+    } else {
+        return false;
+    }
+
+    uint16_t sourcePort = 0;
+    uint16_t destinationPort = 0;
+    if (hasPorts && (protocol == kProtocolTcp || protocol == kProtocolUdp || protocol == kProtocolSctp)
+        && length >= offset + 4) {
+        sourcePort = readBigEndian16(data + offset);
+        destinationPort = readBigEndian16(data + offset + 2);
+    }
+
+    if (tcpFlags) {
+        const bool hasTcpFlags = hasPorts && protocol == kProtocolTcp && length > offset + kTcpFlagsOffset;
+        *tcpFlags = hasTcpFlags ? data[offset + kTcpFlagsOffset] : 0;
+    }
+
+    if (tcpSegment && hasPorts && protocol == kProtocolTcp && length >= offset + kTcpMinHeaderSize) {
+        const std::size_t headerSize = static_cast<std::size_t>(data[offset + kTcpDataOffsetOffset] >> 4) * 4;
+        const std::size_t payloadOffset = offset + headerSize;
+        if (headerSize >= kTcpMinHeaderSize && payloadOffset <= ipEnd) {
+            tcpSegment->sequence = readBigEndian32(data + offset + kTcpSequenceOffset);
+            tcpSegment->flags = data[offset + kTcpFlagsOffset];
+            tcpSegment->payloadSize = ipEnd - payloadOffset;
+            tcpSegment->capturedSize = std::min(ipEnd, length) > payloadOffset
+                ? std::min(ipEnd, length) - payloadOffset : 0;
+            tcpSegment->payload = tcpSegment->capturedSize > 0 ? data + payloadOffset : nullptr;
+        }
+    }
+
+    key.ipProtocol = protocol;
+
+    // Canonical order makes both directions produce the same key
+    const bool isSwapped = std::tie(destination, destinationPort) < std::tie(source, sourcePort);
+    if (isSwapped) {
+        key.addressA = destination;
+        key.portA = destinationPort;
+        key.addressB = source;
+        key.portB = sourcePort;
+    } else {
+        key.addressA = source;
+        key.portA = sourcePort;
+        key.addressB = destination;
+        key.portB = destinationPort;
+    }
+
+    if (isReversed) {
+        *isReversed = isSwapped;
+    }
+    return true;
+}
+
+uint64_t FlowKey::hash() const {
+    uint64_t value = mix(readWord(addressA.data()) ^ static_cast<uint64_t>(family));
+    value = mix(value ^ readWord(addressA.data() + 8));
+    value = mix(value ^ readWord(addressB.data()));
+    value = mix(value ^ readWord(addressB.data() + 8));
+    return mix(value ^ ((static_cast<uint64_t>(portA) << 24) | (static_cast<uint64_t>(portB) << 8) | ipProtocol));
+}
+
+}
@@ -0,0 +1,138 @@
+#include "core/FlowTable.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace packetscope {
+
+namespace {
+
+/// Earliest of two timestamps where 0 means "not seen"
+int64_t earliest(int64_t first, int64_t second) {
+    if (first == 0) {
+        return second;
+    }
+    if (second == 0) {
+        return first;
+    }
+    return std::min(first, second);
+}
+
+}
+
+void FlowStats::merge(const FlowStats& other) {
+    packetsAToB += other.packetsAToB;
+    packetsBToA += other.packetsBToA;
+    bytesAToB += other.bytesAToB;
+    bytesBToA += other.bytesBToA;
+    firstSeenNs = earliest(firstSeenNs, other.firstSeenNs);
+    lastSeenNs = std::max(lastSeenNs, other.lastSeenNs);
+    synSeenNs = earliest(synSeenNs, other.synSeenNs);
+    synAckSeenNs = earliest(synAckSeenNs, other.synAckSeenNs);
+    tcpFlags = static_cast<uint8_t>(tcpFlags | other.tcpFlags);
+}
+
+}
+
+FlowTable::FlowTable(std::size_t capacity) {
+    std::size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    slots_.resize(rounded);
+    mask_ = rounded - 1;
+}
+
+void FlowTable::update(const packetscope::FlowKey& key, bool isReversed, int64_t timestampNs,
+                       uint32_t frameLength, uint8_t tcpFlags) {
+    packetscope::FlowStats& stats = findOrInsert(key, key.hash()).stats;
+
+    if (isReversed) {
+        ++stats.packetsBToA;
+        stats.bytesBToA += frameLength;
+    } else {
+        ++stats.packetsAToB;
+        stats.bytesAToB += frameLength;
+    }
+
+    // Workers may see packets of a flow out of capture order in DispatchMode::Batch
+    stats.firstSeenNs = stats.firstSeenNs == 0 ? timestampNs : std::min(stats.firstSeenNs, timestampNs);
+    stats.lastSeenNs = std::max(stats.lastSeenNs, timestampNs);
+
+    stats.tcpFlags = static_cast<uint8_t>(stats.tcpFlags | tcpFlags);
+
+    const uint8_t handshake = tcpFlags & (packetscope::kTcpSyn | packetscope::kTcpAck);
+    if (handshake == packetscope::kTcpSyn) {
+        if (stats.synSeenNs == 0 || timestampNs < stats.synSeenNs) {
+            stats.synSeenNs = timestampNs;
+        }
+    } else if (handshake == (packetscope::kTcpSyn | packetscope::kTcpAck)) {
+        if (stats.synAckSeenNs == 0 || timestampNs < stats.synAckSeenNs) {
+            stats.synAckSeenNs = timestampNs;
+        }
+    }
+}
+
+void FlowTable::clear() {
+    if (size_ == 0) {
+        return;
+    }
+    for (Slot& slot : slots_) {
+        slot.isUsed = false;
+    }
+    size_ = 0;
+}
+
+std::size_t FlowTable::size() const {
+    return size_;
+}
+
+std::size_t FlowTable::capacity() const {
+    return slots_.size();
+}
+
+FlowTable::Slot& FlowTable::findOrInsert(const packetscope::FlowKey& key, uint64_t hash) {
+    std::size_t index = static_cast<std::size_t>(hash) & mask_;
+
+    while (slots_[index].isUsed) {
+        Slot& slot = slots_[index];
+        if (slot.hash == hash && slot.stats.key == key) {
+            return slot;
+        }
+        index = (index + 1) & mask_;
+    }
+
+    // New flow, grow first so the probe sequence stays short
+    if ((size_ + 1) * 100 > slots_.size() * kMaxLoadPercent) {
+        grow();
+        index = static_cast<std::size_t>(hash) & mask_;
+        while (slots_[index].isUsed) {
+            index = (index + 1) & mask_;
+        }
+    }
+
+    Slot& slot = slots_[index];
+    slot.hash = hash;
+    slot.isUsed = true;
+    slot.stats = packetscope::FlowStats{};
+    slot.stats.key = key;
+    ++size_;
+    return slot;
+}
+
+void FlowTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+
+    for (Slot& slot : old) {
+        if (!slot.isUsed) {
+            continue;
+        }
+        std::size_t index = static_cast<std::size_t>(slot.hash) & mask_;
+        while (slots_[index].isUsed) {
+            index = (index + 1) & mask_;
+        }
+        slots_[index] = std::move(slot);
+    }
+}
@@ -0,0 +1,174 @@
+#include "core/FlowTracker.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+FlowTracker::FlowTracker(std::size_t shardCount, std::size_t tableCapacity, std::chrono::milliseconds mergeInterval,
+                         const packetscope::FlowLimits& limits)
+    : mergeInterval_(mergeInterval)
+    , limits_(limits) {
+    const std::size_t count = std::max(shardCount, std::size_t{1});
+    shards_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(tableCapacity));
+    }
+    scheduleNextMerge();
+}
+
+void FlowTracker::mergeIfDue() {
+    if (steadyNowNs() < nextMergeNs_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Never stall a second worker behind a merge in progress
+    std::unique_lock<std::mutex> lock(mergeMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    mergeLocked();
+}
+
+std::vector<packetscope::FlowStats> FlowTracker::flows() {
+    std::lock_guard<std::mutex> lock(mergeMutex_);
+    mergeLocked();
+
+    std::vector<packetscope::FlowStats> result;
+    result.reserve(global_.size());
+    for (const auto& entry : global_) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+std::vector<packetscope::FlowStats> FlowTracker::topFlows(std::size_t count) {
+    std::lock_guard<std::mutex> lock(mergeMutex_);
+    mergeLocked();
+
+    // Ranked by pointer, only the flows returned are copied
+    std::vector<const packetscope::FlowStats*> ranked;
+    ranked.reserve(global_.size());
+    for (const auto& entry : global_) {
+        ranked.push_back(&entry.second);
+    }
+
+    const auto byBytes = [](const packetscope::FlowStats* first, const packetscope::FlowStats* second) {
+        return first->bytes() > second->bytes();
+    };
+    const std::size_t resultSize = std::min(count, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(resultSize), ranked.end(), byBytes);
+
+    std::vector<packetscope::FlowStats> result;
+    result.reserve(resultSize);
+    for (std::size_t i = 0; i < resultSize; ++i) {
+        result.push_back(*ranked[i]);
+    }
+    return result;
+}
+
+std::size_t FlowTracker::flowCount() const {
+    std::lock_guard<std::mutex> lock(mergeMutex_);
+    return global_.size();
+}
+
+void FlowTracker::clear() {
+    std::lock_guard<std::mutex> lock(mergeMutex_);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> shardLock(shard->mutex);
+        shard->active->clear();
+        shard->standby->clear();
+    }
+    global_.clear();
+    newestSeenNs_ = 0;
+    nextExpiryNs_ = 0;
+    scheduleNextMerge();
+}
+
+void FlowTracker::reshard(std::size_t shardCount, std::size_t tableCapacity, std::chrono::milliseconds mergeInterval,
+                          const packetscope::FlowLimits& limits) {
+    std::lock_guard<std::mutex> lock(mergeMutex_);
+    mergeLocked();
+
+    const std::size_t count = std::max(shardCount, std::size_t{1});
+    shards_.clear();
+    shards_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(tableCapacity));
+    }
+
+    mergeInterval_ = mergeInterval;
+    limits_ = limits;
+    nextExpiryNs_ = 0;
+    pruneLocked();
+    scheduleNextMerge();
+}
+
+void FlowTracker::mergeLocked() {
+    for (const auto& shard : shards_) {
+        {
+            // Workers continue on the empty standby table while this one is folded
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            std::swap(shard->active, shard->standby);
+        }
+
+        shard->standby->forEach([this](const packetscope::FlowStats& stats) {
+            const auto result = global_.try_emplace(stats.key, stats);
+            if (!result.second) {
+                result.first->second.merge(stats);
+            }
+            newestSeenNs_ = std::max(newestSeenNs_, stats.lastSeenNs);
+        });
+        shard->standby->clear();
+    }
+    pruneLocked();
+    scheduleNextMerge();
+}
+
+void FlowTracker::pruneLocked() {
+    // A full sweep once per tenth of the timeout of capture time, the merges in between only fold
+    const int64_t idleTimeoutNs = std::chrono::duration_cast<std::chrono::nanoseconds>(limits_.idleTimeout).count();
+    if (idleTimeoutNs > 0 && newestSeenNs_ >= nextExpiryNs_) {
+        nextExpiryNs_ = newestSeenNs_ + std::max<int64_t>(idleTimeoutNs / 10, 1);
+        const int64_t oldestKept = newestSeenNs_ - idleTimeoutNs;
+        for (auto it = global_.begin(); it != global_.end();) {
+            it = it->second.lastSeenNs < oldestKept ? global_.erase(it) : std::next(it);
+        }
+    }
+
+    if (limits_.maxFlows == 0 || global_.size() <= limits_.maxFlows) {
+        return;
+    }
+
+    // Down to 7/8 of the limit, so a scan does not pay for this on every merge
+    const std::size_t kept = limits_.maxFlows - limits_.maxFlows / 8;
+    const std::size_t evicted = global_.size() - kept;
+    std::vector<int64_t> lastSeen;
+    lastSeen.reserve(global_.size());
+    for (const auto& entry : global_) {
+        lastSeen.push_back(entry.second.lastSeenNs);
+    }
+    std::nth_element(lastSeen.begin(), lastSeen.begin() + static_cast<std::ptrdiff_t>(evicted), lastSeen.end());
+    const int64_t threshold = lastSeen[evicted];
+
+    for (auto it = global_.begin(); it != global_.end();) {
+        it = it->second.lastSeenNs < threshold ? global_.erase(it) : std::next(it);
+    }
+    // Flows last seen at the threshold itself, as many as are still over
+    for (auto it = global_.begin(); it != global_.end() && global_.size() > kept;) {
+        it = it->second.lastSeenNs == threshold ? global_.erase(it) : std::next(it);
+    }
+}
+
+void FlowTracker::scheduleNextMerge() {
+    const int64_t intervalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(mergeInterval_).count();
+    nextMergeNs_.store(steadyNowNs() + intervalNs, std::memory_order_relaxed);
+}
@@ -0,0 +1,100 @@
+#include "core/MetricsExporter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+std::unique_ptr<MetricsExporter> MetricsExporter::start(packetscope::MetricsExportConfig config, Source source) {
+    if (!source || config.path.empty()) {
+        spdlog::error("MetricsExporter::start() - No metrics source or path");
+        return nullptr;
+    }
+
+    std::unique_ptr<MetricsExporter> exporter(new MetricsExporter(std::move(config), std::move(source)));
+    // Surfaces an unwritable path to the caller instead of logging every interval
+    if (!exporter->writeSnapshot()) {
+        return nullptr;
+    }
+
+    spdlog::info("MetricsExporter::start() - Writing {} metrics to '{}' every {} ms",
+                 exporter->config_.format == packetscope::MetricsFormat::Json ? "JSON" : "Prometheus",
+                 exporter->config_.path, exporter->config_.interval.count());
+    exporter->exportThread_ = std::thread([self = exporter.get()] { self->exportLoop(); });
+    return exporter;
+}
+
+MetricsExporter::MetricsExporter(packetscope::MetricsExportConfig config, Source source)
+    : config_(std::move(config))
+    , source_(std::move(source)) {
+    config_.interval = std::max(config_.interval, std::chrono::milliseconds{1});
+}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        isStopRequested_ = true;
+    }
+    stopCondition_.notify_all();
+    if (exportThread_.joinable()) {
+        exportThread_.join();
+        writeSnapshot();
+    }
+}
+
+const packetscope::MetricsExportConfig& MetricsExporter::config() const {
+    return config_;
+}
+
+void MetricsExporter::exportLoop() {
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    while (!stopCondition_.wait_for(lock, config_.interval, [this] { return isStopRequested_; })) {
+        lock.unlock();
+        writeSnapshot();
+        lock.lock();
+    }
+}
+
+bool MetricsExporter::writeSnapshot() {
+    const packetscope::PipelineMetricsSnapshot snapshot = source_();
+    const std::string text = config_.format == packetscope::MetricsFormat::Json
+        ? snapshot.toJson()
+        : snapshot.toPrometheus();
+
+    const std::string temporaryPath = config_.path + ".tmp";
+    const int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("MetricsExporter::writeSnapshot() - Cannot open '{}': {}", temporaryPath, std::strerror(errno));
+        return false;
+    }
+
+    std::size_t written = 0;
+    while (written < text.size()) {
+        const ssize_t result = write(fd, text.data() + written, text.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("MetricsExporter::writeSnapshot() - Cannot write '{}': {}", temporaryPath,
+                          std::strerror(errno));
+            close(fd);
+            unlink(temporaryPath.c_str());
+            return false;
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    close(fd);
+
+    // Readers see the previous snapshot or this one, never a partial file
+    if (std::rename(temporaryPath.c_str(), config_.path.c_str()) != 0) {
+        spdlog::error("MetricsExporter::writeSnapshot() - Cannot replace '{}': {}", config_.path, std::strerror(errno));
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
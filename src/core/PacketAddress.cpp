@@ -0,0 +1,52 @@
+#include "core/PacketAddress.hpp"
+
+#include <arpa/inet.h>
+#include <cstdio>
+
+namespace packetscope {
+
+namespace {
+
+/// Finalizer of MurmurHash3, same as the flow key hash
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+}
+
+uint64_t PacketAddress::hash() const {
+    uint64_t high;
+    uint64_t low;
+    std::memcpy(&high, bytes.data(), sizeof(high));
+    std::memcpy(&low, bytes.data() + sizeof(high), sizeof(low));
+    return mix(mix(high ^ static_cast<uint64_t>(family)) ^ low);
+}
+
+std::string PacketAddress::toString() const {
+    switch (family) {
+        case Family::Mac: {
+            char text[18];
+            std::snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x",
+                          bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+            return text;
+        }
+        case Family::IPv4: {
+            char text[INET_ADDRSTRLEN];
+            return inet_ntop(AF_INET, bytes.data(), text, sizeof(text)) ? text : std::string();
+        }
+        case Family::IPv6: {
+            char text[INET6_ADDRSTRLEN];
+            return inet_ntop(AF_INET6, bytes.data(), text, sizeof(text)) ? text : std::string();
+        }
+        case Family::None:
+            break;
+    }
+    return std::string();
+}
+
+}
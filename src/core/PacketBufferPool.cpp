@@ -0,0 +1,118 @@
+#include "core/PacketBufferPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+std::shared_ptr<PacketBufferPool> PacketBufferPool::create(std::size_t slotSize, std::size_t slotsPerSlab) {
+    // The owner's shared_ptr only drops the owner reference, outstanding
+    // buffers keep the pool alive until they are released.
+    return std::shared_ptr<PacketBufferPool>(
+        new PacketBufferPool(slotSize, slotsPerSlab),
+        [](PacketBufferPool* pool) { pool->unref(); }
+    );
+}
+
+PacketBufferPool::PacketBufferPool(std::size_t slotSize, std::size_t slotsPerSlab)
+    : slotSize_(std::max(slotSize, std::size_t{1}))
+    , slotsPerSlab_(std::max(slotsPerSlab, std::size_t{1})) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    growLocked();
+}
+
+packetscope::PacketBuffer PacketBufferPool::acquire(std::size_t size) {
+    if (size > slotSize_) {
+        // Rare path: allocate a dedicated buffer instead of truncating
+        auto* oversized = new OversizedBuffer();
+        oversized->storage = std::make_unique<uint8_t[]>(size);
+        oversized->header.data = oversized->storage.get();
+        oversized->header.size = static_cast<uint32_t>(size);
+        oversized->header.capacity = static_cast<uint32_t>(size);
+        oversized->header.release = &PacketBufferPool::freeOversized;
+        oversized->header.owner = oversized;
+        return packetscope::PacketBuffer(&oversized->header);
+    }
+
+    packetscope::BufferHeader* header = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (freeList_.empty()) {
+            growLocked();
+        }
+        header = freeList_.back();
+        freeList_.pop_back();
+    }
+
+    // Each outstanding slot keeps the pool alive
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    slotsInUse_.fetch_add(1, std::memory_order_relaxed);
+
+    header->size = static_cast<uint32_t>(size);
+    return packetscope::PacketBuffer(header);
+}
+
+packetscope::PacketBuffer PacketBufferPool::copyFrom(const uint8_t* data, std::size_t size) {
+    packetscope::PacketBuffer buffer = acquire(size);
+    if (size > 0) {
+        std::memcpy(buffer.mutableData(), data, size);
+    }
+    return buffer;
+}
+
+std::size_t PacketBufferPool::slotSize() const {
+    return slotSize_;
+}
+
+std::size_t PacketBufferPool::slabCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabs_.size();
+}
+
+std::size_t PacketBufferPool::slotsInUse() const {
+    return slotsInUse_.load(std::memory_order_relaxed);
+}
+
+void PacketBufferPool::growLocked() {
+    Slab slab;
+    // Default initialized on purpose: pages are first touched by the capture
+    // thread's memcpy, which places them on its NUMA node
+    slab.storage = std::unique_ptr<uint8_t[]>(new uint8_t[slotSize_ * slotsPerSlab_]);
+    slab.headers = std::make_unique<packetscope::BufferHeader[]>(slotsPerSlab_);
+
+    freeList_.reserve(freeList_.size() + slotsPerSlab_);
+
+    // Push in reverse so slots are handed out in address order
+    for (std::size_t i = slotsPerSlab_; i-- > 0;) {
+        packetscope::BufferHeader& header = slab.headers[i];
+        header.data = slab.storage.get() + i * slotSize_;
+        header.capacity = static_cast<uint32_t>(slotSize_);
+        header.release = &PacketBufferPool::recycleSlot;
+        header.owner = this;
+        freeList_.push_back(&header);
+    }
+
+    slabs_.push_back(std::move(slab));
+    spdlog::debug("PacketBufferPool::growLocked() - Allocated slab #{} ({} slots of {} bytes)",
+                  slabs_.size(), slotsPerSlab_, slotSize_);
+}
+
+void PacketBufferPool::recycleSlot(packetscope::BufferHeader* header) {
+    auto* pool = static_cast<PacketBufferPool*>(header->owner);
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        pool->freeList_.push_back(header);
+    }
+    pool->slotsInUse_.fetch_sub(1, std::memory_order_relaxed);
+    pool->unref();
+}
+
+void PacketBufferPool::freeOversized(packetscope::BufferHeader* header) {
+    delete static_cast<OversizedBuffer*>(header->owner);
+}
+
+void PacketBufferPool::unref() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
@@ -1,12 +1,17 @@
 #include "core/PacketCapture.hpp"
+#include "core/PcapCaptureBackend.hpp"
+#include "core/TPacketCaptureBackend.hpp"
 
 #include <spdlog/spdlog.h>
 
+PacketCapture::PacketCapture(std::shared_ptr<PacketBufferPool> bufferPool)
+    : bufferPool_(std::move(bufferPool)) {}
+
 PacketCapture::~PacketCapture() {
     stop();
 }
 
-std::vector<packetscope::DeviceInfo> PacketCapture::listAvailableDevices() const {
+std::vector<packetscope::DeviceInfo> PacketCapture::listAvailableDevices() {
     const auto& devicesList = pcpp::PcapLiveDeviceList::getInstance().getPcapLiveDevicesList();
 
     std::vector<packetscope::DeviceInfo> devices;
@@ -29,34 +34,28 @@ bool PacketCapture::start(const std::string& deviceName, CaptureCallback callbac
         return false;
     }
 
-    device_ = pcpp::PcapLiveDeviceList::getInstance().getDeviceByName(deviceName);
-
-    if (!device_) {
-        spdlog::error("PacketCapture::start() - Device '{}' doesn't exist", deviceName);
-        return false;
-    }
-
-    if (!device_->open()) {
-        spdlog::error("PacketCapture::start() - Device '{}' cannot be opened", deviceName);
-        return false;
-    }
-
     callback_ = std::move(callback);
+    backend_ = createBackend();
 
-    /**
-     * relevant log error is printed in any case:
-     *  - Capture is already running
-     *  - Device is not opened
-     *  - Capture thread could not be created
-     */
-    if (!device_->startCapture(onPacketArrives, this)) {
-        spdlog::error("PacketCapture::start() - Capture failed to start on '{}'", deviceName);
-        device_->close();
+    const bool isStarted = backend_->start(deviceName, options_,
+                                           [this](std::vector<packetscope::RawPacketData>& batch) {
+        capturedPacketCount_ += batch.size();
+        callback_(batch);
+    });
+
+    if (!isStarted) {
+        // relevant log error is printed by the backend
+        backend_.reset();
         return false;
     }
 
     isRunning_ = true;
-    spdlog::info("PacketCapture::start() - Packet capture started successfully on '{}'", deviceName);
+    if (options_.fanout) {
+        spdlog::info("PacketCapture::start() - Packet capture started on '{}' (fanout group {})",
+                     deviceName, options_.fanout->id);
+    } else {
+        spdlog::info("PacketCapture::start() - Packet capture started successfully on '{}'", deviceName);
+    }
     return true;
 }
 
@@ -68,36 +67,67 @@ void PacketCapture::stop() {
 
     spdlog::debug("PacketCapture::stop() - Stopping packet capture");
 
-    if (device_) {
-        device_->stopCapture();
-        device_->close();
-        device_ = nullptr;
-    }
+    backend_->stop();
+    pastKernelStats_.merge(backend_->kernelStats());
+    backend_.reset();
 
     isRunning_ = false;
     spdlog::debug("PacketCapture::stop() - Packet capture stopped");
 }
 
-void PacketCapture::onPacketArrives(pcpp::RawPacket* packet, pcpp::PcapLiveDevice* dev, void* cookie) {
-    PacketCapture* self = static_cast<PacketCapture*>(cookie);
-
-    if (!self->callback_) {
-        return;
+std::unique_ptr<CaptureBackend> PacketCapture::createBackend() const {
+    switch (backendType_) {
+        case packetscope::CaptureBackendType::TPacketV3:
+            return std::make_unique<TPacketCaptureBackend>(ringConfig_);
+        case packetscope::CaptureBackendType::Pcap:
+        default:
+            return std::make_unique<PcapCaptureBackend>(bufferPool_);
     }
+}
 
-    self->capturedPacketCount_++;
-
-    packetscope::RawPacketData rawPacketData;
+bool PacketCapture::setBackend(packetscope::CaptureBackendType type, packetscope::TPacketRingConfig ringConfig) {
+    // backend_ is created by start()
+    if (isRunning_) {
+        spdlog::warn("PacketCapture::setBackend() - Cannot change backend while running");
+        return false;
+    }
+    backendType_ = type;
+    ringConfig_ = ringConfig;
+    return true;
+}
 
-    rawPacketData.timestamp = packet->getPacketTimeStamp();
-    rawPacketData.frameLength = packet->getFrameLength();
-    rawPacketData.rawDataLen = packet->getRawDataLen();
-    rawPacketData.linkLayerType = packet->getLinkLayerType();
+bool PacketCapture::setThreadAffinity(std::vector<int> cpus) {
+    // options_ is read by the capture thread while running
+    if (isRunning_) {
+        spdlog::warn("PacketCapture::setThreadAffinity() - Cannot change affinity while running");
+        return false;
+    }
+    options_.threadCpus = std::move(cpus);
+    return true;
+}
 
-    const uint8_t* rawPtr = packet->getRawData();
-    rawPacketData.rawData.assign(rawPtr, rawPtr + rawPacketData.rawDataLen);
+bool PacketCapture::setFanout(std::optional<FanoutGroup> group) {
+    // options_ is read by start() and the capture thread
+    if (isRunning_) {
+        spdlog::warn("PacketCapture::setFanout() - Cannot change fanout while running");
+        return false;
+    }
+    options_.fanout = group;
+    return true;
+}
 
-    self->callback_(std::move(rawPacketData));
+bool PacketCapture::setFilter(const packetscope::CaptureFilter& filter) {
+    if (isRunning_) {
+        if (filter.snapLength != options_.filter.snapLength) {
+            spdlog::warn("PacketCapture::setFilter() - Cannot change snap length while running");
+            return false;
+        }
+        if (!backend_->setFilter(filter.expression)) {
+            return false;
+        }
+    }
+    options_.filter = filter;
+    return true;
 }
 
 bool PacketCapture::isRunning() const {
@@ -110,4 +140,16 @@ std::size_t PacketCapture::getCapturedPacketCount() const {
 
 void PacketCapture::resetCapturedPacketCount() {
     capturedPacketCount_ = 0;
-}
\ No newline at end of file
+}
+
+packetscope::KernelCaptureStats PacketCapture::kernelStats() {
+    packetscope::KernelCaptureStats stats = pastKernelStats_;
+    if (backend_) {
+        stats.merge(backend_->kernelStats());
+    }
+    return stats;
+}
+
+void PacketCapture::resetKernelStats() {
+    pastKernelStats_ = packetscope::KernelCaptureStats{};
+}
@@ -0,0 +1,60 @@
+#include "core/PacketDetailCache.hpp"
+
+PacketDetailCache::PacketDetailCache(std::size_t capacity)
+    : capacity_(capacity) {}
+
+std::shared_ptr<const PacketDetailCache::LayerDetails> PacketDetailCache::find(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = index_.find(id);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+
+    // Move to the front, iterators of std::list stay valid
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+void PacketDetailCache::insert(int id, std::shared_ptr<const LayerDetails> details) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (capacity_ == 0) {
+        return;
+    }
+
+    const auto it = index_.find(id);
+    if (it != index_.end()) {
+        it->second->second = std::move(details);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    entries_.emplace_front(id, std::move(details));
+    index_.emplace(id, entries_.begin());
+    evictLocked();
+}
+
+void PacketDetailCache::setCapacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evictLocked();
+}
+
+void PacketDetailCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+std::size_t PacketDetailCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void PacketDetailCache::evictLocked() {
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+}
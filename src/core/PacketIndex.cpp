@@ -0,0 +1,214 @@
+#include "core/PacketIndex.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+/// Approximate heap cost of a key and its node in an unordered_map
+constexpr std::size_t kNodeBytes = 64;
+
+/// Protocols whose ports FlowKey extracts (TCP, UDP, SCTP)
+bool hasPorts(uint8_t ipProtocol) {
+    return ipProtocol == 6 || ipProtocol == 17 || ipProtocol == 132;
+}
+
+template <typename Map, typename Key>
+std::size_t appendTo(Map& lists, const Key& key, int id) {
+    auto [entry, isInserted] = lists.try_emplace(key);
+    return entry->second.append(id) + (isInserted ? kNodeBytes : 0);
+}
+
+template <typename Map>
+std::size_t eraseBeforeIn(Map& lists, int firstId) {
+    std::size_t bytes = 0;
+    for (auto entry = lists.begin(); entry != lists.end();) {
+        entry->second.eraseBefore(firstId);
+        if (entry->second.isEmpty()) {
+            entry = lists.erase(entry);
+            continue;
+        }
+        bytes += entry->second.memoryBytes() + kNodeBytes;
+        ++entry;
+    }
+    return bytes;
+}
+
+}
+
+std::size_t PacketIndex::PostingList::append(int id) {
+    if (!isEmpty() && id <= blocks_.back().lastId) {
+        return 0;
+    }
+
+    std::size_t addedBytes = 0;
+    if (isEmpty() || blocks_.back().count == kBlockSize) {
+        // The first ID of a block is kept in the block, so blocks decode on their own
+        blocks_.push_back(Block{id, id, static_cast<uint32_t>(bytes_.size()), 1});
+        return sizeof(Block);
+    }
+
+    Block& block = blocks_.back();
+    auto delta = static_cast<uint32_t>(id - block.lastId);
+    while (delta >= 0x80) {
+        bytes_.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+        ++addedBytes;
+    }
+    bytes_.push_back(static_cast<uint8_t>(delta));
+    block.lastId = id;
+    ++block.count;
+    return addedBytes + 1;
+}
+
+void PacketIndex::PostingList::eraseBefore(int firstId) {
+    while (firstBlock_ < blocks_.size() && blocks_[firstBlock_].lastId < firstId) {
+        ++firstBlock_;
+    }
+    if (firstBlock_ == blocks_.size()) {
+        blocks_.clear();
+        bytes_.clear();
+        firstBlock_ = 0;
+        return;
+    }
+
+    // Compact once half of the blocks are erased, O(1) amortized per block
+    if (firstBlock_ > 0 && firstBlock_ * 2 >= blocks_.size()) {
+        const uint32_t offset = blocks_[firstBlock_].offset;
+        bytes_.erase(bytes_.begin(), bytes_.begin() + offset);
+        blocks_.erase(blocks_.begin(), blocks_.begin() + static_cast<std::ptrdiff_t>(firstBlock_));
+        for (Block& block : blocks_) {
+            block.offset -= offset;
+        }
+        firstBlock_ = 0;
+    }
+}
+
+void PacketIndex::PostingList::decode(int firstId, int lastId, std::size_t maxIds, std::vector<int>& ids) const {
+    // Skip the blocks ending before the range
+    auto block = std::lower_bound(blocks_.begin() + static_cast<std::ptrdiff_t>(firstBlock_), blocks_.end(),
+                                  firstId, [](const Block& candidate, int id) { return candidate.lastId < id; });
+
+    for (; block != blocks_.end() && block->firstId <= lastId; ++block) {
+        int id = block->firstId;
+        const uint8_t* delta = bytes_.data() + block->offset;
+        for (uint32_t entry = 0; entry < block->count; ++entry) {
+            if (entry > 0) {
+                uint32_t value = 0;
+                for (unsigned shift = 0;; shift += 7) {
+                    const uint8_t byte = *delta++;
+                    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                    if (!(byte & 0x80)) {
+                        break;
+                    }
+                }
+                id += static_cast<int>(value);
+            }
+            if (id > lastId) {
+                return;
+            }
+            if (id >= firstId) {
+                ids.push_back(id);
+                if (ids.size() > maxIds) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+std::size_t PacketIndex::PostingList::memoryBytes() const {
+    return blocks_.capacity() * sizeof(Block) + bytes_.capacity();
+}
+
+void PacketIndex::add(const PacketColumns& columns) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    std::size_t addedBytes = 0;
+    const std::size_t count = columns.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!columns.isStored(i)) {
+            continue;
+        }
+        const int id = columns.firstId() + static_cast<int>(i);
+
+        const packetscope::PacketAddress& srcAddr = columns.srcAddr(i);
+        const packetscope::PacketAddress& dstAddr = columns.dstAddr(i);
+        if (srcAddr.family != packetscope::PacketAddress::Family::None) {
+            addedBytes += appendTo(addresses_, srcAddr, id);
+        }
+        if (dstAddr.family != packetscope::PacketAddress::Family::None && dstAddr != srcAddr) {
+            addedBytes += appendTo(addresses_, dstAddr, id);
+        }
+
+        const uint8_t ipProtocol = columns.ipProtocol(i);
+        if (ipProtocol != 0) {
+            addedBytes += appendTo(ipProtocols_, ipProtocol, id);
+        }
+        if (hasPorts(ipProtocol)) {
+            // Same port on both sides only appends once
+            addedBytes += appendTo(ports_, portKey(ipProtocol, columns.srcPort(i)), id);
+            addedBytes += appendTo(ports_, portKey(ipProtocol, columns.dstPort(i)), id);
+        }
+
+        addedBytes += appendTo(protocols_, columns.protocol(i), id);
+    }
+
+    memoryBytes_.fetch_add(addedBytes, std::memory_order_relaxed);
+    indexedUntilId_.store(columns.firstId() + static_cast<int>(count) - 1, std::memory_order_release);
+}
+
+void PacketIndex::setIndexedUntil(int id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    indexedUntilId_.store(std::max(id, indexedUntilId_.load(std::memory_order_relaxed)), std::memory_order_release);
+}
+
+void PacketIndex::eraseBefore(int firstId) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    std::size_t bytes = eraseBeforeIn(addresses_, firstId);
+    bytes += eraseBeforeIn(ports_, firstId);
+    bytes += eraseBeforeIn(protocols_, firstId);
+    bytes += eraseBeforeIn(ipProtocols_, firstId);
+    memoryBytes_.store(bytes, std::memory_order_relaxed);
+}
+
+template <typename Map, typename Key>
+std::vector<int> PacketIndex::lookup(const Map& lists, const Key& key, int firstId, int lastId,
+                                     std::size_t maxIds) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    std::vector<int> ids;
+    const auto entry = lists.find(key);
+    if (entry != lists.end()) {
+        entry->second.decode(firstId, std::min(lastId, indexedUntilId_.load(std::memory_order_relaxed)), maxIds, ids);
+    }
+    return ids;
+}
+
+std::vector<int> PacketIndex::addressIds(const packetscope::PacketAddress& address, int firstId, int lastId,
+                                         std::size_t maxIds) const {
+    return lookup(addresses_, address, firstId, lastId, maxIds);
+}
+
+std::vector<int> PacketIndex::portIds(uint8_t ipProtocol, uint16_t port, int firstId, int lastId,
+                                      std::size_t maxIds) const {
+    return lookup(ports_, portKey(ipProtocol, port), firstId, lastId, maxIds);
+}
+
+std::vector<int> PacketIndex::protocolIds(pcpp::ProtocolType protocol, int firstId, int lastId,
+                                          std::size_t maxIds) const {
+    return lookup(protocols_, protocol, firstId, lastId, maxIds);
+}
+
+std::vector<int> PacketIndex::ipProtocolIds(uint8_t ipProtocol, int firstId, int lastId, std::size_t maxIds) const {
+    return lookup(ipProtocols_, ipProtocol, firstId, lastId, maxIds);
+}
+
+int PacketIndex::indexedUntilId() const {
+    return indexedUntilId_.load(std::memory_order_acquire);
+}
+
+std::size_t PacketIndex::memoryBytes() const {
+    return memoryBytes_.load(std::memory_order_relaxed);
+}
@@ -5,17 +5,49 @@
 #include <IPv4Layer.h>
 #include <IPv6Layer.h>
 
-packetscope::ParsedPacket PacketProcessor::process(const packetscope::RawPacketData& rawPacketData) const {
+packetscope::ParsedPacket PacketProcessor::process(const packetscope::RawPacketData& rawPacketData,
+                                                   FlowTable* flowTable,
+                                                   TcpReassembler* reassembler) const {
+    using Family = packetscope::PacketAddress::Family;
+
     packetscope::ParsedPacket result{};
 
-    // Copy metadata for hex view and packet list
+    // The transport columns (display filter) come from the same pre-parse as the flow
+    packetscope::FlowKey key;
+    bool isReversed = false;
+    uint8_t tcpFlags = 0;
+    packetscope::TcpSegment tcpSegment;
+    if (rawPacketData.rawDataLen > 0
+        && packetscope::FlowKey::fromRawPacket(rawPacketData.rawData.data(),
+                                               static_cast<std::size_t>(rawPacketData.rawDataLen),
+                                               rawPacketData.linkLayerType, key, &isReversed, &tcpFlags,
+                                               reassembler ? &tcpSegment : nullptr)) {
+        result.ipProtocol = key.ipProtocol;
+        result.srcPort = isReversed ? key.portB : key.portA;
+        result.dstPort = isReversed ? key.portA : key.portB;
+
+        if (flowTable) {
+            flowTable->update(key, isReversed, packetscope::toNanoseconds(rawPacketData.timestamp),
+                              static_cast<uint32_t>(rawPacketData.frameLength), tcpFlags);
+        }
+        // Only set for TCP with a complete header
+        if (reassembler && (tcpSegment.flags != 0 || tcpSegment.payloadSize > 0)) {
+            reassembler->add(key, isReversed, tcpSegment, packetscope::toPacketId(rawPacketData.sequence),
+                             static_cast<uint64_t>(packetscope::toNanoseconds(rawPacketData.timestamp)));
+        }
+    }
+
+    // Copy metadata for hex view and packet list.
+    // rawData is a shared handle, the bytes themselves are not copied.
+    result.id = packetscope::toPacketId(rawPacketData.sequence);
     result.timestamp = rawPacketData.timestamp;
     result.rawData = rawPacketData.rawData;
     result.rawDataLen = rawPacketData.rawDataLen;
     result.frameLength = rawPacketData.frameLength;
+    result.linkLayerType = rawPacketData.linkLayerType;
 
-    // Reconstruct PcapPlusPlus RawPacket from our copied data
-    // We pass kDoNotDeleteRawData=false because we own the data in our vector.
+    // Reconstruct PcapPlusPlus RawPacket over the pooled buffer
+    // We pass kDoNotDeleteRawData=false because the pool owns the data.
     // PcapPlusPlus should not free it when RawPacket is destroyed.
     pcpp::RawPacket rawPacket(
         rawPacketData.rawData.data(),
@@ -30,11 +62,9 @@ packetscope::ParsedPacket PacketProcessor::process(const packetscope::RawPacketD
     // Get the lowest layer
     pcpp::Layer* layer = parsedPacket.getFirstLayer();
 
-    // Walk through all layers
+    // Walk through all layers.
+    // Summary pass only: no layer->toString() here, see dissect().
     while (layer) {
-        // Store each layer summary for detail view
-        result.layerSummaries.push_back(layer->toString());
-
         // Update protocol only if it's not a generic payload.
         // GenericPayload means "unrecognized data after the last known protocol".
         // We want to display the last recognized protocol, not "Unknown".
@@ -44,26 +74,26 @@ packetscope::ParsedPacket PacketProcessor::process(const packetscope::RawPacketD
             // protocol becomes the displayed protocol.
             // This matches Wireshark's behavior:
             // https://osqa-ask.wireshark.org/questions/21257/how-does-wireshark-determine-the-protocol/
-            result.protocol = protocolTypeToString(layer->getProtocol());
+            result.protocol = layer->getProtocol();
         }
 
         switch (layer->getProtocol()) {
             case pcpp::Ethernet: {
                 const pcpp::EthLayer* eth = static_cast<pcpp::EthLayer*>(layer);
-                result.srcAddr = eth->getSourceMac().toString();
-                result.dstAddr = eth->getDestMac().toString();
+                result.srcAddr = packetscope::PacketAddress::from(Family::Mac, eth->getSourceMac().getRawData());
+                result.dstAddr = packetscope::PacketAddress::from(Family::Mac, eth->getDestMac().getRawData());
                 break;
             }
             case pcpp::IPv4: {
                 const pcpp::IPv4Layer* ip = static_cast<pcpp::IPv4Layer*>(layer);
-                result.srcAddr = ip->getSrcIPAddress().toString();
-                result.dstAddr = ip->getDstIPAddress().toString();
+                result.srcAddr = packetscope::PacketAddress::from(Family::IPv4, ip->getSrcIPAddress().toBytes());
+                result.dstAddr = packetscope::PacketAddress::from(Family::IPv4, ip->getDstIPAddress().toBytes());
                 break;
             }
             case pcpp::IPv6: {
                 const pcpp::IPv6Layer* ip = static_cast<pcpp::IPv6Layer*>(layer);
-                result.srcAddr = ip->getSrcIPAddress().toString();
-                result.dstAddr = ip->getDstIPAddress().toString();
+                result.srcAddr = packetscope::PacketAddress::from(Family::IPv6, ip->getSrcIPAddress().toBytes());
+                result.dstAddr = packetscope::PacketAddress::from(Family::IPv6, ip->getDstIPAddress().toBytes());
                 break;
             }
             default:
@@ -75,6 +105,26 @@ packetscope::ParsedPacket PacketProcessor::process(const packetscope::RawPacketD
     return result;
 }
 
+std::vector<std::string> PacketProcessor::dissect(const packetscope::RawPacketData& rawPacketData) const {
+    std::vector<std::string> layerSummaries;
+
+    pcpp::RawPacket rawPacket(
+        rawPacketData.rawData.data(),
+        rawPacketData.rawDataLen,
+        rawPacketData.timestamp,
+        kDoNotDeleteRawData,
+        rawPacketData.linkLayerType
+    );
+
+    pcpp::Packet parsedPacket(&rawPacket);
+
+    // Each string represents one protocol layer, lowest first
+    for (pcpp::Layer* layer = parsedPacket.getFirstLayer(); layer; layer = layer->getNextLayer()) {
+        layerSummaries.push_back(layer->toString());
+    }
+    return layerSummaries;
+}
+
 std::string PacketProcessor::protocolTypeToString(pcpp::ProtocolType protocolType) {
     switch (protocolType) {
         case pcpp::Ethernet:        return "Ethernet";
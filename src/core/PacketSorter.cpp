@@ -0,0 +1,313 @@
+#include "core/PacketSorter.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "core/PacketProcessor.hpp"
+
+namespace {
+
+/// Reads up to 8 bytes as a big endian number, so keys compare like the bytes
+uint64_t loadBigEndian(const uint8_t* bytes, std::size_t size) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        value = value << 8 | (i < size ? bytes[i] : 0);
+    }
+    return value;
+}
+
+}
+
+PacketSorter::PacketSorter(std::shared_ptr<const PacketStore> store, Column column, std::size_t threadCount)
+    : store_(std::move(store))
+    , column_(column)
+    , threadCount_(threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {
+    thread_ = std::thread(&PacketSorter::sortLoop, this);
+}
+
+PacketSorter::~PacketSorter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_.store(true, std::memory_order_relaxed);
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void PacketSorter::add(int lastId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingUntilId_ = std::max(pendingUntilId_, lastId);
+    }
+    condition_.notify_all();
+}
+
+void PacketSorter::add(const std::vector<int>& ids, int lastId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isListMode_ = true;
+        pendingIds_.insert(pendingIds_.end(), ids.begin(), ids.end());
+        pendingUntilId_ = std::max(pendingUntilId_, lastId);
+    }
+    condition_.notify_all();
+}
+
+void PacketSorter::evictBefore(int firstId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingFirstId_ = std::max(pendingFirstId_, firstId);
+    }
+    condition_.notify_all();
+}
+
+std::shared_ptr<const PacketSorter::Order> PacketSorter::order() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return order_;
+}
+
+bool PacketSorter::isSorting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isPassRunning_ || pendingUntilId_ > takenUntilId_ || pendingFirstId_ > appliedFirstId_;
+}
+
+PacketSorter::Column PacketSorter::column() const {
+    return column_;
+}
+
+template <typename Work>
+void PacketSorter::runParallel(std::size_t count, Work&& work) {
+    std::atomic<std::size_t> nextItem{0};
+    auto drain = [&]() {
+        for (std::size_t item = nextItem.fetch_add(1, std::memory_order_relaxed);
+             item < count && !isStopping_.load(std::memory_order_relaxed);
+             item = nextItem.fetch_add(1, std::memory_order_relaxed)) {
+            work(item);
+        }
+    };
+
+    // The background thread takes items too
+    const std::size_t threadCount = std::min(threadCount_, count);
+    std::vector<std::thread> helpers;
+    helpers.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (std::size_t i = 1; i < threadCount; ++i) {
+        helpers.emplace_back(drain);
+    }
+    drain();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+}
+
+void PacketSorter::sortLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this] {
+            return isStopping_.load(std::memory_order_relaxed) || pendingUntilId_ > takenUntilId_
+                || pendingFirstId_ > appliedFirstId_;
+        });
+        if (isStopping_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Everything added so far goes into this pass
+        const int fromId = takenUntilId_ + 1;
+        const int lastId = pendingUntilId_;
+        const int firstId = pendingFirstId_;
+        const bool isListMode = isListMode_;
+        std::vector<int> ids = std::move(pendingIds_);
+        pendingIds_.clear();
+        takenUntilId_ = lastId;
+        isPassRunning_ = true;
+        lock.unlock();
+
+        std::vector<Entry> added;
+        if (lastId >= std::max(fromId, firstId) && (!isListMode || !ids.empty())) {
+            added = sortNew(std::max(fromId, firstId), lastId, isListMode ? &ids : nullptr);
+        }
+        if (isStopping_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Nothing to change, e.g. a filtered refresh without matches: the order stays as it is
+        if (added.empty() && firstId <= minEntryId_ && order_) {
+            lock.lock();
+            appliedFirstId_ = firstId;
+            isPassRunning_ = false;
+            continue;
+        }
+
+        // One linear merge into the previous order, evicted packets are left out
+        std::vector<Entry> merged;
+        merged.reserve(entries_.size() + added.size());
+        auto previous = entries_.cbegin();
+        auto next = added.cbegin();
+        while (previous != entries_.cend()) {
+            if (previous->id < firstId) {
+                ++previous;
+            } else if (next != added.cend() && *next < *previous) {
+                merged.push_back(*next++);
+            } else {
+                merged.push_back(*previous++);
+            }
+        }
+        merged.insert(merged.end(), next, added.cend());
+        entries_ = std::move(merged);
+
+        auto order = std::make_shared<Order>();
+        order->ids.reserve(entries_.size());
+        minEntryId_ = std::numeric_limits<int>::max();
+        int maxEntryId = 0;
+        for (const Entry& entry : entries_) {
+            order->ids.push_back(entry.id);
+            minEntryId_ = std::min(minEntryId_, entry.id);
+            maxEntryId = std::max(maxEntryId, entry.id);
+        }
+        order->sortedUntilId = lastId;
+
+        // The UI maps its selected packets to rows with this, instead of searching ids
+        if (!entries_.empty()) {
+            order->firstPositionId = minEntryId_;
+            order->positions.assign(static_cast<std::size_t>(maxEntryId - minEntryId_) + 1, Order::kNoPosition);
+            for (std::size_t position = 0; position < order->ids.size(); ++position) {
+                order->positions[static_cast<std::size_t>(order->ids[position] - minEntryId_)] =
+                    static_cast<uint32_t>(position);
+            }
+        }
+
+        spdlog::debug("PacketSorter::sortLoop() - Sorted {} packets, {} new", entries_.size(), added.size());
+
+        lock.lock();
+        order_ = std::move(order);
+        appliedFirstId_ = firstId;
+        isPassRunning_ = false;
+    }
+}
+
+std::vector<PacketSorter::Entry> PacketSorter::sortNew(int firstId, int lastId, const std::vector<int>* ids) {
+    // Chunks are segments, like DisplayFilter::filter()
+    const auto firstChunk = static_cast<std::size_t>(firstId - 1) >> PacketStore::kSegmentShift;
+    const auto lastChunk = static_cast<std::size_t>(lastId - 1) >> PacketStore::kSegmentShift;
+    std::vector<std::vector<Entry>> runs(lastChunk - firstChunk + 1);
+
+    runParallel(runs.size(), [&](std::size_t chunk) {
+        const auto chunkFirst = static_cast<int>(((firstChunk + chunk) << PacketStore::kSegmentShift) + 1);
+        const auto chunkLast = static_cast<int>((firstChunk + chunk + 1) << PacketStore::kSegmentShift);
+        const int scanFirst = std::max(firstId, chunkFirst);
+        const int scanLast = std::min(lastId, chunkLast);
+
+        const int* idsBegin = nullptr;
+        const int* idsEnd = nullptr;
+        if (ids) {
+            idsBegin = ids->data() + (std::lower_bound(ids->begin(), ids->end(), scanFirst) - ids->begin());
+            idsEnd = ids->data() + (std::upper_bound(ids->begin(), ids->end(), scanLast) - ids->begin());
+            if (idsBegin == idsEnd) {
+                return;
+            }
+        }
+
+        std::vector<Entry>& run = runs[chunk];
+        run.reserve(ids ? static_cast<std::size_t>(idsEnd - idsBegin)
+                        : static_cast<std::size_t>(scanLast - scanFirst + 1));
+        store_->scan(scanFirst, scanLast, [&](const PacketColumns& columns) {
+            appendEntries(columns, idsBegin, idsEnd, run);
+        });
+        std::sort(run.begin(), run.end());
+    });
+
+    // Pairwise merge rounds, the pairs of a round merge in parallel
+    while (runs.size() > 1 && !isStopping_.load(std::memory_order_relaxed)) {
+        std::vector<std::vector<Entry>> merged((runs.size() + 1) / 2);
+        runParallel(merged.size(), [&](std::size_t pair) {
+            std::vector<Entry>& left = runs[2 * pair];
+            if (2 * pair + 1 == runs.size()) {
+                merged[pair] = std::move(left);
+                return;
+            }
+            std::vector<Entry>& right = runs[2 * pair + 1];
+            merged[pair].resize(left.size() + right.size());
+            std::merge(left.begin(), left.end(), right.begin(), right.end(), merged[pair].begin());
+            left = std::vector<Entry>();
+            right = std::vector<Entry>();
+        });
+        runs = std::move(merged);
+    }
+
+    if (isStopping_.load(std::memory_order_relaxed)) {
+        return {};
+    }
+    return std::move(runs.front());
+}
+
+void PacketSorter::appendEntries(const PacketColumns& columns, const int* idsBegin, const int* idsEnd,
+                                 std::vector<Entry>& entries) const {
+    const int columnsFirstId = columns.firstId();
+    if (!idsBegin) {
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (columns.isStored(i)) {
+                entries.push_back(makeEntry(columns, i));
+            }
+        }
+        return;
+    }
+
+    // The scan may start later than asked for (eviction), listed IDs before that are gone
+    const int columnsEndId = columnsFirstId + static_cast<int>(columns.size());
+    for (const int* id = std::lower_bound(idsBegin, idsEnd, columnsFirstId); id != idsEnd && *id < columnsEndId; ++id) {
+        const auto i = static_cast<std::size_t>(*id - columnsFirstId);
+        if (columns.isStored(i)) {
+            entries.push_back(makeEntry(columns, i));
+        }
+    }
+}
+
+PacketSorter::Entry PacketSorter::makeEntry(const PacketColumns& columns, std::size_t i) const {
+    Entry entry{0, 0, columns.firstId() + static_cast<int>(i), 0};
+
+    switch (column_) {
+        case Column::Id:
+            break;
+        case Column::Time: {
+            // Flipping the sign bit orders negative seconds before positive ones
+            const timespec& timestamp = columns.timestamp(i);
+            entry.high = static_cast<uint64_t>(static_cast<int64_t>(timestamp.tv_sec)) ^ (uint64_t{1} << 63);
+            entry.low = static_cast<uint64_t>(timestamp.tv_nsec);
+            break;
+        }
+        case Column::Source:
+        case Column::Destination: {
+            const packetscope::PacketAddress& address =
+                column_ == Column::Source ? columns.srcAddr(i) : columns.dstAddr(i);
+            entry.group = static_cast<uint8_t>(address.family);
+            entry.high = loadBigEndian(address.bytes.data(), 8);
+            entry.low = loadBigEndian(address.bytes.data() + 8, 8);
+            break;
+        }
+        case Column::Protocol: {
+            // Few distinct protocols: the name of each is looked up once per thread
+            thread_local std::unordered_map<pcpp::ProtocolType, std::pair<uint64_t, uint64_t>> nameKeys;
+            const pcpp::ProtocolType protocol = columns.protocol(i);
+            auto key = nameKeys.find(protocol);
+            if (key == nameKeys.end()) {
+                // The packet list shows no name for unknown protocols, they sort first
+                const std::string name = protocol == pcpp::UnknownProtocol
+                    ? std::string()
+                    : PacketProcessor::protocolTypeToString(protocol);
+                const auto* bytes = reinterpret_cast<const uint8_t*>(name.data());
+                key = nameKeys.emplace(protocol, std::make_pair(
+                    loadBigEndian(bytes, std::min<std::size_t>(name.size(), 8)),
+                    loadBigEndian(bytes + std::min<std::size_t>(name.size(), 8),
+                                  name.size() > 8 ? name.size() - 8 : 0))).first;
+            }
+            entry.high = key->second.first;
+            entry.low = key->second.second;
+            break;
+        }
+        case Column::Length:
+            entry.high = static_cast<uint64_t>(std::max(columns.frameLength(i), 0));
+            break;
+    }
+    return entry;
+}
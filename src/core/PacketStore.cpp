@@ -1,47 +1,700 @@
 #include "core/PacketStore.hpp"
+#include "core/PacketIndex.hpp"
 
-#include <mutex>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+/**
+ * The spill file outlives clear() while regions of it are still mapped.
+ */
+struct StoreSpillFile {
+    int fd{-1};
+
+    ~StoreSpillFile() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+/**
+ * Raw bytes of one segment in the spill file. refs counts the segment plus
+ * every PacketBuffer handed out by PacketStore::loadSpilled(), the last one
+ * unmaps the region and gives its disk blocks back (the file is append only,
+ * so a ring of evicted segments would otherwise grow it forever).
+ */
+struct StoreSpillRegion {
+    void* mapping{nullptr};
+    std::size_t mappedSize{0};
+    std::shared_ptr<StoreSpillFile> file;
+    uint64_t fileOffset{0};
+    std::unique_ptr<uint64_t[]> offsets;    ///< kSegmentSize + 1 entries, slot i is [offsets[i], offsets[i + 1])
+    std::atomic<uint32_t> refs{1};
+
+    ~StoreSpillRegion() {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+            fallocate(file->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                      static_cast<off_t>(fileOffset), static_cast<off_t>(mappedSize));
+        }
+    }
+};
+
+namespace {
+
+void releaseRegion(StoreSpillRegion* region) {
+    if (region->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete region;
+    }
+}
+
+void releaseSpilledBuffer(packetscope::BufferHeader* header) {
+    StoreSpillRegion* region = static_cast<StoreSpillRegion*>(header->owner);
+    delete header;
+    releaseRegion(region);
+}
+
+/// Orders timespecs, a before b
+bool isBefore(const timespec& a, const timespec& b) {
+    return a.tv_sec != b.tv_sec ? a.tv_sec < b.tv_sec : a.tv_nsec < b.tv_nsec;
+}
+
+bool writeAll(int fd, const uint8_t* data, std::size_t length, uint64_t offset) {
+    while (length > 0) {
+        const ssize_t written = pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+}
+
+PacketStore::Segment::Segment() {
+    // std::atomic default construction leaves the value uninitialized (C++17)
+    for (auto& state : states) {
+        state.store(SlotState::Empty, std::memory_order_relaxed);
+    }
+}
+
+PacketStore::Segment::~Segment() {
+    // Handles still pointing into the region keep it mapped
+    if (spill) {
+        releaseRegion(spill);
+    }
+}
+
+packetscope::ParsedPacket PacketView::toParsedPacket() const {
+    packetscope::ParsedPacket packet{};
+    packet.id = id();
+    packet.timestamp = timestamp();
+    packet.rawDataLen = rawDataLen();
+    packet.frameLength = frameLength();
+    packet.rawData = rawData();
+    packet.linkLayerType = linkLayerType();
+    packet.srcAddr = srcAddr();
+    packet.dstAddr = dstAddr();
+    packet.protocol = protocol();
+    packet.srcPort = srcPort();
+    packet.dstPort = dstPort();
+    packet.ipProtocol = ipProtocol();
+    return packet;
+}
+
+PacketStore::PacketStore(packetscope::StoreSpillConfig spillConfig,
+                         packetscope::StoreRetentionConfig retentionConfig)
+    : segments_(std::make_unique<std::atomic<Segment*>[]>(kMaxSegments))
+    , spillConfig_(std::move(spillConfig))
+    , retentionConfig_(retentionConfig)
+    , memoryBudget_(spillConfig_.memoryBudget) {
+    maintenanceThread_ = std::thread([this] { maintenanceLoop(); });
+}
+
+PacketStore::~PacketStore() {
+    isStopRequested_ = true;
+    {
+        // Pairs with the wait in maintenanceLoop(), the request cannot be missed
+        std::lock_guard<std::mutex> lock(maintenanceMutex_);
+    }
+    maintenanceCondition_.notify_all();
+    maintenanceThread_.join();
+
+    releaseAll();
+}
 
 void PacketStore::addPacket(packetscope::ParsedPacket parsedPacket) {
-    std::unique_lock lock(mutex_);
-    parsedPacket.id = ++id_;
-    parsedPackets_.push_back(std::move(parsedPacket));
+    const auto capturedBytes = static_cast<std::size_t>(std::max(parsedPacket.rawDataLen, 0));
+    rawBytesInMemory_.fetch_add(publish(std::move(parsedPacket)), std::memory_order_relaxed);
+    retainedRawBytes_.fetch_add(capturedBytes, std::memory_order_relaxed);
+    advanceWatermark();
+}
+
+void PacketStore::addPackets(std::vector<packetscope::ParsedPacket> parsedPackets) {
+    std::size_t rawBytes = 0;
+    std::size_t capturedBytes = 0;
+    for (auto& parsedPacket : parsedPackets) {
+        capturedBytes += static_cast<std::size_t>(std::max(parsedPacket.rawDataLen, 0));
+        rawBytes += publish(std::move(parsedPacket));
+    }
+    // One counter update and one watermark pass for the whole batch
+    rawBytesInMemory_.fetch_add(rawBytes, std::memory_order_relaxed);
+    retainedRawBytes_.fetch_add(capturedBytes, std::memory_order_relaxed);
+    advanceWatermark();
+}
+
+void PacketStore::discard(int id) {
+    const std::size_t index = indexOf(id);
+    segmentFor(index >> kSegmentShift)->states[index & kSegmentMask].store(
+        SlotState::Discarded, std::memory_order_seq_cst);
+    advanceWatermark();
+}
+
+std::size_t PacketStore::publish(packetscope::ParsedPacket&& parsedPacket) {
+    const std::size_t index = indexOf(parsedPacket.id);
+    const std::size_t offset = index & kSegmentMask;
+    Segment& segment = *segmentFor(index >> kSegmentShift);
+
+    segment.timestamps[offset] = parsedPacket.timestamp;
+    segment.rawDataLens[offset] = parsedPacket.rawDataLen;
+    segment.frameLengths[offset] = parsedPacket.frameLength;
+    segment.protocols[offset] = parsedPacket.protocol;
+    segment.linkLayerTypes[offset] = parsedPacket.linkLayerType;
+    segment.srcAddrs[offset] = parsedPacket.srcAddr;
+    segment.dstAddrs[offset] = parsedPacket.dstAddr;
+    segment.srcPorts[offset] = parsedPacket.srcPort;
+    segment.dstPorts[offset] = parsedPacket.dstPort;
+    segment.ipProtocols[offset] = parsedPacket.ipProtocol;
+    segment.rawData[offset] = std::move(parsedPacket.rawData);
+    const std::size_t rawBytes = segment.rawData[offset].size();
+
+    // Release (and seq_cst for advanceWatermark()): the columns are
+    // visible to whoever observes the Ready state
+    segment.states[offset].store(SlotState::Ready, std::memory_order_seq_cst);
+    return rawBytes;
+}
+
+bool PacketStore::isSettled(std::size_t index) const {
+    const std::size_t segmentIndex = index >> kSegmentShift;
+    if (segmentIndex >= kMaxSegments) {
+        return false;
+    }
+
+    // seq_cst pairs with the unlink in freeSegmentsLocked(), see ReaderGuard
+    const Segment* segment = segments_[segmentIndex].load(std::memory_order_seq_cst);
+    return segment
+        && segment->states[index & kSegmentMask].load(std::memory_order_seq_cst) != SlotState::Empty;
+}
+
+void PacketStore::advanceWatermark() {
+    // Retention and clear() may free the segments the states are read from
+    const ReaderGuard guard(*this);
+    std::size_t watermark = watermark_.load(std::memory_order_seq_cst);
+
+    while (isSettled(watermark)) {
+        // On failure watermark is reloaded, another writer advanced it
+        watermark_.compare_exchange_weak(watermark, watermark + 1, std::memory_order_seq_cst);
+    }
+}
+
+PacketStore::Segment* PacketStore::segmentFor(std::size_t segmentIndex) {
+    std::atomic<Segment*>& entry = segments_[segmentIndex];
+
+    Segment* segment = entry.load(std::memory_order_acquire);
+    if (segment) {
+        return segment;
+    }
+
+    std::unique_ptr<Segment> fresh = std::make_unique<Segment>();
+    if (entry.compare_exchange_strong(segment, fresh.get(),
+                                      std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return fresh.release();
+    }
+
+    // Another writer installed the segment first, ours is freed
+    return segment;
+}
+
+const PacketStore::Segment* PacketStore::publishedSegment(std::size_t index) const {
+    const std::size_t segmentIndex = index >> kSegmentShift;
+    if (segmentIndex >= kMaxSegments || index < firstIndex_.load(std::memory_order_seq_cst)) {
+        return nullptr;
+    }
+
+    // seq_cst pairs with the unlink in freeSegmentsLocked(), see ReaderGuard
+    const Segment* segment = segments_[segmentIndex].load(std::memory_order_seq_cst);
+    if (!segment) {
+        return nullptr;
+    }
+
+    return segment->states[index & kSegmentMask].load(std::memory_order_acquire) == SlotState::Ready
+        ? segment : nullptr;
 }
 
 packetscope::ParsedPacket PacketStore::getById(int id) const {
-    std::shared_lock lock(mutex_);
     /**
-     * Think about exception handling.
-     * There is no possibility that the id selected from the QT GUI
-     * will directly return 0 because the packets will start from 1
-     * and a selection greater than the size of the vector cannot be made.
-     * Perhaps I don't need to handle it at all.
+     * IDs start from 1. A packet above count() may already be published
+     * but is not visible until the watermark passes it.
      */
-    return parsedPackets_.at(static_cast<std::size_t>(id - 1));
+    packetscope::ParsedPacket packet{};
+    const bool isFound = visit(id, [&packet](const PacketView& view) {
+        packet = view.toParsedPacket();
+    });
+    if (!isFound) {
+        throw std::out_of_range("PacketStore::getById() - Packet not found");
+    }
+    return packet;
 }
 
 std::size_t PacketStore::count() const {
-    std::shared_lock lock(mutex_);
-    return parsedPackets_.size();
+    return watermark_.load(std::memory_order_acquire);
+}
+
+int PacketStore::firstId() const {
+    return static_cast<int>(firstIndex_.load(std::memory_order_acquire) + 1);
 }
 
-// The entire vector is being copied. I need to find a more effective way.
+// The entire store is being copied. I need to find a more effective way.
 std::vector<packetscope::ParsedPacket> PacketStore::getAllPackets() const {
-    std::shared_lock lock(mutex_);
-    return parsedPackets_;
+    const std::size_t watermark = watermark_.load(std::memory_order_acquire);
+    const std::size_t front = std::min(firstIndex_.load(std::memory_order_acquire), watermark);
+
+    std::vector<packetscope::ParsedPacket> packets;
+    packets.reserve(watermark - front);
+
+    for (std::size_t index = front; index < watermark; ++index) {
+        visit(static_cast<int>(index + 1), [&packets](const PacketView& view) {
+            packets.push_back(view.toParsedPacket());
+        });
+    }
+    return packets;
 }
 
 void PacketStore::clear() {
-    std::unique_lock lock(mutex_);
-    /**
-     * Might be use clear() and shrink_to_fit() but it's 2 operation and
-     * shrink_to_fit() is non-binding. It means not guaranteed!
-     * clear() removes all elements so size becomes 0 but doesn't free
-     * allocated memory (capacity).
-     * If going to reuse the vector, just clearing it might be more efficient.
-     * Need to think about it.
-     */
-    std::vector<packetscope::ParsedPacket>().swap(parsedPackets_);
-    // Reset the IDs when cleared the vector.
-    id_ = 0;
-}
\ No newline at end of file
+    std::lock_guard<std::mutex> lock(maintenanceMutex_);
+
+    releaseAll();
+    // Reset the IDs when cleared the store.
+    watermark_.store(0, std::memory_order_relaxed);
+    firstIndex_.store(0, std::memory_order_relaxed);
+    firstSegment_ = 0;
+
+    // The old file lives on (unlinked) while handles into its mappings exist
+    rawBytesInMemory_.store(0, std::memory_order_relaxed);
+    rawBytesSpilled_.store(0, std::memory_order_relaxed);
+    spilledSegments_.store(0, std::memory_order_relaxed);
+    retainedRawBytes_.store(0, std::memory_order_relaxed);
+    evictedPackets_.store(0, std::memory_order_relaxed);
+    nextSpillSegment_ = 0;
+    spillFile_.reset();
+    spillFileEnd_ = 0;
+    isSpillFailed_ = false;
+    {
+        // Holders of the old index keep a consistent (stale) copy
+        std::lock_guard<std::mutex> indexLock(indexMutex_);
+        if (index_) {
+            index_ = std::make_shared<PacketIndex>();
+        }
+    }
+    maintenanceCondition_.notify_all();
+}
+
+void PacketStore::setSpillConfig(const packetscope::StoreSpillConfig& spillConfig) {
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex_);
+        spillConfig_ = spillConfig;
+        memoryBudget_.store(spillConfig.memoryBudget, std::memory_order_relaxed);
+    }
+    maintenanceCondition_.notify_all();
+}
+
+void PacketStore::setRetentionConfig(const packetscope::StoreRetentionConfig& retentionConfig) {
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex_);
+        retentionConfig_ = retentionConfig;
+    }
+    maintenanceCondition_.notify_all();
+}
+
+void PacketStore::setIndexing(bool isIndexing) {
+    {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        if (!isIndexing) {
+            index_.reset();
+        } else if (!index_) {
+            index_ = std::make_shared<PacketIndex>();
+        }
+    }
+    maintenanceCondition_.notify_all();
+}
+
+std::shared_ptr<const PacketIndex> PacketStore::index() const {
+    std::lock_guard<std::mutex> lock(indexMutex_);
+    return index_;
+}
+
+packetscope::StoreMemoryStats PacketStore::memoryStats() const {
+    packetscope::StoreMemoryStats stats;
+    stats.memoryBudget = memoryBudget_.load(std::memory_order_relaxed);
+    stats.rawBytesInMemory = rawBytesInMemory_.load(std::memory_order_relaxed);
+    stats.rawBytesSpilled = rawBytesSpilled_.load(std::memory_order_relaxed);
+    stats.spilledSegments = spilledSegments_.load(std::memory_order_relaxed);
+    stats.evictedPackets = evictedPackets_.load(std::memory_order_relaxed);
+    if (const std::shared_ptr<const PacketIndex> index = this->index()) {
+        stats.indexBytes = index->memoryBytes();
+    }
+    return stats;
+}
+
+packetscope::PacketBuffer PacketStore::loadSpilled(const Segment& segment, std::size_t offset) {
+    StoreSpillRegion* region = segment.spill;
+    const uint64_t begin = region->offsets[offset];
+    const uint64_t size = region->offsets[offset + 1] - begin;
+    if (size == 0) {
+        return packetscope::PacketBuffer();
+    }
+
+    // Read only mapping, the bytes are faulted in on first access
+    auto* header = new packetscope::BufferHeader();
+    header->size = static_cast<uint32_t>(size);
+    header->capacity = static_cast<uint32_t>(size);
+    header->data = static_cast<uint8_t*>(region->mapping) + begin;
+    header->release = releaseSpilledBuffer;
+    header->owner = region;
+    region->refs.fetch_add(1, std::memory_order_relaxed);
+    return packetscope::PacketBuffer(header);
+}
+
+void PacketStore::maintenanceLoop() {
+    std::unique_lock<std::mutex> lock(maintenanceMutex_);
+
+    while (!isStopRequested_) {
+        const std::size_t budget = spillConfig_.memoryBudget;
+        const bool isSpilling = budget > 0 && !isSpillFailed_;
+        const bool isRetaining = retentionConfig_.isBounded();
+        std::shared_ptr<PacketIndex> index;
+        {
+            std::lock_guard<std::mutex> indexLock(indexMutex_);
+            index = index_;
+        }
+        if (!isSpilling && !isRetaining && !index) {
+            maintenanceCondition_.wait(lock);
+            continue;
+        }
+
+        // Evict first, bytes that are about to go are not worth spilling or indexing
+        if (isRetaining) {
+            enforceRetentionLocked();
+        }
+        const bool isIndexBehind = index && indexNewPacketsLocked(*index);
+
+        // Oldest complete segments first, until the RAM tier fits the budget again
+        while (isSpilling && !isStopRequested_ && rawBytesInMemory_.load(std::memory_order_relaxed) > budget
+               && spillNextSegmentLocked()) {
+        }
+        if (!isIndexBehind) {
+            maintenanceCondition_.wait_for(lock, kMaintenancePollInterval);
+        }
+    }
+}
+
+void PacketStore::enforceRetentionLocked() {
+    const packetscope::StoreRetentionConfig& retention = retentionConfig_;
+    const std::size_t watermark = watermark_.load(std::memory_order_acquire);
+    const std::size_t front = firstIndex_.load(std::memory_order_relaxed);
+
+    timespec newest{};
+    const bool isAgeBounded = retention.maxAge.count() > 0 && newestTimestamp(watermark, newest);
+    timespec oldestKept = newest;
+    oldestKept.tv_sec -= static_cast<time_t>(retention.maxAge.count());
+
+    // Walk the front forward, every slot below the watermark is settled and
+    // only read here, so this costs O(1) per evicted packet
+    const std::size_t retainedBytes = retainedRawBytes_.load(std::memory_order_relaxed);
+    std::size_t evictedBytes = 0;
+    std::size_t target = front;
+    while (target < watermark) {
+        const Segment* segment = segments_[target >> kSegmentShift].load(std::memory_order_acquire);
+        const std::size_t offset = target & kSegmentMask;
+        const bool isReady = segment
+            && segment->states[offset].load(std::memory_order_acquire) == SlotState::Ready;
+
+        const bool isOverLimit =
+            (retention.maxPackets > 0 && watermark - target > retention.maxPackets)
+            || (retention.maxBytes > 0 && evictedBytes < retainedBytes
+                && retainedBytes - evictedBytes > retention.maxBytes)
+            // Discarded slots at the front go with the packets around them
+            || (isAgeBounded && (!isReady || isBefore(segment->timestamps[offset], oldestKept)));
+        if (!isOverLimit) {
+            break;
+        }
+
+        if (isReady) {
+            evictedBytes += static_cast<std::size_t>(std::max(segment->rawDataLens[offset], 0));
+        }
+        ++target;
+    }
+
+    if (target == front) {
+        return;
+    }
+
+    firstIndex_.store(target, std::memory_order_seq_cst);
+    retainedRawBytes_.fetch_sub(std::min(evictedBytes, retainedBytes), std::memory_order_relaxed);
+    evictedPackets_.fetch_add(target - front, std::memory_order_relaxed);
+
+    // The segment holding the new front stays until the front leaves it
+    freeSegmentsLocked(target >> kSegmentShift);
+}
+
+bool PacketStore::indexNewPacketsLocked(PacketIndex& index) {
+    const std::size_t watermark = watermark_.load(std::memory_order_acquire);
+    const auto firstIndex = static_cast<std::size_t>(index.indexedUntilId());
+    if (firstIndex >= watermark) {
+        return false;
+    }
+
+    // Every slot below the watermark is settled, so each ID is added exactly once
+    const std::size_t end = std::min(watermark, ((firstIndex >> kSegmentShift) + kIndexSegmentsPerPass) << kSegmentShift);
+    scan(static_cast<int>(firstIndex + 1), static_cast<int>(end),
+         [&index](const PacketColumns& columns) { index.add(columns); });
+    // Also covers evicted IDs the scan skipped
+    index.setIndexedUntil(static_cast<int>(end));
+    return end < watermark;
+}
+
+bool PacketStore::newestTimestamp(std::size_t watermark, timespec& timestamp) const {
+    // The newest slots may be discarded, look back a little
+    constexpr std::size_t kMaxLookBack = 64;
+    const std::size_t front = firstIndex_.load(std::memory_order_relaxed);
+
+    for (std::size_t index = watermark; index > front && watermark - index < kMaxLookBack; --index) {
+        const Segment* segment = segments_[(index - 1) >> kSegmentShift].load(std::memory_order_acquire);
+        const std::size_t offset = (index - 1) & kSegmentMask;
+        if (segment && segment->states[offset].load(std::memory_order_acquire) == SlotState::Ready) {
+            timestamp = segment->timestamps[offset];
+            return true;
+        }
+    }
+    return false;
+}
+
+void PacketStore::freeSegmentsLocked(std::size_t segmentLimit) {
+    std::vector<Segment*> unlinked;
+    for (; firstSegment_ < segmentLimit; ++firstSegment_) {
+        Segment* segment = segments_[firstSegment_].exchange(nullptr, std::memory_order_seq_cst);
+        if (segment) {
+            unlinked.push_back(segment);
+        }
+    }
+    nextSpillSegment_ = std::max(nextSpillSegment_, firstSegment_);
+    if (unlinked.empty()) {
+        return;
+    }
+
+    // Readers that loaded a pointer before the unlink are still counted
+    waitForReadersLocked();
+
+    std::size_t releasedBytes = 0;
+    std::size_t releasedSpilled = 0;
+    std::size_t releasedSegments = 0;
+    for (Segment* segment : unlinked) {
+        for (const auto& rawData : segment->rawData) {
+            releasedBytes += rawData.size();
+        }
+        if (segment->spill) {
+            releasedSpilled += static_cast<std::size_t>(segment->spill->offsets[kSegmentSize]);
+            ++releasedSegments;
+        }
+        delete segment;
+    }
+
+    rawBytesInMemory_.fetch_sub(releasedBytes, std::memory_order_relaxed);
+    rawBytesSpilled_.fetch_sub(releasedSpilled, std::memory_order_relaxed);
+    spilledSegments_.fetch_sub(releasedSegments, std::memory_order_relaxed);
+
+    // Posting lists follow in whole blocks, lookups of IDs in between find no packet
+    std::shared_ptr<PacketIndex> index;
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex_);
+        index = index_;
+    }
+    if (index) {
+        index->eraseBefore(static_cast<int>((firstSegment_ << kSegmentShift) + 1));
+    }
+}
+
+void PacketStore::waitForReadersLocked() {
+    const uint32_t epoch = readerEpoch_.fetch_add(1, std::memory_order_seq_cst);
+
+    // visit() calls are short, there is no point in parking
+    while (activeReaders_[epoch & 1].load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+bool PacketStore::spillNextSegmentLocked() {
+    const std::size_t segmentIndex = nextSpillSegment_;
+    if (segmentIndex >= kMaxSegments) {
+        return false;
+    }
+
+    // Every slot of the segment is settled, so no writer touches it any more
+    if (watermark_.load(std::memory_order_acquire) < (segmentIndex + 1) * kSegmentSize) {
+        return false;
+    }
+
+    Segment* segment = segments_[segmentIndex].load(std::memory_order_acquire);
+    if (segment && !spillSegmentLocked(*segment)) {
+        isSpillFailed_ = true;
+        return false;
+    }
+    ++nextSpillSegment_;
+    return true;
+}
+
+bool PacketStore::spillSegmentLocked(Segment& segment) {
+    if (!spillFile_ && !openSpillFileLocked()) {
+        return false;
+    }
+    const int spillFd = spillFile_->fd;
+
+    auto region = std::make_unique<StoreSpillRegion>();
+    region->offsets = std::make_unique<uint64_t[]>(kSegmentSize + 1);
+
+    uint64_t regionSize = 0;
+    for (std::size_t offset = 0; offset < kSegmentSize; ++offset) {
+        region->offsets[offset] = regionSize;
+        if (segment.states[offset].load(std::memory_order_acquire) == SlotState::Ready) {
+            regionSize += segment.rawData[offset].size();
+        }
+    }
+    region->offsets[kSegmentSize] = regionSize;
+
+    // Regions start on a page boundary so each can be mapped on its own
+    const uint64_t regionOffset = spillFileEnd_;
+    uint64_t position = regionOffset;
+    std::vector<uint8_t> staging;
+    staging.reserve(kSpillWriteSize);
+
+    auto flush = [&]() {
+        if (!writeAll(spillFd, staging.data(), staging.size(), position)) {
+            return false;
+        }
+        position += staging.size();
+        staging.clear();
+        return true;
+    };
+
+    for (std::size_t offset = 0; offset < kSegmentSize; ++offset) {
+        if (region->offsets[offset + 1] == region->offsets[offset]) {
+            continue;
+        }
+        const packetscope::PacketBuffer& rawData = segment.rawData[offset];
+        if (staging.size() + rawData.size() > kSpillWriteSize && !flush()) {
+            spdlog::error("PacketStore::spillSegmentLocked() - Cannot write spill file: {}", std::strerror(errno));
+            return false;
+        }
+        staging.insert(staging.end(), rawData.begin(), rawData.end());
+    }
+    if (!flush()) {
+        spdlog::error("PacketStore::spillSegmentLocked() - Cannot write spill file: {}", std::strerror(errno));
+        return false;
+    }
+
+    if (regionSize > 0) {
+        void* mapping = mmap(nullptr, regionSize, PROT_READ, MAP_SHARED, spillFd, static_cast<off_t>(regionOffset));
+        if (mapping == MAP_FAILED) {
+            spdlog::error("PacketStore::spillSegmentLocked() - Cannot map spill file: {}", std::strerror(errno));
+            return false;
+        }
+        region->mapping = mapping;
+        region->mappedSize = regionSize;
+        region->file = spillFile_;
+        region->fileOffset = regionOffset;
+    }
+
+    const auto pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    spillFileEnd_ = (regionOffset + regionSize + pageSize - 1) / pageSize * pageSize;
+
+    // New readers take the bytes from the mapping from now on, wait for the
+    // ones still reading rawData before releasing it (see ReaderGuard)
+    segment.spill = region.release();
+    segment.isSpilled.store(true, std::memory_order_seq_cst);
+    waitForReadersLocked();
+
+    std::size_t releasedBytes = 0;
+    for (auto& rawData : segment.rawData) {
+        releasedBytes += rawData.size();
+        rawData.reset();
+    }
+
+    rawBytesInMemory_.fetch_sub(releasedBytes, std::memory_order_relaxed);
+    rawBytesSpilled_.fetch_add(static_cast<std::size_t>(regionSize), std::memory_order_relaxed);
+    spilledSegments_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool PacketStore::openSpillFileLocked() {
+    std::string directory = spillConfig_.directory;
+    if (directory.empty()) {
+        const char* temporaryDirectory = std::getenv("TMPDIR");
+        directory = temporaryDirectory && *temporaryDirectory ? temporaryDirectory : "/tmp";
+    }
+
+    std::string path = directory + "/packetscope-spill-XXXXXX";
+    const int fd = mkstemp(path.data());
+    if (fd < 0) {
+        spdlog::error("PacketStore::openSpillFileLocked() - Cannot create spill file in '{}': {}",
+                      directory, std::strerror(errno));
+        return false;
+    }
+
+    // Only the descriptor and the mappings refer to it, the space is freed with them
+    ::unlink(path.c_str());
+    spillFile_ = std::make_shared<StoreSpillFile>();
+    spillFile_->fd = fd;
+    spdlog::info("PacketStore::openSpillFileLocked() - Spilling raw packet bytes above {} bytes to '{}'",
+                 spillConfig_.memoryBudget, path);
+    return true;
+}
+
+void PacketStore::releaseAll() {
+    // Packets may have been stored beyond the watermark, walk the whole directory
+    std::vector<Segment*> unlinked;
+    for (std::size_t segmentIndex = 0; segmentIndex < kMaxSegments; ++segmentIndex) {
+        if (Segment* segment = segments_[segmentIndex].exchange(nullptr, std::memory_order_seq_cst)) {
+            unlinked.push_back(segment);
+        }
+    }
+
+    // visit() and scan() calls that loaded a pointer before the unlink still read it
+    waitForReadersLocked();
+
+    // Unwritten slots hold empty PacketBuffer handles, deleting is enough
+    for (Segment* segment : unlinked) {
+        delete segment;
+    }
+}
+
+std::size_t PacketStore::indexOf(int id) {
+    if (id <= 0 || static_cast<std::size_t>(id - 1) >= kSegmentSize * kMaxSegments) {
+        throw std::out_of_range("PacketStore - Packet ID outside of store capacity");
+    }
+    return static_cast<std::size_t>(id - 1);
+}
@@ -0,0 +1,235 @@
+#include "core/PcapCaptureBackend.hpp"
+#include "core/CpuAffinity.hpp"
+
+#include <pcap.h>
+
+#include <spdlog/spdlog.h>
+
+PcapCaptureBackend::PcapCaptureBackend(std::shared_ptr<PacketBufferPool> bufferPool)
+    : bufferPool_(std::move(bufferPool)) {
+    batch_.reserve(1);
+}
+
+PcapCaptureBackend::~PcapCaptureBackend() {
+    stop();
+}
+
+bool PcapCaptureBackend::start(const std::string& deviceName, const Options& options, FrameHandler handler) {
+    handler_ = std::move(handler);
+    threadCpus_ = options.threadCpus;
+    isThreadPinned_ = false;
+    lastStats_ = packetscope::KernelCaptureStats{};
+
+    if (options.fanout) {
+        return startFanoutMember(deviceName, *options.fanout, options.filter);
+    }
+
+    device_ = pcpp::PcapLiveDeviceList::getInstance().getDeviceByName(deviceName);
+
+    if (!device_) {
+        spdlog::error("PcapCaptureBackend::start() - Device '{}' doesn't exist", deviceName);
+        return false;
+    }
+
+    // The snap length is a property of the pcap handle, so it is fixed at open
+    const pcpp::PcapLiveDevice::DeviceConfiguration config(pcpp::PcapLiveDevice::Promiscuous, 0, 0,
+                                                           pcpp::PcapLiveDevice::PCPP_INOUT,
+                                                           options.filter.snapLength);
+    if (!device_->open(config)) {
+        spdlog::error("PcapCaptureBackend::start() - Device '{}' cannot be opened", deviceName);
+        device_ = nullptr;
+        return false;
+    }
+
+    if (!options.filter.expression.empty() && !device_->setFilter(options.filter.expression)) {
+        spdlog::error("PcapCaptureBackend::start() - Cannot set filter '{}' on '{}'",
+                      options.filter.expression, deviceName);
+        device_->close();
+        device_ = nullptr;
+        return false;
+    }
+
+    /**
+     * relevant log error is printed in any case:
+     *  - Capture is already running
+     *  - Device is not opened
+     *  - Capture thread could not be created
+     */
+    if (!device_->startCapture(onPacketArrives, this)) {
+        spdlog::error("PcapCaptureBackend::start() - Capture failed to start on '{}'", deviceName);
+        device_->close();
+        device_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PcapCaptureBackend::stop() {
+    if (device_) {
+        device_->stopCapture();
+        // Final counters of the session, the handle goes away with close()
+        kernelStats();
+        device_->close();
+        device_ = nullptr;
+    }
+
+    if (fanoutHandle_) {
+        isFanoutStopRequested_ = true;
+        pcap_breakloop(fanoutHandle_);
+        if (fanoutThread_.joinable()) {
+            fanoutThread_.join();
+        }
+        kernelStats();
+        pcap_close(fanoutHandle_);
+        fanoutHandle_ = nullptr;
+    }
+}
+
+packetscope::KernelCaptureStats PcapCaptureBackend::kernelStats() {
+    if (device_) {
+        pcpp::IPcapDevice::PcapStats stats{};
+        device_->getStatistics(stats);
+        lastStats_ = packetscope::KernelCaptureStats{stats.packetsRecv, stats.packetsDrop,
+                                                     stats.packetsDropByInterface};
+    } else if (fanoutHandle_) {
+        pcap_stat stats{};
+        if (pcap_stats(fanoutHandle_, &stats) == 0) {
+            lastStats_ = packetscope::KernelCaptureStats{stats.ps_recv, stats.ps_drop, stats.ps_ifdrop};
+        }
+    }
+    return lastStats_;
+}
+
+bool PcapCaptureBackend::setFilter(const std::string& expression) {
+    if (device_) {
+        return expression.empty() ? device_->clearFilter() : device_->setFilter(expression);
+    }
+    if (fanoutHandle_) {
+        return setFanoutFilter(expression);
+    }
+    return false;
+}
+
+void PcapCaptureBackend::onPacketArrives(pcpp::RawPacket* packet, pcpp::PcapLiveDevice* dev, void* cookie) {
+    PcapCaptureBackend* self = static_cast<PcapCaptureBackend*>(cookie);
+
+    self->deliver(packet->getRawData(), packet->getRawDataLen(), packet->getFrameLength(),
+                  packet->getPacketTimeStamp(), packet->getLinkLayerType());
+}
+
+void PcapCaptureBackend::onFanoutPacketArrives(unsigned char* cookie, const pcap_pkthdr* header,
+                                               const unsigned char* data) {
+    PcapCaptureBackend* self = reinterpret_cast<PcapCaptureBackend*>(cookie);
+
+    timespec timestamp{};
+    timestamp.tv_sec = header->ts.tv_sec;
+    timestamp.tv_nsec = static_cast<long>(header->ts.tv_usec) * 1000;
+
+    self->deliver(data, static_cast<int>(header->caplen), static_cast<int>(header->len),
+                  timestamp, self->fanoutLinkLayerType_);
+}
+
+void PcapCaptureBackend::deliver(const uint8_t* data, int rawDataLen, int frameLength, timespec timestamp,
+                                 pcpp::LinkLayerType linkLayerType) {
+    // Runs once per capture session, on the capture thread
+    if (!isThreadPinned_) {
+        isThreadPinned_ = true;
+        if (!CpuAffinity::pinCurrentThread(threadCpus_)) {
+            spdlog::warn("PcapCaptureBackend::deliver() - Failed to pin capture thread");
+        }
+    }
+
+    packetscope::RawPacketData rawPacketData;
+    rawPacketData.timestamp = timestamp;
+    rawPacketData.frameLength = frameLength;
+    rawPacketData.rawDataLen = rawDataLen;
+    rawPacketData.linkLayerType = linkLayerType;
+
+    // Single memcpy into a recycled pool slot, no per packet allocation
+    rawPacketData.rawData = bufferPool_->copyFrom(data, static_cast<std::size_t>(rawDataLen));
+
+    batch_.push_back(std::move(rawPacketData));
+    handler_(batch_);
+    batch_.clear();
+}
+
+bool PcapCaptureBackend::startFanoutMember(const std::string& deviceName, const FanoutGroup& group,
+                                           const packetscope::CaptureFilter& filter) {
+#ifdef __linux__
+    char errorBuffer[PCAP_ERRBUF_SIZE] = {};
+
+    pcap_t* handle = pcap_create(deviceName.c_str(), errorBuffer);
+    if (!handle) {
+        spdlog::error("PcapCaptureBackend::startFanoutMember() - Device '{}' cannot be opened: {}",
+                      deviceName, errorBuffer);
+        return false;
+    }
+
+    pcap_set_snaplen(handle, filter.snapLength > 0 ? filter.snapLength : packetscope::CaptureFilter::kMaxSnapLength);
+    pcap_set_promisc(handle, 1);
+    pcap_set_timeout(handle, kFanoutReadTimeoutMs);
+
+    // Negative results are errors, positive ones warnings
+    const int activation = pcap_activate(handle);
+    if (activation < 0) {
+        spdlog::error("PcapCaptureBackend::startFanoutMember() - Device '{}' cannot be activated: {}",
+                      deviceName, pcap_geterr(handle));
+        pcap_close(handle);
+        return false;
+    }
+
+    if (!joinFanoutGroup(pcap_fileno(handle), group)) {
+        spdlog::error("PcapCaptureBackend::startFanoutMember() - Cannot join fanout group {} on '{}'",
+                      group.id, deviceName);
+        pcap_close(handle);
+        return false;
+    }
+
+    fanoutHandle_ = handle;
+    fanoutLinkLayerType_ = static_cast<pcpp::LinkLayerType>(pcap_datalink(handle));
+    isFanoutStopRequested_ = false;
+
+    if (!filter.expression.empty() && !setFanoutFilter(filter.expression)) {
+        pcap_close(fanoutHandle_);
+        fanoutHandle_ = nullptr;
+        return false;
+    }
+
+    fanoutThread_ = std::thread([this] {
+        while (!isFanoutStopRequested_) {
+            // Returns after a buffer of packets or the read timeout
+            const int result = pcap_dispatch(fanoutHandle_, -1, onFanoutPacketArrives,
+                                             reinterpret_cast<unsigned char*>(this));
+            if (result == PCAP_ERROR) {
+                spdlog::error("PcapCaptureBackend::startFanoutMember() - Capture failed: {}",
+                              pcap_geterr(fanoutHandle_));
+                break;
+            }
+        }
+    });
+    return true;
+#else
+    spdlog::error("PcapCaptureBackend::startFanoutMember() - PF_PACKET fanout is not supported on this platform ('{}', group {})",
+                  deviceName, group.id);
+    (void)filter;
+    return false;
+#endif
+}
+
+bool PcapCaptureBackend::setFanoutFilter(const std::string& expression) {
+    // An empty expression compiles to a program accepting every packet
+    bpf_program program{};
+    if (pcap_compile(fanoutHandle_, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+        spdlog::error("PcapCaptureBackend::setFanoutFilter() - Invalid filter '{}': {}",
+                      expression, pcap_geterr(fanoutHandle_));
+        return false;
+    }
+
+    const bool isSet = pcap_setfilter(fanoutHandle_, &program) == 0;
+    if (!isSet) {
+        spdlog::error("PcapCaptureBackend::setFanoutFilter() - Cannot set filter '{}': {}",
+                      expression, pcap_geterr(fanoutHandle_));
+    }
+    pcap_freecode(&program);
+    return isSet;
+}
@@ -1,21 +1,91 @@
 #include "core/PipelineController.hpp"
+#include "core/CpuAffinity.hpp"
+#include "core/FlowKey.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <unistd.h>
 
 #include <spdlog/spdlog.h>
+#include <spdlog/fmt/ranges.h>
+
+namespace {
+
+/**
+ * @brief Packets travelling from the dispatcher to a worker.
+ *
+ * Every packet already owns a slot in PacketStore (its capture sequence
+ * number). If the task never runs, e.g. because the task queue's overflow
+ * policy dropped it, the destructor discards the remaining slots so the
+ * store watermark keeps advancing, and counts them as dropped packets.
+ */
+class DispatchBatch {
+public:
+    DispatchBatch(std::vector<packetscope::RawPacketData> packets, PacketStore* store,
+                  std::atomic<std::size_t>* droppedPackets)
+        : packets_(std::move(packets))
+        , store_(store)
+        , droppedPackets_(droppedPackets) {}
+
+    ~DispatchBatch() {
+        for (const auto& packet : packets_) {
+            store_->discard(packetscope::toPacketId(packet.sequence));
+        }
+        if (!packets_.empty()) {
+            droppedPackets_->fetch_add(packets_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    DispatchBatch(const DispatchBatch&) = delete;
+    DispatchBatch& operator=(const DispatchBatch&) = delete;
+    DispatchBatch(DispatchBatch&&) = delete;
+    DispatchBatch& operator=(DispatchBatch&&) = delete;
+
+    /**
+     * @brief Hands the packets over to the worker, nothing is discarded afterwards.
+     */
+    std::vector<packetscope::RawPacketData> take() {
+        return std::exchange(packets_, {});
+    }
+
+private:
+    std::vector<packetscope::RawPacketData> packets_;
+    PacketStore* store_;
+    std::atomic<std::size_t>* droppedPackets_;
+};
+
+}
 
-PipelineController::PipelineController()
-    : packetStore_(std::make_shared<PacketStore>())
-    , packetCapture_(std::make_unique<PacketCapture>())
-    , threadPool_(std::make_unique<ThreadPool>(kWorkerCount)) {}
+PipelineController::PipelineController(packetscope::PipelineConfig config)
+    : packetStore_(std::make_shared<PacketStore>(config.storeSpill, config.storeRetention))
+    , detailCache_(config.detailCacheCapacity)
+    , flowTracker_(1, config.flowTableCapacity, config.flowMergeInterval, config.flowLimits)
+    , streamTracker_(1, config.reassembly)
+    , config_(std::move(config)) {
+    packetStore_->setIndexing(config_.indexStore);
+    checkReassemblyConfig();
+    // Placeholder until start() knows the device, see createThreadPoolLocked()
+    threadPool_ = std::make_unique<WorkStealingThreadPool>(1, config_.taskQueue);
+}
 
 PipelineController::~PipelineController() {
     stop();
+    stopRecording();
+    stopMetricsExport();
+}
+
+std::vector<packetscope::DeviceInfo> PipelineController::listAvailableDevices() {
+    return PacketCapture::listAvailableDevices();
 }
 
-std::vector<packetscope::DeviceInfo> PipelineController::listAvailableDevices() const {
-    return packetCapture_->listAvailableDevices();
+bool PipelineController::start(const std::string& deviceName, const packetscope::CaptureFilter& filter) {
+    return start(std::vector<std::string>{deviceName}, filter);
 }
 
-bool PipelineController::start(const std::string& deviceName) {
+bool PipelineController::start(const std::vector<std::string>& deviceNames,
+                               const packetscope::CaptureFilter& filter) {
     std::lock_guard<std::mutex> lock(controlMutex_);
 
     // Check if already running or still shutting down from previous stop
@@ -24,57 +94,43 @@ bool PipelineController::start(const std::string& deviceName) {
         return false;
     }
 
-    // Recreate ThreadPool if it was shut down from presvious stop
-    if (threadPool_->isStopped()) {
-        spdlog::debug("PipelineController::start() - Recreating ThreadPool");
-        threadPool_ = std::make_unique<ThreadPool>(kWorkerCount);
+    if (deviceNames.empty()) {
+        spdlog::error("PipelineController::start() - No capture device given");
+        return false;
     }
 
-    // Start PacketCapture
-    bool isPacketCaptureSuccess = packetCapture_->start(deviceName, [this](packetscope::RawPacketData rawPacket) {
-        rawPacketQueue_.push(std::move(rawPacket));
-    });
-
-    if (!isPacketCaptureSuccess) {
-        spdlog::error("PipelineController::start() - Failed to start packet capture on '{}'", deviceName);
+    if (filter.snapLength < 0 || filter.snapLength > packetscope::CaptureFilter::kMaxSnapLength
+        || !CaptureBackend::isValidFilter(filter.expression)) {
+        spdlog::error("PipelineController::start() - Invalid capture filter '{}' (snap length {})",
+                      filter.expression, filter.snapLength);
         return false;
     }
 
-    // Store device name for restart
-    currentDeviceName_ = deviceName;
+    fileReader_.reset();
+    prepareCaptureInputsLocked(deviceNames);
+    const ThreadPlacement placement = placementFor(deviceNames);
 
-    // Start dispatcher thread
-    dispatcherThread_ = std::thread([this] {
-        try {
-            spdlog::debug("PipelineController::start() - Dispatcher thread started");
-            while (true) {
-                // std::optional for poison pill pattern (nullopt = shutdown)
-                std::optional<packetscope::RawPacketData> rawPacket = rawPacketQueue_.pop();
-
-                // Check for poison pill (shutdown signal)
-                if (!rawPacket) {
-                    spdlog::debug("PipelineController::start() - Dispatcher received poison pill, exiting");
-                    break;
-                }
+    // Recreate the ThreadPool: the previous one was shut down by stop() or
+    // was created before the device (and its NUMA node) was known
+    threadPool_->shutdown();
+    retireThreadPoolStats();
+    createThreadPoolLocked(placement);
 
-                // Submit parsing task to thread pool
-                threadPool_->submit([this, raw = std::move(*rawPacket)]() {
-                    packetscope::ParsedPacket parsedPacket = packetProcessor_.process(raw);
-                    packetStore_->addPacket(std::move(parsedPacket));
-                });
-            }
-            spdlog::debug("PipelineController::start() - Dispatcher thread exited");
-        } catch (const std::exception& e) {
-            // Catch standard exceptions
-            spdlog::error("PipelineController::start() - Dispatcher thread exception: {}", e.what());
-        } catch (...) {
-            // Catch all other exceptions
-            spdlog::error("PipelineController::start() - Dispatcher thread unknown exception");
-        }
-    });
+    if (!startCapturesLocked(placement, filter)) {
+        spdlog::error("PipelineController::start() - Failed to start packet capture on '{}'",
+                      fmt::join(deviceNames, ", "));
+        return false;
+    }
+
+    // Store device names and filter for restart
+    currentDeviceNames_ = deviceNames;
+    currentFilter_ = filter;
+
+    startDispatcherLocked(placement);
 
     isRunning_ = true;
-    spdlog::info("PipelineController::start() - Pipeline started successfully on '{}'", deviceName);
+    spdlog::info("PipelineController::start() - Pipeline started successfully on '{}' ({} captures)",
+                 fmt::join(deviceNames, ", "), captureInputs_.size());
     return true;
 }
 
@@ -87,94 +143,907 @@ void PipelineController::stop() {
     }
 
     spdlog::info("PipelineController::stop() - Stopping pipeline");
+    stopLocked();
+    spdlog::info("PipelineController::stop() - Pipeline stopped");
+}
 
-    // Stop packet capture (no new packets)
-    packetCapture_->stop();
+bool PipelineController::restart() {
+    std::lock_guard<std::mutex> lock(controlMutex_);
 
-    // Send poison pill to dispatcher (std::nullopt)
-    rawPacketQueue_.push(std::nullopt);
+    // Check if we have a device to restart on
+    if (currentDeviceNames_.empty()) {
+        spdlog::warn("PipelineController::restart() - No device set, call start() first");
+        return false;
+    }
 
-    // Wait for dispatcher to finish
-    if (dispatcherThread_.joinable()) {
-        dispatcherThread_.join();
-        spdlog::debug("PipelineController::stop() - Dispatcher thread joined");
+    spdlog::info("PipelineController::restart() - Restarting pipeline on '{}'", fmt::join(currentDeviceNames_, ", "));
+
+    // Stop if currently running
+    if (isRunning_) {
+        stopLocked();
     }
 
-    // Shutdown thread pool
+    fileReader_.reset();
+    prepareCaptureInputsLocked(currentDeviceNames_);
+    resetSessionLocked();
+
+    const ThreadPlacement placement = placementFor(currentDeviceNames_);
+
+    // Recreate ThreadPool because previous one was shut down
     threadPool_->shutdown();
+    createThreadPoolLocked(placement);
 
-    isRunning_ = false;
-    spdlog::info("PipelineController::stop() - Pipeline stopped");
+    // Start fresh capture on same devices
+    if (!startCapturesLocked(placement, currentFilter_)) {
+        spdlog::error("PipelineController::restart() - Failed to restart capture on '{}'",
+                      fmt::join(currentDeviceNames_, ", "));
+        return false;
+    }
+
+    startDispatcherLocked(placement);
+
+    isRunning_ = true;
+    spdlog::info("PipelineController::restart() - Pipeline restarted successfully");
+    return true;
 }
 
-bool PipelineController::restart() {
+bool PipelineController::openFile(const std::string& path) {
     std::lock_guard<std::mutex> lock(controlMutex_);
 
-    // Check if we have a device to restart on
-    if (currentDeviceName_.empty()) {
-        spdlog::warn("PipelineController::restart() - No device set, call start() first");
+    std::unique_ptr<CaptureFileReader> reader = CaptureFileReader::open(path);
+    if (!reader) {
         return false;
     }
 
-    spdlog::info("PipelineController::restart() - Restarting pipeline on '{}'", currentDeviceName_);
+    spdlog::info("PipelineController::openFile() - Loading '{}'", path);
 
-    // Stop if currently running
     if (isRunning_) {
-        packetCapture_->stop();
-        rawPacketQueue_.push(std::nullopt);
+        stopLocked();
+    }
 
-        if (dispatcherThread_.joinable()) {
-            dispatcherThread_.join();
-        }
+    fileReader_ = std::move(reader);
+    resetSessionLocked();
+
+    const ThreadPlacement placement = placementFor({});
+
+    threadPool_->shutdown();
+    createThreadPoolLocked(placement);
+
+    isFileStopRequested_ = false;
+    isFileLoadFinished_ = false;
+    fileLoadDurationNs_ = 0;
+    fileLoadStart_ = std::chrono::steady_clock::now();
+
+    startDispatcherLocked(placement);
+
+    isRunning_ = true;
+    return true;
+}
+
+std::optional<packetscope::FileLoadProgress> PipelineController::fileLoadProgress() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    if (!fileReader_) {
+        return std::nullopt;
+    }
+
+    packetscope::FileLoadProgress progress;
+    progress.path = fileReader_->path();
+    progress.fileSize = fileReader_->fileSize();
+    progress.bytesRead = fileReader_->bytesRead();
+    progress.packetsRead = fileReader_->packetsRead();
+    progress.isFinished = isFileLoadFinished_;
+
+    const auto elapsed = progress.isFinished
+        ? std::chrono::nanoseconds(fileLoadDurationNs_.load())
+        : std::chrono::steady_clock::now() - fileLoadStart_;
+    progress.secondsElapsed = std::chrono::duration<double>(elapsed).count();
+    if (progress.secondsElapsed > 0) {
+        progress.megabytesPerSecond = static_cast<double>(progress.bytesRead) / 1e6 / progress.secondsElapsed;
+    }
+    return progress;
+}
+
+bool PipelineController::startRecording(const packetscope::CaptureWriterConfig& config) {
+    std::lock_guard<std::mutex> lock(recordingMutex_);
+
+    if (captureWriter_) {
+        spdlog::warn("PipelineController::startRecording() - Already recording");
+        return false;
+    }
+
+    captureWriter_ = CaptureFileWriter::start(config);
+    return captureWriter_ != nullptr;
+}
+
+void PipelineController::stopRecording() {
+    std::unique_ptr<CaptureFileWriter> writer;
+    {
+        std::lock_guard<std::mutex> lock(recordingMutex_);
+        writer = std::move(captureWriter_);
+    }
+    // The dispatcher no longer offers to it, the destructor drains the queue
+    // and writes while the pipeline keeps running
+    writer.reset();
+}
+
+void PipelineController::setStoreRetention(const packetscope::StoreRetentionConfig& retention) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    config_.storeRetention = retention;
+    packetStore_->setRetentionConfig(retention);
+}
+
+void PipelineController::setStoreIndexing(bool isIndexing) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    config_.indexStore = isIndexing;
+    packetStore_->setIndexing(isIndexing);
+}
 
-        threadPool_->shutdown();
-        isRunning_ = false;
+packetscope::PipelineMetricsSnapshot PipelineController::metrics() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    packetscope::PipelineMetricsSnapshot snapshot;
+    snapshot.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    metrics_.collect(snapshot);
+
+    snapshot.kernel = retiredKernelStats_;
+    snapshot.captures.reserve(captureInputs_.size());
+    for (const CaptureInput& input : captureInputs_) {
+        packetscope::CaptureMetrics capture{input.deviceName, input.capture->kernelStats(), input.queue->stats(),
+                                            input.capture->getCapturedPacketCount()};
+        snapshot.kernel.merge(capture.kernel);
+        snapshot.captures.push_back(std::move(capture));
+    }
+
+    snapshot.rawQueue = rawQueueStatsLocked();
+    snapshot.taskQueue = taskQueueStatsLocked();
+    snapshot.captured = capturedCountLocked();
+    snapshot.processed = packetStore_->count();
+    return snapshot;
+}
+
+bool PipelineController::startMetricsExport(const packetscope::MetricsExportConfig& config) {
+    std::lock_guard<std::mutex> lock(metricsExportMutex_);
+
+    if (metricsExporter_) {
+        spdlog::warn("PipelineController::startMetricsExport() - Already exporting to '{}'",
+                     metricsExporter_->config().path);
+        return false;
+    }
+
+    metricsExporter_ = MetricsExporter::start(config, [this] { return metrics(); });
+    return metricsExporter_ != nullptr;
+}
+
+void PipelineController::stopMetricsExport() {
+    std::unique_ptr<MetricsExporter> exporter;
+    {
+        std::lock_guard<std::mutex> lock(metricsExportMutex_);
+        exporter = std::move(metricsExporter_);
     }
+    // Writes the last snapshot, which takes controlMutex_
+    exporter.reset();
+}
+
+std::optional<packetscope::MetricsExportConfig> PipelineController::metricsExport() const {
+    std::lock_guard<std::mutex> lock(metricsExportMutex_);
 
+    if (!metricsExporter_) {
+        return std::nullopt;
+    }
+    return metricsExporter_->config();
+}
+
+std::optional<packetscope::CaptureWriterStats> PipelineController::recordingStats() const {
+    std::lock_guard<std::mutex> lock(recordingMutex_);
+
+    if (!captureWriter_) {
+        return std::nullopt;
+    }
+    return captureWriter_->stats();
+}
+
+void PipelineController::checkReassemblyConfig() {
+    if (config_.reassembleTcp && config_.dispatchMode != packetscope::DispatchMode::FlowAffine) {
+        // A flow's segments would be spread over several reassemblers
+        spdlog::warn("PipelineController::checkReassemblyConfig() - TCP reassembly needs DispatchMode::FlowAffine, disabled");
+        config_.reassembleTcp = false;
+    }
+}
+
+void PipelineController::resetSessionLocked() {
     // Clear stored packets and reset counters
     packetStore_->clear();
-    packetCapture_->resetCapturedPacketCount();
-    rawPacketQueue_.clear();
+    detailCache_.clear();
+    flowTracker_.clear();
+    streamTracker_.clear();
+    metrics_.reset();
+    for (CaptureInput& input : captureInputs_) {
+        input.capture->resetCapturedPacketCount();
+        input.capture->resetKernelStats();
+        input.queue->clear();
+        input.queue->resetStats();
+    }
+    retiredRawQueueStats_ = packetscope::QueueStats{};
+    retiredCapturedCount_ = 0;
+    retiredKernelStats_ = packetscope::KernelCaptureStats{};
+    retiredTaskQueueStats_ = packetscope::QueueStats{};
+    taskQueueDroppedPackets_ = 0;
+    nextSequence_ = 0;
+}
 
-    // Recreate ThreadPool because previous one was shut down
-    threadPool_ = std::make_unique<ThreadPool>(kWorkerCount);
+PipelineController::ThreadPlacement PipelineController::placementFor(const std::vector<std::string>& deviceNames) const {
+    std::vector<int> nodeCpus;
 
-    // Start fresh capture on same device
-    bool isPacketCaptureSuccess = packetCapture_->start(currentDeviceName_, [this](packetscope::RawPacketData rawPacket) {
-        rawPacketQueue_.push(std::move(rawPacket));
-    });
+    if (config_.pinToDeviceNumaNode && !deviceNames.empty()) {
+        const std::string& deviceName = deviceNames.front();
+        const int node = CpuAffinity::deviceNumaNode(deviceName);
+        nodeCpus = CpuAffinity::numaNodeCpus(node);
+
+        if (nodeCpus.empty()) {
+            spdlog::warn("PipelineController::placementFor() - NUMA node of '{}' is unknown, not pinning to a node", deviceName);
+        } else {
+            spdlog::info("PipelineController::placementFor() - '{}' is on NUMA node {} ({} CPUs)",
+                         deviceName, node, nodeCpus.size());
+        }
+    }
+
+    // Explicit CPU lists win over the NUMA node
+    auto choose = [&nodeCpus](const std::vector<int>& cpus) {
+        return cpus.empty() ? nodeCpus : cpus;
+    };
+
+    return ThreadPlacement{
+        choose(config_.captureCpus),
+        choose(config_.dispatcherCpus),
+        choose(config_.workerCpus)
+    };
+}
+
+std::size_t PipelineController::resolvedWorkerCount() const {
+    if (config_.workerCount > 0) {
+        return config_.workerCount;
+    }
+
+    // Leave one hardware thread each for the capture threads and the dispatcher
+    const std::size_t captureThreads = fileReader_ ? 0 : std::max(captureInputs_.size(), std::size_t{1});
+    const std::size_t reservedThreads = captureThreads + kDispatcherThreadCount;
+    const std::size_t hardwareThreads = CpuAffinity::hardwareThreads();
+    return hardwareThreads > reservedThreads ? hardwareThreads - reservedThreads : 1;
+}
 
-    if (!isPacketCaptureSuccess) {
-        spdlog::error("PipelineController::restart() - Failed to restart capture on '{}'", currentDeviceName_);
+void PipelineController::createThreadPoolLocked(const ThreadPlacement& placement) {
+    const std::size_t workerCount = resolvedWorkerCount();
+    spdlog::debug("PipelineController::createThreadPoolLocked() - Creating ThreadPool with {} workers", workerCount);
+    threadPool_ = std::make_unique<WorkStealingThreadPool>(workerCount, config_.taskQueue, placement.workers);
+
+    // Ring and file frames are copied once, by the worker storing them; pool
+    // slabs are first touched there, on the worker's node
+    workerBufferPools_.clear();
+    if (fileReader_ || config_.captureBackend == packetscope::CaptureBackendType::TPacketV3) {
+        for (std::size_t worker = 0; worker < workerCount; ++worker) {
+            workerBufferPools_.push_back(PacketBufferPool::create());
+        }
+    }
+
+    // One flow table per worker, the old pool's workers have exited
+    flowTracker_.reshard(workerCount, config_.flowTableCapacity, config_.flowMergeInterval, config_.flowLimits);
+
+    // Shard i is worker i, as FlowAffine dispatch maps the flows
+    streamTracker_.reshard(workerCount, config_.reassembly);
+
+    metrics_.resize(0, workerCount);
+}
+
+void PipelineController::prepareCaptureInputsLocked(const std::vector<std::string>& deviceNames) {
+    const std::size_t queuesPerDevice = std::max(config_.captureQueuesPerDevice, std::size_t{1});
+
+    std::vector<std::string> inputDevices;
+    for (const std::string& deviceName : deviceNames) {
+        inputDevices.insert(inputDevices.end(), queuesPerDevice, deviceName);
+    }
+
+    const bool isUnchanged = std::equal(inputDevices.begin(), inputDevices.end(),
+                                        captureInputs_.begin(), captureInputs_.end(),
+                                        [](const std::string& deviceName, const CaptureInput& input) {
+                                            return deviceName == input.deviceName;
+                                        });
+    if (isUnchanged) {
+        return;
+    }
+
+    retireCaptureInputStats();
+    captureInputs_.clear();
+    captureInputs_.reserve(inputDevices.size());
+
+    for (std::size_t device = 0; device < deviceNames.size(); ++device) {
+        // One fanout group per device; the id only has to be unique on this host
+        const auto groupId = static_cast<uint16_t>((static_cast<std::size_t>(getpid()) + device) & 0xFFFF);
+
+        for (std::size_t queue = 0; queue < queuesPerDevice; ++queue) {
+            CaptureInput input{
+                deviceNames[device],
+                std::make_unique<PacketCapture>(PacketBufferPool::create()),
+                std::make_unique<RawPacketQueue>(config_.rawQueue)
+            };
+            input.capture->setBackend(config_.captureBackend, config_.tpacketRing);
+            if (queuesPerDevice > 1) {
+                input.capture->setFanout(PacketCapture::FanoutGroup{groupId, config_.fanoutMode});
+            }
+            captureInputs_.push_back(std::move(input));
+        }
+    }
+}
+
+void PipelineController::retireCaptureInputStats() {
+    for (const CaptureInput& input : captureInputs_) {
+        const packetscope::QueueStats stats = input.queue->stats();
+        retiredRawQueueStats_.dropped += stats.dropped;
+        retiredRawQueueStats_.highWaterMark = std::max(retiredRawQueueStats_.highWaterMark, stats.highWaterMark);
+        retiredCapturedCount_ += input.capture->getCapturedPacketCount();
+        retiredKernelStats_.merge(input.capture->kernelStats());
+    }
+}
+
+bool PipelineController::setCaptureFilter(const std::string& expression) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    if (!CaptureBackend::isValidFilter(expression)) {
         return false;
     }
 
-    // Start dispatcher thread
-    dispatcherThread_ = std::thread([this] {
+    // Only the capture sockets change, the pool, dispatcher and rings keep running
+    packetscope::CaptureFilter filter{expression, currentFilter_.snapLength};
+    for (CaptureInput& input : captureInputs_) {
+        if (!input.capture->setFilter(filter)) {
+            spdlog::error("PipelineController::setCaptureFilter() - Cannot apply filter '{}' on '{}'",
+                          expression, input.deviceName);
+            return false;
+        }
+    }
+
+    currentFilter_ = std::move(filter);
+    spdlog::info("PipelineController::setCaptureFilter() - Capture filter set to '{}'", expression);
+    return true;
+}
+
+packetscope::CaptureFilter PipelineController::captureFilter() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return currentFilter_;
+}
+
+bool PipelineController::startCapturesLocked(const ThreadPlacement& placement,
+                                             const packetscope::CaptureFilter& filter) {
+    metrics_.resize(captureInputs_.size(), 0);
+
+    for (std::size_t i = 0; i < captureInputs_.size(); ++i) {
+        CaptureInput& input = captureInputs_[i];
+        input.capture->setFilter(filter);
+
+        // A single capture may use the whole list, several get one CPU each
+        std::vector<int> cpus = placement.capture;
+        if (captureInputs_.size() > 1 && !cpus.empty()) {
+            cpus = {placement.capture[i % placement.capture.size()]};
+        }
+        input.capture->setThreadAffinity(std::move(cpus));
+
+        RawPacketQueue* queue = input.queue.get();
+        ThreadMetrics* threadMetrics = config_.collectMetrics ? metrics_.capture(i) : nullptr;
+        const bool isStarted = input.capture->start(input.deviceName,
+                                                    [queue, threadMetrics](std::vector<packetscope::RawPacketData>& batch) {
+            const uint64_t start = threadMetrics ? ThreadMetrics::now() : 0;
+
+            // Overflow policy decides between dropping, sampling and blocking.
+            // Packets are numbered by the dispatcher, a dropped one leaves no gap.
+            queue->offerBatch(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+
+            // A blocking ring shows up here as a slow callback
+            if (threadMetrics) {
+                const uint64_t elapsed = ThreadMetrics::now() - start;
+                threadMetrics->record(packetscope::PipelineStage::CaptureCallback, elapsed);
+                threadMetrics->addWork(batch.size(), elapsed);
+            }
+        });
+
+        if (!isStarted) {
+            for (std::size_t started = 0; started < i; ++started) {
+                captureInputs_[started].capture->stop();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void PipelineController::startDispatcherLocked(const ThreadPlacement& placement) {
+    dispatcherThread_ = std::thread([this, cpus = placement.dispatcher] {
+        if (!CpuAffinity::pinCurrentThread(cpus)) {
+            spdlog::warn("PipelineController::dispatcherLoop() - Failed to pin dispatcher thread");
+        }
+
         try {
-            spdlog::debug("PipelineController::restart() - Dispatcher thread started");
-            while (true) {
-                std::optional<packetscope::RawPacketData> rawPacket = rawPacketQueue_.pop();
+            spdlog::debug("PipelineController::dispatcherLoop() - Dispatcher thread started");
+            dispatcherLoop();
+            spdlog::debug("PipelineController::dispatcherLoop() - Dispatcher thread exited");
+        } catch (const std::exception& e) {
+            // Catch standard exceptions
+            spdlog::error("PipelineController::dispatcherLoop() - Dispatcher thread exception: {}", e.what());
+        } catch (...) {
+            // Catch all other exceptions
+            spdlog::error("PipelineController::dispatcherLoop() - Dispatcher thread unknown exception");
+        }
+    });
+}
+
+void PipelineController::stopLocked() {
+    // A file dispatcher stops at the next chunk
+    isFileStopRequested_ = true;
+
+    // Stop packet capture (no new packets)
+    for (CaptureInput& input : captureInputs_) {
+        input.capture->stop();
+    }
 
-                if (!rawPacket) {
-                    break;
+    // Send poison pill to dispatcher (std::nullopt), one per ring.
+    // A file dispatcher does not read the rings, a pill would stay queued.
+    if (!fileReader_) {
+        for (CaptureInput& input : captureInputs_) {
+            input.queue->push(std::nullopt);
+        }
+    }
+
+    // Wait for dispatcher to finish
+    if (dispatcherThread_.joinable()) {
+        dispatcherThread_.join();
+        spdlog::debug("PipelineController::stopLocked() - Dispatcher thread joined");
+    }
+
+    // Shutdown thread pool
+    threadPool_->shutdown();
+
+    if (fileReader_ && !isFileLoadFinished_) {
+        fileLoadDurationNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - fileLoadStart_).count();
+        isFileLoadFinished_ = true;
+    }
+
+    isRunning_ = false;
+}
+
+void PipelineController::dispatcherLoop() {
+    if (fileReader_) {
+        fileDispatcherLoop();
+        return;
+    }
+
+    if (captureInputs_.size() > 1) {
+        mergingDispatcherLoop();
+        return;
+    }
+
+    RawPacketQueue& rawPacketQueue = *captureInputs_.front().queue;
+    const std::size_t batchSize = std::max(config_.dispatchBatchSize, std::size_t{1});
+    const std::chrono::microseconds batchTimeout = config_.dispatchBatchTimeout;
+
+    std::vector<packetscope::RawPacketData> batch;
+    batch.reserve(batchSize);
+
+    while (true) {
+        // Block until the first packet of the next batch arrives.
+        // std::optional for poison pill pattern (nullopt = shutdown)
+        std::optional<packetscope::RawPacketData> rawPacket = rawPacketQueue.pop();
+
+        // Check for poison pill (shutdown signal)
+        if (!rawPacket) {
+            spdlog::debug("PipelineController::dispatcherLoop() - Dispatcher received poison pill, exiting");
+            return;
+        }
+        // Wire order number, assigned before parallel parsing can reorder it
+        rawPacket->sequence = nextSequence_++;
+        batch.push_back(std::move(*rawPacket));
+
+        // Fill the batch until it is full or the timeout expires
+        bool isPoisonPillReceived = false;
+        const auto deadline = std::chrono::steady_clock::now() + batchTimeout;
+
+        while (batch.size() < batchSize) {
+            std::optional<std::optional<packetscope::RawPacketData>> next = rawPacketQueue.popUntil(deadline);
+            if (!next) {
+                break; // Timeout
+            }
+            if (!*next) {
+                isPoisonPillReceived = true;
+                break;
+            }
+            (*next)->sequence = nextSequence_++;
+            batch.push_back(std::move(**next));
+        }
+
+        dispatch(std::move(batch));
+        batch = std::vector<packetscope::RawPacketData>();
+        batch.reserve(batchSize);
+
+        if (isPoisonPillReceived) {
+            spdlog::debug("PipelineController::dispatcherLoop() - Dispatcher received poison pill, exiting");
+            return;
+        }
+    }
+}
+
+void PipelineController::mergingDispatcherLoop() {
+    using Clock = std::chrono::steady_clock;
+
+    const std::size_t batchSize = std::max(config_.dispatchBatchSize, std::size_t{1});
+    const std::chrono::microseconds batchTimeout = config_.dispatchBatchTimeout;
+    const std::chrono::microseconds mergeWindow = config_.captureMergeWindow;
+
+    /// Merge state of one ring
+    struct MergeInput {
+        RawPacketQueue* queue;
+        std::optional<packetscope::RawPacketData> head;   ///< Next packet of this ring
+        Clock::time_point heldSince;
+        Clock::time_point emptySince;                     ///< When the last head was taken
+        bool isFinished{false};                           ///< Poison pill received
+    };
+
+    const Clock::time_point start = Clock::now();
+    std::vector<MergeInput> inputs;
+    inputs.reserve(captureInputs_.size());
+    for (CaptureInput& input : captureInputs_) {
+        inputs.push_back(MergeInput{input.queue.get(), std::nullopt, {}, start, false});
+    }
+    std::size_t finishedCount = 0;
+
+    std::vector<packetscope::RawPacketData> batch;
+    batch.reserve(batchSize);
+    Clock::time_point batchDeadline;
+
+    auto flush = [&]() {
+        if (!batch.empty()) {
+            dispatch(std::move(batch));
+            batch = std::vector<packetscope::RawPacketData>();
+            batch.reserve(batchSize);
+        }
+    };
+
+    auto accept = [&](MergeInput& input, std::optional<packetscope::RawPacketData>&& next, Clock::time_point now) {
+        if (!next) {
+            input.isFinished = true;
+            ++finishedCount;
+        } else {
+            input.head = std::move(next);
+            input.heldSince = now;
+        }
+    };
+
+    auto isEarlier = [](const timespec& first, const timespec& second) {
+        return first.tv_sec != second.tv_sec ? first.tv_sec < second.tv_sec : first.tv_nsec < second.tv_nsec;
+    };
+
+    while (true) {
+        const Clock::time_point now = Clock::now();
+
+        // Refill the rings without a packet in hand
+        for (MergeInput& input : inputs) {
+            if (!input.head && !input.isFinished) {
+                if (std::optional<std::optional<packetscope::RawPacketData>> next = input.queue->poll()) {
+                    accept(input, std::move(*next), now);
+                }
+            }
+        }
+
+        // A ring that stayed empty for a whole merge window is idle and no
+        // longer holds back the others; waitingOn is the last one to go quiet
+        MergeInput* oldest = nullptr;
+        MergeInput* empty = nullptr;
+        MergeInput* waitingOn = nullptr;
+        for (MergeInput& input : inputs) {
+            if (input.head) {
+                if (!oldest || isEarlier(input.head->timestamp, oldest->head->timestamp)) {
+                    oldest = &input;
+                }
+            } else if (!input.isFinished) {
+                if (!empty) {
+                    empty = &input;
+                }
+                if (now - input.emptySince < mergeWindow
+                    && (!waitingOn || input.emptySince > waitingOn->emptySince)) {
+                    waitingOn = &input;
+                }
+            }
+        }
+
+        // Emit once no busy ring can deliver an older packet, or the oldest waited long enough
+        if (oldest && (!waitingOn || now - oldest->heldSince >= mergeWindow)) {
+            if (batch.empty()) {
+                batchDeadline = now + batchTimeout;
+            }
+            oldest->head->sequence = nextSequence_++;
+            batch.push_back(std::move(*oldest->head));
+            oldest->head.reset();
+            oldest->emptySince = now;
+
+            if (batch.size() >= batchSize) {
+                flush();
+            }
+            continue;
+        }
+
+        if (!batch.empty() && now >= batchDeadline) {
+            flush();
+        }
+
+        if (!oldest && finishedCount == inputs.size()) {
+            flush();
+            spdlog::debug("PipelineController::mergingDispatcherLoop() - Every capture delivered its poison pill, exiting");
+            return;
+        }
+
+        // Park on a ring that has nothing queued until the oldest head may be
+        // emitted (its wait or the last busy ring going idle), bounded by the batch timeout
+        MergeInput* parked = waitingOn ? waitingOn : empty;
+        Clock::time_point deadline = now + mergeWindow;
+        if (oldest) {
+            deadline = std::min(oldest->heldSince, waitingOn->emptySince) + mergeWindow;
+        }
+        if (!batch.empty()) {
+            deadline = std::min(deadline, batchDeadline);
+        }
+        if (std::optional<std::optional<packetscope::RawPacketData>> next = parked->queue->popUntil(deadline)) {
+            accept(*parked, std::move(*next), Clock::now());
+        }
+    }
+}
+
+void PipelineController::fileDispatcherLoop() {
+    CaptureFileReader& reader = *fileReader_;
+    const std::size_t chunkSize = std::max(config_.fileChunkSize, std::size_t{1});
+    const std::size_t maxChunksInFlight = threadPool_->threadCount() * kFileChunksInFlightPerWorker;
+
+    while (!isFileStopRequested_) {
+        // The mapping is free to read ahead, but every chunk in flight holds
+        // its frame headers and pending task
+        if (reader.chunksInFlight() >= maxChunksInFlight) {
+            std::this_thread::sleep_for(kFileBackpressureSleep);
+            continue;
+        }
+
+        std::vector<packetscope::RawPacketData> chunk;
+        chunk.reserve(chunkSize);
+        if (reader.read(chunk, chunkSize) == 0) {
+            break;
+        }
+
+        for (auto& rawPacket : chunk) {
+            rawPacket.sequence = nextSequence_++;
+        }
+        dispatch(std::move(chunk));
+    }
+
+    // Include the workers' copy, parse and store in the reported throughput
+    while (!isFileStopRequested_ && reader.chunksInFlight() > 0) {
+        std::this_thread::sleep_for(kFileBackpressureSleep);
+    }
+
+    if (isFileStopRequested_) {
+        spdlog::info("PipelineController::fileDispatcherLoop() - Load of '{}' stopped after {} packets",
+                     reader.path(), reader.packetsRead());
+        return;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - fileLoadStart_;
+    fileLoadDurationNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    isFileLoadFinished_ = true;
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    spdlog::info("PipelineController::fileDispatcherLoop() - Loaded {} packets ({:.1f} MB) from '{}' in {:.2f} s, {:.1f} MB/s",
+                 reader.packetsRead(), static_cast<double>(reader.bytesRead()) / 1e6, reader.path(), seconds,
+                 seconds > 0 ? static_cast<double>(reader.bytesRead()) / 1e6 / seconds : 0.0);
+}
+
+void PipelineController::dispatch(std::vector<packetscope::RawPacketData> batch) {
+    ThreadMetrics* threadMetrics = config_.collectMetrics ? &metrics_.dispatcher() : nullptr;
+    const uint64_t start = threadMetrics ? ThreadMetrics::now() : 0;
+    const std::size_t packetCount = batch.size();
+
+    // Capture timestamps are wall clock time; packets read from a file wait for nothing
+    if (threadMetrics && !fileReader_) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (const auto& packet : batch) {
+            const int64_t captured = static_cast<int64_t>(packet.timestamp.tv_sec) * 1000000000
+                + packet.timestamp.tv_nsec;
+            // Hardware or adjusted clocks may run ahead of the system clock
+            threadMetrics->record(packetscope::PipelineStage::RawQueueWait,
+                            now > captured ? static_cast<uint64_t>(now - captured) : 0);
+        }
+    }
+
+    {
+        // Pooled buffers are shared with the writer, ring frames are copied so the ring is not held
+        std::lock_guard<std::mutex> lock(recordingMutex_);
+        if (captureWriter_) {
+            for (const auto& packet : batch) {
+                captureWriter_->offer(packet);
+            }
+        }
+    }
+
+    if (config_.dispatchMode == packetscope::DispatchMode::FlowAffine) {
+        submitFlowAffine(std::move(batch));
+    } else {
+        submitBatch(std::move(batch));
+    }
+
+    // Includes waiting for room in a blocking task queue
+    if (threadMetrics) {
+        threadMetrics->addWork(packetCount, ThreadMetrics::now() - start);
+    }
+}
+
+void PipelineController::submitBatch(std::vector<packetscope::RawPacketData> batch) {
+    submitTask(std::move(batch), WorkStealingThreadPool::kNoWorker);
+}
+
+void PipelineController::submitFlowAffine(std::vector<packetscope::RawPacketData> batch) {
+    const std::size_t workerCount = threadPool_->threadCount();
+
+    std::vector<std::vector<packetscope::RawPacketData>> perWorker(workerCount);
+    std::vector<packetscope::RawPacketData> unclassified;
+
+    for (auto& raw : batch) {
+        packetscope::FlowKey key;
+        const bool isClassified = packetscope::FlowKey::fromRawPacket(
+            raw.rawData.data(), static_cast<std::size_t>(raw.rawDataLen), raw.linkLayerType, key);
+
+        if (isClassified) {
+            perWorker[static_cast<std::size_t>(key.hash() % workerCount)].push_back(std::move(raw));
+        } else {
+            unclassified.push_back(std::move(raw));
+        }
+    }
+
+    // Sub-batches keep capture order, and each worker runs its affine tasks in order
+    for (std::size_t worker = 0; worker < workerCount; ++worker) {
+        if (!perWorker[worker].empty()) {
+            submitTask(std::move(perWorker[worker]), worker);
+        }
+    }
+    if (!unclassified.empty()) {
+        submitTask(std::move(unclassified), WorkStealingThreadPool::kNoWorker);
+    }
+}
+
+void PipelineController::submitTask(std::vector<packetscope::RawPacketData> packets, std::size_t worker) {
+    auto pending = std::make_shared<DispatchBatch>(std::move(packets), packetStore_.get(), &taskQueueDroppedPackets_);
+    const uint64_t submittedAt = config_.collectMetrics ? ThreadMetrics::now() : 0;
+
+    // One task (and one task queue round trip) per batch
+    auto task = [this, pending, worker, submittedAt]() {
+        const std::size_t workerIndex = threadPool_->currentWorkerIndex();
+        ThreadMetrics* threadMetrics = config_.collectMetrics ? metrics_.worker(workerIndex) : nullptr;
+        const uint64_t start = threadMetrics ? ThreadMetrics::now() : 0;
+        if (threadMetrics) {
+            threadMetrics->record(packetscope::PipelineStage::TaskQueueWait, start - submittedAt);
+        }
+
+        const std::vector<packetscope::RawPacketData> rawPackets = pending->take();
+
+        std::vector<packetscope::ParsedPacket> parsedPackets;
+        parsedPackets.reserve(rawPackets.size());
+
+        auto parseAll = [&](FlowTable* flowTable, TcpReassembler* reassembler) {
+            // One clock read per packet: each one ends the previous packet's time
+            uint64_t previous = threadMetrics ? ThreadMetrics::now() : 0;
+            for (const auto& raw : rawPackets) {
+                try {
+                    parsedPackets.push_back(packetProcessor_.process(raw, flowTable, reassembler));
+                } catch (const std::exception& e) {
+                    // Every ID must be settled, otherwise the store watermark stalls
+                    spdlog::error("PipelineController::submitTask() - Failed to process packet: {}", e.what());
+                    packetStore_->discard(packetscope::toPacketId(raw.sequence));
                 }
+                if (threadMetrics) {
+                    const uint64_t now = ThreadMetrics::now();
+                    threadMetrics->record(packetscope::PipelineStage::Process, now - previous);
+                    previous = now;
+                }
+            }
+        };
 
-                threadPool_->submit([this, raw = std::move(*rawPacket)]() {
-                    packetscope::ParsedPacket parsedPacket = packetProcessor_.process(raw);
-                    packetStore_->addPacket(std::move(parsedPacket));
+        // Affine tasks hold whole flows, in order; the others carry no TCP
+        auto parseWithStreams = [&](FlowTable* flowTable) {
+            if (config_.reassembleTcp && worker != WorkStealingThreadPool::kNoWorker) {
+                streamTracker_.update(workerIndex, [&](TcpReassembler& reassembler) {
+                    parseAll(flowTable, &reassembler);
+                    reassembler.expireIfDue(packetStore_->firstId());
                 });
+            } else {
+                parseAll(flowTable, nullptr);
             }
-        } catch (const std::exception& e) {
-            spdlog::error("PipelineController::restart() - Dispatcher thread exception: {}", e.what());
-        } catch (...) {
-            spdlog::error("PipelineController::restart() - Dispatcher thread unknown exception");
+        };
+
+        if (config_.trackFlows) {
+            // The worker's own table, its mutex is taken once for the whole batch
+            flowTracker_.update(workerIndex, [&](FlowTable& flowTable) {
+                parseWithStreams(&flowTable);
+            });
+            flowTracker_.mergeIfDue();
+        } else {
+            parseWithStreams(nullptr);
         }
+
+        // The store outlives the capture ring, so frames lent by it are copied
+        // here; the ring blocks are released with rawPackets when the task ends
+        if (workerIndex < workerBufferPools_.size()) {
+            PacketBufferPool& bufferPool = *workerBufferPools_[workerIndex];
+            for (auto& parsed : parsedPackets) {
+                if (parsed.rawData.isBorrowed()) {
+                    parsed.rawData = bufferPool.copyFrom(parsed.rawData.data(), parsed.rawData.size());
+                }
+            }
+        }
+
+        // Single store update (and watermark pass) for the whole batch
+        const uint64_t storeStart = threadMetrics ? ThreadMetrics::now() : 0;
+        packetStore_->addPackets(std::move(parsedPackets));
+
+        if (threadMetrics) {
+            const uint64_t end = ThreadMetrics::now();
+            threadMetrics->record(packetscope::PipelineStage::StoreInsert, end - storeStart);
+            threadMetrics->addWork(rawPackets.size(), end - start);
+        }
+    };
+
+    const bool isSubmitted = worker == WorkStealingThreadPool::kNoWorker
+        ? threadPool_->submit(std::move(task))
+        : threadPool_->submitTo(worker, std::move(task));
+
+    if (!isSubmitted) {
+        spdlog::debug("PipelineController::submitTask() - Batch dropped by task queue");
+    }
+    // A dropped task releases pending, whose destructor discards the batch
+}
+
+std::vector<packetscope::FlowStats> PipelineController::topFlows(std::size_t count) const {
+    return flowTracker_.topFlows(count);
+}
+
+std::vector<packetscope::FlowStats> PipelineController::flows() const {
+    return flowTracker_.flows();
+}
+
+std::optional<packetscope::TcpStream> PipelineController::tcpStream(int packetId) const {
+    // Keeps start() / openFile() from resharding the reassemblers meanwhile
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    if (!config_.reassembleTcp) {
+        return std::nullopt;
+    }
+
+    packetscope::FlowKey key;
+    bool isFound = false;
+    packetStore_->visit(packetId, [&key, &isFound](const PacketView& packet) {
+        isFound = packetscope::FlowKey::fromRawPacket(packet.rawData().data(),
+                                                      static_cast<std::size_t>(packet.rawDataLen()),
+                                                      packet.linkLayerType(), key);
     });
 
-    isRunning_ = true;
-    spdlog::info("PipelineController::restart() - Pipeline restarted successfully");
-    return true;
+    constexpr uint8_t kProtocolTcp = 6;
+    if (!isFound || key.ipProtocol != kProtocolTcp) {
+        return std::nullopt;
+    }
+    return streamTracker_.stream(key);
+}
+
+packetscope::ReassemblyStats PipelineController::reassemblyStats() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return streamTracker_.stats();
+}
+
+bool PipelineController::isReassemblingTcp() const {
+    return config_.reassembleTcp;
 }
 
 bool PipelineController::isRunning() const {
@@ -185,12 +1054,128 @@ std::shared_ptr<PacketStore> PipelineController::getStore() const {
     return packetStore_;
 }
 
+std::shared_ptr<const PacketDetailCache::LayerDetails> PipelineController::layerDetails(int packetId) const {
+    if (auto cached = detailCache_.find(packetId)) {
+        return cached;
+    }
+
+    std::shared_ptr<const PacketDetailCache::LayerDetails> details;
+    packetStore_->visit(packetId, [this, &details](const PacketView& packet) {
+        const packetscope::RawPacketData rawPacket{
+            static_cast<uint64_t>(packet.id() - 1),
+            packet.timestamp(),
+            packet.rawData(),
+            packet.rawDataLen(),
+            packet.frameLength(),
+            packet.linkLayerType()
+        };
+        details = std::make_shared<const PacketDetailCache::LayerDetails>(packetProcessor_.dissect(rawPacket));
+    });
+
+    if (details) {
+        detailCache_.insert(packetId, details);
+    }
+    return details;
+}
+
 std::size_t PipelineController::queueSize() const {
-    return rawPacketQueue_.size();
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    std::size_t size = 0;
+    for (const CaptureInput& input : captureInputs_) {
+        size += input.queue->size();
+    }
+    return size;
+}
+
+std::size_t PipelineController::droppedCount() const {
+    return rawQueueStats().dropped + taskQueueStats().dropped;
+}
+
+packetscope::QueueStats PipelineController::rawQueueStats() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return rawQueueStatsLocked();
+}
+
+packetscope::QueueStats PipelineController::rawQueueStatsLocked() const {
+    packetscope::QueueStats stats = retiredRawQueueStats_;
+    for (const CaptureInput& input : captureInputs_) {
+        const packetscope::QueueStats ring = input.queue->stats();
+        stats.size += ring.size;
+        stats.capacity += ring.capacity;
+        stats.dropped += ring.dropped;
+        stats.highWaterMark = std::max(stats.highWaterMark, ring.highWaterMark);
+    }
+    return stats;
+}
+
+packetscope::QueueStats PipelineController::taskQueueStats() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return taskQueueStatsLocked();
+}
+
+packetscope::QueueStats PipelineController::taskQueueStatsLocked() const {
+    // The pool counts dropped tasks, the batches count the packets they held
+    packetscope::QueueStats stats = threadPool_->queueStats();
+    stats.dropped = taskQueueDroppedPackets_.load(std::memory_order_relaxed);
+    stats.highWaterMark = std::max(stats.highWaterMark, retiredTaskQueueStats_.highWaterMark);
+    return stats;
+}
+
+void PipelineController::retireThreadPoolStats() {
+    const packetscope::QueueStats stats = threadPool_->queueStats();
+    retiredTaskQueueStats_.highWaterMark = std::max(retiredTaskQueueStats_.highWaterMark, stats.highWaterMark);
+}
+
+bool PipelineController::setConfig(const packetscope::PipelineConfig& config) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+
+    if (isRunning_) {
+        spdlog::warn("PipelineController::setConfig() - Cannot change configuration while running");
+        return false;
+    }
+
+    config_ = config;
+    checkReassemblyConfig();
+    detailCache_.setCapacity(config_.detailCacheCapacity);
+    packetStore_->setSpillConfig(config_.storeSpill);
+    packetStore_->setRetentionConfig(config_.storeRetention);
+    packetStore_->setIndexing(config_.indexStore);
+
+    // The rings are only touched by the capture and dispatcher threads,
+    // both of which are stopped here. start() recreates them with the new limits.
+    retireCaptureInputStats();
+    captureInputs_.clear();
+
+    // Worker count, affinity and task queue limits are applied when the
+    // ThreadPool is recreated on start()
+    return true;
+}
+
+packetscope::PipelineConfig PipelineController::config() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return config_;
+}
+
+std::size_t PipelineController::workerCount() const {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return threadPool_->threadCount();
 }
 
 std::size_t PipelineController::capturedCount() const {
-    return packetCapture_->getCapturedPacketCount();
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    return capturedCountLocked();
+}
+
+std::size_t PipelineController::capturedCountLocked() const {
+    std::size_t count = retiredCapturedCount_;
+    for (const CaptureInput& input : captureInputs_) {
+        count += input.capture->getCapturedPacketCount();
+    }
+    if (fileReader_) {
+        count += static_cast<std::size_t>(fileReader_->packetsRead());
+    }
+    return count;
 }
 std::size_t PipelineController::processedCount() const {
     return packetStore_->count();
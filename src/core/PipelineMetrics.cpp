@@ -0,0 +1,363 @@
+#include "core/PipelineMetrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+/// Quantiles of the exported summaries
+constexpr std::array<double, 4> kExportedQuantiles{0.5, 0.9, 0.99, 0.999};
+
+constexpr std::array<packetscope::PipelineStage, packetscope::kPipelineStageCount> kStages{
+    packetscope::PipelineStage::CaptureCallback,
+    packetscope::PipelineStage::RawQueueWait,
+    packetscope::PipelineStage::TaskQueueWait,
+    packetscope::PipelineStage::Process,
+    packetscope::PipelineStage::StoreInsert
+};
+
+double toSeconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e9;
+}
+
+/**
+ * @brief Escapes a Prometheus label value.
+ */
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief Escapes a JSON string (without the quotes).
+ */
+std::string escapeJson(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fmt::format_to(std::back_inserter(escaped), "\\u{:04x}", static_cast<unsigned>(c));
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief Appends the header lines of a Prometheus metric family.
+ */
+void appendFamily(std::string& out, const char* name, const char* type, const char* help) {
+    fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void appendQueueJson(std::string& out, const packetscope::QueueStats& stats) {
+    fmt::format_to(std::back_inserter(out), R"({{"size":{},"capacity":{},"dropped":{},"highWaterMark":{}}})",
+                   stats.size, stats.capacity, stats.dropped, stats.highWaterMark);
+}
+
+void appendKernelJson(std::string& out, const packetscope::KernelCaptureStats& stats) {
+    fmt::format_to(std::back_inserter(out), R"({{"received":{},"dropped":{},"interfaceDropped":{}}})",
+                   stats.received, stats.dropped, stats.interfaceDropped);
+}
+
+}
+
+namespace packetscope {
+
+const char* pipelineStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::CaptureCallback: return "capture_callback";
+        case PipelineStage::RawQueueWait: return "raw_queue_wait";
+        case PipelineStage::TaskQueueWait: return "task_queue_wait";
+        case PipelineStage::Process: return "process";
+        case PipelineStage::StoreInsert: return "store_insert";
+    }
+    return "unknown";
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    if (bucket < kSubBucketCount) {
+        return bucket;
+    }
+    const std::size_t shift = bucket / kSubBucketCount - 1;
+    const uint64_t lower = static_cast<uint64_t>(kSubBucketCount + bucket % kSubBucketCount) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the value, 1 based: the smallest bucket covering it
+    const double clamped = std::clamp(quantile, 0.0, 1.0);
+    const auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count))), 1);
+
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < counts.size(); ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(bucket), max);
+        }
+    }
+    // The buckets were read slightly after count
+    return max;
+}
+
+double LatencyHistogram::mean() const {
+    return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t bucket = 0; bucket < counts.size() && bucket < other.counts.size(); ++bucket) {
+        counts[bucket] += other.counts[bucket];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+const LatencyHistogram& PipelineMetricsSnapshot::stage(PipelineStage stage) const {
+    return stages[static_cast<std::size_t>(stage)];
+}
+
+std::string PipelineMetricsSnapshot::toPrometheus() const {
+    std::string out;
+    auto append = std::back_inserter(out);
+
+    appendFamily(out, "packetscope_stage_latency_seconds", "summary", "Latency of the pipeline stages");
+    for (const PipelineStage stage : kStages) {
+        const LatencyHistogram& histogram = this->stage(stage);
+        const char* name = pipelineStageName(stage);
+        for (const double quantile : kExportedQuantiles) {
+            fmt::format_to(append, "packetscope_stage_latency_seconds{{stage=\"{}\",quantile=\"{}\"}} {}\n",
+                           name, quantile, toSeconds(histogram.percentile(quantile)));
+        }
+        fmt::format_to(append, "packetscope_stage_latency_seconds_sum{{stage=\"{}\"}} {}\n", name,
+                       toSeconds(histogram.sum));
+        fmt::format_to(append, "packetscope_stage_latency_seconds_count{{stage=\"{}\"}} {}\n", name, histogram.count);
+    }
+    appendFamily(out, "packetscope_stage_latency_max_seconds", "gauge", "Largest latency of the pipeline stages");
+    for (const PipelineStage stage : kStages) {
+        fmt::format_to(append, "packetscope_stage_latency_max_seconds{{stage=\"{}\"}} {}\n", pipelineStageName(stage),
+                       toSeconds(this->stage(stage).max));
+    }
+
+    appendFamily(out, "packetscope_thread_packets_total", "counter", "Packets handled per pipeline thread");
+    for (const ThreadMetricsSnapshot& thread : threads) {
+        fmt::format_to(append, "packetscope_thread_packets_total{{thread=\"{}\"}} {}\n", thread.name, thread.packets);
+    }
+    appendFamily(out, "packetscope_thread_batches_total", "counter", "Batches or tasks handled per pipeline thread");
+    for (const ThreadMetricsSnapshot& thread : threads) {
+        fmt::format_to(append, "packetscope_thread_batches_total{{thread=\"{}\"}} {}\n", thread.name, thread.batches);
+    }
+    appendFamily(out, "packetscope_thread_busy_seconds_total", "counter", "Time spent on batches per pipeline thread");
+    for (const ThreadMetricsSnapshot& thread : threads) {
+        fmt::format_to(append, "packetscope_thread_busy_seconds_total{{thread=\"{}\"}} {}\n", thread.name,
+                       toSeconds(thread.busyNs));
+    }
+
+    appendFamily(out, "packetscope_kernel_received_packets_total", "counter", "Packets the kernel passed the filter");
+    fmt::format_to(append, "packetscope_kernel_received_packets_total {}\n", kernel.received);
+    appendFamily(out, "packetscope_kernel_dropped_packets_total", "counter", "Packets dropped by the kernel socket buffer or ring");
+    fmt::format_to(append, "packetscope_kernel_dropped_packets_total {}\n", kernel.dropped);
+    appendFamily(out, "packetscope_kernel_interface_dropped_packets_total", "counter", "Packets dropped by the interface");
+    fmt::format_to(append, "packetscope_kernel_interface_dropped_packets_total {}\n", kernel.interfaceDropped);
+
+    appendFamily(out, "packetscope_capture_kernel_dropped_packets_total", "counter", "Kernel drops per capture socket");
+    for (std::size_t i = 0; i < captures.size(); ++i) {
+        fmt::format_to(append, "packetscope_capture_kernel_dropped_packets_total{{capture=\"{}\",device=\"{}\"}} {}\n",
+                       i, escapeLabel(captures[i].deviceName), captures[i].kernel.dropped);
+    }
+    appendFamily(out, "packetscope_capture_raw_queue_dropped_packets_total", "counter", "Raw ring drops per capture");
+    for (std::size_t i = 0; i < captures.size(); ++i) {
+        fmt::format_to(append, "packetscope_capture_raw_queue_dropped_packets_total{{capture=\"{}\",device=\"{}\"}} {}\n",
+                       i, escapeLabel(captures[i].deviceName), captures[i].rawQueue.dropped);
+    }
+
+    appendFamily(out, "packetscope_queue_dropped_total", "counter", "Packets dropped by the queue overflow policy");
+    fmt::format_to(append, "packetscope_queue_dropped_total{{queue=\"raw\"}} {}\n", rawQueue.dropped);
+    fmt::format_to(append, "packetscope_queue_dropped_total{{queue=\"task\"}} {}\n", taskQueue.dropped);
+    appendFamily(out, "packetscope_queue_size", "gauge", "Elements currently queued, packets (raw) or batch tasks (task)");
+    fmt::format_to(append, "packetscope_queue_size{{queue=\"raw\"}} {}\n", rawQueue.size);
+    fmt::format_to(append, "packetscope_queue_size{{queue=\"task\"}} {}\n", taskQueue.size);
+    appendFamily(out, "packetscope_queue_high_water_mark", "gauge", "Largest queue length observed, packets (raw) or batch tasks (task)");
+    fmt::format_to(append, "packetscope_queue_high_water_mark{{queue=\"raw\"}} {}\n", rawQueue.highWaterMark);
+    fmt::format_to(append, "packetscope_queue_high_water_mark{{queue=\"task\"}} {}\n", taskQueue.highWaterMark);
+
+    appendFamily(out, "packetscope_captured_packets_total", "counter", "Packets handed to the pipeline");
+    fmt::format_to(append, "packetscope_captured_packets_total {}\n", captured);
+    appendFamily(out, "packetscope_processed_packets_total", "counter", "Packets stored");
+    fmt::format_to(append, "packetscope_processed_packets_total {}\n", processed);
+    return out;
+}
+
+std::string PipelineMetricsSnapshot::toJson() const {
+    std::string out;
+    auto append = std::back_inserter(out);
+
+    fmt::format_to(append, R"({{"timestampMs":{},"captured":{},"processed":{},"stages":{{)",
+                   timestampMs, captured, processed);
+    for (std::size_t i = 0; i < kStages.size(); ++i) {
+        const LatencyHistogram& histogram = stage(kStages[i]);
+        fmt::format_to(append, R"({}"{}":{{"count":{},"sumNs":{},"meanNs":{:.1f},"maxNs":{})",
+                       i > 0 ? "," : "", pipelineStageName(kStages[i]), histogram.count, histogram.sum,
+                       histogram.mean(), histogram.max);
+        fmt::format_to(append, R"(,"p50Ns":{},"p90Ns":{},"p99Ns":{},"p999Ns":{}}})",
+                       histogram.percentile(0.5), histogram.percentile(0.9), histogram.percentile(0.99),
+                       histogram.percentile(0.999));
+    }
+
+    out += R"(},"threads":[)";
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+        const ThreadMetricsSnapshot& thread = threads[i];
+        fmt::format_to(append, R"({}{{"name":"{}","packets":{},"batches":{},"busyNs":{}}})",
+                       i > 0 ? "," : "", escapeJson(thread.name), thread.packets, thread.batches, thread.busyNs);
+    }
+
+    out += R"(],"captures":[)";
+    for (std::size_t i = 0; i < captures.size(); ++i) {
+        const CaptureMetrics& capture = captures[i];
+        fmt::format_to(append, R"({}{{"device":"{}","captured":{},"kernel":)",
+                       i > 0 ? "," : "", escapeJson(capture.deviceName), capture.captured);
+        appendKernelJson(out, capture.kernel);
+        out += R"(,"rawQueue":)";
+        appendQueueJson(out, capture.rawQueue);
+        out += '}';
+    }
+
+    out += R"(],"kernel":)";
+    appendKernelJson(out, kernel);
+    out += R"(,"rawQueue":)";
+    appendQueueJson(out, rawQueue);
+    out += R"(,"taskQueue":)";
+    appendQueueJson(out, taskQueue);
+    out += "}\n";
+    return out;
+}
+
+}
+
+ThreadMetrics::ThreadMetrics(std::string name)
+    : name_(std::move(name)) {
+    reset();
+}
+
+packetscope::ThreadMetricsSnapshot ThreadMetrics::snapshot() const {
+    packetscope::ThreadMetricsSnapshot snapshot;
+    snapshot.name = name_;
+    snapshot.packets = packets_.load(std::memory_order_relaxed);
+    snapshot.batches = batches_.load(std::memory_order_relaxed);
+    snapshot.busyNs = busyNs_.load(std::memory_order_relaxed);
+    for (std::size_t stage = 0; stage < recorders_.size(); ++stage) {
+        const Recorder& recorder = recorders_[stage];
+        snapshot.stages[stage] = packetscope::StageTotals{recorder.count.load(std::memory_order_relaxed),
+                                                          recorder.sum.load(std::memory_order_relaxed),
+                                                          recorder.max.load(std::memory_order_relaxed)};
+    }
+    return snapshot;
+}
+
+void ThreadMetrics::mergeInto(std::array<packetscope::LatencyHistogram, packetscope::kPipelineStageCount>& stages) const {
+    for (std::size_t stage = 0; stage < recorders_.size(); ++stage) {
+        const Recorder& recorder = recorders_[stage];
+        packetscope::LatencyHistogram& histogram = stages[stage];
+
+        // Nothing recorded: skip the bucket walk, most threads feed only some stages
+        const uint64_t count = recorder.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        for (std::size_t bucket = 0; bucket < recorder.counts.size(); ++bucket) {
+            histogram.counts[bucket] += recorder.counts[bucket].load(std::memory_order_relaxed);
+        }
+        histogram.count += count;
+        histogram.sum += recorder.sum.load(std::memory_order_relaxed);
+        histogram.max = std::max(histogram.max, recorder.max.load(std::memory_order_relaxed));
+    }
+}
+
+void ThreadMetrics::reset() {
+    for (Recorder& recorder : recorders_) {
+        for (std::atomic<uint64_t>& count : recorder.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        recorder.count.store(0, std::memory_order_relaxed);
+        recorder.sum.store(0, std::memory_order_relaxed);
+        recorder.max.store(0, std::memory_order_relaxed);
+    }
+    packets_.store(0, std::memory_order_relaxed);
+    batches_.store(0, std::memory_order_relaxed);
+    busyNs_.store(0, std::memory_order_relaxed);
+}
+
+PipelineMetrics::PipelineMetrics()
+    : dispatcher_(std::make_unique<ThreadMetrics>("dispatcher")) {}
+
+void PipelineMetrics::resize(std::size_t captureCount, std::size_t workerCount) {
+    while (captures_.size() < captureCount) {
+        captures_.push_back(std::make_unique<ThreadMetrics>(fmt::format("capture-{}", captures_.size())));
+    }
+    while (workers_.size() < workerCount) {
+        workers_.push_back(std::make_unique<ThreadMetrics>(fmt::format("worker-{}", workers_.size())));
+    }
+}
+
+ThreadMetrics* PipelineMetrics::capture(std::size_t index) const {
+    return index < captures_.size() ? captures_[index].get() : nullptr;
+}
+
+ThreadMetrics* PipelineMetrics::worker(std::size_t index) const {
+    return index < workers_.size() ? workers_[index].get() : nullptr;
+}
+
+ThreadMetrics& PipelineMetrics::dispatcher() const {
+    return *dispatcher_;
+}
+
+void PipelineMetrics::collect(packetscope::PipelineMetricsSnapshot& snapshot) const {
+    snapshot.threads.reserve(snapshot.threads.size() + captures_.size() + 1 + workers_.size());
+
+    auto add = [&snapshot](const ThreadMetrics& metrics) {
+        metrics.mergeInto(snapshot.stages);
+        snapshot.threads.push_back(metrics.snapshot());
+    };
+    for (const auto& metrics : captures_) {
+        add(*metrics);
+    }
+    add(*dispatcher_);
+    for (const auto& metrics : workers_) {
+        add(*metrics);
+    }
+}
+
+void PipelineMetrics::reset() {
+    dispatcher_->reset();
+    for (const auto& metrics : captures_) {
+        metrics->reset();
+    }
+    for (const auto& metrics : workers_) {
+        metrics->reset();
+    }
+}
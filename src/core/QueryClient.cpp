@@ -0,0 +1,228 @@
+#include "core/QueryClient.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+std::unique_ptr<QueryClient> QueryClient::connect(const std::string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        spdlog::error("QueryClient::connect() - Invalid socket path '{}'", socketPath);
+        return nullptr;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        spdlog::error("QueryClient::connect() - Cannot connect to '{}': {}", socketPath, std::strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<QueryClient> client(new QueryClient(fd));
+    const uint32_t version = packetscope::kQueryProtocolVersion;
+    packetscope::QueryHeader reply;
+    if (!client->call(packetscope::QueryType::Hello, &version, sizeof(version), reply)) {
+        spdlog::error("QueryClient::connect() - '{}' refused: {}", socketPath, client->lastError());
+        return nullptr;
+    }
+    uint32_t serverVersion = 0;
+    if (reply.length != sizeof(serverVersion) || !client->receiveAll(&serverVersion, sizeof(serverVersion))) {
+        spdlog::error("QueryClient::connect() - Invalid reply from '{}'", socketPath);
+        return nullptr;
+    }
+    return client;
+}
+
+QueryClient::QueryClient(int fd)
+    : fd_(fd) {}
+
+QueryClient::~QueryClient() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+std::optional<packetscope::QueryStatusReply> QueryClient::status() {
+    packetscope::QueryHeader reply;
+    if (!call(packetscope::QueryType::Status, nullptr, 0, reply)) {
+        return std::nullopt;
+    }
+
+    packetscope::QueryStatusReply status;
+    if (reply.length != sizeof(status)) {
+        fail("Unexpected status reply size");
+        return std::nullopt;
+    }
+    if (!receiveAll(&status, sizeof(status))) {
+        return std::nullopt;
+    }
+    return status;
+}
+
+bool QueryClient::packets(int firstId, uint32_t count, std::vector<packetscope::QueryPacketRecord>& records) {
+    const packetscope::QueryRangeRequest request{firstId, count};
+    packetscope::QueryHeader reply;
+    if (!call(packetscope::QueryType::Packets, &request, sizeof(request), reply)) {
+        return false;
+    }
+    if (reply.length % sizeof(packetscope::QueryPacketRecord) != 0) {
+        return fail("Unexpected packets reply size");
+    }
+
+    // Received in place, the vector is the receive buffer
+    records.resize(reply.length / sizeof(packetscope::QueryPacketRecord));
+    return receiveAll(records.data(), reply.length);
+}
+
+bool QueryClient::packetData(int firstId, uint32_t count, std::vector<PacketData>& packets) {
+    packets.clear();
+
+    const packetscope::QueryRangeRequest request{firstId, count};
+    packetscope::QueryHeader reply;
+    if (!call(packetscope::QueryType::PacketData, &request, sizeof(request), reply)) {
+        return false;
+    }
+    packetBuffer_.resize(reply.length);
+    if (!receiveAll(packetBuffer_.data(), packetBuffer_.size())) {
+        return false;
+    }
+
+    // Each record is followed by its bytes, which stay in the buffer
+    std::size_t offset = 0;
+    while (offset < packetBuffer_.size()) {
+        PacketData packet;
+        if (packetBuffer_.size() - offset < sizeof(packet.record)) {
+            return fail("Truncated packet data reply");
+        }
+        std::memcpy(&packet.record, packetBuffer_.data() + offset, sizeof(packet.record));
+        offset += sizeof(packet.record);
+
+        const auto size = static_cast<std::size_t>(packet.record.rawDataLen);
+        if (packet.record.rawDataLen < 0 || packetBuffer_.size() - offset < size) {
+            return fail("Truncated packet data reply");
+        }
+        packet.data = packetBuffer_.data() + offset;
+        offset += size;
+        packets.push_back(packet);
+    }
+    return true;
+}
+
+bool QueryClient::filter(const std::string& expression, int firstId, int lastId, std::vector<int>& ids) {
+    const packetscope::QueryFilterRequest request{firstId, lastId};
+    packetscope::QueryHeader reply;
+    if (!call(packetscope::QueryType::Filter, &request, sizeof(request), reply, expression)) {
+        return false;
+    }
+    if (reply.length % sizeof(int) != 0) {
+        return fail("Unexpected filter reply size");
+    }
+
+    ids.resize(reply.length / sizeof(int));
+    return receiveAll(ids.data(), reply.length);
+}
+
+const std::string& QueryClient::lastError() const {
+    return lastError_;
+}
+
+bool QueryClient::call(packetscope::QueryType type, const void* payload, std::size_t size,
+                       packetscope::QueryHeader& reply, const std::string& trailer) {
+    if (fd_ < 0) {
+        lastError_ = "Not connected";
+        return false;
+    }
+    if (size + trailer.size() > packetscope::kMaxQueryRequestSize) {
+        lastError_ = "Request too large";
+        return false;
+    }
+
+    packetscope::QueryHeader header;
+    header.length = static_cast<uint32_t>(size + trailer.size());
+    header.type = type;
+    const bool isSent = sendAll(&header, sizeof(header)) && sendAll(payload, size)
+        && sendAll(trailer.data(), trailer.size());
+    // A server refusing the client (Busy) replies and closes without reading, the reply explains the failed send
+    if (!receiveAll(&reply, sizeof(reply))) {
+        return false;
+    }
+    if (reply.type != type && isSent) {
+        return fail("Reply to a different request");
+    }
+
+    if (reply.status != packetscope::QueryStatus::Ok) {
+        if (reply.length > packetscope::kMaxQueryRequestSize) {
+            return fail("Error reply too large");
+        }
+        std::string message(reply.length, '\0');
+        if (!receiveAll(message.data(), message.size())) {
+            return false;
+        }
+        if (reply.status == packetscope::QueryStatus::VersionMismatch && message.size() == sizeof(uint32_t)) {
+            uint32_t serverVersion = 0;
+            std::memcpy(&serverVersion, message.data(), sizeof(serverVersion));
+            message = "Server speaks protocol version " + std::to_string(serverVersion);
+        }
+        lastError_ = message;
+        return isSent ? false : fail(message);
+    }
+    if (!isSent) {
+        return fail(lastError_);
+    }
+    return true;
+}
+
+bool QueryClient::sendAll(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t sent = send(fd_, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Not closed yet, call() still reads a reply the server may have sent
+            lastError_ = std::string("Send failed: ") + std::strerror(errno);
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool QueryClient::receiveAll(void* data, std::size_t size) {
+    auto* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t received = recv(fd_, bytes, size, 0);
+        if (received == 0) {
+            return fail("Connection closed by the daemon");
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail(std::string("Receive failed: ") + std::strerror(errno));
+        }
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+bool QueryClient::fail(const std::string& error) {
+    lastError_ = error;
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    return false;
+}
@@ -0,0 +1,458 @@
+#include "core/QueryServer.hpp"
+
+#include "core/CpuAffinity.hpp"
+#include "core/DisplayFilter.hpp"
+#include "core/PacketStore.hpp"
+#include "core/PipelineController.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <limits>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+static_assert(sizeof(int) == sizeof(int32_t), "Filter replies send the IDs as they are");
+
+/**
+ * @brief Fills a record from a PacketView (no index) or a row of PacketColumns (index i).
+ */
+template <typename Source, typename... Index>
+packetscope::QueryPacketRecord makeRecord(int id, const Source& source, Index... index) {
+    packetscope::QueryPacketRecord record;
+    const timespec& timestamp = source.timestamp(index...);
+    const packetscope::PacketAddress& srcAddr = source.srcAddr(index...);
+    const packetscope::PacketAddress& dstAddr = source.dstAddr(index...);
+
+    record.seconds = static_cast<int64_t>(timestamp.tv_sec);
+    record.protocol = static_cast<uint64_t>(source.protocol(index...));
+    record.id = id;
+    record.nanoseconds = static_cast<uint32_t>(timestamp.tv_nsec);
+    record.rawDataLen = source.rawDataLen(index...);
+    record.frameLength = source.frameLength(index...);
+    record.srcAddr = srcAddr.bytes;
+    record.dstAddr = dstAddr.bytes;
+    record.linkLayerType = static_cast<uint16_t>(source.linkLayerType(index...));
+    record.srcPort = source.srcPort(index...);
+    record.dstPort = source.dstPort(index...);
+    record.ipProtocol = source.ipProtocol(index...);
+    record.srcFamily = srcAddr.family;
+    record.dstFamily = dstAddr.family;
+    return record;
+}
+
+/**
+ * @brief Clips [firstId, firstId + count) to the retained IDs and at most maxCount packets.
+ * @return false if nothing of the range is stored
+ */
+bool clipRange(const PacketStore& store, const packetscope::QueryRangeRequest& request, uint32_t maxCount,
+               int& firstId, int& lastId) {
+    const int64_t first = std::max<int64_t>(request.firstId, store.firstId());
+    const int64_t last = std::min<int64_t>(int64_t{request.firstId} + std::min(request.count, maxCount) - 1,
+                                           static_cast<int64_t>(store.count()));
+    if (first > last) {
+        return false;
+    }
+    firstId = static_cast<int>(first);
+    lastId = static_cast<int>(last);
+    return true;
+}
+
+/**
+ * @brief Writes every buffer of iov, continuing after partial writes.
+ */
+bool sendAll(int fd, std::vector<iovec>& iov) {
+    std::size_t index = 0;
+    while (index < iov.size()) {
+        msghdr message{};
+        message.msg_iov = iov.data() + index;
+        message.msg_iovlen = std::min<std::size_t>(iov.size() - index, IOV_MAX);
+
+        const ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        // Skip what was sent, the first buffer not sent completely starts later
+        auto remaining = static_cast<std::size_t>(sent);
+        while (index < iov.size() && remaining >= iov[index].iov_len) {
+            remaining -= iov[index].iov_len;
+            ++index;
+        }
+        if (remaining > 0) {
+            iov[index].iov_base = static_cast<uint8_t*>(iov[index].iov_base) + remaining;
+            iov[index].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns true if another process accepts connections on the socket path.
+ */
+bool isSocketServed(const sockaddr_un& address) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    const bool isServed = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    close(fd);
+    return isServed;
+}
+
+}
+
+std::unique_ptr<QueryServer> QueryServer::start(const packetscope::QueryServerConfig& config,
+                                                PipelineController& controller) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (config.socketPath.empty() || config.socketPath.size() >= sizeof(address.sun_path)) {
+        spdlog::error("QueryServer::start() - Invalid socket path '{}'", config.socketPath);
+        return nullptr;
+    }
+    std::memcpy(address.sun_path, config.socketPath.c_str(), config.socketPath.size() + 1);
+
+    if (isSocketServed(address)) {
+        spdlog::error("QueryServer::start() - '{}' is served by another process", config.socketPath);
+        return nullptr;
+    }
+    // A daemon that was killed leaves its socket file behind
+    unlink(config.socketPath.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || listen(fd, SOMAXCONN) != 0) {
+        spdlog::error("QueryServer::start() - Cannot listen on '{}': {}", config.socketPath, std::strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<QueryServer> server(new QueryServer(config, fd, controller));
+    server->acceptThread_ = std::thread([self = server.get()] { self->acceptLoop(); });
+    spdlog::info("QueryServer::start() - Serving on '{}'", config.socketPath);
+    return server;
+}
+
+QueryServer::QueryServer(packetscope::QueryServerConfig config, int listenFd, PipelineController& controller)
+    : config_(std::move(config))
+    , listenFd_(listenFd)
+    , controller_(controller) {}
+
+QueryServer::~QueryServer() {
+    isStopRequested_ = true;
+    if (acceptThread_.joinable()) {
+        acceptThread_.join();
+    }
+
+    for (Connection& connection : connections_) {
+        // Also wakes a thread blocked sending to a client that stopped reading
+        shutdown(connection.fd, SHUT_RDWR);
+        connection.thread.join();
+        close(connection.fd);
+    }
+    connections_.clear();
+
+    close(listenFd_);
+    unlink(config_.socketPath.c_str());
+    spdlog::info("QueryServer::~QueryServer() - Stopped serving on '{}'", config_.socketPath);
+}
+
+std::size_t QueryServer::clientCount() const {
+    return clientCount_.load(std::memory_order_relaxed);
+}
+
+void QueryServer::acceptLoop() {
+    if (!CpuAffinity::pinCurrentThread(config_.cpus)) {
+        spdlog::warn("QueryServer::acceptLoop() - Failed to pin accept thread");
+    }
+
+    pollfd descriptor{};
+    descriptor.fd = listenFd_;
+    descriptor.events = POLLIN;
+
+    while (!isStopRequested_) {
+        // Clients close their fd only here, after joining, so shutdown() never hits a reused fd
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if (it->isFinished.load(std::memory_order_acquire)) {
+                it->thread.join();
+                close(it->fd);
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (poll(&descriptor, 1, kPollTimeoutMs) <= 0) {
+            continue;
+        }
+        const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                spdlog::warn("QueryServer::acceptLoop() - accept() failed: {}", std::strerror(errno));
+            }
+            continue;
+        }
+
+        // Finished connections may not be joined yet, count the live ones
+        const std::size_t clientCount = clientCount_.load(std::memory_order_relaxed);
+        if (clientCount >= config_.maxClients) {
+            spdlog::warn("QueryServer::acceptLoop() - Refusing client, {} connected", clientCount);
+            sendError(fd, packetscope::QueryType::Hello, packetscope::QueryStatus::Busy, "Client limit reached");
+            close(fd);
+            continue;
+        }
+
+        Connection& connection = connections_.emplace_back();
+        connection.fd = fd;
+        clientCount_.fetch_add(1, std::memory_order_relaxed);
+        connection.thread = std::thread([this, &connection] { serve(connection); });
+    }
+}
+
+void QueryServer::serve(Connection& connection) {
+    if (!CpuAffinity::pinCurrentThread(config_.cpus)) {
+        spdlog::warn("QueryServer::serve() - Failed to pin client thread");
+    }
+    spdlog::info("QueryServer::serve() - Client connected");
+
+    packetscope::QueryHeader header;
+    std::vector<uint8_t> payload;
+    bool isGreeted = false;
+    while (receive(connection.fd, &header, sizeof(header))) {
+        if (header.length > packetscope::kMaxQueryRequestSize) {
+            sendError(connection.fd, header.type, packetscope::QueryStatus::BadRequest, "Request too large");
+            break;
+        }
+        payload.resize(header.length);
+        if (!receive(connection.fd, payload.data(), payload.size())
+            || !handleRequest(connection.fd, header, payload, isGreeted)) {
+            break;
+        }
+    }
+
+    spdlog::info("QueryServer::serve() - Client disconnected");
+    clientCount_.fetch_sub(1, std::memory_order_relaxed);
+    connection.isFinished.store(true, std::memory_order_release);
+}
+
+bool QueryServer::receive(int fd, void* data, std::size_t size) const {
+    auto* bytes = static_cast<uint8_t*>(data);
+
+    pollfd descriptor{};
+    descriptor.fd = fd;
+    descriptor.events = POLLIN;
+
+    while (size > 0) {
+        if (isStopRequested_) {
+            return false;
+        }
+        const int ready = poll(&descriptor, 1, kPollTimeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        const ssize_t received = recv(fd, bytes, size, 0);
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+bool QueryServer::handleRequest(int fd, const packetscope::QueryHeader& header, const std::vector<uint8_t>& payload,
+                                bool& isGreeted) {
+    using packetscope::QueryStatus;
+    using packetscope::QueryType;
+
+    if (header.type == QueryType::Hello) {
+        uint32_t version = 0;
+        if (payload.size() != sizeof(version)) {
+            return sendError(fd, header.type, QueryStatus::BadRequest, "Hello carries the protocol version");
+        }
+        std::memcpy(&version, payload.data(), sizeof(version));
+
+        isGreeted = version == packetscope::kQueryProtocolVersion;
+        const uint32_t serverVersion = packetscope::kQueryProtocolVersion;
+        return sendReply(fd, header.type, isGreeted ? QueryStatus::Ok : QueryStatus::VersionMismatch,
+                         &serverVersion, sizeof(serverVersion));
+    }
+    if (!isGreeted) {
+        return sendError(fd, header.type, QueryStatus::NotReady, "Send Hello first");
+    }
+
+    switch (header.type) {
+        case QueryType::Status:
+            if (!payload.empty()) {
+                break;
+            }
+            return sendStatus(fd);
+
+        case QueryType::Packets:
+        case QueryType::PacketData: {
+            if (payload.size() != sizeof(packetscope::QueryRangeRequest)) {
+                break;
+            }
+            packetscope::QueryRangeRequest request;
+            std::memcpy(&request, payload.data(), sizeof(request));
+            return header.type == QueryType::Packets ? sendPackets(fd, request) : sendPacketData(fd, request);
+        }
+
+        case QueryType::Filter: {
+            if (payload.size() < sizeof(packetscope::QueryFilterRequest)) {
+                break;
+            }
+            packetscope::QueryFilterRequest request;
+            std::memcpy(&request, payload.data(), sizeof(request));
+            const std::string expression(payload.begin() + sizeof(request), payload.end());
+            return sendFilterMatches(fd, request, expression);
+        }
+
+        default:
+            return sendError(fd, header.type, QueryStatus::UnknownType, "Unknown request type");
+    }
+    return sendError(fd, header.type, QueryStatus::BadRequest, "Unexpected payload size");
+}
+
+bool QueryServer::sendStatus(int fd) {
+    const std::shared_ptr<PacketStore> store = controller_.getStore();
+    const packetscope::PipelineMetricsSnapshot metrics = controller_.metrics();
+    const packetscope::StoreMemoryStats memory = store->memoryStats();
+
+    packetscope::QueryStatusReply reply;
+    reply.storedCount = store->count();
+    reply.firstId = static_cast<uint64_t>(store->firstId());
+    reply.capturedCount = metrics.captured;
+    reply.processedCount = metrics.processed;
+    reply.rawQueueDropped = metrics.rawQueue.dropped;
+    reply.taskQueueDropped = metrics.taskQueue.dropped;
+    reply.kernelReceived = metrics.kernel.received;
+    reply.kernelDropped = metrics.kernel.dropped;
+    reply.interfaceDropped = metrics.kernel.interfaceDropped;
+    reply.rawBytesInMemory = memory.rawBytesInMemory;
+    reply.rawBytesSpilled = memory.rawBytesSpilled;
+    reply.isRunning = controller_.isRunning() ? 1 : 0;
+    reply.workerCount = static_cast<uint32_t>(controller_.workerCount());
+    return sendReply(fd, packetscope::QueryType::Status, packetscope::QueryStatus::Ok, &reply, sizeof(reply));
+}
+
+bool QueryServer::sendPackets(int fd, const packetscope::QueryRangeRequest& request) {
+    const std::shared_ptr<PacketStore> store = controller_.getStore();
+    std::vector<packetscope::QueryPacketRecord> records;
+
+    int firstId = 0;
+    int lastId = 0;
+    if (clipRange(*store, request, packetscope::kMaxQueryPackets, firstId, lastId)) {
+        records.reserve(static_cast<std::size_t>(lastId - firstId + 1));
+        // Straight from the columns, like the packet list's filter pass
+        store->scan(firstId, lastId, [&records](const PacketColumns& columns) {
+            for (std::size_t i = 0; i < columns.size(); ++i) {
+                if (columns.isStored(i)) {
+                    records.push_back(makeRecord(columns.firstId() + static_cast<int>(i), columns, i));
+                }
+            }
+        });
+    }
+    return sendReply(fd, packetscope::QueryType::Packets, packetscope::QueryStatus::Ok, records.data(),
+                     records.size() * sizeof(packetscope::QueryPacketRecord));
+}
+
+bool QueryServer::sendPacketData(int fd, const packetscope::QueryRangeRequest& request) {
+    const std::shared_ptr<PacketStore> store = controller_.getStore();
+    std::vector<packetscope::QueryPacketRecord> records;
+    // References keep the bytes alive (and spilled ones loaded) until they are sent
+    std::vector<packetscope::PacketBuffer> buffers;
+
+    int firstId = 0;
+    int lastId = 0;
+    if (clipRange(*store, request, packetscope::kMaxQueryPacketData, firstId, lastId)) {
+        for (int id = firstId; id <= lastId; ++id) {
+            store->visit(id, [&records, &buffers](const PacketView& view) {
+                records.push_back(makeRecord(view.id(), view));
+                buffers.push_back(view.rawData());
+            });
+        }
+    }
+
+    packetscope::QueryHeader header;
+    header.type = packetscope::QueryType::PacketData;
+
+    std::vector<iovec> iov;
+    iov.reserve(1 + 2 * records.size());
+    iov.push_back(iovec{&header, sizeof(header)});
+    std::size_t length = 0;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const std::size_t size = std::min(static_cast<std::size_t>(std::max(records[i].rawDataLen, 0)),
+                                          buffers[i].size());
+        records[i].rawDataLen = static_cast<int32_t>(size);
+        iov.push_back(iovec{&records[i], sizeof(records[i])});
+        iov.push_back(iovec{const_cast<uint8_t*>(buffers[i].data()), size});
+        length += sizeof(records[i]) + size;
+    }
+    header.length = static_cast<uint32_t>(length);
+    return sendAll(fd, iov);
+}
+
+bool QueryServer::sendFilterMatches(int fd, const packetscope::QueryFilterRequest& request,
+                                    const std::string& expression) {
+    const std::shared_ptr<const DisplayFilter> filter = DisplayFilter::compile(expression);
+    if (!filter) {
+        return sendError(fd, packetscope::QueryType::Filter, packetscope::QueryStatus::InvalidFilter,
+                         "Invalid display filter: " + expression);
+    }
+
+    const std::shared_ptr<PacketStore> store = controller_.getStore();
+    const int firstId = std::max(request.firstId, store->firstId());
+    const int lastId = static_cast<int>(std::min<int64_t>(request.lastId, static_cast<int64_t>(store->count())));
+
+    std::vector<int> ids;
+    if (firstId <= lastId) {
+        ids = filter->filter(*store, firstId, lastId, config_.filterThreads);
+    }
+    return sendReply(fd, packetscope::QueryType::Filter, packetscope::QueryStatus::Ok, ids.data(),
+                     ids.size() * sizeof(int));
+}
+
+bool QueryServer::sendError(int fd, packetscope::QueryType type, packetscope::QueryStatus status,
+                            const std::string& message) {
+    return sendReply(fd, type, status, message.data(), message.size());
+}
+
+bool QueryServer::sendReply(int fd, packetscope::QueryType type, packetscope::QueryStatus status,
+                            const void* payload, std::size_t size) {
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        return sendError(fd, type, packetscope::QueryStatus::BadRequest, "Reply too large, narrow the range");
+    }
+
+    packetscope::QueryHeader header;
+    header.length = static_cast<uint32_t>(size);
+    header.type = type;
+    header.status = status;
+
+    std::vector<iovec> iov{iovec{&header, sizeof(header)}, iovec{const_cast<void*>(payload), size}};
+    return sendAll(fd, iov);
+}
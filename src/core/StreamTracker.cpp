@@ -0,0 +1,71 @@
+#include "core/StreamTracker.hpp"
+
+#include <algorithm>
+
+StreamTracker::StreamTracker(std::size_t shardCount, const packetscope::ReassemblyLimits& limits) {
+    reshard(shardCount, limits);
+}
+
+std::optional<packetscope::TcpStream> StreamTracker::stream(const packetscope::FlowKey& key) const {
+    // The shard FlowAffine dispatch sends the flow to
+    const Shard& shard = *shards_[static_cast<std::size_t>(key.hash() % shards_.size())];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.reassembler->stream(key);
+}
+
+std::size_t StreamTracker::streamCount() const {
+    std::size_t count = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->reassembler->streamCount();
+    }
+    return count;
+}
+
+std::size_t StreamTracker::bytes() const {
+    return totalBytes_.load(std::memory_order_relaxed);
+}
+
+packetscope::ReassemblyStats StreamTracker::stats() const {
+    packetscope::ReassemblyStats stats;
+    stats.evictedStreams = retiredEvicted_;
+    stats.refusedStreams = retiredRefused_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.streams += shard->reassembler->streamCount();
+        stats.evictedStreams += shard->reassembler->evictedCount();
+        stats.refusedStreams += shard->reassembler->refusedCount();
+    }
+    stats.bytes = bytes();
+    return stats;
+}
+
+void StreamTracker::clear() {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->reassembler->clear();
+    }
+    retiredEvicted_ = 0;
+    retiredRefused_ = 0;
+}
+
+void StreamTracker::reshard(std::size_t shardCount, const packetscope::ReassemblyLimits& limits) {
+    const std::size_t count = std::max(shardCount, std::size_t{1});
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<TcpReassembler*> reassemblers;
+    shards.reserve(count);
+    reassemblers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        shards.push_back(std::make_unique<Shard>(limits, totalBytes_, count));
+        reassemblers.push_back(shards.back()->reassembler.get());
+    }
+
+    // Flows keep their stream across a restart with a different worker count
+    for (const auto& shard : shards_) {
+        shard->reassembler->moveStreamsTo(reassemblers);
+        retiredEvicted_ += shard->reassembler->evictedCount();
+        retiredRefused_ += shard->reassembler->refusedCount();
+    }
+    shards_ = std::move(shards);
+}
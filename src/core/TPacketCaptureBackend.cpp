@@ -0,0 +1,400 @@
+#include "core/TPacketCaptureBackend.hpp"
+#include "core/CpuAffinity.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include <pcap.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+
+/**
+ * Shared by the backend and every block lent to the pipeline: refs counts
+ * the backend (until stop()) plus each held block, the last one unmaps the
+ * ring and closes the socket.
+ */
+struct TPacketRing {
+    /**
+     * A block handed over by the kernel stays held until every frame handle
+     * into it and the capture thread's own guard reference are gone.
+     */
+    struct Block {
+        TPacketRing* ring{nullptr};
+        tpacket_block_desc* descriptor{nullptr};
+        std::atomic<uint32_t> outstanding{0};   ///< Live frame handles + 1 while delivering
+        std::atomic<bool> isHeld{false};        ///< Cleared after the block went back to the kernel
+        std::unique_ptr<packetscope::BufferHeader[]> frames;
+        std::size_t frameCapacity{0};
+    };
+
+    int socketFd{-1};
+    uint8_t* map{nullptr};
+    std::size_t mapSize{0};
+    std::size_t blockCount{0};
+    std::unique_ptr<Block[]> blocks;
+    pcpp::LinkLayerType linkLayerType{pcpp::LINKTYPE_ETHERNET};
+    std::atomic<uint32_t> refs{1};
+
+    ~TPacketRing() {
+        if (map) {
+            munmap(map, mapSize);
+        }
+        if (socketFd >= 0) {
+            close(socketFd);
+        }
+    }
+};
+
+namespace {
+
+/// Back off while the next block is still held by the pipeline (the kernel reports it readable)
+constexpr std::chrono::microseconds kHeldBlockBackoff{50};
+
+void releaseRing(TPacketRing* ring) {
+    if (ring->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete ring;
+    }
+}
+
+void releaseBlock(TPacketRing::Block& block) {
+    if (block.outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // Hand the block back first; isHeld is what tells the capture thread the status can be trusted again
+    TPacketRing* ring = block.ring;
+    __atomic_store_n(&block.descriptor->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block.isHeld.store(false, std::memory_order_release);
+    releaseRing(ring);
+}
+
+void releaseFrame(packetscope::BufferHeader* header) {
+    releaseBlock(*static_cast<TPacketRing::Block*>(header->owner));
+}
+
+pcpp::LinkLayerType toLinkLayerType(unsigned short hardwareType) {
+    switch (hardwareType) {
+        case ARPHRD_ETHER:
+        case ARPHRD_LOOPBACK:
+            return pcpp::LINKTYPE_ETHERNET;
+        case ARPHRD_NONE:
+        case ARPHRD_PPP:
+            // No link header on SOCK_RAW (tun, ppp)
+            return pcpp::LINKTYPE_RAW;
+        default:
+            spdlog::warn("TPacketCaptureBackend::start() - Unknown hardware type {}, assuming Ethernet",
+                         hardwareType);
+            return pcpp::LINKTYPE_ETHERNET;
+    }
+}
+
+}
+
+TPacketCaptureBackend::TPacketCaptureBackend(packetscope::TPacketRingConfig ringConfig)
+    : ringConfig_(ringConfig) {}
+
+TPacketCaptureBackend::~TPacketCaptureBackend() {
+    stop();
+}
+
+bool TPacketCaptureBackend::start(const std::string& deviceName, const Options& options, FrameHandler handler) {
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    if (ringConfig_.blockCount == 0 || ringConfig_.blockSize < kFrameSize
+        || ringConfig_.blockSize % pageSize != 0 || ringConfig_.blockSize % kFrameSize != 0) {
+        spdlog::error("TPacketCaptureBackend::start() - Invalid ring of {} blocks of {} bytes",
+                      ringConfig_.blockCount, ringConfig_.blockSize);
+        return false;
+    }
+
+    const unsigned interfaceIndex = if_nametoindex(deviceName.c_str());
+    if (interfaceIndex == 0) {
+        spdlog::error("TPacketCaptureBackend::start() - Device '{}' doesn't exist", deviceName);
+        return false;
+    }
+
+    // Protocol 0: nothing is received until bind(), after the filter is attached
+    auto ring = std::make_unique<TPacketRing>();
+    ring->socketFd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (ring->socketFd < 0) {
+        spdlog::error("TPacketCaptureBackend::start() - Cannot open packet socket for '{}'", deviceName);
+        return false;
+    }
+
+    ifreq interfaceRequest{};
+    std::strncpy(interfaceRequest.ifr_name, deviceName.c_str(), IFNAMSIZ - 1);
+    if (ioctl(ring->socketFd, SIOCGIFHWADDR, &interfaceRequest) == 0) {
+        ring->linkLayerType = toLinkLayerType(interfaceRequest.ifr_hwaddr.sa_family);
+    }
+    dataLinkType_ = ring->linkLayerType == pcpp::LINKTYPE_RAW ? DLT_RAW : DLT_EN10MB;
+    snapLength_ = options.filter.snapLength;
+
+    if (!attachFilter(ring->socketFd, options.filter.expression)) {
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(ring->socketFd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        spdlog::error("TPacketCaptureBackend::start() - TPACKET_V3 is not supported");
+        return false;
+    }
+
+    tpacket_req3 request{};
+    request.tp_block_size = static_cast<unsigned>(ringConfig_.blockSize);
+    request.tp_block_nr = static_cast<unsigned>(ringConfig_.blockCount);
+    request.tp_frame_size = kFrameSize;
+    request.tp_frame_nr = static_cast<unsigned>(ringConfig_.blockSize / kFrameSize * ringConfig_.blockCount);
+    request.tp_retire_blk_tov = static_cast<unsigned>(ringConfig_.blockTimeout.count());
+    if (setsockopt(ring->socketFd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0) {
+        spdlog::error("TPacketCaptureBackend::start() - Cannot create a ring of {} blocks of {} bytes on '{}'",
+                      ringConfig_.blockCount, ringConfig_.blockSize, deviceName);
+        return false;
+    }
+
+    ring->mapSize = ringConfig_.blockSize * ringConfig_.blockCount;
+    void* map = mmap(nullptr, ring->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, ring->socketFd, 0);
+    if (map == MAP_FAILED) {
+        spdlog::error("TPacketCaptureBackend::start() - Cannot map the ring of '{}'", deviceName);
+        return false;
+    }
+    ring->map = static_cast<uint8_t*>(map);
+
+    sockaddr_ll address{};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = static_cast<int>(interfaceIndex);
+    if (bind(ring->socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        spdlog::error("TPacketCaptureBackend::start() - Cannot bind to '{}'", deviceName);
+        return false;
+    }
+
+    packet_mreq membership{};
+    membership.mr_ifindex = static_cast<int>(interfaceIndex);
+    membership.mr_type = PACKET_MR_PROMISC;
+    if (setsockopt(ring->socketFd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+        spdlog::warn("TPacketCaptureBackend::start() - Cannot enable promiscuous mode on '{}'", deviceName);
+    }
+
+    if (options.fanout && !joinFanoutGroup(ring->socketFd, *options.fanout)) {
+        spdlog::error("TPacketCaptureBackend::start() - Cannot join fanout group {} on '{}'",
+                      options.fanout->id, deviceName);
+        return false;
+    }
+
+    ring->blockCount = ringConfig_.blockCount;
+    ring->blocks = std::make_unique<TPacketRing::Block[]>(ring->blockCount);
+    for (std::size_t i = 0; i < ring->blockCount; ++i) {
+        ring->blocks[i].ring = ring.get();
+        ring->blocks[i].descriptor = reinterpret_cast<tpacket_block_desc*>(ring->map + i * ringConfig_.blockSize);
+    }
+
+    ring_ = ring.release();
+    handler_ = std::move(handler);
+    isStopRequested_ = false;
+    stats_ = packetscope::KernelCaptureStats{};
+    captureThread_ = std::thread(&TPacketCaptureBackend::captureLoop, this, options.threadCpus);
+    return true;
+}
+
+void TPacketCaptureBackend::stop() {
+    if (!ring_) {
+        return;
+    }
+
+    isStopRequested_ = true;
+    if (captureThread_.joinable()) {
+        captureThread_.join();
+    }
+
+    const packetscope::KernelCaptureStats stats = kernelStats();
+    spdlog::info("TPacketCaptureBackend::stop() - Kernel received {} packets, dropped {}",
+                 stats.received, stats.dropped);
+
+    // Blocks still held by the pipeline keep the ring mapped until they are released
+    releaseRing(std::exchange(ring_, nullptr));
+}
+
+packetscope::KernelCaptureStats TPacketCaptureBackend::kernelStats() {
+    if (!ring_) {
+        return stats_;
+    }
+
+    tpacket_stats_v3 stats{};
+    socklen_t statsLength = sizeof(stats);
+    if (getsockopt(ring_->socketFd, SOL_PACKET, PACKET_STATISTICS, &stats, &statsLength) == 0) {
+        // Counted since the previous read
+        stats_.received += stats.tp_packets;
+        stats_.dropped += stats.tp_drops;
+    }
+    return stats_;
+}
+
+bool TPacketCaptureBackend::setFilter(const std::string& expression) {
+    if (!ring_) {
+        return false;
+    }
+    return attachFilter(ring_->socketFd, expression);
+}
+
+bool TPacketCaptureBackend::attachFilter(int socketFd, const std::string& expression) const {
+    if (expression.empty() && snapLength_ <= 0) {
+        // Fails with ENOENT when no filter is attached, nothing to undo then
+        setsockopt(socketFd, SOL_SOCKET, SO_DETACH_FILTER, nullptr, 0);
+        return true;
+    }
+
+    const int snapLength = snapLength_ > 0 ? snapLength_ : packetscope::CaptureFilter::kMaxSnapLength;
+    pcap_t* handle = pcap_open_dead(dataLinkType_, snapLength);
+    if (!handle) {
+        spdlog::error("TPacketCaptureBackend::attachFilter() - Cannot open a libpcap handle to compile the filter");
+        return false;
+    }
+
+    bpf_program program{};
+    if (pcap_compile(handle, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+        spdlog::error("TPacketCaptureBackend::attachFilter() - Invalid filter '{}': {}",
+                      expression, pcap_geterr(handle));
+        pcap_close(handle);
+        return false;
+    }
+
+    // struct bpf_insn and struct sock_filter share the classic BPF layout
+    sock_fprog socketProgram{};
+    socketProgram.len = static_cast<unsigned short>(program.bf_len);
+    socketProgram.filter = reinterpret_cast<sock_filter*>(program.bf_insns);
+
+    // Replaces the previous program atomically, a live change drops no packet
+    const bool isAttached = setsockopt(socketFd, SOL_SOCKET, SO_ATTACH_FILTER,
+                                       &socketProgram, sizeof(socketProgram)) == 0;
+    if (!isAttached) {
+        spdlog::error("TPacketCaptureBackend::attachFilter() - Cannot attach filter '{}'", expression);
+    }
+
+    pcap_freecode(&program);
+    pcap_close(handle);
+    return isAttached;
+}
+
+void TPacketCaptureBackend::captureLoop(std::vector<int> threadCpus) {
+    if (!CpuAffinity::pinCurrentThread(threadCpus)) {
+        spdlog::warn("TPacketCaptureBackend::captureLoop() - Failed to pin capture thread");
+    }
+
+    pollfd pollDescriptor{};
+    pollDescriptor.fd = ring_->socketFd;
+    pollDescriptor.events = POLLIN | POLLERR;
+
+    // The kernel fills blocks in ring order, so they are read in the same order
+    std::size_t blockIndex = 0;
+    while (!isStopRequested_) {
+        TPacketRing::Block& block = ring_->blocks[blockIndex];
+
+        // isHeld before the status: a held block still reads TP_STATUS_USER
+        if (block.isHeld.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(kHeldBlockBackoff);
+            continue;
+        }
+
+        const uint32_t status = __atomic_load_n(&block.descriptor->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+        if ((status & TP_STATUS_USER) == 0) {
+            poll(&pollDescriptor, 1, kPollTimeoutMs);
+            continue;
+        }
+
+        deliverBlock(blockIndex);
+        blockIndex = (blockIndex + 1) % ring_->blockCount;
+    }
+}
+
+void TPacketCaptureBackend::deliverBlock(std::size_t blockIndex) {
+    TPacketRing::Block& block = ring_->blocks[blockIndex];
+    const tpacket_hdr_v1& blockHeader = block.descriptor->hdr.bh1;
+    const uint32_t frameCount = blockHeader.num_pkts;
+
+    // Nobody refers to the frame headers while the block is idle, so they may be regrown here
+    if (block.frameCapacity < frameCount) {
+        block.frames = std::make_unique<packetscope::BufferHeader[]>(frameCount);
+        block.frameCapacity = frameCount;
+    }
+
+    block.isHeld.store(true, std::memory_order_relaxed);
+    block.outstanding.store(frameCount + 1, std::memory_order_relaxed);
+    ring_->refs.fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t* frame = reinterpret_cast<uint8_t*>(block.descriptor) + blockHeader.offset_to_first_pkt;
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        const auto* frameHeader = reinterpret_cast<const tpacket3_hdr*>(frame);
+
+        packetscope::BufferHeader& bufferHeader = block.frames[i];
+        bufferHeader.refs.store(0, std::memory_order_relaxed);
+        bufferHeader.size = frameHeader->tp_snaplen;
+        bufferHeader.capacity = frameHeader->tp_snaplen;
+        bufferHeader.data = frame + frameHeader->tp_mac;
+        bufferHeader.release = &releaseFrame;
+        bufferHeader.owner = &block;
+        bufferHeader.isBorrowed = true;
+
+        packetscope::RawPacketData rawPacketData;
+        rawPacketData.timestamp.tv_sec = frameHeader->tp_sec;
+        rawPacketData.timestamp.tv_nsec = frameHeader->tp_nsec;
+        rawPacketData.frameLength = static_cast<int>(frameHeader->tp_len);
+        rawPacketData.rawDataLen = static_cast<int>(frameHeader->tp_snaplen);
+        rawPacketData.linkLayerType = ring_->linkLayerType;
+        rawPacketData.rawData = packetscope::PacketBuffer(&bufferHeader);
+        batch_.push_back(std::move(rawPacketData));
+
+        frame += frameHeader->tp_next_offset;
+    }
+
+    handler_(batch_);
+
+    // Frames the handler did not take are released here, then the delivery guard
+    batch_.clear();
+    releaseBlock(block);
+}
+
+#else
+
+struct TPacketRing {};
+
+TPacketCaptureBackend::TPacketCaptureBackend(packetscope::TPacketRingConfig ringConfig)
+    : ringConfig_(ringConfig) {}
+
+TPacketCaptureBackend::~TPacketCaptureBackend() = default;
+
+bool TPacketCaptureBackend::start(const std::string& deviceName, const Options&, FrameHandler) {
+    spdlog::error("TPacketCaptureBackend::start() - TPACKET_V3 is not supported on this platform ('{}')",
+                  deviceName);
+    return false;
+}
+
+void TPacketCaptureBackend::stop() {}
+
+bool TPacketCaptureBackend::setFilter(const std::string&) {
+    return false;
+}
+
+bool TPacketCaptureBackend::attachFilter(int, const std::string&) const {
+    return false;
+}
+
+void TPacketCaptureBackend::captureLoop(std::vector<int>) {}
+
+void TPacketCaptureBackend::deliverBlock(std::size_t) {}
+
+#endif
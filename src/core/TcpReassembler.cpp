@@ -0,0 +1,348 @@
+#include "core/TcpReassembler.hpp"
+#include "core/FlowTable.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+TcpReassembler::TcpReassembler(const packetscope::ReassemblyLimits& limits, std::atomic<std::size_t>& totalBytes,
+                               std::size_t shareCount)
+    : limits_(limits)
+    , totalBytes_(totalBytes)
+    , shareBytes_(limits.maxBytes / std::max(shareCount, std::size_t{1})) {}
+
+TcpReassembler::~TcpReassembler() {
+    clear();
+}
+
+void TcpReassembler::add(const packetscope::FlowKey& key, bool isReversed, const packetscope::TcpSegment& segment,
+                         int packetId, uint64_t timestamp) {
+    now_ = std::max(now_, timestamp);
+
+    auto it = streams_.find(key);
+    if (it == streams_.end()) {
+        // Handshakes, scans and pure ACKs never cost a stream
+        if (segment.payloadSize == 0) {
+            return;
+        }
+        Stream stream;
+        if (!reserve(stream, kStreamOverhead)) {
+            ++refusedCount_;
+            return;
+        }
+        it = streams_.emplace(key, std::move(stream)).first;
+        it->second.lruPosition = lru_.insert(lru_.end(), key);
+    } else {
+        lru_.splice(lru_.end(), lru_, it->second.lruPosition);
+    }
+    if (!bufferPool_) {
+        bufferPool_ = PacketBufferPool::create(PacketBufferPool::kDefaultSlotSize, kSlotsPerSlab);
+    }
+
+    Stream& stream = it->second;
+    Direction& direction = stream.directions[isReversed ? 1 : 0];
+    stream.lastPacketId = packetId;
+    stream.lastSeen = timestamp;
+
+    if (segment.flags & packetscope::kTcpRst) {
+        stream.isClosed = true;
+        return;
+    }
+
+    // A SYN occupies one sequence number before the first payload byte
+    const uint32_t sequence = (segment.flags & packetscope::kTcpSyn) ? segment.sequence + 1 : segment.sequence;
+    if (!direction.hasStart) {
+        direction.startSequence = sequence;
+        direction.hasStart = true;
+    }
+
+    if (segment.payloadSize > 0 && !stream.isTruncated) {
+        const int64_t begin = static_cast<int32_t>(sequence - direction.startSequence);
+        const int64_t end = begin + static_cast<int64_t>(segment.payloadSize);
+        const int64_t next = direction.nextOffset;
+
+        if (end <= next) {
+            // Retransmission of delivered bytes
+        } else if (begin <= next) {
+            const std::size_t skip = static_cast<std::size_t>(next - begin);
+            if (skip < segment.capturedSize) {
+                appendInOrder(stream, isReversed, segment.payload + skip, segment.capturedSize - skip);
+            }
+            // Bytes past the snap length
+            const std::size_t captured = std::max(skip, segment.capturedSize);
+            if (segment.payloadSize > captured) {
+                appendGap(stream, isReversed, segment.payloadSize - captured);
+            }
+            direction.nextOffset = static_cast<uint32_t>(end);
+            drainOutOfOrder(stream, isReversed);
+        } else if (begin - next <= static_cast<int64_t>(limits_.maxStreamBytes)
+                   && segment.capturedSize == segment.payloadSize) {
+            // After a hole: held until it is filled. A cut segment is left to become part of a gap.
+            const uint32_t offset = static_cast<uint32_t>(begin);
+            auto held = direction.outOfOrder.find(offset);
+            if (held == direction.outOfOrder.end() || held->second.size() < segment.capturedSize) {
+                packetscope::PacketBuffer buffer = bufferPool_->copyFrom(segment.payload, segment.capturedSize);
+                const std::size_t capacity = buffer.capacity();
+                if (reserve(stream, capacity + sizeof(packetscope::StreamChunk))) {
+                    if (held != direction.outOfOrder.end()) {
+                        direction.outOfOrderBytes -= held->second.capacity();
+                        release(stream, held->second.capacity() + sizeof(packetscope::StreamChunk));
+                        held->second = std::move(buffer);
+                    } else {
+                        direction.outOfOrder.emplace(offset, std::move(buffer));
+                    }
+                    direction.outOfOrderBytes += capacity;
+                    drainOutOfOrder(stream, isReversed);
+                }
+            }
+        }
+    }
+
+    if (segment.flags & packetscope::kTcpFin) {
+        direction.hasFin = true;
+        stream.isClosed = stream.directions[0].hasFin && stream.directions[1].hasFin;
+    }
+}
+
+void TcpReassembler::expireIfDue(int firstStoredId) {
+    if (now_ < nextExpiry_) {
+        return;
+    }
+    nextExpiry_ = now_ + kExpiryInterval;
+
+    // Least recently used first is the order of the last packets, so the fully evicted streams lead
+    const auto idleTimeout = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(limits_.idleTimeout).count());
+    for (auto position = lru_.begin(); position != lru_.end();) {
+        const auto it = streams_.find(*position);
+        ++position;
+        const Stream& stream = it->second;
+        if (stream.lastPacketId >= firstStoredId) {
+            break;
+        }
+        if (stream.isClosed || (idleTimeout > 0 && now_ - stream.lastSeen >= idleTimeout)) {
+            remove(it);
+        }
+    }
+
+    // Close to the global limit a shard keeps to its share, so the other workers' new streams find room
+    if (totalBytes_.load(std::memory_order_relaxed) >= limits_.maxBytes - limits_.maxBytes / 8) {
+        while (bytes_ > shareBytes_ && !lru_.empty()) {
+            remove(streams_.find(lru_.front()));
+            ++evictedCount_;
+        }
+    }
+}
+
+std::optional<packetscope::TcpStream> TcpReassembler::stream(const packetscope::FlowKey& key) const {
+    const auto it = streams_.find(key);
+    if (it == streams_.end()) {
+        return std::nullopt;
+    }
+
+    const Stream& stream = it->second;
+    packetscope::TcpStream result;
+    result.key = key;
+    result.chunks = stream.chunks;
+    result.bytesAToB = stream.bytesAToB;
+    result.bytesBToA = stream.bytesBToA;
+    result.missingBytes = stream.missingBytes;
+    result.isTruncated = stream.isTruncated;
+    result.isClosed = stream.isClosed;
+    return result;
+}
+
+void TcpReassembler::moveStreamsTo(const std::vector<TcpReassembler*>& targets) {
+    if (targets.empty()) {
+        return;
+    }
+
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        TcpReassembler* target = targets[static_cast<std::size_t>(it->first.hash() % targets.size())];
+        if (target == this) {
+            ++it;
+            continue;
+        }
+        bytes_ -= it->second.bytes;
+        target->bytes_ += it->second.bytes;
+        target->now_ = std::max(target->now_, now_);
+        lru_.erase(it->second.lruPosition);
+        const auto moved = target->streams_.emplace(it->first, std::move(it->second)).first;
+        moved->second.lruPosition = target->lru_.insert(target->lru_.end(), moved->first);
+        it = streams_.erase(it);
+    }
+
+    // Streams of several shards meet in a target, restore the order of their last packets
+    for (TcpReassembler* target : targets) {
+        if (target == this) {
+            continue;
+        }
+        const StreamMap& streams = target->streams_;
+        target->lru_.sort([&streams](const packetscope::FlowKey& a, const packetscope::FlowKey& b) {
+            return streams.at(a).lastPacketId < streams.at(b).lastPacketId;
+        });
+    }
+}
+
+void TcpReassembler::clear() {
+    streams_.clear();
+    lru_.clear();
+    totalBytes_.fetch_sub(bytes_, std::memory_order_relaxed);
+    bytes_ = 0;
+    evictedCount_ = 0;
+    refusedCount_ = 0;
+}
+
+std::size_t TcpReassembler::streamCount() const {
+    return streams_.size();
+}
+
+std::size_t TcpReassembler::bytes() const {
+    return bytes_;
+}
+
+uint64_t TcpReassembler::evictedCount() const {
+    return evictedCount_;
+}
+
+uint64_t TcpReassembler::refusedCount() const {
+    return refusedCount_;
+}
+
+void TcpReassembler::appendInOrder(Stream& stream, bool isReversed, const uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        if (!stream.tailSlot.data() || stream.tailUsed == stream.tailSlot.size()) {
+            packetscope::PacketBuffer slot = bufferPool_->acquire(bufferPool_->slotSize());
+            if (!reserve(stream, slot.capacity())) {
+                return;
+            }
+            stream.tailSlot = std::move(slot);
+            stream.tailUsed = 0;
+        }
+
+        // Past the bytes any chunk (and so any TcpStream) refers to
+        const std::size_t count = std::min(size, stream.tailSlot.size() - stream.tailUsed);
+        std::memcpy(stream.tailSlot.mutableData() + stream.tailUsed, data, count);
+
+        packetscope::StreamChunk* last = stream.chunks.empty() ? nullptr : &stream.chunks.back();
+        if (last && last->isReversed == isReversed && last->buffer.data() == stream.tailSlot.data()
+            && last->offset + last->size == stream.tailUsed) {
+            last->size += static_cast<uint32_t>(count);
+        } else {
+            if (!reserve(stream, sizeof(packetscope::StreamChunk))) {
+                return;
+            }
+            stream.chunks.push_back(packetscope::StreamChunk{
+                stream.tailSlot, static_cast<uint32_t>(stream.tailUsed), static_cast<uint32_t>(count), 0, isReversed});
+        }
+
+        stream.tailUsed += count;
+        (isReversed ? stream.bytesBToA : stream.bytesAToB) += count;
+        data += count;
+        size -= count;
+    }
+}
+
+void TcpReassembler::appendBuffer(Stream& stream, bool isReversed, packetscope::PacketBuffer buffer,
+                                  std::size_t skip) {
+    const std::size_t size = buffer.size() - skip;
+    stream.chunks.push_back(packetscope::StreamChunk{
+        std::move(buffer), static_cast<uint32_t>(skip), static_cast<uint32_t>(size), 0, isReversed});
+    (isReversed ? stream.bytesBToA : stream.bytesAToB) += size;
+}
+
+void TcpReassembler::appendGap(Stream& stream, bool isReversed, std::size_t size) {
+    if (!reserve(stream, sizeof(packetscope::StreamChunk))) {
+        return;
+    }
+    stream.chunks.push_back(packetscope::StreamChunk{{}, 0, 0, static_cast<uint32_t>(size), isReversed});
+    stream.missingBytes += size;
+}
+
+void TcpReassembler::drainOutOfOrder(Stream& stream, bool isReversed) {
+    Direction& direction = stream.directions[isReversed ? 1 : 0];
+
+    while (!direction.outOfOrder.empty()) {
+        if (stream.isTruncated) {
+            // Nothing is appended any more, held bytes are of no use
+            for (const auto& [offset, buffer] : direction.outOfOrder) {
+                release(stream, buffer.capacity() + sizeof(packetscope::StreamChunk));
+            }
+            direction.outOfOrder.clear();
+            direction.outOfOrderBytes = 0;
+            return;
+        }
+
+        auto first = direction.outOfOrder.begin();
+        if (first->first > direction.nextOffset) {
+            if (direction.outOfOrderBytes <= limits_.maxOutOfOrderBytes) {
+                return;
+            }
+            // Too much is waiting: the missing segment was lost before the capture saw it
+            appendGap(stream, isReversed, first->first - direction.nextOffset);
+            direction.nextOffset = first->first;
+            continue;
+        }
+
+        const uint32_t offset = first->first;
+        packetscope::PacketBuffer buffer = std::move(first->second);
+        direction.outOfOrder.erase(first);
+        direction.outOfOrderBytes -= buffer.capacity();
+
+        const uint32_t end = offset + static_cast<uint32_t>(buffer.size());
+        if (end > direction.nextOffset) {
+            const std::size_t skip = direction.nextOffset - offset;
+            direction.nextOffset = end;
+            appendBuffer(stream, isReversed, std::move(buffer), skip);
+        } else {
+            release(stream, buffer.capacity() + sizeof(packetscope::StreamChunk));
+        }
+    }
+}
+
+bool TcpReassembler::reserve(Stream& stream, std::size_t size) {
+    if (stream.isTruncated) {
+        return false;
+    }
+    if (stream.bytes + size > limits_.maxStreamBytes) {
+        stream.isTruncated = true;
+        return false;
+    }
+    // Before data is dropped, the streams seen least recently make room
+    while (totalBytes_.fetch_add(size, std::memory_order_relaxed) + size > limits_.maxBytes) {
+        totalBytes_.fetch_sub(size, std::memory_order_relaxed);
+        if (!evictOldest(stream)) {
+            stream.isTruncated = true;
+            return false;
+        }
+    }
+    stream.bytes += size;
+    bytes_ += size;
+    return true;
+}
+
+void TcpReassembler::remove(StreamMap::iterator it) {
+    release(it->second, it->second.bytes);
+    lru_.erase(it->second.lruPosition);
+    streams_.erase(it);
+}
+
+bool TcpReassembler::evictOldest(const Stream& keep) {
+    if (lru_.empty()) {
+        return false;
+    }
+    // The stream being added to was moved to the back, it is only at the front when it is alone
+    const auto it = streams_.find(lru_.front());
+    if (&it->second == &keep) {
+        return false;
+    }
+    remove(it);
+    ++evictedCount_;
+    return true;
+}
+
+void TcpReassembler::release(Stream& stream, std::size_t size) {
+    stream.bytes -= size;
+    bytes_ -= size;
+    totalBytes_.fetch_sub(size, std::memory_order_relaxed);
+}
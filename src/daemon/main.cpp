@@ -0,0 +1,220 @@
+/**
+ * @file main.cpp
+ * @brief packet-scope-daemon: the capture pipeline as a headless service.
+ *
+ * Captures, parses, stores and optionally records without a GUI: only the
+ * core library is linked, no Qt. Clients (packet-scope-cli, or a GUI through
+ * QueryClient) browse and filter the stored packets over the QueryServer
+ * socket. Runs until SIGINT or SIGTERM.
+ */
+
+#include "core/CpuAffinity.hpp"
+#include "core/PipelineController.hpp"
+#include "core/QueryServer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <pthread.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> deviceNames;
+    packetscope::CaptureFilter filter;
+    packetscope::PipelineConfig config;
+    packetscope::QueryServerConfig server;
+    std::string recordDirectory;
+    packetscope::CaptureWriterConfig recording;
+    std::string metricsPath;
+    bool isServing{true};
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s -i <device> [-i <device> ...] [options]\n"
+                 "  -i, --interface DEV        Capture device, repeat for several\n"
+                 "  -f, --filter BPF           Capture filter (libpcap syntax)\n"
+                 "  --snaplen N                Bytes kept per packet, 0 keeps full frames\n"
+                 "  --backend pcap|tpacket     Capture backend (default pcap)\n"
+                 "  --queues N                 Capture sockets per device, PACKET_FANOUT\n"
+                 "  --workers N                Worker threads, 0 is one per core\n"
+                 "  --flow-affine              Dispatch flows to fixed workers (needed by --reassemble)\n"
+                 "  --reassemble               Reassemble TCP streams\n"
+                 "  --capture-cpus LIST        Pin the capture threads, e.g. 2-3\n"
+                 "  --dispatcher-cpus LIST     Pin the dispatcher thread\n"
+                 "  --worker-cpus LIST         Pin the worker threads\n"
+                 "  --server-cpus LIST         Pin the query server threads\n"
+                 "  --retention-packets N      Packets kept in the store, 0 is unlimited\n"
+                 "  --memory-budget BYTES      RAM for raw bytes before spilling to disk, 0 is unlimited\n"
+                 "  --record DIR               Write pcapng files to DIR\n"
+                 "  --rotate-size BYTES        Start a new file after BYTES\n"
+                 "  --file-count N             Keep only the newest N files\n"
+                 "  --metrics FILE             Write metrics every second (.json: JSON, else Prometheus)\n"
+                 "  --socket PATH              Query socket (default %s)\n"
+                 "  --no-socket                Do not serve queries\n",
+                 program, packetscope::QueryServerConfig{}.socketPath.c_str());
+}
+
+bool parseCount(const std::string& text, std::size_t& value) {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+        return false;
+    }
+    value = static_cast<std::size_t>(parsed);
+    return true;
+}
+
+bool parseCpus(const std::string& text, std::vector<int>& cpus) {
+    cpus = CpuAffinity::parseCpuList(text);
+    return !cpus.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+
+        // Flags without a value
+        if (argument == "--flow-affine") {
+            options.config.dispatchMode = packetscope::DispatchMode::FlowAffine;
+            continue;
+        }
+        if (argument == "--reassemble") {
+            options.config.reassembleTcp = true;
+            continue;
+        }
+        if (argument == "--no-socket") {
+            options.isServing = false;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        std::size_t count = 0;
+        bool isValid = true;
+
+        if (argument == "-i" || argument == "--interface") {
+            options.deviceNames.push_back(value);
+        } else if (argument == "-f" || argument == "--filter") {
+            options.filter.expression = value;
+        } else if (argument == "--snaplen") {
+            isValid = parseCount(value, count)
+                && count <= static_cast<std::size_t>(packetscope::CaptureFilter::kMaxSnapLength);
+            options.filter.snapLength = static_cast<int>(count);
+        } else if (argument == "--backend") {
+            isValid = value == "pcap" || value == "tpacket";
+            options.config.captureBackend = value == "tpacket"
+                ? packetscope::CaptureBackendType::TPacketV3
+                : packetscope::CaptureBackendType::Pcap;
+        } else if (argument == "--queues") {
+            isValid = parseCount(value, options.config.captureQueuesPerDevice)
+                && options.config.captureQueuesPerDevice > 0;
+        } else if (argument == "--workers") {
+            isValid = parseCount(value, options.config.workerCount);
+        } else if (argument == "--capture-cpus") {
+            isValid = parseCpus(value, options.config.captureCpus);
+        } else if (argument == "--dispatcher-cpus") {
+            isValid = parseCpus(value, options.config.dispatcherCpus);
+        } else if (argument == "--worker-cpus") {
+            isValid = parseCpus(value, options.config.workerCpus);
+        } else if (argument == "--server-cpus") {
+            isValid = parseCpus(value, options.server.cpus);
+        } else if (argument == "--retention-packets") {
+            isValid = parseCount(value, options.config.storeRetention.maxPackets);
+        } else if (argument == "--memory-budget") {
+            isValid = parseCount(value, options.config.storeSpill.memoryBudget);
+        } else if (argument == "--record") {
+            options.recordDirectory = value;
+        } else if (argument == "--rotate-size") {
+            isValid = parseCount(value, count);
+            options.recording.maxFileSize = count;
+        } else if (argument == "--file-count") {
+            isValid = parseCount(value, options.recording.fileCount);
+        } else if (argument == "--metrics") {
+            options.metricsPath = value;
+        } else if (argument == "--socket") {
+            options.server.socketPath = value;
+        } else {
+            isValid = false;
+        }
+
+        if (!isValid) {
+            std::fprintf(stderr, "Invalid option: %s %s\n", argument.c_str(), value.c_str());
+            return false;
+        }
+    }
+    return !options.deviceNames.empty();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Blocked before any thread starts, so every thread inherits the mask and sigwait() below gets them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    PipelineController controller(options.config);
+
+    if (!options.metricsPath.empty()) {
+        packetscope::MetricsExportConfig metrics;
+        metrics.path = options.metricsPath;
+        const std::string jsonSuffix = ".json";
+        if (metrics.path.size() >= jsonSuffix.size()
+            && metrics.path.compare(metrics.path.size() - jsonSuffix.size(), jsonSuffix.size(), jsonSuffix) == 0) {
+            metrics.format = packetscope::MetricsFormat::Json;
+        }
+        if (!controller.startMetricsExport(metrics)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.recordDirectory.empty()) {
+        options.recording.directory = options.recordDirectory;
+        if (!controller.startRecording(options.recording)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!controller.start(options.deviceNames, options.filter)) {
+        spdlog::error("main() - Failed to start the capture");
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<QueryServer> server;
+    if (options.isServing) {
+        server = QueryServer::start(options.server, controller);
+        if (!server) {
+            controller.stop();
+            return EXIT_FAILURE;
+        }
+    }
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    spdlog::info("main() - Received signal {}, shutting down", signal);
+
+    // Clients first: they read the store the pipeline is writing
+    server.reset();
+    controller.stop();
+    controller.stopRecording();
+    controller.stopMetricsExport();
+    return EXIT_SUCCESS;
+}
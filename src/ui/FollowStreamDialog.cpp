@@ -0,0 +1,86 @@
+#include "ui/FollowStreamDialog.hpp"
+
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include <utility>
+
+FollowStreamDialog::FollowStreamDialog(packetscope::TcpStream stream, QWidget* parent)
+    : QDialog(parent)
+    , stream_(std::move(stream))
+    , summaryLabel_(new QLabel(this))
+    , directionCombo_(new QComboBox(this))
+    , hexView_(new HexView(this))
+{
+    setWindowTitle(QString("Follow TCP Stream (%1 <-> %2)").arg(endpoint(false), endpoint(true)));
+    resize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+
+    // Item data is the Direction
+    directionCombo_->addItem(QStringLiteral("Both directions"), static_cast<int>(Direction::Both));
+    directionCombo_->addItem(QString("%1 -> %2 (%3 bytes)").arg(endpoint(false), endpoint(true)).arg(stream_.bytesAToB),
+                             static_cast<int>(Direction::AToB));
+    directionCombo_->addItem(QString("%1 -> %2 (%3 bytes)").arg(endpoint(true), endpoint(false)).arg(stream_.bytesBToA),
+                             static_cast<int>(Direction::BToA));
+
+    QString summary = QString("%1 bytes").arg(stream_.bytesAToB + stream_.bytesBToA);
+    if (stream_.missingBytes > 0) {
+        summary += QString(", %1 bytes missing from the capture").arg(stream_.missingBytes);
+    }
+    if (stream_.isTruncated) {
+        summary += QStringLiteral(", truncated at the reassembly memory limit");
+    }
+    summary += stream_.isClosed ? QStringLiteral(", closed") : QStringLiteral(", open");
+    summaryLabel_->setText(summary);
+
+    QHBoxLayout* topLayout = new QHBoxLayout();
+    topLayout->addWidget(summaryLabel_, 1);
+    topLayout->addWidget(directionCombo_);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(topLayout);
+    layout->addWidget(hexView_, 1);
+    layout->addWidget(buttons);
+
+    connect(directionCombo_, &QComboBox::currentIndexChanged, this, &FollowStreamDialog::onDirectionChanged);
+    onDirectionChanged();
+}
+
+void FollowStreamDialog::onDirectionChanged() {
+    const auto direction = static_cast<Direction>(directionCombo_->currentData().toInt());
+
+    auto isShown = [direction](const packetscope::StreamChunk& chunk) {
+        return direction == Direction::Both || chunk.isReversed == (direction == Direction::BToA);
+    };
+
+    // Gaps (bytes the capture lost) have no buffer and are left out
+    std::size_t size = 0;
+    for (const packetscope::StreamChunk& chunk : stream_.chunks) {
+        if (isShown(chunk)) {
+            size += chunk.size;
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(size);
+    for (const packetscope::StreamChunk& chunk : stream_.chunks) {
+        if (isShown(chunk) && chunk.size > 0) {
+            bytes.insert(bytes.end(), chunk.data(), chunk.data() + chunk.size);
+        }
+    }
+    hexView_->setBytes(std::move(bytes));
+}
+
+QString FollowStreamDialog::endpoint(bool isB) const {
+    const packetscope::FlowKey& key = stream_.key;
+    const auto address = packetscope::PacketAddress::from(key.family, isB ? key.addressB.data() : key.addressA.data());
+    const QString text = QString::fromStdString(address.toString());
+    const uint16_t port = isB ? key.portB : key.portA;
+    // IPv6 addresses are bracketed so the port stays readable
+    return key.family == packetscope::PacketAddress::Family::IPv6
+        ? QString("[%1]:%2").arg(text).arg(port)
+        : QString("%1:%2").arg(text).arg(port);
+}
@@ -0,0 +1,204 @@
+#include "ui/HexView.hpp"
+
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/**
+ * Text of every byte value, so a byte costs two table loads instead of a
+ * QString::arg() call.
+ */
+struct ByteTables {
+    char hex[256][2]{};
+    char ascii[256]{};
+};
+
+constexpr ByteTables makeByteTables() {
+    ByteTables tables;
+    for (int byte = 0; byte < 256; ++byte) {
+        tables.hex[byte][0] = kHexDigits[byte >> 4];
+        tables.hex[byte][1] = kHexDigits[byte & 0xf];
+        tables.ascii[byte] = byte >= 32 && byte < 127 ? static_cast<char>(byte) : '.';
+    }
+    return tables;
+}
+
+constexpr ByteTables kByteTables = makeByteTables();
+
+/// Bytes after which the hex column has an extra gap
+constexpr std::size_t kGroupSize = 8;
+
+}
+
+HexView::HexView(QWidget* parent)
+    : QAbstractScrollArea(parent) {
+    setFocusPolicy(Qt::StrongFocus);
+    updateScrollBars();
+}
+
+void HexView::setBuffer(packetscope::PacketBuffer buffer) {
+    ownedBytes_.clear();
+    buffer_ = std::move(buffer);
+    showBytes(buffer_.data(), buffer_.size());
+}
+
+void HexView::setBytes(std::vector<uint8_t> bytes) {
+    buffer_ = packetscope::PacketBuffer();
+    ownedBytes_ = std::move(bytes);
+    showBytes(ownedBytes_.data(), ownedBytes_.size());
+}
+
+void HexView::clear() {
+    buffer_ = packetscope::PacketBuffer();
+    ownedBytes_ = std::vector<uint8_t>();
+    showBytes(nullptr, 0);
+}
+
+void HexView::showBytes(const uint8_t* data, std::size_t size) {
+    data_ = data;
+    size_ = size;
+    updateScrollBars();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    viewport()->update();
+}
+
+std::size_t HexView::formatLine(const uint8_t* data, std::size_t size, std::size_t line,
+                                int offsetDigits, char* out) {
+    const std::size_t begin = line * BYTES_PER_LINE;
+    const std::size_t count = begin < size ? std::min(BYTES_PER_LINE, size - begin) : 0;
+    const uint8_t* bytes = data + begin;
+    char* next = out;
+
+    for (int shift = (offsetDigits - 1) * 4; shift >= 0; shift -= 4) {
+        *next++ = kHexDigits[(begin >> shift) & 0xf];
+    }
+    *next++ = ' ';
+    *next++ = ' ';
+
+    for (std::size_t i = 0; i < BYTES_PER_LINE; ++i) {
+        if (i < count) {
+            std::memcpy(next, kByteTables.hex[bytes[i]], 2);
+        } else {
+            // Pads the last line so the ASCII column stays aligned
+            next[0] = ' ';
+            next[1] = ' ';
+        }
+        next[2] = ' ';
+        next += 3;
+        if (i == kGroupSize - 1) {
+            *next++ = ' ';
+        }
+    }
+    *next++ = ' ';
+
+    for (std::size_t i = 0; i < count; ++i) {
+        *next++ = kByteTables.ascii[bytes[i]];
+    }
+    return static_cast<std::size_t>(next - out);
+}
+
+QString HexView::toPlainText() const {
+    const std::size_t lines = lineCount();
+    const int digits = offsetDigits();
+
+    QByteArray text;
+    text.reserve(static_cast<qsizetype>(lines * (MAX_LINE_LENGTH + 1)));
+    std::array<char, MAX_LINE_LENGTH> line{};
+    for (std::size_t i = 0; i < lines; ++i) {
+        const std::size_t length = formatLine(data_, size_, i, digits, line.data());
+        text.append(line.data(), static_cast<qsizetype>(length));
+        text.append('\n');
+    }
+    return QString::fromLatin1(text);
+}
+
+void HexView::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+
+    const int height = lineHeight();
+    const auto firstLine = static_cast<std::size_t>(verticalScrollBar()->value());
+    const auto visibleLines = static_cast<std::size_t>(viewport()->height() / height + 2);
+    const std::size_t endLine = std::min(lineCount(), firstLine + visibleLines);
+    const int digits = offsetDigits();
+    const int x = TEXT_MARGIN - horizontalScrollBar()->value();
+
+    // Only the lines in view are formatted, each into the same buffer
+    int y = fontMetrics().ascent();
+    for (std::size_t line = firstLine; line < endLine; ++line, y += height) {
+        const std::size_t length = formatLine(data_, size_, line, digits, lineBuffer_.data());
+        painter.drawText(x, y, QString::fromLatin1(lineBuffer_.data(), static_cast<qsizetype>(length)));
+    }
+}
+
+void HexView::resizeEvent(QResizeEvent* event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void HexView::changeEvent(QEvent* event) {
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+void HexView::keyPressEvent(QKeyEvent* event) {
+    if (event->matches(QKeySequence::Copy)) {
+        QGuiApplication::clipboard()->setText(toPlainText());
+        return;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void HexView::contextMenuEvent(QContextMenuEvent* event) {
+    QMenu menu(this);
+    QAction* copyAction = menu.addAction(QStringLiteral("Copy"));
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setEnabled(size_ > 0);
+    if (menu.exec(event->globalPos()) == copyAction) {
+        QGuiApplication::clipboard()->setText(toPlainText());
+    }
+}
+
+void HexView::updateScrollBars() {
+    const int height = lineHeight();
+    const int visibleLines = std::max(viewport()->height() / height, 1);
+    const auto lines = static_cast<int>(std::min<std::size_t>(lineCount(), INT_MAX));
+    verticalScrollBar()->setRange(0, std::max(lines - visibleLines, 0));
+    verticalScrollBar()->setPageStep(visibleLines);
+    verticalScrollBar()->setSingleStep(1);
+
+    const int lineLength = offsetDigits() + static_cast<int>(MAX_LINE_LENGTH) - 8;
+    const int lineWidth = 2 * TEXT_MARGIN + fontMetrics().horizontalAdvance(QLatin1Char('0')) * lineLength;
+    horizontalScrollBar()->setRange(0, std::max(lineWidth - viewport()->width(), 0));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+std::size_t HexView::lineCount() const {
+    return (size_ + BYTES_PER_LINE - 1) / BYTES_PER_LINE;
+}
+
+int HexView::offsetDigits() const {
+    return size_ > 0x10000 ? 8 : 4;
+}
+
+int HexView::lineHeight() const {
+    return std::max(fontMetrics().lineSpacing(), 1);
+}
@@ -1,14 +1,38 @@
 #include "ui/MainWindow.hpp"
+#include "ui/FollowStreamDialog.hpp"
 
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QHeaderView>
 #include <QToolBar>
 #include <QStatusBar>
+#include <QMenu>
 #include <QMessageBox>
 #include <QFont>
+#include <QScrollBar>
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Pipeline settings of the UI: flow affine workers, so they can reassemble TCP for "Follow TCP Stream".
+ */
+packetscope::PipelineConfig makePipelineConfig() {
+    packetscope::PipelineConfig config;
+    config.dispatchMode = packetscope::DispatchMode::FlowAffine;
+    config.reassembleTcp = true;
+    return config;
+}
+
+}
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
+    , controller_(makePipelineConfig())
     , stackedWidget_(new QStackedWidget(this))
     , packetListModel_(nullptr)
     , updateTimer_(new QTimer(this))
@@ -33,6 +57,9 @@ MainWindow::MainWindow(QWidget* parent)
 
     // Connect timer timeout to UI update slot
     connect(updateTimer_, &QTimer::timeout, this, &MainWindow::onUpdateUI);
+
+    // Host and port filters from the packet list are looked up in the index
+    controller_.setStoreIndexing(true);
 }
 
 MainWindow::~MainWindow() {
@@ -51,16 +78,34 @@ void MainWindow::setupWelcomeScreen() {
     titleLabel->setAlignment(Qt::AlignCenter);
 
     QLabel* subtitleLabel = new QLabel(
-        QStringLiteral("Double-click a network interface to start capturing")
+        QStringLiteral("Double-click a network interface to start capturing (Ctrl-click to select several)")
     );
     subtitleLabel->setAlignment(Qt::AlignCenter);
 
     deviceListWidget_ = new QListWidget();
     deviceListWidget_->setAlternatingRowColors(true);
     deviceListWidget_->setFont(QFont("Monospace", 10));
+    deviceListWidget_->setSelectionMode(QAbstractItemView::ExtendedSelection);
 
     populateDeviceList();
 
+    // Kernel side filter of the capture, see PipelineController::start()
+    filterEdit_ = new QLineEdit();
+    filterEdit_->setPlaceholderText(QStringLiteral("BPF syntax, e.g. tcp port 443 (empty captures everything)"));
+
+    snapLengthSpinBox_ = new QSpinBox();
+    snapLengthSpinBox_->setRange(0, packetscope::CaptureFilter::kMaxSnapLength);
+    snapLengthSpinBox_->setSingleStep(SNAP_LENGTH_STEP);
+    snapLengthSpinBox_->setSuffix(QStringLiteral(" bytes"));
+    snapLengthSpinBox_->setSpecialValueText(QStringLiteral("Full frames"));
+
+    QFormLayout* filterLayout = new QFormLayout();
+    filterLayout->addRow(QStringLiteral("Capture filter:"), filterEdit_);
+    filterLayout->addRow(QStringLiteral("Snap length:"), snapLengthSpinBox_);
+
+    openFileButton_ = new QPushButton(QStringLiteral("Open capture file..."));
+    connect(openFileButton_, &QPushButton::clicked, this, &MainWindow::onOpenFile);
+
     // Connect double click signal to slot
     // When user double clicks a device, start capture
     connect(deviceListWidget_, &QListWidget::itemDoubleClicked,
@@ -71,6 +116,9 @@ void MainWindow::setupWelcomeScreen() {
     layout->addWidget(subtitleLabel);
     layout->addSpacing(20);
     layout->addWidget(deviceListWidget_);
+    layout->addLayout(filterLayout);
+    layout->addSpacing(10);
+    layout->addWidget(openFileButton_, 0, Qt::AlignCenter);
     layout->addSpacing(50);
 
     stackedWidget_->addWidget(welcomeWidget_);
@@ -106,6 +154,26 @@ void MainWindow::setupCaptureScreen() {
     startAction_ = toolbar->addAction(QStringLiteral("Start"));
     stopAction_ = toolbar->addAction(QStringLiteral("Stop"));
     restartAction_ = toolbar->addAction(QStringLiteral("Restart"));
+    openFileAction_ = toolbar->addAction(QStringLiteral("Open File"));
+    recordAction_ = toolbar->addAction(QStringLiteral("Record"));
+    recordAction_->setCheckable(true);
+    followAction_ = toolbar->addAction(QStringLiteral("Follow"));
+    followAction_->setCheckable(true);
+    followAction_->setChecked(true);
+    followAction_->setToolTip(QStringLiteral("Scroll to the newest packet on every update"));
+
+    // Hidden until toggled from the toolbar, see onUpdateUI()
+    metricsPanel_ = new MetricsPanel();
+    metricsDock_ = new QDockWidget(QStringLiteral("Pipeline Metrics"), this);
+    metricsDock_->setWidget(metricsPanel_);
+    addDockWidget(Qt::RightDockWidgetArea, metricsDock_);
+    metricsDock_->hide();
+    QAction* metricsAction = metricsDock_->toggleViewAction();
+    metricsAction->setText(QStringLiteral("Metrics"));
+    toolbar->addAction(metricsAction);
+    exportMetricsAction_ = toolbar->addAction(QStringLiteral("Export Metrics"));
+    exportMetricsAction_->setCheckable(true);
+    exportMetricsAction_->setToolTip(QStringLiteral("Write the pipeline metrics to a Prometheus or JSON file every second"));
 
     // Initial state: all disabled until device is selected
     startAction_->setEnabled(false);
@@ -115,9 +183,60 @@ void MainWindow::setupCaptureScreen() {
     connect(startAction_, &QAction::triggered, this, &MainWindow::onStartCapture);
     connect(stopAction_, &QAction::triggered, this, &MainWindow::onStopCapture);
     connect(restartAction_, &QAction::triggered, this, &MainWindow::onRestartCapture);
+    connect(openFileAction_, &QAction::triggered, this, &MainWindow::onOpenFile);
+    connect(recordAction_, &QAction::toggled, this, &MainWindow::onToggleRecording);
+    connect(exportMetricsAction_, &QAction::toggled, this, &MainWindow::onToggleMetricsExport);
+    // The timer is stopped while the pipeline is, show the final numbers when opened
+    connect(metricsDock_, &QDockWidget::visibilityChanged, this, [this](bool isVisible) {
+        if (isVisible) {
+            metricsPanel_->setMetrics(controller_.metrics());
+        }
+    });
+
+    // Changing the filter here keeps the captured packets, see onApplyCaptureFilter()
+    toolbar->addSeparator();
+    toolbar->addWidget(new QLabel(QStringLiteral(" Capture filter: ")));
+    liveFilterEdit_ = new QLineEdit();
+    liveFilterEdit_->setPlaceholderText(QStringLiteral("BPF syntax, Enter to apply"));
+    toolbar->addWidget(liveFilterEdit_);
+
+    connect(liveFilterEdit_, &QLineEdit::returnPressed, this, &MainWindow::onApplyCaptureFilter);
+
+    // Item data is the TimestampFormatter enum, see onTimeFormatChanged()
+    toolbar->addSeparator();
+    toolbar->addWidget(new QLabel(QStringLiteral(" Time: ")));
+    timeReferenceCombo_ = new QComboBox();
+    timeReferenceCombo_->addItem(QStringLiteral("Absolute"),
+                                 static_cast<int>(TimestampFormatter::Reference::Absolute));
+    timeReferenceCombo_->addItem(QStringLiteral("Since start"),
+                                 static_cast<int>(TimestampFormatter::Reference::CaptureStart));
+    timeReferenceCombo_->addItem(QStringLiteral("Since previous"),
+                                 static_cast<int>(TimestampFormatter::Reference::PreviousPacket));
+    toolbar->addWidget(timeReferenceCombo_);
+    timePrecisionCombo_ = new QComboBox();
+    timePrecisionCombo_->addItem(QStringLiteral("\u00b5s"),
+                                 static_cast<int>(TimestampFormatter::Precision::Microseconds));
+    timePrecisionCombo_->addItem(QStringLiteral("ns"),
+                                 static_cast<int>(TimestampFormatter::Precision::Nanoseconds));
+    toolbar->addWidget(timePrecisionCombo_);
+
+    connect(timeReferenceCombo_, &QComboBox::currentIndexChanged, this, &MainWindow::onTimeFormatChanged);
+    connect(timePrecisionCombo_, &QComboBox::currentIndexChanged, this, &MainWindow::onTimeFormatChanged);
 
     mainLayout->addWidget(toolbar);
 
+    // Hides rows of the packet list only, see onApplyDisplayFilter()
+    QHBoxLayout* displayFilterLayout = new QHBoxLayout();
+    displayFilterLayout->setContentsMargins(4, 0, 4, 0);
+    displayFilterLayout->addWidget(new QLabel(QStringLiteral("Display filter:")));
+    displayFilterEdit_ = new QLineEdit();
+    displayFilterEdit_->setPlaceholderText(
+        QStringLiteral("e.g. ip.addr == 10.0.0.0/8 && tcp.port == 443, Enter to apply (empty shows everything)"));
+    displayFilterLayout->addWidget(displayFilterEdit_);
+    mainLayout->addLayout(displayFilterLayout);
+
+    connect(displayFilterEdit_, &QLineEdit::returnPressed, this, &MainWindow::onApplyDisplayFilter);
+
     QSplitter* mainSplitter = new QSplitter(Qt::Vertical);
 
     packetTableView_ = new QTableView();
@@ -125,6 +244,8 @@ void MainWindow::setupCaptureScreen() {
     packetTableView_->setSelectionMode(QAbstractItemView::SingleSelection);
     packetTableView_->setAlternatingRowColors(true);
     packetTableView_->verticalHeader()->setVisible(false);
+    // Fixed rows: the view maps scroll positions to rows without asking for any row's size
+    packetTableView_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
     packetListModel_ = new PacketListModel(controller_.getStore(), this);
     packetTableView_->setModel(packetListModel_);
@@ -132,6 +253,10 @@ void MainWindow::setupCaptureScreen() {
     QHeaderView* header = packetTableView_->horizontalHeader();
     header->setStretchLastSection(false);
 
+    // Starts in capture order; clicking a header sorts in the background, see PacketListModel::sort()
+    header->setSortIndicator(static_cast<int>(PacketListModel::ColumnType::Id), Qt::AscendingOrder);
+    packetTableView_->setSortingEnabled(true);
+
     header->resizeSection(static_cast<int>(PacketListModel::ColumnType::Id), COLUMN_WIDTH_ID);
     header->resizeSection(static_cast<int>(PacketListModel::ColumnType::Time), COLUMN_WIDTH_TIME);
     header->resizeSection(static_cast<int>(PacketListModel::ColumnType::Source), COLUMN_WIDTH_SOURCE);
@@ -146,6 +271,14 @@ void MainWindow::setupCaptureScreen() {
     connect(packetTableView_->selectionModel(), &QItemSelectionModel::currentRowChanged,
             this, &MainWindow::onPacketSelected);
 
+    packetTableView_->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(packetTableView_, &QTableView::customContextMenuRequested, this, &MainWindow::onPacketContextMenu);
+
+    // Only user scrolling toggles follow mode, scrollToBottom() does not trigger actions
+    QScrollBar* scrollBar = packetTableView_->verticalScrollBar();
+    connect(scrollBar, &QScrollBar::actionTriggered, this, &MainWindow::onPacketTableScrolled);
+    connect(scrollBar, &QScrollBar::valueChanged, this, [this]() { updateViewport(); });
+
     // Add table to main splitter
     mainSplitter->addWidget(packetTableView_);
 
@@ -156,10 +289,10 @@ void MainWindow::setupCaptureScreen() {
     layerTreeWidget_->setFont(QFont("Monospace", 9));
     detailSplitter->addWidget(layerTreeWidget_);
 
-    hexView_ = new QPlainTextEdit();
-    hexView_->setReadOnly(true);
-    hexView_->setFont(QFont("Monospace", 9));
-    hexView_->setLineWrapMode(QPlainTextEdit::NoWrap);
+    hexView_ = new HexView();
+    QFont hexFont("Monospace", 9);
+    hexFont.setStyleHint(QFont::TypeWriter);
+    hexView_->setFont(hexFont);
     detailSplitter->addWidget(hexView_);
 
     detailSplitter->setSizes({400, 400});
@@ -174,18 +307,44 @@ void MainWindow::setupCaptureScreen() {
 }
 
 void MainWindow::onDeviceDoubleClicked(QListWidgetItem* item) {
-    currentDeviceName_ = item->data(Qt::UserRole).toString();
+    currentDeviceNames_.clear();
 
-    if (controller_.start(currentDeviceName_.toStdString())) {
+    // Capture on every selected device if the clicked one is part of the selection
+    const QList<QListWidgetItem*> selected = deviceListWidget_->selectedItems();
+    if (selected.contains(item)) {
+        for (const QListWidgetItem* selectedItem : selected) {
+            currentDeviceNames_.append(selectedItem->data(Qt::UserRole).toString());
+        }
+    } else {
+        currentDeviceNames_.append(item->data(Qt::UserRole).toString());
+    }
+
+    const QString devices = currentDeviceNames_.join(QStringLiteral(", "));
+
+    captureFilter_.expression = filterEdit_->text().trimmed().toStdString();
+    captureFilter_.snapLength = snapLengthSpinBox_->value();
+    liveFilterEdit_->setText(filterEdit_->text().trimmed());
+
+    if (controller_.start(currentDevices(), captureFilter_)) {
         hasDevice_ = true;
         showCaptureScreen();
         updateTimer_->start(UI_UPDATE_INTERVAL_MS);
-        statusLabel_->setText(QStringLiteral("Capturing on: ") + currentDeviceName_);
+        statusLabel_->setText(QStringLiteral("Capturing on: ") + devices);
         updateButtonStates();
     } else {
         QMessageBox::warning(this, QStringLiteral("Error"),
-                            QStringLiteral("Failed to start capture on ") + currentDeviceName_);
+                            QStringLiteral("Failed to start capture on ") + devices
+                            + QStringLiteral(" (check the capture filter)"));
+    }
+}
+
+std::vector<std::string> MainWindow::currentDevices() const {
+    std::vector<std::string> devices;
+    devices.reserve(static_cast<std::size_t>(currentDeviceNames_.size()));
+    for (const QString& name : currentDeviceNames_) {
+        devices.push_back(name.toStdString());
     }
+    return devices;
 }
 
 void MainWindow::onStopCapture() {
@@ -196,9 +355,9 @@ void MainWindow::onStopCapture() {
 }
 
 void MainWindow::onStartCapture() {
-    if (controller_.start(currentDeviceName_.toStdString())) {
+    if (controller_.start(currentDevices(), captureFilter_)) {
         updateTimer_->start(UI_UPDATE_INTERVAL_MS);
-        statusLabel_->setText(QStringLiteral("Capturing on: ") + currentDeviceName_);
+        statusLabel_->setText(QStringLiteral("Capturing on: ") + currentDeviceNames_.join(QStringLiteral(", ")));
         updateButtonStates();
     } else {
         QMessageBox::warning(this, QStringLiteral("Error"),
@@ -207,10 +366,12 @@ void MainWindow::onStartCapture() {
 }
 
 void MainWindow::onRestartCapture() {
+    // The store is cleared, no sort may read it meanwhile
+    packetListModel_->stopSorting();
     if (controller_.restart()) {
         packetListModel_->reset();
         updateTimer_->start(UI_UPDATE_INTERVAL_MS);
-        statusLabel_->setText(QStringLiteral("Restarted on: ") + currentDeviceName_);
+        statusLabel_->setText(QStringLiteral("Restarted on: ") + currentDeviceNames_.join(QStringLiteral(", ")));
         updateButtonStates();
     } else {
         QMessageBox::warning(this, QStringLiteral("Error"),
@@ -218,6 +379,158 @@ void MainWindow::onRestartCapture() {
     }
 }
 
+void MainWindow::onApplyCaptureFilter() {
+    const QString expression = liveFilterEdit_->text().trimmed();
+
+    if (controller_.setCaptureFilter(expression.toStdString())) {
+        captureFilter_.expression = expression.toStdString();
+        statusBar()->showMessage(expression.isEmpty() ? QStringLiteral("Capture filter cleared")
+                                                      : QStringLiteral("Capture filter applied: ") + expression,
+                                 STATUS_MESSAGE_TIMEOUT_MS);
+    } else {
+        QMessageBox::warning(this, QStringLiteral("Error"),
+                            QStringLiteral("Invalid capture filter: ") + expression);
+        liveFilterEdit_->setText(QString::fromStdString(captureFilter_.expression));
+    }
+}
+
+void MainWindow::onApplyDisplayFilter() {
+    const QString expression = displayFilterEdit_->text().trimmed();
+
+    if (expression.isEmpty()) {
+        packetListModel_->setFilter(nullptr);
+        statusBar()->showMessage(QStringLiteral("Display filter cleared"), STATUS_MESSAGE_TIMEOUT_MS);
+        return;
+    }
+
+    auto filter = DisplayFilter::compile(expression.toStdString());
+    if (!filter) {
+        QMessageBox::warning(this, QStringLiteral("Error"),
+                            QStringLiteral("Invalid display filter: ") + expression);
+        return;
+    }
+
+    packetListModel_->setFilter(std::move(filter));
+    statusBar()->showMessage(QString("Display filter applied: %1 (%2 packets)")
+                                 .arg(expression).arg(packetListModel_->rowCount()),
+                             STATUS_MESSAGE_TIMEOUT_MS);
+}
+
+void MainWindow::onOpenFile() {
+    const QString path = QFileDialog::getOpenFileName(
+        this, QStringLiteral("Open capture file"), QString(),
+        QStringLiteral("Capture files (*.pcap *.pcapng *.cap);;All files (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    packetListModel_->stopSorting();
+    if (controller_.openFile(path.toStdString())) {
+        packetListModel_->reset();
+        showCaptureScreen();
+        updateTimer_->start(UI_UPDATE_INTERVAL_MS);
+        statusLabel_->setText(QStringLiteral("Loading: ") + path);
+        updateButtonStates();
+    } else {
+        QMessageBox::warning(this, QStringLiteral("Error"),
+                            QStringLiteral("Failed to open capture file ") + path);
+    }
+}
+
+void MainWindow::onToggleRecording(bool isChecked) {
+    if (!isChecked) {
+        const auto stats = controller_.recordingStats();
+        controller_.stopRecording();
+        if (stats) {
+            statusBar()->showMessage(QString("Recording stopped: %1 packets in %2 files")
+                                         .arg(stats->packetsWritten)
+                                         .arg(stats->filesWritten),
+                                     STATUS_MESSAGE_TIMEOUT_MS);
+        }
+        return;
+    }
+
+    const QString directory = QFileDialog::getExistingDirectory(this, QStringLiteral("Record to directory"));
+
+    packetscope::CaptureWriterConfig config;
+    config.directory = directory.toStdString();
+    config.maxFileSize = RECORDING_FILE_SIZE_BYTES;
+    config.fileCount = RECORDING_FILE_COUNT;
+
+    if (directory.isEmpty() || !controller_.startRecording(config)) {
+        if (!directory.isEmpty()) {
+            QMessageBox::warning(this, QStringLiteral("Error"),
+                                QStringLiteral("Cannot record to ") + directory);
+        }
+        // Does not emit toggled again
+        const QSignalBlocker blocker(recordAction_);
+        recordAction_->setChecked(false);
+    }
+}
+
+void MainWindow::onToggleMetricsExport(bool isChecked) {
+    if (!isChecked) {
+        controller_.stopMetricsExport();
+        statusBar()->showMessage(QStringLiteral("Metrics export stopped"), STATUS_MESSAGE_TIMEOUT_MS);
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(
+        this, QStringLiteral("Export metrics to"), QStringLiteral("packetscope.prom"),
+        QStringLiteral("Prometheus text (*.prom);;JSON (*.json)"));
+
+    packetscope::MetricsExportConfig config;
+    config.path = path.toStdString();
+    config.format = path.endsWith(QStringLiteral(".json"), Qt::CaseInsensitive)
+        ? packetscope::MetricsFormat::Json
+        : packetscope::MetricsFormat::Prometheus;
+
+    if (path.isEmpty() || !controller_.startMetricsExport(config)) {
+        if (!path.isEmpty()) {
+            QMessageBox::warning(this, QStringLiteral("Error"),
+                                QStringLiteral("Cannot write metrics to ") + path);
+        }
+        // Does not emit toggled again
+        const QSignalBlocker blocker(exportMetricsAction_);
+        exportMetricsAction_->setChecked(false);
+        return;
+    }
+    statusBar()->showMessage(QString("Exporting metrics to %1 every %2 ms").arg(path).arg(config.interval.count()),
+                             STATUS_MESSAGE_TIMEOUT_MS);
+}
+
+bool MainWindow::updateFileLoadStatus() {
+    const auto progress = controller_.fileLoadProgress();
+    if (!progress) {
+        return false;
+    }
+
+    const QString path = QString::fromStdString(progress->path);
+    if (!progress->isFinished) {
+        const double percent = progress->fileSize > 0
+            ? 100.0 * static_cast<double>(progress->bytesRead) / static_cast<double>(progress->fileSize)
+            : 0.0;
+        statusLabel_->setText(QString("Loading %1: %2% at %3 MB/s")
+                                  .arg(path)
+                                  .arg(percent, 0, 'f', 1)
+                                  .arg(progress->megabytesPerSecond, 0, 'f', 1));
+        return true;
+    }
+
+    // Every packet is stored, release the workers
+    if (controller_.isRunning()) {
+        controller_.stop();
+        updateTimer_->stop();
+        updateButtonStates();
+    }
+    statusLabel_->setText(QString("Loaded %1: %2 packets in %3 s (%4 MB/s)")
+                              .arg(path)
+                              .arg(progress->packetsRead)
+                              .arg(progress->secondsElapsed, 0, 'f', 2)
+                              .arg(progress->megabytesPerSecond, 0, 'f', 1));
+    return true;
+}
+
 void MainWindow::updateButtonStates() {
     bool isRunning = controller_.isRunning();
 
@@ -235,78 +548,203 @@ void MainWindow::showCaptureScreen() {
 }
 
 void MainWindow::onUpdateUI() {
+    QElapsedTimer elapsed;
+    elapsed.start();
+
     packetListModel_->refresh();
+    if (followAction_->isChecked()) {
+        packetTableView_->scrollToBottom();
+    }
+    updateViewport();
+    updateFileLoadStatus();
+
+    const packetscope::QueueStats rawStats = controller_.rawQueueStats();
+    const packetscope::QueueStats taskStats = controller_.taskQueueStats();
 
     packetCountLabel_->setText(
-        QString("Captured: %1 | Processed: %2")
+        QString("Captured: %1 | Processed: %2 | Raw queue: %3 dropped, peak %4/%5 | Task queue: %6 dropped, peak %7/%8 batches")
             .arg(controller_.capturedCount())
             .arg(controller_.processedCount())
+            .arg(rawStats.dropped)
+            .arg(rawStats.highWaterMark)
+            .arg(rawStats.capacity)
+            .arg(taskStats.dropped)
+            .arg(taskStats.highWaterMark)
+            .arg(taskStats.capacity)
     );
+
+    if (metricsDock_->isVisible()) {
+        metricsPanel_->setMetrics(controller_.metrics());
+    }
+
+    const packetscope::StoreMemoryStats memory = controller_.getStore()->memoryStats();
+    if (memory.spilledSegments > 0) {
+        packetCountLabel_->setText(packetCountLabel_->text()
+            + QString(" | Raw bytes: %1 MB in memory, %2 MB on disk")
+                  .arg(static_cast<double>(memory.rawBytesInMemory) / 1e6, 0, 'f', 1)
+                  .arg(static_cast<double>(memory.rawBytesSpilled) / 1e6, 0, 'f', 1));
+    }
+    if (memory.evictedPackets > 0) {
+        packetCountLabel_->setText(packetCountLabel_->text()
+            + QString(" | Evicted: %1").arg(memory.evictedPackets));
+    }
+    if (packetListModel_->filter()) {
+        packetCountLabel_->setText(packetCountLabel_->text()
+            + QString(" | Displayed: %1").arg(packetListModel_->rowCount()));
+    }
+
+    if (const auto recording = controller_.recordingStats()) {
+        packetCountLabel_->setText(packetCountLabel_->text()
+            + QString(" | Recorded: %1 (%2 dropped)").arg(recording->packetsWritten).arg(recording->packetsDropped));
+    }
+
+    adaptUpdateInterval(elapsed.nsecsElapsed());
 }
 
-void MainWindow::onPacketSelected(const QModelIndex& current, const QModelIndex& previous) {
-    Q_UNUSED(previous);
+void MainWindow::adaptUpdateInterval(qint64 updateNanoseconds) {
+    const qint64 intervalMs = updateNanoseconds * UI_UPDATE_SHARE / 1000000;
+    const auto interval = static_cast<int>(
+        std::clamp<qint64>(intervalMs, UI_UPDATE_INTERVAL_MS, UI_UPDATE_MAX_INTERVAL_MS));
+    if (interval != updateTimer_->interval()) {
+        updateTimer_->setInterval(interval);
+    }
+}
 
-    // Early return for invalid selection
-    if (!current.isValid()) {
+void MainWindow::updateViewport() {
+    const int rowCount = packetListModel_->rowCount();
+    if (rowCount == 0) {
         return;
     }
 
-    const int packetId = packetListModel_->getPacketId(current.row());
+    // rowAt() is -1 below the last row
+    const int firstRow = std::max(packetTableView_->rowAt(0), 0);
+    const int lastRow = packetTableView_->rowAt(packetTableView_->viewport()->height() - 1);
+    packetListModel_->setViewport(firstRow, lastRow < 0 ? rowCount - 1 : lastRow);
+}
 
-    try {
-        const auto packet = controller_.getStore()->getById(packetId);
+void MainWindow::onPacketTableScrolled(int action) {
+    Q_UNUSED(action);
 
-        layerTreeWidget_->clear();
+    // The slider already moved, the value follows after this signal
+    const QScrollBar* scrollBar = packetTableView_->verticalScrollBar();
+    followAction_->setChecked(scrollBar->sliderPosition() >= scrollBar->maximum());
+}
 
-        // Each string in layerSummaries represents one protocol layer
-        for (const auto& layer : packet.layerSummaries) {
-            QTreeWidgetItem* item = new QTreeWidgetItem(layerTreeWidget_);
-            item->setText(0, QString::fromStdString(layer));
-        }
+void MainWindow::onTimeFormatChanged() {
+    packetListModel_->setTimeFormat(
+        static_cast<TimestampFormatter::Reference>(timeReferenceCombo_->currentData().toInt()),
+        static_cast<TimestampFormatter::Precision>(timePrecisionCombo_->currentData().toInt()));
+    // Reformats the visible rows in one pass
+    updateViewport();
+}
 
-        QString hexText;
-        const auto& data = packet.rawData;
-
-        // Process bytes in lines of HEX_BYTES_PER_LINE(16)
-        for (std::size_t i = 0; i < data.size(); i += HEX_BYTES_PER_LINE) {
-            // Offset
-            hexText += QString("%1  ").arg(i, 4, 16, QChar('0'));
-
-            QString hexPart;
-            QString asciiPart;
-
-            // Hex and ASCII Parts
-            for (std::size_t j = 0; j < HEX_BYTES_PER_LINE; ++j) {
-                if (i + j < data.size()) {
-                    const uint8_t byte = data[i + j];
-
-                    // Hex representation
-                    hexPart += QString("%1 ").arg(byte, 2, 16, QChar('0'));
-
-                    // ASCII representation
-                    asciiPart += (byte >= 32 && byte < 127)
-                        ? QChar(static_cast<char>(byte))
-                        : QChar('.');
-                } else {
-                    // Padding for incomplete last line
-                    hexPart += "   ";
-                }
-
-                // Add extra space after 8th byte for visual separator
-                if (j == HEX_SEPARATOR_POS) {
-                    hexPart += " ";
-                }
+void MainWindow::onPacketContextMenu(const QPoint& position) {
+    const QModelIndex index = packetTableView_->indexAt(position);
+    if (!index.isValid()) {
+        return;
+    }
+
+    const int packetId = packetListModel_->getPacketId(index.row());
+
+    // Label and expression of each offered filter
+    std::vector<std::pair<QString, QString>> filters;
+    bool isTcp = false;
+    controller_.getStore()->visit(packetId, [&filters, &isTcp](const PacketView& packet) {
+        auto addAddress = [&filters](const QString& label, const packetscope::PacketAddress& address) {
+            using Family = packetscope::PacketAddress::Family;
+            if (address.family != Family::IPv4 && address.family != Family::IPv6) {
+                return;
             }
+            const QString text = QString::fromStdString(address.toString());
+            const QString field = address.family == Family::IPv4 ? QStringLiteral("ip.addr") : QStringLiteral("ipv6.addr");
+            filters.emplace_back(QString("Filter on %1 %2").arg(label, text), QString("%1 == %2").arg(field, text));
+        };
+        addAddress(QStringLiteral("source"), packet.srcAddr());
+        addAddress(QStringLiteral("destination"), packet.dstAddr());
+
+        // IANA numbers of the transports with ports in the display filter
+        constexpr uint8_t IP_PROTOCOL_TCP = 6;
+        constexpr uint8_t IP_PROTOCOL_UDP = 17;
+        const uint8_t ipProtocol = packet.ipProtocol();
+        isTcp = ipProtocol == IP_PROTOCOL_TCP;
+        if (ipProtocol == IP_PROTOCOL_TCP || ipProtocol == IP_PROTOCOL_UDP) {
+            const QString field = ipProtocol == IP_PROTOCOL_TCP ? QStringLiteral("tcp.port") : QStringLiteral("udp.port");
+            filters.emplace_back(QString("Filter on source port %1").arg(packet.srcPort()),
+                                 QString("%1 == %2").arg(field).arg(packet.srcPort()));
+            filters.emplace_back(QString("Filter on destination port %1").arg(packet.dstPort()),
+                                 QString("%1 == %2").arg(field).arg(packet.dstPort()));
+        }
+    });
+    if (filters.empty()) {
+        return;
+    }
+
+    QMenu menu(this);
+    for (const auto& [label, expression] : filters) {
+        connect(menu.addAction(label), &QAction::triggered, this, [this, expression = expression]() {
+            displayFilterEdit_->setText(expression);
+            onApplyDisplayFilter();
+        });
+    }
+    if (isTcp && controller_.isReassemblingTcp()) {
+        menu.addSeparator();
+        connect(menu.addAction(QStringLiteral("Follow TCP Stream")), &QAction::triggered, this, [this, packetId]() {
+            onFollowTcpStream(packetId);
+        });
+    }
+    menu.exec(packetTableView_->viewport()->mapToGlobal(position));
+}
 
-            // Combine offset, hex and ASCII parts
-            hexText += hexPart + " " + asciiPart + "\n";
+void MainWindow::onFollowTcpStream(int packetId) {
+    std::optional<packetscope::TcpStream> stream = controller_.tcpStream(packetId);
+    if (!stream) {
+        QString message = QStringLiteral("No payload was reassembled for this connection.");
+        const packetscope::ReassemblyStats stats = controller_.reassemblyStats();
+        if (stats.evictedStreams > 0 || stats.refusedStreams > 0) {
+            message += QString("\n\nThe reassembly memory limit was reached: %1 streams were evicted "
+                               "to make room, %2 connections could not be reassembled.")
+                           .arg(stats.evictedStreams)
+                           .arg(stats.refusedStreams);
         }
+        QMessageBox::information(this, QStringLiteral("Follow TCP Stream"), message);
+        return;
+    }
 
-        hexView_->setPlainText(hexText);
+    // A snapshot: the stream keeps growing in the pipeline while the dialog is open
+    FollowStreamDialog* dialog = new FollowStreamDialog(std::move(*stream), this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::onPacketSelected(const QModelIndex& current, const QModelIndex& previous) {
+    Q_UNUSED(previous);
+
+    // Early return for invalid selection
+    if (!current.isValid()) {
+        return;
+    }
+
+    const int packetId = packetListModel_->getPacketId(current.row());
+
+    // Dissected on demand, missing packets (e.g. discarded) are silently ignored
+    const auto layerDetails = controller_.layerDetails(packetId);
+    if (!layerDetails) {
+        return;
+    }
+
+    layerTreeWidget_->clear();
+
+    // Each string in layerDetails represents one protocol layer
+    for (const auto& layer : *layerDetails) {
+        QTreeWidgetItem* item = new QTreeWidgetItem(layerTreeWidget_);
+        item->setText(0, QString::fromStdString(layer));
+    }
 
-    } catch (const std::exception&) {
-        // Exceptions from PacketStore
-        // Silently ignore to avoid crashing UI
+    // Keeps the packet's buffer, the view formats the lines it shows
+    const bool isFound = controller_.getStore()->visit(packetId, [this](const PacketView& packet) {
+        hexView_->setBuffer(packet.rawData());
+    });
+    if (!isFound) {
+        hexView_->clear();
     }
 }
\ No newline at end of file
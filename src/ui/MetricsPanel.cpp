@@ -0,0 +1,145 @@
+#include "ui/MetricsPanel.hpp"
+
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+namespace {
+
+enum StageColumn { StageName, StageCount, StageMean, StageP50, StageP90, StageP99, StageP999, StageMax };
+enum ThreadColumn { ThreadName, ThreadPackets, ThreadBatches, ThreadLoad };
+enum CaptureColumn { CaptureDevice, CaptureCaptured, CaptureKernelDropped, CaptureInterfaceDropped,
+                     CaptureRingDropped, CaptureRingPeak };
+
+}
+
+MetricsPanel::MetricsPanel(QWidget* parent)
+    : QWidget(parent)
+    , dropsLabel_(new QLabel(this))
+    , stageTable_(createTable({QStringLiteral("Stage"), QStringLiteral("Count"), QStringLiteral("Mean"),
+                               QStringLiteral("p50"), QStringLiteral("p90"), QStringLiteral("p99"),
+                               QStringLiteral("p99.9"), QStringLiteral("Max")}))
+    , threadTable_(createTable({QStringLiteral("Thread"), QStringLiteral("Packets"), QStringLiteral("Batches"),
+                                QStringLiteral("Busy")}))
+    , captureTable_(createTable({QStringLiteral("Capture"), QStringLiteral("Captured"),
+                                 QStringLiteral("Kernel dropped"), QStringLiteral("Interface dropped"),
+                                 QStringLiteral("Ring dropped"), QStringLiteral("Ring peak")}))
+{
+    dropsLabel_->setWordWrap(true);
+
+    stageTable_->setRowCount(static_cast<int>(packetscope::kPipelineStageCount));
+    for (std::size_t stage = 0; stage < packetscope::kPipelineStageCount; ++stage) {
+        setCell(stageTable_, static_cast<int>(stage), StageName,
+                QString::fromLatin1(packetscope::pipelineStageName(static_cast<packetscope::PipelineStage>(stage))));
+    }
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(dropsLabel_);
+    layout->addWidget(new QLabel(QStringLiteral("Stage latency"), this));
+    layout->addWidget(stageTable_, 2);
+    layout->addWidget(new QLabel(QStringLiteral("Threads"), this));
+    layout->addWidget(threadTable_, 3);
+    layout->addWidget(new QLabel(QStringLiteral("Captures"), this));
+    layout->addWidget(captureTable_, 1);
+
+    sinceLastSnapshot_.start();
+}
+
+void MetricsPanel::setMetrics(const packetscope::PipelineMetricsSnapshot& metrics) {
+    // Packets lost, in pipeline order
+    dropsLabel_->setText(QString("Dropped by the interface: %1 | by the kernel: %2 of %3 | raw queue: %4 | task queue: %5"
+                                 " | Captured: %6 | Processed: %7")
+                             .arg(metrics.kernel.interfaceDropped)
+                             .arg(metrics.kernel.dropped)
+                             .arg(metrics.kernel.received)
+                             .arg(metrics.rawQueue.dropped)
+                             .arg(metrics.taskQueue.dropped)
+                             .arg(metrics.captured)
+                             .arg(metrics.processed));
+
+    for (std::size_t stage = 0; stage < packetscope::kPipelineStageCount; ++stage) {
+        const packetscope::LatencyHistogram& histogram = metrics.stages[stage];
+        const int row = static_cast<int>(stage);
+        setCell(stageTable_, row, StageCount, QString::number(histogram.count));
+        setCell(stageTable_, row, StageMean, formatDuration(static_cast<uint64_t>(histogram.mean())));
+        setCell(stageTable_, row, StageP50, formatDuration(histogram.percentile(0.5)));
+        setCell(stageTable_, row, StageP90, formatDuration(histogram.percentile(0.9)));
+        setCell(stageTable_, row, StageP99, formatDuration(histogram.percentile(0.99)));
+        setCell(stageTable_, row, StageP999, formatDuration(histogram.percentile(0.999)));
+        setCell(stageTable_, row, StageMax, formatDuration(histogram.max));
+    }
+
+    // Share of the wall time each thread spent on batches since the previous snapshot
+    const auto elapsedNs = static_cast<double>(std::max<qint64>(sinceLastSnapshot_.nsecsElapsed(), 1));
+    sinceLastSnapshot_.restart();
+
+    threadTable_->setRowCount(static_cast<int>(metrics.threads.size()));
+    QHash<QString, uint64_t> busyNs;
+    for (std::size_t i = 0; i < metrics.threads.size(); ++i) {
+        const packetscope::ThreadMetricsSnapshot& thread = metrics.threads[i];
+        const QString name = QString::fromStdString(thread.name);
+        const int row = static_cast<int>(i);
+
+        // A reset (restart) makes the counters go back, the load then starts over
+        const uint64_t previous = previousBusyNs_.value(name, 0);
+        const uint64_t busy = thread.busyNs >= previous ? thread.busyNs - previous : thread.busyNs;
+        const double load = std::min(100.0 * static_cast<double>(busy) / elapsedNs, 100.0);
+        busyNs.insert(name, thread.busyNs);
+
+        setCell(threadTable_, row, ThreadName, name);
+        setCell(threadTable_, row, ThreadPackets, QString::number(thread.packets));
+        setCell(threadTable_, row, ThreadBatches, QString::number(thread.batches));
+        setCell(threadTable_, row, ThreadLoad, QString("%1%").arg(load, 0, 'f', 1));
+    }
+    previousBusyNs_ = std::move(busyNs);
+
+    captureTable_->setRowCount(static_cast<int>(metrics.captures.size()));
+    for (std::size_t i = 0; i < metrics.captures.size(); ++i) {
+        const packetscope::CaptureMetrics& capture = metrics.captures[i];
+        const int row = static_cast<int>(i);
+        setCell(captureTable_, row, CaptureDevice, QString("%1 #%2").arg(QString::fromStdString(capture.deviceName)).arg(i));
+        setCell(captureTable_, row, CaptureCaptured, QString::number(capture.captured));
+        setCell(captureTable_, row, CaptureKernelDropped, QString::number(capture.kernel.dropped));
+        setCell(captureTable_, row, CaptureInterfaceDropped, QString::number(capture.kernel.interfaceDropped));
+        setCell(captureTable_, row, CaptureRingDropped, QString::number(capture.rawQueue.dropped));
+        setCell(captureTable_, row, CaptureRingPeak,
+                QString("%1/%2").arg(capture.rawQueue.highWaterMark).arg(capture.rawQueue.capacity));
+    }
+}
+
+QString MetricsPanel::formatDuration(uint64_t nanoseconds) {
+    const auto value = static_cast<double>(nanoseconds);
+    if (nanoseconds < 1000) {
+        return QString("%1 ns").arg(nanoseconds);
+    }
+    if (nanoseconds < 1000 * 1000) {
+        return QString("%1 \u00b5s").arg(value / 1e3, 0, 'f', 1);
+    }
+    if (nanoseconds < 1000 * 1000 * 1000) {
+        return QString("%1 ms").arg(value / 1e6, 0, 'f', 1);
+    }
+    return QString("%1 s").arg(value / 1e9, 0, 'f', 2);
+}
+
+void MetricsPanel::setCell(QTableWidget* table, int row, int column, const QString& text) {
+    QTableWidgetItem* item = table->item(row, column);
+    if (!item) {
+        item = new QTableWidgetItem();
+        // Numbers line up on the right, names stay left
+        item->setTextAlignment(column == 0 ? (Qt::AlignLeft | Qt::AlignVCenter) : (Qt::AlignRight | Qt::AlignVCenter));
+        table->setItem(row, column, item);
+    }
+    item->setText(text);
+}
+
+QTableWidget* MetricsPanel::createTable(const QStringList& headers) {
+    QTableWidget* table = new QTableWidget(0, static_cast<int>(headers.size()), this);
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setStretchLastSection(true);
+    return table;
+}
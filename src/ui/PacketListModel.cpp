@@ -1,14 +1,30 @@
 #include "ui/PacketListModel.hpp"
 
-#include <ctime>
-#include <stdexcept>
+#include "core/PacketProcessor.hpp"
+
+#include <algorithm>
 
 PacketListModel::PacketListModel(std::shared_ptr<PacketStore> store, QObject* parent)
     : QAbstractTableModel(parent)
-    , store_(std::move(store)) {}
+    , store_(std::move(store))
+    , sortPollTimer_(new QTimer(this)) {
+    sortPollTimer_->setInterval(SORT_POLL_INTERVAL_MS);
+    connect(sortPollTimer_, &QTimer::timeout, this, [this]() {
+        // Checked first, a pass finishing in between is still applied below
+        const bool isSorting = sorter_ && sorter_->isSorting();
+        applySortedOrder();
+        if (!isSorting) {
+            sortPollTimer_->stop();
+        }
+    });
+}
 
 int PacketListModel::rowCount(const QModelIndex& parent) const {
-    return parent.isValid() ? 0 : static_cast<int>(cachedRowCount_);
+    if (parent.isValid()) {
+        return 0;
+    }
+    // Sorted rows first, then the base rows not sorted yet
+    return static_cast<int>(sortedRowCount() + baseRowCount() - tailFirst_) + rowAdjustment_;
 }
 
 int PacketListModel::columnCount(const QModelIndex& parent) const {
@@ -20,30 +36,91 @@ QVariant PacketListModel::data(const QModelIndex& index, int role) const {
         return QVariant();
     }
 
-    const int packetId = index.row() + 1;
-
-    try {
-        const auto packet = store_->getById(packetId);
+    const int column = index.column();
+    if (column < 0 || column >= static_cast<int>(ColumnType::COUNT)) {
+        return QVariant();
+    }
 
-        switch (static_cast<ColumnType>(index.column())) {
-            case ColumnType::Id:          return packet.id;
-            case ColumnType::Time:        return formatTimestamp(packet.timestamp);
-            case ColumnType::Source:      return QString::fromStdString(packet.srcAddr);
-            case ColumnType::Destination: return QString::fromStdString(packet.dstAddr);
-            case ColumnType::Protocol:    return QString::fromStdString(packet.protocol);
-            case ColumnType::Length:      return packet.frameLength;
-            default:                      return QVariant();
+    const int row = index.row();
+    if (!viewportCache_.contains(row)) {
+        loadRows(row - VIEWPORT_CACHE_MARGIN, row + VIEWPORT_CACHE_MARGIN);
+        if (!viewportCache_.contains(row)) {
+            return QVariant();
         }
+    }
 
-    } catch (const std::out_of_range&) {
-        // Packet not found
-        // Return empty variant view will display nothing
-        return QVariant();
-    } catch (const std::exception&) {
-        // Other exceptions from PacketStore
-        // Return empty variant to avoid crashing the UI
-        return QVariant();
+    // Packets not found (e.g. discarded) have empty cells, the view displays nothing
+    return viewportCache_.rows[static_cast<std::size_t>(row - viewportCache_.firstRow)]
+                             [static_cast<std::size_t>(column)];
+}
+
+void PacketListModel::setViewport(int firstRow, int lastRow) {
+    if (viewportCache_.contains(firstRow) && viewportCache_.contains(lastRow)) {
+        return;
     }
+    loadRows(firstRow - VIEWPORT_CACHE_MARGIN, lastRow + VIEWPORT_CACHE_MARGIN);
+}
+
+void PacketListModel::loadRows(int firstRow, int lastRow) const {
+    firstRow = std::max(firstRow, 0);
+    lastRow = std::min(lastRow, rowCount() - 1);
+
+    viewportCache_.firstRow = firstRow;
+    viewportCache_.rows.assign(static_cast<std::size_t>(std::max(lastRow - firstRow + 1, 0)), RowCells{});
+
+    // Deltas from the previous packet need the row above the first one
+    timespec previous{};
+    bool hasPrevious = false;
+    if (firstRow > 0 && firstRow <= lastRow
+        && timestampFormatter_.reference() == TimestampFormatter::Reference::PreviousPacket) {
+        hasPrevious = store_->visit(getPacketId(firstRow - 1), [&previous](const PacketView& packet) {
+            previous = packet.timestamp();
+        });
+    }
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        RowCells& cells = viewportCache_.rows[static_cast<std::size_t>(row - firstRow)];
+        auto column = [&cells](ColumnType type) -> QVariant& {
+            return cells[static_cast<std::size_t>(type)];
+        };
+
+        hasPrevious = store_->visit(getPacketId(row), [&](const PacketView& packet) {
+            const timespec timestamp = packet.timestamp();
+            column(ColumnType::Id)          = packet.id();
+            column(ColumnType::Time)        = formatTimestamp(timestamp, hasPrevious ? &previous : nullptr);
+            previous = timestamp;
+            // Binary columns are only formatted here, for rows around the viewport
+            column(ColumnType::Source)      = QString::fromStdString(packet.srcAddr().toString());
+            column(ColumnType::Destination) = QString::fromStdString(packet.dstAddr().toString());
+            column(ColumnType::Protocol)    = packet.protocol() == pcpp::UnknownProtocol
+                ? QString()
+                : QString::fromStdString(PacketProcessor::protocolTypeToString(packet.protocol()));
+            column(ColumnType::Length)      = packet.frameLength();
+        });
+    }
+}
+
+void PacketListModel::setTimeFormat(TimestampFormatter::Reference reference,
+                                    TimestampFormatter::Precision precision) {
+    if (reference == timestampFormatter_.reference() && precision == timestampFormatter_.precision()) {
+        return;
+    }
+    timestampFormatter_.setReference(reference);
+    timestampFormatter_.setPrecision(precision);
+
+    viewportCache_ = ViewportCache{};
+    if (rowCount() > 0) {
+        const int timeColumn = static_cast<int>(ColumnType::Time);
+        emit dataChanged(index(0, timeColumn), index(rowCount() - 1, timeColumn), {Qt::DisplayRole});
+    }
+}
+
+void PacketListModel::shiftCache(int removedRows) {
+    // Cached rows that were removed go, the rest keep their cells under a lower row number
+    const int dropped = std::min(std::max(removedRows - viewportCache_.firstRow, 0),
+                                 static_cast<int>(viewportCache_.rows.size()));
+    viewportCache_.rows.erase(viewportCache_.rows.begin(), viewportCache_.rows.begin() + dropped);
+    viewportCache_.firstRow = std::max(viewportCache_.firstRow - removedRows, 0);
 }
 
 QVariant PacketListModel::headerData(int section, Qt::Orientation orientation, int role) const {
@@ -64,35 +141,348 @@ QVariant PacketListModel::headerData(int section, Qt::Orientation orientation, i
 }
 
 int PacketListModel::getPacketId(int row) const {
-    // Rows are 0 based, packet IDs are 1 based
-    return row + 1;
+    const auto index = static_cast<std::size_t>(row);
+    const std::size_t sortedRows = sortedRowCount();
+    if (index < sortedRows) {
+        const std::vector<int>& ids = sortedOrder_->ids;
+        return sortOrder_ == Qt::AscendingOrder ? ids[index] : ids[sortedRows - 1 - index];
+    }
+
+    // Rows past the mapped ones only exist while a new order is laid out
+    const std::size_t baseRow = tailFirst_ + (index - sortedRows);
+    return baseRow < baseRowCount() ? baseId(baseRow) : 0;
+}
+
+std::size_t PacketListModel::baseRowCount() const {
+    return filter_ ? filteredIds_.size() : cachedRowCount_;
+}
+
+int PacketListModel::baseId(std::size_t baseRow) const {
+    if (filter_) {
+        return filteredIds_[baseRow];
+    }
+    // Base rows are 0 based and start at the oldest retained packet
+    return firstRowId_ + static_cast<int>(baseRow);
+}
+
+std::size_t PacketListModel::sortedRowCount() const {
+    return sortedOrder_ ? sortedOrder_->ids.size() : 0;
+}
+
+void PacketListModel::sort(int column, Qt::SortOrder order) {
+    std::optional<PacketSorter::Column> sortColumn;
+    switch (static_cast<ColumnType>(column)) {
+        // Ascending by ID is the base order, nothing to sort
+        case ColumnType::Id:          if (order == Qt::DescendingOrder) { sortColumn = PacketSorter::Column::Id; } break;
+        case ColumnType::Time:        sortColumn = PacketSorter::Column::Time; break;
+        case ColumnType::Source:      sortColumn = PacketSorter::Column::Source; break;
+        case ColumnType::Destination: sortColumn = PacketSorter::Column::Destination; break;
+        case ColumnType::Protocol:    sortColumn = PacketSorter::Column::Protocol; break;
+        case ColumnType::Length:      sortColumn = PacketSorter::Column::Length; break;
+        case ColumnType::COUNT:
+        default: return;
+    }
+
+    if (sortColumn == sortColumn_) {
+        // Same column, other direction: the sorted rows are read backwards
+        if (order != sortOrder_) {
+            relayout(sortedOrder_, tailFirst_, order);
+        }
+        return;
+    }
+
+    // Base order until the sorter's first pass finishes, see applySortedOrder()
+    sortColumn_ = sortColumn;
+    relayout(nullptr, 0, order);
+    startSorter();
+}
+
+void PacketListModel::stopSorting() {
+    sorter_.reset();
+}
+
+void PacketListModel::startSorter() {
+    sorter_.reset();
+    if (!sortColumn_) {
+        return;
+    }
+
+    sorter_ = std::make_unique<PacketSorter>(store_, *sortColumn_);
+    if (filter_) {
+        sorter_->add(std::vector<int>(filteredIds_.begin(), filteredIds_.end()), filteredUntilId_);
+    } else {
+        sorter_->evictBefore(firstRowId_);
+        sorter_->add(firstRowId_ + static_cast<int>(cachedRowCount_) - 1);
+    }
+    sortPollTimer_->start();
+}
+
+void PacketListModel::applySortedOrder() {
+    if (sortColumn_ && !sorter_) {
+        // Stopped by stopSorting(), starts over on the current rows
+        startSorter();
+    }
+    if (!sorter_) {
+        return;
+    }
+
+    std::shared_ptr<const PacketSorter::Order> order = sorter_->order();
+    if (!order || order == sortedOrder_) {
+        return;
+    }
+
+    // The base rows up to the order's last ID are part of it, the rest stays in the tail
+    std::size_t tailFirst = 0;
+    if (filter_) {
+        tailFirst = static_cast<std::size_t>(
+            std::upper_bound(filteredIds_.begin(), filteredIds_.end(), order->sortedUntilId) - filteredIds_.begin());
+    } else if (order->sortedUntilId >= firstRowId_) {
+        tailFirst = std::min(static_cast<std::size_t>(order->sortedUntilId - firstRowId_ + 1), cachedRowCount_);
+    }
+    relayout(std::move(order), tailFirst, sortOrder_);
+}
+
+void PacketListModel::relayout(std::shared_ptr<const PacketSorter::Order> order, std::size_t tailFirst,
+                               Qt::SortOrder sortOrder) {
+    // Rows may come and go with a new order (evictions), so the count is kept during the layout change
+    const int oldRowCount = rowCount();
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList persistent = persistentIndexList();
+    std::vector<int> persistentIds;
+    persistentIds.reserve(static_cast<std::size_t>(persistent.size()));
+    for (const QModelIndex& index : persistent) {
+        persistentIds.push_back(getPacketId(index.row()));
+    }
+
+    sortedOrder_ = std::move(order);
+    tailFirst_ = tailFirst;
+    sortOrder_ = sortOrder;
+    viewportCache_ = ViewportCache{};
+    rowAdjustment_ = 0;
+    const int newRowCount = rowCount();
+    rowAdjustment_ = oldRowCount - newRowCount;
+
+    // Selected and current rows follow their packet
+    QModelIndexList moved;
+    moved.reserve(persistent.size());
+    for (qsizetype i = 0; i < persistent.size(); ++i) {
+        const int row = rowOfId(persistentIds[static_cast<std::size_t>(i)]);
+        moved.append(row >= 0 && row < oldRowCount ? index(row, persistent[i].column()) : QModelIndex());
+    }
+    changePersistentIndexList(persistent, moved);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    if (newRowCount < oldRowCount) {
+        beginRemoveRows(QModelIndex(), newRowCount, oldRowCount - 1);
+        rowAdjustment_ = 0;
+        endRemoveRows();
+    } else if (newRowCount > oldRowCount) {
+        beginInsertRows(QModelIndex(), oldRowCount, newRowCount - 1);
+        rowAdjustment_ = 0;
+        endInsertRows();
+    }
+}
+
+int PacketListModel::rowOfId(int id) const {
+    const std::size_t sortedRows = sortedRowCount();
+    if (id <= 0) {
+        return -1;
+    }
+
+    // Tail rows are in ID order
+    if (!sortedOrder_ || id > sortedOrder_->sortedUntilId) {
+        std::size_t baseRow = 0;
+        if (filter_) {
+            const auto match = std::lower_bound(filteredIds_.begin(), filteredIds_.end(), id);
+            if (match == filteredIds_.end() || *match != id) {
+                return -1;
+            }
+            baseRow = static_cast<std::size_t>(match - filteredIds_.begin());
+        } else if (id >= firstRowId_ && id < firstRowId_ + static_cast<int>(cachedRowCount_)) {
+            baseRow = static_cast<std::size_t>(id - firstRowId_);
+        } else {
+            return -1;
+        }
+        return baseRow >= tailFirst_ ? static_cast<int>(sortedRows + baseRow - tailFirst_) : -1;
+    }
+
+    // Inverse map of the order, built by the sorter thread with it
+    const std::ptrdiff_t match = sortedOrder_->positionOf(id);
+    if (match < 0) {
+        return -1;
+    }
+    const auto position = static_cast<std::size_t>(match);
+    return static_cast<int>(sortOrder_ == Qt::AscendingOrder ? position : sortedRows - 1 - position);
+}
+
+void PacketListModel::setFilter(std::shared_ptr<const DisplayFilter> filter) {
+    beginResetModel();
+    filter_ = std::move(filter);
+    viewportCache_ = ViewportCache{};
+    filteredIds_.clear();
+    sortedOrder_.reset();
+    tailFirst_ = 0;
+
+    updateCaptureStart();
+    const int firstId = store_->firstId();
+    const auto watermark = static_cast<int>(store_->count());
+    if (filter_) {
+        const std::vector<int> matches = filter_->filter(*store_, firstId, watermark);
+        filteredIds_.assign(matches.begin(), matches.end());
+        filteredUntilId_ = watermark;
+    } else {
+        firstRowId_ = firstId;
+        cachedRowCount_ = watermark >= firstId ? static_cast<std::size_t>(watermark - firstId + 1) : 0;
+    }
+    startSorter();
+    endResetModel();
+}
+
+const std::shared_ptr<const DisplayFilter>& PacketListModel::filter() const {
+    return filter_;
 }
 
 void PacketListModel::refresh() {
-    const std::size_t newCount = store_->count();
+    updateCaptureStart();
+    if (filter_) {
+        refreshFiltered();
+        return;
+    }
+
+    const int firstId = store_->firstId();
+
+    if (firstId > firstRowId_) {
+        const std::size_t evicted = std::min(
+            static_cast<std::size_t>(firstId - firstRowId_), cachedRowCount_);
+
+        removeEvictedRows(evicted);
+
+        // Also skips packets evicted before they were ever shown
+        firstRowId_ = firstId;
+    }
+
+    // The watermark never falls behind the front, unless the store was cleared without reset()
+    const std::size_t watermark = store_->count();
+    const auto precedingIds = static_cast<std::size_t>(firstRowId_ - 1);
+    const std::size_t newCount = watermark > precedingIds ? watermark - precedingIds : 0;
 
     if (newCount > cachedRowCount_) {
+        const int rows = rowCount();
         beginInsertRows(
             QModelIndex(),
-            static_cast<int>(cachedRowCount_),
-            static_cast<int>(newCount - 1)
+            rows,
+            rows + static_cast<int>(newCount - cachedRowCount_) - 1
         );
 
         cachedRowCount_ = newCount;
         endInsertRows();
     }
+
+    if (sorter_) {
+        sorter_->evictBefore(firstRowId_);
+        sorter_->add(firstRowId_ + static_cast<int>(cachedRowCount_) - 1);
+        sortPollTimer_->start();
+    }
+    applySortedOrder();
+}
+
+void PacketListModel::refreshFiltered() {
+    const int firstId = store_->firstId();
+
+    // Evicted matches leave from the front, in one batch
+    const auto evictedEnd = std::lower_bound(filteredIds_.begin(), filteredIds_.end(), firstId);
+    removeEvictedRows(static_cast<std::size_t>(evictedEnd - filteredIds_.begin()));
+    if (sorter_) {
+        sorter_->evictBefore(firstId);
+    }
+
+    // Only the packets stored since the last refresh are tested
+    const auto watermark = static_cast<int>(store_->count());
+    if (watermark > filteredUntilId_) {
+        const std::vector<int> matches =
+            filter_->filter(*store_, std::max(filteredUntilId_ + 1, firstId), watermark);
+        filteredUntilId_ = watermark;
+
+        if (!matches.empty()) {
+            const int rows = rowCount();
+            beginInsertRows(QModelIndex(), rows, rows + static_cast<int>(matches.size()) - 1);
+            filteredIds_.insert(filteredIds_.end(), matches.begin(), matches.end());
+            endInsertRows();
+        }
+        if (sorter_) {
+            sorter_->add(matches, watermark);
+            sortPollTimer_->start();
+        }
+    }
+    applySortedOrder();
+}
+
+void PacketListModel::removeEvictedRows(std::size_t evicted) {
+    if (evicted == 0) {
+        return;
+    }
+
+    // Unsorted rows leave the tail in one batch; sorted ones stay (empty) until the next order drops them
+    const std::size_t sortedRows = sortedRowCount();
+    const std::size_t evictedTail = evicted > tailFirst_ ? evicted - tailFirst_ : 0;
+    if (evictedTail > 0) {
+        beginRemoveRows(QModelIndex(), static_cast<int>(sortedRows),
+                        static_cast<int>(sortedRows + evictedTail) - 1);
+    }
+
+    if (filter_) {
+        filteredIds_.erase(filteredIds_.begin(), filteredIds_.begin() + static_cast<std::ptrdiff_t>(evicted));
+    } else {
+        cachedRowCount_ -= evicted;
+        firstRowId_ += static_cast<int>(evicted);
+    }
+    tailFirst_ -= std::min(tailFirst_, evicted);
+
+    if (evictedTail > 0) {
+        if (sortedRows == 0) {
+            shiftCache(static_cast<int>(evictedTail));
+        } else {
+            viewportCache_ = ViewportCache{};
+        }
+        endRemoveRows();
+    }
 }
 
 void PacketListModel::reset() {
     beginResetModel();
     cachedRowCount_ = 0;
+    firstRowId_ = 1;
+    filteredIds_.clear();
+    filteredUntilId_ = 0;
+    viewportCache_ = ViewportCache{};
+    hasCaptureStart_ = false;
+    sortedOrder_.reset();
+    tailFirst_ = 0;
+    startSorter();
     endResetModel();
 }
 
-QString PacketListModel::formatTimestamp(const timespec& ts) const {
-    std::tm localTime{};
-    localtime_r(&ts.tv_sec, &localTime);
+void PacketListModel::updateCaptureStart() {
+    if (hasCaptureStart_ || store_->count() == 0) {
+        return;
+    }
+    // Taken before any row is shown, so every row formats against the same start
+    hasCaptureStart_ = store_->visit(store_->firstId(), [this](const PacketView& packet) {
+        captureStart_ = packet.timestamp();
+    });
+}
+
+QString PacketListModel::formatTimestamp(const timespec& timestamp, const timespec* previous) const {
+    const timespec* reference = nullptr;
+    switch (timestampFormatter_.reference()) {
+        case TimestampFormatter::Reference::Absolute:       reference = &timestamp; break;
+        case TimestampFormatter::Reference::CaptureStart:   reference = hasCaptureStart_ ? &captureStart_ : &timestamp; break;
+        // The first row has no previous packet and shows 0
+        case TimestampFormatter::Reference::PreviousPacket: reference = previous ? previous : &timestamp; break;
+    }
 
-    return QTime(localTime.tm_hour, localTime.tm_min,
-                 localTime.tm_sec).toString("HH:mm:ss");
+    std::array<char, TimestampFormatter::MAX_LENGTH> text{};
+    const std::size_t length = timestampFormatter_.format(timestamp, *reference, text.data());
+    return QString::fromLatin1(text.data(), static_cast<qsizetype>(length));
 }
@@ -0,0 +1,97 @@
+#include "ui/TimestampFormatter.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr long kNanosecondsPerSecond = 1000000000L;
+
+/// Writes value as two digits
+char* writeTwoDigits(int value, char* out) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+    return out + 2;
+}
+
+/// Writes value in decimal without leading zeros
+char* writeUnsigned(uint64_t value, char* out) {
+    char digits[20];
+    std::size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+}
+
+std::size_t TimestampFormatter::format(const timespec& timestamp, const timespec& reference, char* out) {
+    if (reference_ == Reference::Absolute) {
+        return formatAbsolute(timestamp, out);
+    }
+    return formatDuration(timestamp, reference, out);
+}
+
+std::size_t TimestampFormatter::formatAbsolute(const timespec& timestamp, char* out) {
+    SecondBucket& bucket = buckets_[static_cast<std::size_t>(timestamp.tv_sec) & (SECOND_BUCKETS - 1)];
+    if (!bucket.isValid || bucket.second != timestamp.tv_sec) {
+        // The only time zone lookup, shared by every packet of the second
+        std::tm localTime{};
+        localtime_r(&timestamp.tv_sec, &localTime);
+
+        char* clock = bucket.clock.data();
+        clock = writeTwoDigits(localTime.tm_hour, clock);
+        *clock++ = ':';
+        clock = writeTwoDigits(localTime.tm_min, clock);
+        *clock++ = ':';
+        writeTwoDigits(localTime.tm_sec, clock);
+        bucket.second = timestamp.tv_sec;
+        bucket.isValid = true;
+    }
+
+    std::memcpy(out, bucket.clock.data(), bucket.clock.size());
+    char* next = out + bucket.clock.size();
+    *next++ = '.';
+    next = writeFraction(timestamp.tv_nsec, next);
+    return static_cast<std::size_t>(next - out);
+}
+
+std::size_t TimestampFormatter::formatDuration(const timespec& timestamp, const timespec& reference,
+                                               char* out) const {
+    int64_t seconds = static_cast<int64_t>(timestamp.tv_sec) - static_cast<int64_t>(reference.tv_sec);
+    long nanoseconds = timestamp.tv_nsec - reference.tv_nsec;
+
+    // Same sign for both parts, e.g. -1 s + 0.25 s becomes -0.75 s
+    if (seconds > 0 && nanoseconds < 0) {
+        --seconds;
+        nanoseconds += kNanosecondsPerSecond;
+    } else if (seconds < 0 && nanoseconds > 0) {
+        ++seconds;
+        nanoseconds -= kNanosecondsPerSecond;
+    }
+
+    char* next = out;
+    // Packets of several capture queues may be numbered slightly out of time order
+    if (seconds < 0 || nanoseconds < 0) {
+        *next++ = '-';
+    }
+    next = writeUnsigned(seconds < 0 ? 0 - static_cast<uint64_t>(seconds) : static_cast<uint64_t>(seconds), next);
+    *next++ = '.';
+    next = writeFraction(nanoseconds < 0 ? -nanoseconds : nanoseconds, next);
+    return static_cast<std::size_t>(next - out);
+}
+
+char* TimestampFormatter::writeFraction(long nanoseconds, char* out) const {
+    const int digits = precision_ == Precision::Nanoseconds ? 9 : 6;
+    long value = precision_ == Precision::Nanoseconds ? nanoseconds : nanoseconds / 1000;
+    for (int i = digits - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + digits;
+}